@@ -66,21 +66,29 @@ namespace Controller {
   };
 }}
 
-#define T_ERROR(...)                                              \
-  do {                                                            \
-    tuvok::Controller::Debug::Out().Error(_func_, __VA_ARGS__);   \
-  } while(0)
-#define WARNING(...)                                              \
-  do {                                                            \
-    tuvok::Controller::Debug::Out().Warning(_func_, __VA_ARGS__); \
-  } while(0)
-#define MESSAGE(...)                                              \
-  do {                                                            \
-    tuvok::Controller::Debug::Out().Message(_func_, __VA_ARGS__); \
-  } while(0)
-#define OTHER(...)                                                \
-  do {                                                            \
-    tuvok::Controller::Debug::Out().Other(_func_, __VA_ARGS__);   \
+/// Channels above this level are compiled out of the macros below:
+/// 1 = errors, 2 = + warnings, 3 = + messages, 4 = + other (default).
+#ifndef TUVOK_LOG_LEVEL
+# define TUVOK_LOG_LEVEL 4
+#endif
+
+/// The arguments are only evaluated if the channel is enabled, see
+/// AbstrDebugOut::ChannelEnabled.  Compiled out channels cost nothing, not
+/// even the suppressed count.
+#define TUVOK_LOG(channel, func, ...)                                   \
+  do {                                                                  \
+    if (AbstrDebugOut::channel <= TUVOK_LOG_LEVEL) {                    \
+      if (AbstrDebugOut::ChannelEnabled(AbstrDebugOut::channel)) {      \
+        tuvok::Controller::Debug::Out().func(_func_, __VA_ARGS__);      \
+      } else {                                                          \
+        AbstrDebugOut::CountSuppressed(AbstrDebugOut::channel);         \
+      }                                                                 \
+    }                                                                   \
   } while(0)
 
+#define T_ERROR(...) TUVOK_LOG(CHANNEL_ERROR,   Error,   __VA_ARGS__)
+#define WARNING(...) TUVOK_LOG(CHANNEL_WARNING, Warning, __VA_ARGS__)
+#define MESSAGE(...) TUVOK_LOG(CHANNEL_MESSAGE, Message, __VA_ARGS__)
+#define OTHER(...)   TUVOK_LOG(CHANNEL_OTHER,   Other,   __VA_ARGS__)
+
 #endif // TUVOK_CONTROLLER_H
@@ -38,6 +38,7 @@
 #include <sstream>
 #include <functional>
 #include "MasterController.h"
+#include "Tracer.h"
 #include "../Basics/SystemInfo.h"
 #include "../Basics/SysTools.h"
 #include "../IO/IOManager.h"
@@ -87,13 +88,17 @@ MasterController::MasterController() :
   LuaScript()->cexec("provenance.enable", false);
 
   RState.BStrategy = RendererState::BS_SkipTwoLevels;
-  std::fill(m_Perf, m_Perf+PERF_END, 0.0);
+  std::fill(m_PerfQueryBase, m_PerfQueryBase+PERF_END, 0.0);
+
+  AbstrDebugOut::SetFrontEnd(DebugOut());
+  Tracer::Instance().SetThreadName("MasterController");
 }
 
 
 MasterController::~MasterController() {
   Cleanup();
   m_DebugOut.clear();
+  AbstrDebugOut::SetFrontEnd(NULL);
 }
 
 void MasterController::Cleanup() {
@@ -117,6 +122,7 @@ void MasterController::AddDebugOut(AbstrDebugOut* debugOut) {
     m_DebugOut.AddDebugOut(debugOut);
 
     debugOut->Other(_func_, "Connected to this debug out");
+    AbstrDebugOut::SetFrontEnd(DebugOut());
   } else {
     m_DebugOut.Warning(_func_,
                        "New debug is a NULL pointer, ignoring it.");
@@ -126,6 +132,7 @@ void MasterController::AddDebugOut(AbstrDebugOut* debugOut) {
 
 void MasterController::RemoveDebugOut(AbstrDebugOut* debugOut) {
   m_DebugOut.RemoveDebugOut(debugOut);
+  AbstrDebugOut::SetFrontEnd(DebugOut());
 }
 
 /// Access the currently-active debug stream.
@@ -304,14 +311,30 @@ unsigned MasterController::GetHTSize() const {
 
 double MasterController::PerfQuery(enum PerfCounter pc) {
   assert(pc < PERF_END);
-  double tmp = m_Perf[pc];
-  m_Perf[pc] = 0.0;
+  const double total = PerfCounters::Instance().Total(pc).sum;
+  const double tmp = total - m_PerfQueryBase[pc];
+  m_PerfQueryBase[pc] = total;
   return tmp;
 }
 void MasterController::IncrementPerfCounter(enum PerfCounter pc,
                                             double amount) {
   assert(pc < PERF_END);
-  m_Perf[pc] += amount;
+  PerfCounters::Instance().Add(pc, amount);
+}
+PerfCounterStats MasterController::PerfStats(enum PerfCounter pc) const {
+  assert(pc < PERF_END);
+  return PerfCounters::Instance().Total(pc);
+}
+PerfCounterStats MasterController::PerfFrameStats(enum PerfCounter pc) const {
+  assert(pc < PERF_END);
+  return PerfCounters::Instance().LastFrame(pc);
+}
+void MasterController::EndPerfFrame() {
+  PerfCounters::Instance().EndFrame();
+}
+void MasterController::ResetPerfCounters() {
+  PerfCounters::Instance().Reset();
+  std::fill(m_PerfQueryBase, m_PerfQueryBase+PERF_END, 0.0);
 }
 
 void MasterController::SetMaxGPUMem(uint64_t megs) {
@@ -502,6 +525,33 @@ void MasterController::RegisterLuaCommands() {
     &MasterController::PerfQuery, "tuvok.perf",
     "queries performance information.  meaning is query-specific.", false
   );
+  m_pMemReg->registerFunction(this,
+    &MasterController::PerfStats, "tuvok.perfStats",
+    "returns {count, sum, min, max, mean, p50, p95, histogram} of a counter "
+    "since startup.", false
+  );
+  m_pMemReg->registerFunction(this,
+    &MasterController::PerfFrameStats, "tuvok.perfFrameStats",
+    "like tuvok.perfStats, but only for the last completed frame.", false
+  );
+  m_pMemReg->registerFunction(this,
+    &MasterController::ResetPerfCounters, "tuvok.perfReset",
+    "clears all performance counters.", false
+  );
+
+  Tracer* tracer = &Tracer::Instance();
+  m_pMemReg->registerFunction(tracer, &Tracer::SetEnabled,
+    "tuvok.trace.enable", "starts/stops recording the timeline trace.", false);
+  m_pMemReg->registerFunction(tracer, &Tracer::Clear,
+    "tuvok.trace.clear", "drops all recorded trace events.", false);
+  m_pMemReg->registerFunction(tracer, &Tracer::SetCapacity,
+    "tuvok.trace.setCapacity", "sets the number of events the trace ring "
+    "holds; drops all recorded events.", false);
+  m_pMemReg->registerFunction(tracer, &Tracer::GetEventCount,
+    "tuvok.trace.eventCount", "number of events in the trace ring.", false);
+  m_pMemReg->registerFunction(tracer, &Tracer::WriteChromeTrace,
+    "tuvok.trace.dump", "writes the trace to the given file in Chrome's "
+    "trace event format (load it in chrome://tracing).", false);
   ss->registerFunction(&SysTools::basename, "basename",
                        "basename for the given filename", false);
   ss->registerFunction(&SysTools::dirname, "dirname",
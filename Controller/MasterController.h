@@ -39,6 +39,7 @@
 
 #include "Basics/PerfCounter.h"
 #include "Basics/Vectors.h"
+#include "PerfCounters.h"
 #include "../DebugOut/MultiplexOut.h"
 #include "../DebugOut/ConsoleOut.h"
 
@@ -181,9 +182,19 @@ public:
   ///@}
 
   /// Performance query interface.  Each id is a separate performance metric.
-  /// @warning Querying a metric resets it!
+  /// Returns the sum accumulated since the previous PerfQuery of that id.
+  /// The values themselves live in PerfCounters; use PerfStats for
+  /// count/min/max and histograms.
   double PerfQuery(enum PerfCounter);
   void IncrementPerfCounter(enum PerfCounter, double amount);
+  /// Statistics since startup or the last ResetPerfCounters.
+  PerfCounterStats PerfStats(enum PerfCounter) const;
+  /// Statistics of the last completed frame, see EndPerfFrame.
+  PerfCounterStats PerfFrameStats(enum PerfCounter) const;
+  /// Closes the current per-frame window; renderers call this after Paint.
+  void EndPerfFrame();
+  /// Clears all counters; PerfQuery starts over from 0 as well.
+  void ResetPerfCounters();
 
 private:
   /// Initializer; add all our builtin commands.
@@ -229,8 +240,8 @@ private:
   // The active renderer should point into a member of the renderer list.
   AbstrRenderer*   m_pActiveRenderer;
 
-  /// for PerfCounter tracking.
-  double m_Perf[PERF_END];
+  /// PerfCounters sum at the last PerfQuery, per counter.
+  double m_PerfQueryBase[PERF_END];
 };
 
 }
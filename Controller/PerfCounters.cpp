@@ -0,0 +1,215 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include "PerfCounters.h"
+
+namespace tuvok {
+
+PerfCounters                PerfCounters::s_Instance;
+TUVOK_THREAD_LOCAL unsigned PerfCounters::s_iThreadShard = 0;
+std::atomic<unsigned>       PerfCounters::s_iNextShard(0);
+
+static const double fInf = std::numeric_limits<double>::infinity();
+
+PerfCounterStats::PerfCounterStats() : count(0), sum(0.0), min(0.0), max(0.0)
+{
+  std::fill(histogram, histogram+HISTOGRAM_BUCKETS, 0);
+}
+
+size_t PerfCounterStats::Bucket(double value) {
+  if(!(value > 0.0)) { return 0; } // also catches NaN
+  int exponent;
+  std::frexp(value, &exponent); // value = m * 2^exponent, m in [0.5, 1)
+  const int bucket = exponent - HISTOGRAM_MIN_EXPONENT;
+  if(bucket < 0) { return 0; }
+  return std::min(static_cast<size_t>(bucket),
+                  static_cast<size_t>(HISTOGRAM_BUCKETS-1));
+}
+
+double PerfCounterStats::BucketUpperBound(size_t bucket) {
+  if(bucket >= HISTOGRAM_BUCKETS-1) { return fInf; }
+  return std::ldexp(1.0, static_cast<int>(bucket) + HISTOGRAM_MIN_EXPONENT);
+}
+
+double PerfCounterStats::Percentile(double p) const {
+  if(count == 0) { return 0.0; }
+  p = std::max(0.0, std::min(1.0, p));
+  const uint64_t rank = std::max<uint64_t>(1,
+    static_cast<uint64_t>(std::ceil(p * double(count))));
+  uint64_t seen = 0;
+  for(size_t b=0; b < HISTOGRAM_BUCKETS; ++b) {
+    seen += histogram[b];
+    if(seen >= rank) {
+      return std::max(min, std::min(max, BucketUpperBound(b)));
+    }
+  }
+  return max;
+}
+
+// std::atomic<double> has no fetch_add; shards are rarely contended, so the
+// loops below almost always succeed on the first try.
+static void AtomicAdd(std::atomic<double>& a, double value) {
+  double cur = a.load(std::memory_order_relaxed);
+  while(!a.compare_exchange_weak(cur, cur+value, std::memory_order_relaxed)) {}
+}
+static void AtomicMin(std::atomic<double>& a, double value) {
+  double cur = a.load(std::memory_order_relaxed);
+  while(value < cur &&
+        !a.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+}
+static void AtomicMax(std::atomic<double>& a, double value) {
+  double cur = a.load(std::memory_order_relaxed);
+  while(value > cur &&
+        !a.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+}
+
+void PerfCounters::Accumulator::Add(double value) {
+  count.fetch_add(1, std::memory_order_relaxed);
+  AtomicAdd(sum, value);
+  AtomicMin(min, value);
+  AtomicMax(max, value);
+  histogram[PerfCounterStats::Bucket(value)].fetch_add(
+    1, std::memory_order_relaxed
+  );
+}
+
+void PerfCounters::Accumulator::Clear() {
+  count.store(0, std::memory_order_relaxed);
+  sum.store(0.0, std::memory_order_relaxed);
+  min.store(fInf, std::memory_order_relaxed);
+  max.store(-fInf, std::memory_order_relaxed);
+  for(size_t b=0; b < PerfCounterStats::HISTOGRAM_BUCKETS; ++b) {
+    histogram[b].store(0, std::memory_order_relaxed);
+  }
+}
+
+void PerfCounters::Accumulator::MergeInto(PerfCounterStats& stats,
+                                          bool withMinMax) const {
+  stats.count += count.load(std::memory_order_relaxed);
+  stats.sum += sum.load(std::memory_order_relaxed);
+  if(withMinMax) {
+    stats.min = std::min(stats.min, min.load(std::memory_order_relaxed));
+    stats.max = std::max(stats.max, max.load(std::memory_order_relaxed));
+  }
+  for(size_t b=0; b < PerfCounterStats::HISTOGRAM_BUCKETS; ++b) {
+    stats.histogram[b] += histogram[b].load(std::memory_order_relaxed);
+  }
+}
+
+PerfCounters::PerfCounters() : m_iFrameCount(0) {
+  std::fill(m_ClosedMin, m_ClosedMin+PERF_END, fInf);
+  std::fill(m_ClosedMax, m_ClosedMax+PERF_END, -fInf);
+}
+
+unsigned PerfCounters::AssignShard() {
+  return s_iNextShard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS + 1;
+}
+
+PerfCounterStats PerfCounters::Merge(enum PerfCounter pc,
+                                     bool withMinMax) const {
+  PerfCounterStats stats;
+  stats.min = fInf;
+  stats.max = -fInf;
+  for(size_t s=0; s < NUM_SHARDS; ++s) {
+    m_Shards[s].counters[pc].MergeInto(stats, withMinMax);
+  }
+  return stats;
+}
+
+PerfCounterStats PerfCounters::Total(enum PerfCounter pc) const {
+  assert(pc < PERF_END);
+  PerfCounterStats stats = Merge(pc, true);
+  {
+    SCOPEDLOCK(m_FrameLock);
+    stats.min = std::min(stats.min, m_ClosedMin[pc]);
+    stats.max = std::max(stats.max, m_ClosedMax[pc]);
+  }
+  if(stats.count == 0) { stats.min = stats.max = 0.0; }
+  return stats;
+}
+
+PerfCounterStats PerfCounters::LastFrame(enum PerfCounter pc) const {
+  assert(pc < PERF_END);
+  SCOPEDLOCK(m_FrameLock);
+  return m_LastFrame[pc];
+}
+
+void PerfCounters::EndFrame() {
+  SCOPEDLOCK(m_FrameLock);
+  for(size_t pc=0; pc < PERF_END; ++pc) {
+    // Swap out the running frame's min/max first: a value added in between
+    // is then attributed to the next frame, not lost.
+    double fMin = fInf, fMax = -fInf;
+    for(size_t s=0; s < NUM_SHARDS; ++s) {
+      Accumulator& acc = m_Shards[s].counters[pc];
+      fMin = std::min(fMin, acc.min.exchange(fInf, std::memory_order_relaxed));
+      fMax = std::max(fMax, acc.max.exchange(-fInf, std::memory_order_relaxed));
+    }
+    const PerfCounterStats now = Merge(static_cast<enum PerfCounter>(pc),
+                                       false);
+    const PerfCounterStats& start = m_FrameStart[pc];
+
+    PerfCounterStats& frame = m_LastFrame[pc];
+    frame.count = now.count - start.count;
+    frame.sum = now.sum - start.sum;
+    for(size_t b=0; b < PerfCounterStats::HISTOGRAM_BUCKETS; ++b) {
+      frame.histogram[b] = now.histogram[b] - start.histogram[b];
+    }
+    frame.min = frame.count ? fMin : 0.0;
+    frame.max = frame.count ? fMax : 0.0;
+
+    m_FrameStart[pc] = now;
+    m_ClosedMin[pc] = std::min(m_ClosedMin[pc], fMin);
+    m_ClosedMax[pc] = std::max(m_ClosedMax[pc], fMax);
+  }
+  ++m_iFrameCount;
+}
+
+uint64_t PerfCounters::GetFrameCount() const {
+  SCOPEDLOCK(m_FrameLock);
+  return m_iFrameCount;
+}
+
+void PerfCounters::Reset() {
+  SCOPEDLOCK(m_FrameLock);
+  for(size_t s=0; s < NUM_SHARDS; ++s) {
+    for(size_t pc=0; pc < PERF_END; ++pc) {
+      m_Shards[s].counters[pc].Clear();
+    }
+  }
+  std::fill(m_FrameStart, m_FrameStart+PERF_END, PerfCounterStats());
+  std::fill(m_LastFrame, m_LastFrame+PERF_END, PerfCounterStats());
+  std::fill(m_ClosedMin, m_ClosedMin+PERF_END, fInf);
+  std::fill(m_ClosedMax, m_ClosedMax+PERF_END, -fInf);
+  m_iFrameCount = 0;
+}
+
+}
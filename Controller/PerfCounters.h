@@ -0,0 +1,165 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_PERFCOUNTERS_H
+#define TUVOK_PERFCOUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "Basics/PerfCounter.h"
+#include "Basics/Threads.h"
+
+#ifndef TUVOK_THREAD_LOCAL
+# ifdef _MSC_VER
+#  define TUVOK_THREAD_LOCAL __declspec(thread)
+# else
+#  define TUVOK_THREAD_LOCAL __thread
+# endif
+#endif
+
+namespace tuvok {
+
+/// Aggregated values of one performance counter.
+struct PerfCounterStats {
+  enum {
+    HISTOGRAM_BUCKETS = 48,
+    /// Bucket i>0 holds values in [2^(i-1+MIN_EXPONENT), 2^(i+MIN_EXPONENT)),
+    /// bucket 0 everything smaller, the last bucket everything larger.
+    HISTOGRAM_MIN_EXPONENT = -10
+  };
+
+  PerfCounterStats();
+
+  uint64_t count;
+  double   sum;
+  double   min;    ///< 0 if count is 0
+  double   max;    ///< 0 if count is 0
+  uint64_t histogram[HISTOGRAM_BUCKETS];
+
+  double Mean() const { return count ? sum / double(count) : 0.0; }
+  /// Approximates the p-th percentile (p in [0,1]) from the histogram; the
+  /// result is the upper bound of the bucket the percentile falls into,
+  /// clamped to [min, max].
+  double Percentile(double p) const;
+
+  static size_t Bucket(double value);
+  static double BucketUpperBound(size_t bucket);
+};
+
+/// Process wide store of the PerfCounter values.
+///
+/// Add() is lock free: every thread writes to one of NUM_SHARDS cache line
+/// aligned shards of relaxed atomics, so the render thread, the
+/// AsyncVisibilityUpdater and IO threads rarely touch the same lines.
+/// Readers merge the shards.
+///
+/// Count, sum and histogram only ever grow. EndFrame() remembers them, so
+/// LastFrame() can report the values of a single frame as a difference; the
+/// min/max of the running frame are swapped out at the same time.
+class PerfCounters {
+public:
+  enum { NUM_SHARDS = 8 };
+
+  PerfCounters();
+
+  static PerfCounters& Instance() { return s_Instance; }
+
+  void Add(enum PerfCounter pc, double value) {
+    m_Shards[ShardIndex()].counters[pc].Add(value);
+  }
+
+  /// Values since construction / the last Reset().
+  PerfCounterStats Total(enum PerfCounter pc) const;
+  /// Values between the last two EndFrame() calls.
+  PerfCounterStats LastFrame(enum PerfCounter pc) const;
+
+  /// Closes the current frame window.
+  void EndFrame();
+  uint64_t GetFrameCount() const;
+
+  /// Clears all counters.  Values added concurrently may be lost.
+  void Reset();
+
+private:
+  PerfCounters(const PerfCounters&);            ///< unimplemented
+  PerfCounters& operator=(const PerfCounters&); ///< unimplemented
+
+  struct Accumulator {
+    Accumulator() { Clear(); }
+    void Add(double value);
+    void Clear();
+    /// Adds this accumulator's current values to 'stats'; min/max are only
+    /// considered if 'withMinMax' is set.
+    void MergeInto(PerfCounterStats& stats, bool withMinMax) const;
+
+    std::atomic<uint64_t> count;
+    std::atomic<double>   sum;
+    std::atomic<double>   min;
+    std::atomic<double>   max;
+    std::atomic<uint64_t> histogram[PerfCounterStats::HISTOGRAM_BUCKETS];
+  };
+
+  /// Aligned (and thereby padded) to a cache line, so neighbouring shards
+  /// never share one.
+  struct alignas(64) Shard {
+    Accumulator counters[PERF_END];
+  };
+
+  /// Shard of the calling thread, assigned round robin on first use.
+  static size_t ShardIndex() {
+    if(s_iThreadShard == 0) { s_iThreadShard = AssignShard(); }
+    return s_iThreadShard - 1;
+  }
+  static unsigned AssignShard();
+
+  /// Merges all shards; min/max of the running frame are only merged if
+  /// requested.
+  PerfCounterStats Merge(enum PerfCounter pc, bool withMinMax) const;
+
+  Shard m_Shards[NUM_SHARDS];
+
+  mutable CriticalSection m_FrameLock;
+  uint64_t                m_iFrameCount;
+  /// Cumulative count/sum/histogram at the last EndFrame() ...
+  PerfCounterStats        m_FrameStart[PERF_END];
+  /// ... the previous frame's values ...
+  PerfCounterStats        m_LastFrame[PERF_END];
+  /// ... and min/max over all closed frames.
+  double                  m_ClosedMin[PERF_END];
+  double                  m_ClosedMax[PERF_END];
+
+  static PerfCounters                s_Instance;
+  static TUVOK_THREAD_LOCAL unsigned s_iThreadShard;  ///< shard+1, 0=none
+  static std::atomic<unsigned>       s_iNextShard;
+};
+
+}
+#endif // TUVOK_PERFCOUNTERS_H
@@ -0,0 +1,264 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include "Tracer.h"
+
+namespace tuvok {
+
+// must be initialized before s_Instance, which is defined below
+static const std::chrono::steady_clock::time_point tEpoch =
+  std::chrono::steady_clock::now();
+
+Tracer                      Tracer::s_Instance;
+TUVOK_THREAD_LOCAL uint32_t Tracer::s_iThreadID = 0;
+std::atomic<uint32_t>       Tracer::s_iNextThreadID(1);
+
+Tracer::Ring::Ring(size_t iCapacity) : events(new Event[iCapacity]),
+  mask(iCapacity-1)
+{
+  for(size_t i=0; i < iCapacity; ++i) {
+    events[i].seq.store(0, std::memory_order_relaxed);
+  }
+}
+
+Tracer::Tracer() : m_bEnabled(false), m_pRing(NULL), m_iNext(0),
+  m_iWriters(0)
+{
+  m_ThreadNames[GPU_THREAD_ID] = "GPU";
+}
+
+Tracer::~Tracer() {
+  m_bEnabled = false;
+  m_pRing = NULL;
+}
+
+uint64_t Tracer::Now() {
+  // +1: TraceScope uses 0 for "not started"
+  return 1 + std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - tEpoch
+  ).count();
+}
+
+uint32_t Tracer::ThreadID() {
+  if(s_iThreadID == 0) {
+    s_iThreadID = s_iNextThreadID.fetch_add(1, std::memory_order_relaxed);
+  }
+  return s_iThreadID;
+}
+
+void Tracer::SetEnabled(bool bEnabled) {
+  if(bEnabled && m_pRing.load() == NULL) {
+    SetCapacity(DEFAULT_CAPACITY);
+  }
+  m_bEnabled = bEnabled;
+}
+
+void Tracer::SetCapacity(size_t iEvents) {
+  size_t iCapacity = 1;
+  while(iCapacity < iEvents) { iCapacity <<= 1; }
+
+  SCOPEDLOCK(m_Lock);
+  std::unique_ptr<Ring> pOld(m_pOwnedRing.release());
+  m_pOwnedRing.reset(new Ring(iCapacity));
+  m_iNext = 0;
+  m_pRing = m_pOwnedRing.get();
+
+  // A writer increments m_iWriters before it loads the ring.  Both are
+  // sequentially consistent, so a writer we do not see here will load the
+  // new ring; the ones we see finish within a few stores.
+  while(m_iWriters.load() != 0) {
+    std::this_thread::yield();
+  }
+}
+
+size_t Tracer::GetCapacity() const {
+  SCOPEDLOCK(m_Lock);
+  const Ring* ring = m_pRing.load();
+  return ring ? static_cast<size_t>(ring->mask + 1) : 0;
+}
+
+size_t Tracer::GetEventCount() const {
+  const uint64_t iNext = m_iNext.load();
+  const size_t iCapacity = GetCapacity();
+  return iNext < iCapacity ? static_cast<size_t>(iNext) : iCapacity;
+}
+
+void Tracer::Clear() {
+  SCOPEDLOCK(m_Lock);
+  m_iNext = 0;
+  Ring* ring = m_pRing.load();
+  if(ring == NULL) { return; }
+  for(uint64_t i=0; i <= ring->mask; ++i) {
+    ring->events[i].seq.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Tracer::SetThreadName(const std::string& name) {
+  SetThreadName(ThreadID(), name);
+}
+
+void Tracer::SetThreadName(uint32_t tid, const std::string& name) {
+  SCOPEDLOCK(m_Lock);
+  m_ThreadNames[tid] = name;
+}
+
+void Tracer::Record(char phase, const char* category, const char* name,
+                    uint64_t ts, uint64_t dur, const char* argName,
+                    int64_t argValue, uint32_t tid) {
+  if(!Enabled()) { return; }
+  // announce ourselves before loading the ring, and load the ring before
+  // claiming a slot; see SetCapacity.
+  m_iWriters.fetch_add(1);
+  Ring* ring = m_pRing.load();
+  if(ring == NULL) {
+    m_iWriters.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+  const uint64_t idx = m_iNext.fetch_add(1, std::memory_order_relaxed);
+  Event& e = ring->events[idx & ring->mask];
+
+  e.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.category = category;
+  e.name = name;
+  e.argName = argName;
+  e.argValue = argValue;
+  e.ts = ts;
+  e.dur = dur;
+  e.tid = tid;
+  e.phase = phase;
+  e.seq.store(idx+1, std::memory_order_release);
+  m_iWriters.fetch_sub(1, std::memory_order_release);
+}
+
+void Tracer::Complete(const char* category, const char* name,
+                      uint64_t iStartNs, uint64_t iDurationNs,
+                      const char* argName, int64_t argValue, uint32_t tid) {
+  Record('X', category, name, iStartNs, iDurationNs, argName, argValue, tid);
+}
+
+void Tracer::Begin(const char* category, const char* name) {
+  Record('B', category, name, Now(), 0, NULL, 0, ThreadID());
+}
+
+void Tracer::End(const char* category, const char* name) {
+  Record('E', category, name, Now(), 0, NULL, 0, ThreadID());
+}
+
+void Tracer::FrameMarker(uint64_t iFrame) {
+  Record('i', "frame", "Frame", Now(), 0, "frame",
+         static_cast<int64_t>(iFrame), ThreadID());
+}
+
+void Tracer::Counter(const char* category, const char* name, int64_t value) {
+  Record('C', category, name, Now(), 0, name, value, ThreadID());
+}
+
+static std::string JSONEscape(const char* str) {
+  std::string out;
+  if(str == NULL) { return out; }
+  for(; *str; ++str) {
+    const unsigned char c = static_cast<unsigned char>(*str);
+    if(c == '"' || c == '\\') {
+      out += '\\';
+      out += *str;
+    } else if(c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += *str;
+    }
+  }
+  return out;
+}
+
+bool Tracer::WriteChromeTrace(const std::string& filename) const {
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::trunc);
+  if(!out.is_open()) { return false; }
+
+  SCOPEDLOCK(m_Lock);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool bFirst = true;
+  char buf[64];
+
+  for(std::map<uint32_t, std::string>::const_iterator t =
+      m_ThreadNames.begin(); t != m_ThreadNames.end(); ++t) {
+    out << (bFirst ? "" : ",\n")
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << t->first << ",\"args\":{\"name\":\""
+        << JSONEscape(t->second.c_str()) << "\"}}";
+    bFirst = false;
+  }
+
+  const Ring* ring = m_pRing.load(std::memory_order_acquire);
+  const uint64_t iNext = m_iNext.load(std::memory_order_acquire);
+  const uint64_t iFirst = (ring && iNext > ring->mask+1) ?
+                          iNext - (ring->mask+1) : 0;
+  for(uint64_t i = iFirst; ring && i < iNext; ++i) {
+    const Event& e = ring->events[i & ring->mask];
+    // copy the event out and verify no writer touched it meanwhile
+    const uint64_t seq = e.seq.load(std::memory_order_acquire);
+    if(seq != i+1) { continue; }
+    const char* category = e.category;
+    const char* name = e.name;
+    const char* argName = e.argName;
+    const int64_t argValue = e.argValue;
+    const uint64_t ts = e.ts;
+    const uint64_t dur = e.dur;
+    const uint32_t tid = e.tid;
+    const char phase = e.phase;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(e.seq.load(std::memory_order_relaxed) != seq) { continue; }
+
+    out << (bFirst ? "" : ",\n");
+    bFirst = false;
+    snprintf(buf, sizeof(buf), "%.3f", ts / 1000.0);
+    out << "{\"name\":\"" << JSONEscape(name) << "\",\"cat\":\""
+        << JSONEscape(category) << "\",\"ph\":\"" << phase
+        << "\",\"ts\":" << buf << ",\"pid\":1,\"tid\":" << tid;
+    if(phase == 'X') {
+      snprintf(buf, sizeof(buf), "%.3f", dur / 1000.0);
+      out << ",\"dur\":" << buf;
+    } else if(phase == 'i') {
+      out << ",\"s\":\"g\"";
+    }
+    if(argName) {
+      out << ",\"args\":{\"" << JSONEscape(argName) << "\":" << argValue
+          << "}";
+    }
+    out << "}";
+  }
+  out << "\n]}\n";
+  return !out.fail();
+}
+
+}
@@ -0,0 +1,195 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#ifndef TUVOK_TRACER_H
+#define TUVOK_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Basics/Threads.h"
+
+#ifndef TUVOK_THREAD_LOCAL
+# ifdef _MSC_VER
+#  define TUVOK_THREAD_LOCAL __declspec(thread)
+# else
+#  define TUVOK_THREAD_LOCAL __thread
+# endif
+#endif
+
+namespace tuvok {
+
+/// Timeline tracing.  Events go into a fixed size in-memory ring (the oldest
+/// events are overwritten) and can be written out in the Chrome trace event
+/// format, viewable in chrome://tracing.
+///
+/// While tracing is disabled every trace point costs one relaxed atomic
+/// load.  When enabled, recording an event is a fetch_add on the ring
+/// position, one on the count of writers in flight and a few stores; there
+/// is no locking.
+///
+/// Names and categories are stored as pointers and must be string literals
+/// (or otherwise outlive the trace).
+class Tracer {
+public:
+  enum { DEFAULT_CAPACITY = 1 << 16 };
+  /// Thread id used for spans measured on the GPU, see GLGPUTracer.
+  enum { GPU_THREAD_ID = 1000 };
+
+  Tracer();
+  ~Tracer();
+
+  static Tracer& Instance() { return s_Instance; }
+  static bool Enabled() {
+    return s_Instance.m_bEnabled.load(std::memory_order_relaxed);
+  }
+
+  void SetEnabled(bool bEnabled);
+  /// Resizes the ring (rounded up to a power of two) and drops all events.
+  /// Waits for writers still storing into the old ring, then frees it.
+  void SetCapacity(size_t iEvents);
+  size_t GetCapacity() const;
+  /// Number of events in the ring, at most the capacity.
+  size_t GetEventCount() const;
+  void Clear();
+
+  /// Nanoseconds since the tracer was created.
+  static uint64_t Now();
+  /// Small, stable id of the calling thread.
+  static uint32_t ThreadID();
+  /// Names the calling thread in the trace.
+  void SetThreadName(const std::string& name);
+  void SetThreadName(uint32_t tid, const std::string& name);
+
+  /// A span that started at iStartNs and lasted iDurationNs.  If argName is
+  /// not NULL the span carries the integer argument 'argValue'.
+  void Complete(const char* category, const char* name, uint64_t iStartNs,
+                uint64_t iDurationNs, const char* argName=NULL,
+                int64_t argValue=0, uint32_t tid=ThreadID());
+  /// Unpaired begin/end events for spans that do not fit a scope.  They
+  /// must be issued by the same thread.
+  void Begin(const char* category, const char* name);
+  void End(const char* category, const char* name);
+  /// Marks the end of frame 'iFrame' across all threads.
+  void FrameMarker(uint64_t iFrame);
+  /// A value plotted as a counter track.
+  void Counter(const char* category, const char* name, int64_t value);
+
+  /// Writes all events in the ring to 'filename' as Chrome trace JSON.
+  bool WriteChromeTrace(const std::string& filename) const;
+
+private:
+  Tracer(const Tracer&);            ///< unimplemented
+  Tracer& operator=(const Tracer&); ///< unimplemented
+
+  struct Event {
+    /// Ring position+1 of the event stored here, 0 while it is written.
+    std::atomic<uint64_t> seq;
+    const char* category;
+    const char* name;
+    const char* argName;
+    int64_t     argValue;
+    uint64_t    ts;
+    uint64_t    dur;
+    uint32_t    tid;
+    char        phase;
+  };
+  struct Ring {
+    explicit Ring(size_t iCapacity);
+    std::unique_ptr<Event[]> events;
+    uint64_t                 mask;
+  };
+
+  void Record(char phase, const char* category, const char* name,
+              uint64_t ts, uint64_t dur, const char* argName,
+              int64_t argValue, uint32_t tid);
+
+  std::atomic<bool>     m_bEnabled;
+  std::atomic<Ring*>    m_pRing;
+  std::atomic<uint64_t> m_iNext;
+  /// Number of Record() calls that might hold a pointer to a ring.  A
+  /// replaced ring is freed once this drops to 0.
+  std::atomic<uint32_t> m_iWriters;
+  std::unique_ptr<Ring> m_pOwnedRing;  ///< m_pRing
+
+  mutable CriticalSection            m_Lock;  ///< ring, thread names
+  std::map<uint32_t, std::string>    m_ThreadNames;
+
+  static Tracer                      s_Instance;
+  static TUVOK_THREAD_LOCAL uint32_t s_iThreadID;  ///< 0 = not assigned
+  static std::atomic<uint32_t>       s_iNextThreadID;
+};
+
+/// Records the enclosing scope as a span.  For example:
+///
+///   void GLVolumePool::UploadBricks(...) {
+///     TraceScope trace("paging", "UploadBricks");
+///     ...
+///   }
+class TraceScope {
+public:
+  TraceScope(const char* category, const char* name)
+    : m_category(category), m_name(name), m_argName(NULL), m_argValue(0),
+      m_iStart(Tracer::Enabled() ? Tracer::Now() : 0) {}
+  ~TraceScope() {
+    if(m_iStart != 0 && Tracer::Enabled()) {
+      Tracer::Instance().Complete(m_category, m_name, m_iStart,
+                                  Tracer::Now() - m_iStart,
+                                  m_argName, m_argValue);
+    }
+  }
+  /// Attaches an integer argument, e.g. the number of bricks handled.
+  void SetArg(const char* name, int64_t value) {
+    m_argName = name; m_argValue = value;
+  }
+
+private:
+  TraceScope(const TraceScope&);            ///< unimplemented
+  TraceScope& operator=(const TraceScope&); ///< unimplemented
+
+  const char* m_category;
+  const char* m_name;
+  const char* m_argName;
+  int64_t     m_argValue;
+  uint64_t    m_iStart;
+};
+
+}
+
+#define TUVOK_TRACE_CONCAT_(a, b) a##b
+#define TUVOK_TRACE_CONCAT(a, b) TUVOK_TRACE_CONCAT_(a, b)
+/// Shorthand for an anonymous TraceScope.
+#define TUVOK_TRACE(category, name) \
+  tuvok::TraceScope TUVOK_TRACE_CONCAT(_trace_scope_, __LINE__)(category, name)
+
+#endif // TUVOK_TRACER_H
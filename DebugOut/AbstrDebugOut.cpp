@@ -39,6 +39,11 @@
 #include <cstring>
 #include "AbstrDebugOut.h"
 
+AbstrDebugOut* AbstrDebugOut::s_pFrontEnd = NULL;
+std::atomic<uint32_t> AbstrDebugOut::s_iChannelMask(~0u);
+std::array<std::atomic<uint64_t>, AbstrDebugOut::CHANNEL_FINAL>
+  AbstrDebugOut::s_iSuppressed;
+
 const char *AbstrDebugOut::ChannelToString(enum DebugChannel c) const
 {
   switch(c) {
@@ -80,6 +85,7 @@ void AbstrDebugOut::Other(const char *source, const char* format, ...)
   va_end(args);
 
   this->printf(CHANNEL_OTHER, source, buff);
+  Record(CHANNEL_OTHER, source, buff);
 }
 
 void AbstrDebugOut::Message(const char* source, const char* format, ...)
@@ -97,6 +103,7 @@ void AbstrDebugOut::Message(const char* source, const char* format, ...)
   va_end(args);
 
   this->printf(CHANNEL_MESSAGE, source, buff);
+  Record(CHANNEL_MESSAGE, source, buff);
 }
 void AbstrDebugOut::Warning(const char* source, const char* format, ...)
 {
@@ -113,6 +120,7 @@ void AbstrDebugOut::Warning(const char* source, const char* format, ...)
   va_end(args);
 
   this->printf(CHANNEL_WARNING, source, buff);
+  Record(CHANNEL_WARNING, source, buff);
 }
 void AbstrDebugOut::Error(const char* source, const char* format, ...)
 {
@@ -129,35 +137,35 @@ void AbstrDebugOut::Error(const char* source, const char* format, ...)
   va_end(args);
 
   this->printf(CHANNEL_ERROR, source, buff);
+  Record(CHANNEL_ERROR, source, buff);
+}
+
+namespace {
+  // prints the message of each visited record
+  struct PrintRecord {
+    explicit PrintRecord(const AbstrDebugOut* pOut) : m_pOut(pOut) {}
+    void operator()(const DebugRecordStore::Record& r) const {
+      m_pOut->printf(r.message.c_str());
+    }
+    const AbstrDebugOut* m_pOut;
+  };
 }
 
 void AbstrDebugOut::PrintErrorList() {
   printf( "Printing recorded errors:" );
-  for (std::deque<std::string>::const_iterator i =
-         m_strLists[CHANNEL_ERROR].begin();
-       i != m_strLists[CHANNEL_ERROR].end(); ++i) {
-    printf( i->c_str() );
-  }
+  m_pRecords->ForEachRecord(CHANNEL_ERROR, PrintRecord(this));
   printf( "end of recorded errors" );
 }
 
 void AbstrDebugOut::PrintWarningList() {
   printf( "Printing recorded errors:" );
-  for (std::deque<std::string>::const_iterator i =
-         m_strLists[CHANNEL_WARNING].begin();
-       i != m_strLists[CHANNEL_WARNING].end(); ++i) {
-    printf( i->c_str() );
-  }
+  m_pRecords->ForEachRecord(CHANNEL_WARNING, PrintRecord(this));
   printf( "end of recorded errors" );
 }
 
 void AbstrDebugOut::PrintMessageList() {
   printf( "Printing recorded errors:" );
-  for (std::deque<std::string>::const_iterator i =
-         m_strLists[CHANNEL_MESSAGE].begin();
-       i != m_strLists[CHANNEL_MESSAGE].end(); ++i) {
-    printf( i->c_str() );
-  }
+  m_pRecords->ForEachRecord(CHANNEL_MESSAGE, PrintRecord(this));
   printf( "end of recorded errors" );
 }
 
@@ -185,18 +193,41 @@ void AbstrDebugOut::GetOutput(bool& bShowErrors,
 
 void AbstrDebugOut::SetShowMessages(bool bShowMessages) {
   m_bShowMessages = bShowMessages;
+  UpdateChannelMask();
 }
 
 void AbstrDebugOut::SetShowWarnings(bool bShowWarnings) {
   m_bShowWarnings = bShowWarnings;
+  UpdateChannelMask();
 }
 
 void AbstrDebugOut::SetShowErrors(bool bShowErrors) {
   m_bShowErrors = bShowErrors;
+  UpdateChannelMask();
 }
 
 void AbstrDebugOut::SetShowOther(bool bShowOther) {
   m_bShowOther = bShowOther;
+  UpdateChannelMask();
+}
+
+void AbstrDebugOut::SetFrontEnd(AbstrDebugOut* pFrontEnd) {
+  s_pFrontEnd = pFrontEnd;
+  if (pFrontEnd) {
+    pFrontEnd->UpdateChannelMask();
+  } else {
+    s_iChannelMask.store(~0u, std::memory_order_relaxed);
+  }
+}
+
+void AbstrDebugOut::UpdateChannelMask() const {
+  if (s_pFrontEnd != this) return;
+
+  uint32_t iMask = 0;
+  for (int i = 0; i < CHANNEL_FINAL; ++i) {
+    if (Enabled(DebugChannel(i))) iMask |= 1u << i;
+  }
+  s_iChannelMask.store(iMask, std::memory_order_relaxed);
 }
 
 
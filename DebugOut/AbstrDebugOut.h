@@ -43,9 +43,11 @@
 
 #include "../StdTuvokDefines.h"
 #include <array>
+#include <atomic>
 #include <cstdarg>
-#include <deque>
+#include <memory>
 #include <string>
+#include "DebugRecordStore.h"
 
 class AbstrDebugOut {
   public:
@@ -57,17 +59,13 @@ class AbstrDebugOut {
         m_bShowWarnings(false),
 #endif
         m_bShowErrors(true),
-        m_bShowOther(false)
+        m_bShowOther(false),
+        m_pRecords(new DebugRecordStore(CHANNEL_FINAL))
     {
-      for(size_t i=0; i < m_bRecordLists.size(); ++i) {
-        m_bRecordLists[i] = false;
-      }
     }
 
     virtual ~AbstrDebugOut() {
-      for(size_t i=0; i < m_bRecordLists.size(); ++i) {
-        m_bRecordLists[i] = false;
-      }
+      if (s_pFrontEnd == this) SetFrontEnd(NULL);
     }
     enum DebugChannel {
       CHANNEL_NONE=0,
@@ -92,16 +90,24 @@ class AbstrDebugOut {
     void PrintWarningList();
     void PrintMessageList();
 
-    virtual void ClearErrorList()   { m_strLists[CHANNEL_ERROR].clear(); }
-    virtual void ClearWarningList() { m_strLists[CHANNEL_WARNING].clear(); }
-    virtual void ClearMessageList() { m_strLists[CHANNEL_MESSAGE].clear(); }
-
-    virtual void SetListRecordingErrors(bool bRecord)   {m_bRecordLists[0] = bRecord;}
-    virtual void SetListRecordingWarnings(bool bRecord) {m_bRecordLists[1] = bRecord;}
-    virtual void SetListRecordingMessages(bool bRecord) {m_bRecordLists[2] = bRecord;}
-    virtual bool GetListRecordingErrors()   {return m_bRecordLists[0];}
-    virtual bool GetListRecordingWarnings() {return m_bRecordLists[1];}
-    virtual bool GetListRecordingMessages() {return m_bRecordLists[2];}
+    virtual void ClearErrorList()   { m_pRecords->Clear(CHANNEL_ERROR); }
+    virtual void ClearWarningList() { m_pRecords->Clear(CHANNEL_WARNING); }
+    virtual void ClearMessageList() { m_pRecords->Clear(CHANNEL_MESSAGE); }
+
+    virtual void SetListRecordingErrors(bool bRecord)   {m_pRecords->SetRecording(CHANNEL_ERROR, bRecord);}
+    virtual void SetListRecordingWarnings(bool bRecord) {m_pRecords->SetRecording(CHANNEL_WARNING, bRecord);}
+    virtual void SetListRecordingMessages(bool bRecord) {m_pRecords->SetRecording(CHANNEL_MESSAGE, bRecord);}
+    virtual bool GetListRecordingErrors()   {return m_pRecords->IsRecording(CHANNEL_ERROR);}
+    virtual bool GetListRecordingWarnings() {return m_pRecords->IsRecording(CHANNEL_WARNING);}
+    virtual bool GetListRecordingMessages() {return m_pRecords->IsRecording(CHANNEL_MESSAGE);}
+
+    /// Recorded messages, visit a channel with GetRecords().ForEachRecord().
+    const DebugRecordStore& GetRecords() const {return *m_pRecords;}
+    DebugRecordStore& GetRecords() {return *m_pRecords;}
+    /// Records into the given store from now on; used to share one store.
+    void SetRecordStore(std::shared_ptr<DebugRecordStore> pRecords) {
+      m_pRecords = pRecords;
+    }
 
     void SetOutput(bool bShowErrors, bool bShowWarnings, bool bShowMessages,
                    bool bShowOther);
@@ -118,16 +124,55 @@ class AbstrDebugOut {
     virtual void SetShowErrors(bool bShowErrors);
     virtual void SetShowOther(bool bShowOther);
 
+    /// The logging macros (T_ERROR, WARNING, MESSAGE, OTHER) check this
+    /// mask before they evaluate their arguments. It mirrors the channels
+    /// enabled in the front end, the debug out the macros write to; without
+    /// a front end all channels pass.
+    /// @{
+    static bool ChannelEnabled(enum DebugChannel channel) {
+      return (s_iChannelMask.load(std::memory_order_relaxed) &
+              (1u << channel)) != 0;
+    }
+    static void SetFrontEnd(AbstrDebugOut* pFrontEnd);
+    /// @}
+
+    /// Counts messages the logging macros skipped because their channel was
+    /// disabled at runtime; channels compiled out with TUVOK_LOG_LEVEL are
+    /// not counted.  Cheap rather than exact: concurrent increments from
+    /// several threads may get lost.
+    static void CountSuppressed(enum DebugChannel channel) {
+      s_iSuppressed[channel].store(
+        s_iSuppressed[channel].load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    }
+    static uint64_t GetSuppressedCount(enum DebugChannel channel) {
+      return s_iSuppressed[channel].load(std::memory_order_relaxed);
+    }
+
 protected:
     bool                      m_bShowMessages;
     bool                      m_bShowWarnings;
     bool                      m_bShowErrors;
     bool                      m_bShowOther;
 
-    std::array<bool, CHANNEL_FINAL> m_bRecordLists;
-    std::array<std::deque<std::string>, CHANNEL_FINAL> m_strLists;
+    std::shared_ptr<DebugRecordStore> m_pRecords;
 
     void ReplaceSpecialChars(char* buff, size_t iSize) const;
+
+    /// Adds the message to the recorded list of its channel, if enabled.
+    void Record(enum DebugChannel channel, const char* source,
+                const char* msg) {
+      m_pRecords->Append(channel, source, msg);
+    }
+
+    /// Recomputes the channel mask if this is the front end; needs to be
+    /// called whenever the m_bShow* flags change.
+    void UpdateChannelMask() const;
+
+private:
+    static AbstrDebugOut* s_pFrontEnd;
+    static std::atomic<uint32_t> s_iChannelMask;
+    static std::array<std::atomic<uint64_t>, CHANNEL_FINAL> s_iSuppressed;
 };
 
 #endif // TUVOK_ABSTRDEBUGOUT_H
@@ -0,0 +1,138 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    DebugRecordStore.cpp
+*/
+
+#include <algorithm>
+#include "DebugRecordStore.h"
+
+DebugRecordStore::DebugRecordStore(size_t iChannels, size_t iCapacity) :
+  m_iChannels(iChannels),
+  m_pRings(new Ring[iChannels])
+{
+  for (size_t i = 0; i < m_iChannels; ++i) {
+    m_pRings[i].iCapacity = iCapacity;
+  }
+}
+
+void DebugRecordStore::Append(size_t iChannel, const char* source,
+                              const char* msg)
+{
+  Ring& r = m_pRings[iChannel];
+  // most channels are not recorded, don't lock for those
+  if (!r.bRecording.load(std::memory_order_relaxed)) return;
+
+  SCOPEDLOCK(r.guard);
+  if (!r.bRecording || r.iCapacity == 0) return;
+
+  Record* pRecord;
+  if (r.iSize < r.vRecords.size()) {
+    pRecord = &r.vRecords[(r.iFirst + r.iSize) % r.vRecords.size()];
+    ++r.iSize;
+  } else if (r.vRecords.size() < r.iCapacity) {
+    // still filling up, the ring starts at index 0 until then
+    r.vRecords.push_back(Record());
+    pRecord = &r.vRecords.back();
+    ++r.iSize;
+  } else {
+    // full, overwrite the oldest record
+    pRecord = &r.vRecords[r.iFirst];
+    r.iFirst = (r.iFirst + 1) % r.vRecords.size();
+  }
+
+  pRecord->source = Intern(r, source);
+  pRecord->message = msg;
+}
+
+void DebugRecordStore::SetRecording(size_t iChannel, bool bRecord)
+{
+  m_pRings[iChannel].bRecording = bRecord;
+}
+
+bool DebugRecordStore::IsRecording(size_t iChannel) const
+{
+  return m_pRings[iChannel].bRecording;
+}
+
+void DebugRecordStore::Clear(size_t iChannel)
+{
+  Ring& r = m_pRings[iChannel];
+  SCOPEDLOCK(r.guard);
+  // keep the records around, their strings are reused
+  r.iFirst = 0;
+  r.iSize = 0;
+}
+
+void DebugRecordStore::SetCapacity(size_t iChannel, size_t iCapacity)
+{
+  Ring& r = m_pRings[iChannel];
+  SCOPEDLOCK(r.guard);
+
+  // unroll the ring, keeping the newest records
+  std::vector<Record> vRecords;
+  const size_t iKeep = std::min(r.iSize, iCapacity);
+  vRecords.reserve(iKeep);
+  for (size_t i = r.iSize - iKeep; i < r.iSize; ++i) {
+    vRecords.push_back(r.vRecords[(r.iFirst + i) % r.vRecords.size()]);
+  }
+
+  r.vRecords.swap(vRecords);
+  r.iFirst = 0;
+  r.iSize = iKeep;
+  r.iCapacity = iCapacity;
+}
+
+size_t DebugRecordStore::GetCapacity(size_t iChannel) const
+{
+  const Ring& r = m_pRings[iChannel];
+  SCOPEDLOCK(r.guard);
+  return r.iCapacity;
+}
+
+size_t DebugRecordStore::Size(size_t iChannel) const
+{
+  const Ring& r = m_pRings[iChannel];
+  SCOPEDLOCK(r.guard);
+  return r.iSize;
+}
+
+// called with the ring's guard held
+const std::string* DebugRecordStore::Intern(Ring& r, const char* source)
+{
+  if (!source) source = "";
+  // consecutive messages often come from the same function
+  if (r.pLastSource && *r.pLastSource == source) return r.pLastSource;
+
+  // sources are function names, so the set stays small; elements of an
+  // unordered_set keep their address when it rehashes
+  SCOPEDLOCK(m_SourceGuard);
+  r.pLastSource = &*m_Sources.insert(std::string(source)).first;
+  return r.pLastSource;
+}
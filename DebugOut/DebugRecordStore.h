@@ -0,0 +1,115 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    DebugRecordStore.h
+  \brief   Bounded storage for the messages a debug out records.
+*/
+
+#pragma once
+
+#ifndef TUVOK_DEBUGRECORDSTORE_H
+#define TUVOK_DEBUGRECORDSTORE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Basics/Threads.h"
+
+/// Keeps the most recent messages of each channel in a fixed size ring, so
+/// recording for a log window cannot grow without bounds over long sessions.
+/// Sources are interned, the ring only stores a pointer to them, and message
+/// strings are reused once the ring wraps around.
+///
+/// MultiplexOut shares its store with all its outputs, so a message is
+/// recorded once no matter how many outputs are attached.
+///
+/// Messages arrive from the render thread, IO threads and other workers.
+/// Each channel has its own lock, and a message for a channel that is not
+/// recorded is dropped without locking at all.  Readers visit a channel in
+/// place with ForEachRecord.
+class DebugRecordStore {
+  public:
+    struct Record {
+      const std::string* source;  ///< interned, valid as long as the store
+      std::string        message;
+    };
+
+    /// \param iChannels  number of channels, channel indices are [0,iChannels)
+    /// \param iCapacity  records kept per channel
+    DebugRecordStore(size_t iChannels, size_t iCapacity=4096);
+
+    /// Stores the message if recording is enabled for the channel; the
+    /// oldest record is overwritten once the channel is full.
+    void Append(size_t iChannel, const char* source, const char* msg);
+
+    void SetRecording(size_t iChannel, bool bRecord);
+    bool IsRecording(size_t iChannel) const;
+
+    void Clear(size_t iChannel);
+    /// Changes the number of kept records, dropping the oldest ones.
+    void SetCapacity(size_t iChannel, size_t iCapacity);
+    size_t GetCapacity(size_t iChannel) const;
+    size_t Size(size_t iChannel) const;
+
+    /// Calls fn(const Record&) for the records of one channel, oldest
+    /// first.  The channel stays locked meanwhile, so fn must not log to it.
+    template<typename Fn> void ForEachRecord(size_t iChannel, Fn fn) const {
+      const Ring& r = m_pRings[iChannel];
+      SCOPEDLOCK(r.guard);
+      for (size_t i = 0; i < r.iSize; ++i) {
+        fn(r.vRecords[(r.iFirst + i) % r.vRecords.size()]);
+      }
+    }
+
+  private:
+    struct Ring {
+      Ring() : iFirst(0), iSize(0), iCapacity(0), bRecording(false),
+               pLastSource(NULL) {}
+
+      mutable tuvok::CriticalSection guard;  ///< everything below
+      std::vector<Record> vRecords;
+      size_t              iFirst;    ///< index of the oldest record
+      size_t              iSize;
+      size_t              iCapacity;
+      std::atomic<bool>   bRecording; ///< also read without the lock
+      const std::string*  pLastSource;
+    };
+
+    const std::string* Intern(Ring& r, const char* source);
+
+    const size_t                    m_iChannels;
+    std::unique_ptr<Ring[]>         m_pRings;
+
+    tuvok::CriticalSection          m_SourceGuard;  ///< m_Sources
+    std::unordered_set<std::string> m_Sources;
+};
+
+#endif // TUVOK_DEBUGRECORDSTORE_H
@@ -63,6 +63,15 @@ MultiplexOut::~MultiplexOut() {
 
 void MultiplexOut::AddDebugOut(AbstrDebugOut* pDebugger) {
   m_vpDebugger.push_back(pDebugger);
+
+  // Messages reach the outputs through our Message() & co., which record
+  // them once; the outputs see the same records.
+  for (size_t c = 0; c < CHANNEL_FINAL; ++c) {
+    if (pDebugger->GetRecords().IsRecording(c)) {
+      m_pRecords->SetRecording(c, true);
+    }
+  }
+  pDebugger->SetRecordStore(m_pRecords);
   pDebugger->Other(_func_,"Operating as part of a multiplexed debug out now.");
 
   // Find the maximal set of channels to enable.
@@ -70,6 +79,7 @@ void MultiplexOut::AddDebugOut(AbstrDebugOut* pDebugger) {
   m_bShowWarnings |= pDebugger->ShowWarnings();
   m_bShowErrors |= pDebugger->ShowErrors();
   m_bShowOther |= pDebugger->ShowOther();
+  UpdateChannelMask();
 }
 
 void MultiplexOut::RemoveDebugOut(AbstrDebugOut* pDebugger) {
@@ -81,6 +91,16 @@ void MultiplexOut::RemoveDebugOut(AbstrDebugOut* pDebugger) {
     delete *del;
     m_vpDebugger.erase(del);
   }
+
+  // the channels the remaining outputs still want
+  m_bShowMessages = m_bShowWarnings = m_bShowErrors = m_bShowOther = false;
+  for (size_t i = 0;i<m_vpDebugger.size();i++) {
+    m_bShowMessages |= m_vpDebugger[i]->ShowMessages();
+    m_bShowWarnings |= m_vpDebugger[i]->ShowWarnings();
+    m_bShowErrors |= m_vpDebugger[i]->ShowErrors();
+    m_bShowOther |= m_vpDebugger[i]->ShowOther();
+  }
+  UpdateChannelMask();
 }
 
 
@@ -34,49 +34,241 @@
   \date    August 2008
 */
 
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <stdarg.h>
+#include <vector>
 #ifdef WIN32
   #include <windows.h>
 #endif
 #include "TextfileOut.h"
+#include "Basics/Threads.h"
 #include <ctime>
 
 using namespace std;
+using namespace tuvok;
 
-TextfileOut::TextfileOut(std::string strFilename) :
+namespace {
+  /// Formats the local time of epoch_time, returns false on failure.
+  bool FormatTime(time_t epoch_time, char* datetime, size_t iSize) {
+#ifdef DETECTED_OS_WINDOWS
+    struct tm now;
+    if (localtime_s(&now, &epoch_time) != 0) return false;
+    return strftime(datetime, iSize, "(%d.%m.%Y %H:%M:%S)", &now) > 0;
+#else
+    struct tm now;
+    if (localtime_r(&epoch_time, &now) == NULL) return false;
+    return strftime(datetime, iSize, "(%d.%m.%Y %H:%M:%S)", &now) > 0;
+#endif
+  }
+
+  const size_t   iBufferCapacity = 1024*1024;
+  const uint32_t iDefaultFlushInterval = 250; // ms
+}
+
+/// State of the buffered mode. Writers append complete lines to m_Pending,
+/// the thread swaps it with m_Writing and writes that out, so neither side
+/// waits on the other for longer than a swap.
+class TextfileOut::Buffer : public ThreadClass {
+  public:
+    Buffer(const std::string& strFilename) :
+      m_strFilename(strFilename),
+      m_pFile(NULL),
+      m_iFileSize(0),
+      m_iRotationSize(0),
+      m_iFlushInterval(iDefaultFlushInterval),
+      m_iDropped(0),
+      m_iReportedDrops(0),
+      m_LastTime(0)
+    {
+      m_Pending.reserve(iBufferCapacity);
+      m_Writing.reserve(iBufferCapacity);
+      m_strTime[0] = 0;
+      Open();
+      StartThread();
+    }
+
+    ~Buffer() {
+      {
+        SCOPEDLOCK(m_BufferGuard);
+        RequestThreadStop();
+        m_Wakeup.WakeOne();
+      }
+      JoinThread();
+      Flush();
+      if (m_pFile) fclose(m_pFile);
+    }
+
+    /// Appends one line, prefixed with the time stamp, and drops it if the
+    /// buffer is full.
+    void Append(const char* channel, const char* source, const char* msg) {
+      time_t epoch_time;
+      time(&epoch_time);
+
+      SCOPEDLOCK(m_BufferGuard);
+      // the time stamp only changes once per second
+      if (epoch_time != m_LastTime) {
+        if (!FormatTime(epoch_time, m_strTime, sizeof(m_strTime)))
+          m_strTime[0] = 0;
+        m_LastTime = epoch_time;
+      }
+
+      const size_t iTime = strlen(m_strTime);
+      const size_t iChannel = channel ? strlen(channel) : 0;
+      const size_t iSource = source ? strlen(source) : 0;
+      const size_t iMsg = strlen(msg);
+      // "time channel (source) msg\n"
+      const size_t iLength = iTime + 1 + (channel ? iChannel + 1 : 0) +
+                             (source ? iSource + 3 : 0) + iMsg + 1;
+      if (m_Pending.size() + iLength > iBufferCapacity) {
+        ++m_iDropped;
+        return;
+      }
+
+      if (iTime) {
+        m_Pending.insert(m_Pending.end(), m_strTime, m_strTime + iTime);
+        m_Pending.push_back(' ');
+      }
+      if (channel) {
+        m_Pending.insert(m_Pending.end(), channel, channel + iChannel);
+        m_Pending.push_back(' ');
+      }
+      if (source) {
+        m_Pending.push_back('(');
+        m_Pending.insert(m_Pending.end(), source, source + iSource);
+        m_Pending.push_back(')');
+        m_Pending.push_back(' ');
+      }
+      m_Pending.insert(m_Pending.end(), msg, msg + iMsg);
+      m_Pending.push_back('\n');
+
+      // do not wait for the interval if the buffer is filling up
+      if (m_Pending.size() > iBufferCapacity / 2) m_Wakeup.WakeOne();
+    }
+
+    /// Writes everything appended so far to the file.
+    void Flush() {
+      SCOPEDLOCK(m_FileGuard);
+      uint64_t iDropped;
+      {
+        SCOPEDLOCK(m_BufferGuard);
+        m_Pending.swap(m_Writing);
+        iDropped = m_iDropped;
+      }
+
+      if (m_pFile) {
+        if (iDropped != m_iReportedDrops) {
+          int iWritten = fprintf(m_pFile,
+                                 "(%llu log messages dropped, buffer full)\n",
+                                 (unsigned long long)(iDropped -
+                                                      m_iReportedDrops));
+          if (iWritten > 0) m_iFileSize += uint64_t(iWritten);
+          m_iReportedDrops = iDropped;
+        }
+        if (!m_Writing.empty()) {
+          m_iFileSize += fwrite(&m_Writing[0], 1, m_Writing.size(), m_pFile);
+        }
+        fflush(m_pFile);
+        if (m_iRotationSize && m_iFileSize > m_iRotationSize) Rotate();
+      }
+      m_Writing.clear();
+    }
+
+    void SetFlushInterval(uint32_t iMilliseconds) {
+      SCOPEDLOCK(m_BufferGuard);
+      m_iFlushInterval = iMilliseconds;
+      m_Wakeup.WakeOne();
+    }
+    void SetRotationSize(uint64_t iBytes) {
+      SCOPEDLOCK(m_FileGuard);
+      m_iRotationSize = iBytes;
+    }
+    uint64_t GetDropped() {
+      SCOPEDLOCK(m_BufferGuard);
+      return m_iDropped;
+    }
+
+  protected:
+    virtual void ThreadMain(void*) {
+      while (m_bContinue) {
+        {
+          SCOPEDLOCK(m_BufferGuard);
+          // checked under the lock, the destructor's wake up is not lost
+          if (m_bContinue) m_Wakeup.Wait(m_BufferGuard, m_iFlushInterval);
+        }
+        Flush();
+      }
+    }
+
+  private:
+    void Open() {
+      m_pFile = fopen(m_strFilename.c_str(), "a");
+      if (!m_pFile) return;
+      fseek(m_pFile, 0, SEEK_END);
+      long iSize = ftell(m_pFile);
+      m_iFileSize = iSize > 0 ? uint64_t(iSize) : 0;
+    }
+
+    void Rotate() {
+      fclose(m_pFile);
+      const std::string strOld = m_strFilename + ".1";
+      remove(strOld.c_str());
+      rename(m_strFilename.c_str(), strOld.c_str());
+      Open();
+    }
+
+    std::string       m_strFilename;
+    /// guards m_pFile, m_Writing and the rotation state
+    CriticalSection   m_FileGuard;
+    FILE*             m_pFile;
+    uint64_t          m_iFileSize;
+    uint64_t          m_iRotationSize;
+    std::vector<char> m_Writing;
+
+    /// guards everything below
+    CriticalSection   m_BufferGuard;
+    WaitCondition     m_Wakeup;
+    uint32_t          m_iFlushInterval;
+    std::vector<char> m_Pending;
+    uint64_t          m_iDropped;
+    uint64_t          m_iReportedDrops;
+    time_t            m_LastTime;
+    char              m_strTime[64];
+};
+
+TextfileOut::TextfileOut(std::string strFilename, bool bBuffered) :
   m_strFilename(strFilename)
 {
+  if (bBuffered) m_pBuffer.reset(new Buffer(m_strFilename));
   this->Message(_func_, "Starting up");
 }
 
 TextfileOut::~TextfileOut() {
   this->Message(_func_, "Shutting down\n");
+  // joins the writer thread and flushes what is left
+  m_pBuffer.reset();
 }
 
 void TextfileOut::printf(enum DebugChannel channel, const char* source,
                          const char* buff)
 {
+  if (m_pBuffer) {
+    m_pBuffer->Append(ChannelToString(channel), source, buff);
+    // make sure errors are on disk, the program might not survive them
+    if (channel == CHANNEL_ERROR) m_pBuffer->Flush();
+    return;
+  }
+
   time_t epoch_time;
   time(&epoch_time);
-
-#undef ADDR_NOW
-#ifdef DETECTED_OS_WINDOWS
-  struct tm now;
-  localtime_s(&now, &epoch_time);
-#define ADDR_NOW (&now)
-#else
-  struct tm* now;
-  now = localtime(&epoch_time);
-#define ADDR_NOW (now)
-#endif
   char datetime[64];
 
   ofstream fs;
   fs.open(m_strFilename.c_str(), ios_base::app);
   if (fs.fail()) return;
 
-  if(strftime(datetime, 64, "(%d.%m.%Y %H:%M:%S)", ADDR_NOW) > 0) {
+  if(FormatTime(epoch_time, datetime, 64)) {
     fs << datetime << " ";
   }
   fs << ChannelToString(channel) << " (" << source << ") " << buff << std::endl;
@@ -87,26 +279,20 @@ void TextfileOut::printf(enum DebugChannel channel, const char* source,
 
 void TextfileOut::printf(const char *s) const
 {
+  if (m_pBuffer) {
+    m_pBuffer->Append(NULL, NULL, s);
+    return;
+  }
+
   time_t epoch_time;
   time(&epoch_time);
-
-#undef ADDR_NOW
-#ifdef DETECTED_OS_WINDOWS
-  struct tm now;
-  localtime_s(&now, &epoch_time);
-#define ADDR_NOW (&now)
-#else
-  struct tm* now;
-  now = localtime(&epoch_time);
-#define ADDR_NOW (now)
-#endif
   char datetime[64];
 
   ofstream fs;
   fs.open(m_strFilename.c_str(), ios_base::app);
   if (fs.fail()) return;
 
-  if(strftime(datetime, 64, "(%d.%m.%Y %H:%M:%S)", ADDR_NOW) > 0) {
+  if(FormatTime(epoch_time, datetime, 64)) {
     fs << datetime << " " << s << std::endl;
   } else {
     fs << s << std::endl;
@@ -115,3 +301,23 @@ void TextfileOut::printf(const char *s) const
   fs.flush();
   fs.close();
 }
+
+void TextfileOut::Flush() const
+{
+  if (m_pBuffer) m_pBuffer->Flush();
+}
+
+void TextfileOut::SetFlushInterval(uint32_t iMilliseconds)
+{
+  if (m_pBuffer) m_pBuffer->SetFlushInterval(iMilliseconds);
+}
+
+void TextfileOut::SetRotationSize(uint64_t iBytes)
+{
+  if (m_pBuffer) m_pBuffer->SetRotationSize(iBytes);
+}
+
+uint64_t TextfileOut::GetDroppedMessages() const
+{
+  return m_pBuffer ? m_pBuffer->GetDropped() : 0;
+}
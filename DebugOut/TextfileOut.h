@@ -41,12 +41,17 @@
 #ifndef TUVOK_TEXTFILEOUT_H
 #define TUVOK_TEXTFILEOUT_H
 
+#include <memory>
 #include <string>
 #include "AbstrDebugOut.h"
 
 class TextfileOut : public AbstrDebugOut {
   public:
-    TextfileOut(std::string strFilename="logfile.txt");
+    /// In buffered mode the file is kept open and messages are collected in
+    /// a bounded buffer which a background thread writes out every flush
+    /// interval. Otherwise every message opens, appends to and closes the
+    /// file.
+    TextfileOut(std::string strFilename="logfile.txt", bool bBuffered=false);
     ~TextfileOut();
     virtual void printf(enum DebugChannel, const char* source,
                         const char* msg);
@@ -54,12 +59,27 @@ class TextfileOut : public AbstrDebugOut {
 
     const std::string& GetFileName() const {return m_strFilename;}
 
+    bool IsBuffered() const {return m_pBuffer.get() != NULL;}
+    /// Writes all buffered messages to the file; errors do this implicitly.
+    void Flush() const;
+    /// Maximum time messages stay in the buffer, buffered mode only.
+    void SetFlushInterval(uint32_t iMilliseconds);
+    /// Once the file grows beyond iBytes it is renamed to <filename>.1
+    /// (replacing an older one) and a new file is started. 0 disables
+    /// rotation. Buffered mode only.
+    void SetRotationSize(uint64_t iBytes);
+    /// Messages lost because the buffer was full.
+    uint64_t GetDroppedMessages() const;
+
   private:
     TextfileOut(const TextfileOut &); ///< unimplemented.
 
   private:
     std::string m_strFilename;
 
+    class Buffer;
+    std::unique_ptr<Buffer> m_pBuffer;
+
     /// same as printf above but does regard m_bShowOther
     void _printf(const char* format, ...) const;
 };
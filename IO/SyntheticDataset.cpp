@@ -0,0 +1,837 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    SyntheticDataset.cpp
+  \brief   A bricked, multi resolution data set that is generated on the fly.
+*/
+#include "StdTuvokDefines.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include "Controller/Controller.h"
+#include "SyntheticDataset.h"
+
+namespace tuvok {
+
+namespace {
+  const char* const patternNames[SyntheticDataset::SP_END] = {
+    "noise", "shells", "ml", "blobs"
+  };
+  const double pi = 3.141592653589793238462643383;
+  /// samples per axis when bounding a brick are picked so that all bricks
+  /// of a timestep take about this many evaluations, within [5,17]
+  const double fBoundBudget = double(1 << 22);
+  const uint32_t iMinBoundSamples = 5;
+  const uint32_t iMaxBoundSamples = 17;
+  /// bins of the gradient axis of the 2D histogram
+  const size_t iGradientBins = 256;
+  const uint32_t iNoiseOctaves = 4;
+  const double fNoiseFrequency = 4.0;
+  const double fShellFrequency = 8.0;
+  /// max. |w'(s)| of the blob falloff w(s) = (1-s^2)^2, at s = 1/sqrt(3)
+  const double fBlobSlope = 8.0 / (3.0 * std::sqrt(3.0));
+
+  // integer hash with good avalanche; the data must not depend on the
+  // platform's <random>.
+  uint32_t hash(uint32_t a) {
+    a ^= a >> 16; a *= 0x7feb352dU;
+    a ^= a >> 15; a *= 0x846ca68bU;
+    a ^= a >> 16;
+    return a;
+  }
+  uint32_t hash(uint32_t x, uint32_t y, uint32_t z, uint32_t seed) {
+    return hash(x ^ hash(y ^ hash(z ^ hash(seed))));
+  }
+  /// maps a hash to [0,1)
+  double unit(uint32_t h) { return h / 4294967296.0; }
+
+  double smooth(double t) { return t*t*(3.0 - 2.0*t); }
+
+  /// trilinearly interpolated lattice noise in [0,1]
+  double value_noise(const DOUBLEVECTOR3& p, uint32_t seed) {
+    const double fx = std::floor(p.x), fy = std::floor(p.y),
+                 fz = std::floor(p.z);
+    const uint32_t ix = static_cast<uint32_t>(static_cast<int64_t>(fx));
+    const uint32_t iy = static_cast<uint32_t>(static_cast<int64_t>(fy));
+    const uint32_t iz = static_cast<uint32_t>(static_cast<int64_t>(fz));
+    const double tx = smooth(p.x-fx), ty = smooth(p.y-fy),
+                 tz = smooth(p.z-fz);
+    double v[2][2];
+    for(uint32_t k=0; k < 2; ++k) {
+      for(uint32_t j=0; j < 2; ++j) {
+        const double a = unit(hash(ix,   iy+j, iz+k, seed));
+        const double b = unit(hash(ix+1, iy+j, iz+k, seed));
+        v[k][j] = a + tx*(b-a);
+      }
+    }
+    const double lo = v[0][0] + ty*(v[0][1]-v[0][0]);
+    const double hi = v[1][0] + ty*(v[1][1]-v[1][0]);
+    return lo + tz*(hi-lo);
+  }
+
+  bool parse_vector(const std::string& str, UINT64VECTOR3& v) {
+    std::istringstream in(str);
+    uint64_t c[3];
+    char x;
+    if(!(in >> c[0])) { return false; }
+    if(in.eof()) { v = UINT64VECTOR3(c[0], c[0], c[0]); return true; }
+    if(!(in >> x >> c[1] >> x >> c[2]) || !in.eof()) { return false; }
+    v = UINT64VECTOR3(c[0], c[1], c[2]);
+    return true;
+  }
+  template<typename T> bool parse_number(const std::string& str, T& value) {
+    std::istringstream in(str);
+    return (in >> value) && in.eof();
+  }
+}
+
+SyntheticDataset::Params::Params() :
+  ePattern(SP_NOISE),
+  vDomainSize(256, 256, 256),
+  vMaxBrickSize(128, 128, 128),
+  iOverlap(2),
+  iBitWidth(8),
+  iTimesteps(1),
+  fEmptyFraction(0.9),
+  iSeed(1)
+{}
+
+SyntheticDataset::SyntheticDataset(const Params& params) :
+  m_Params(params),
+  m_fMaxValue(0.0),
+  m_fLipschitz(0.0),
+  m_fMaxGradient(0.0),
+  m_iBricksPerTimestep(0)
+{
+  if(m_Params.iBitWidth != 8 && m_Params.iBitWidth != 16) {
+    WARNING("%u bit data not supported, generating 8 bit data",
+            m_Params.iBitWidth);
+    m_Params.iBitWidth = 8;
+  }
+  if(m_Params.ePattern >= SP_END) {
+    WARNING("Unknown pattern %d, generating noise",
+            static_cast<int>(m_Params.ePattern));
+    m_Params.ePattern = SP_NOISE;
+  }
+  for(size_t i=0; i < 3; ++i) {
+    m_Params.vDomainSize[i] = std::max<uint64_t>(m_Params.vDomainSize[i], 1);
+    if(m_Params.vMaxBrickSize[i] <= 2*m_Params.iOverlap) {
+      WARNING("Brick size %u leaves no room inside the overlap, using %u",
+              m_Params.vMaxBrickSize[i], 2*m_Params.iOverlap+1);
+      m_Params.vMaxBrickSize[i] = 2*m_Params.iOverlap+1;
+    }
+  }
+  m_Params.iTimesteps = std::max<uint64_t>(m_Params.iTimesteps, 1);
+  m_Params.fEmptyFraction = std::max(0.0, std::min(1.0,
+                                                   m_Params.fEmptyFraction));
+
+  // 16 bit data uses 12 significant bits, like most CT scans, which keeps
+  // the 1D transfer function at 4096 entries.
+  m_fMaxValue = m_Params.iBitWidth == 8 ? 255.0 : 4095.0;
+
+  switch(m_Params.ePattern) {
+    case SP_NOISE:
+      // |d/dx| of one octave is at most 1.5 (the slope of smoothstep) per
+      // lattice cell; octave o has 2^o the frequency at 0.5^o the weight.
+      m_fLipschitz = 1.5 * std::sqrt(3.0) * fNoiseFrequency * iNoiseOctaves /
+                     (2.0 - std::pow(0.5, double(iNoiseOctaves-1)));
+      break;
+    case SP_SHELLS: m_fLipschitz = pi * fShellFrequency; break;
+    case SP_MARSCHNER_LOBB:
+      // d/dz: pi/2 / 2.5, d/dr: 0.25 * 2pi*6 * pi/2 / 2.5; times 2 since
+      // the signal is defined on [-1,1]^3
+      m_fLipschitz = 2.0 * std::sqrt(std::pow(0.5*pi/2.5, 2.0) +
+                                     std::pow(0.25*12.0*pi*0.5*pi/2.5, 2.0));
+      break;
+    case SP_BLOBS:  // bounded analytically, see BoundBlobs
+    case SP_END: break;
+  }
+  m_fMaxGradient = m_fLipschitz * m_fMaxValue /
+                   double(m_Params.vDomainSize.minVal());
+
+  BuildHierarchy();
+  if(m_Params.ePattern == SP_BLOBS) { PlaceBlobs(); }
+  ComputeMinMax();
+  ComputeHistograms();
+
+  MESSAGE("Generated a %llux%llux%llu %s data set with %u LODs and %u "
+          "bricks per timestep",
+          static_cast<unsigned long long>(m_Params.vDomainSize.x),
+          static_cast<unsigned long long>(m_Params.vDomainSize.y),
+          static_cast<unsigned long long>(m_Params.vDomainSize.z),
+          patternNames[m_Params.ePattern],
+          static_cast<unsigned>(m_vDomainSizes.size()),
+          static_cast<unsigned>(m_iBricksPerTimestep));
+}
+
+SyntheticDataset::~SyntheticDataset() {}
+
+bool SyntheticDataset::ParseSpec(const std::string& spec, Params& params) {
+  std::vector<std::string> tokens;
+  std::istringstream in(spec);
+  for(std::string tok; std::getline(in, tok, ':'); ) {
+    tokens.push_back(tok);
+  }
+  if(!tokens.empty() && tokens[0] == "synthetic") {
+    tokens.erase(tokens.begin());
+  }
+  if(tokens.empty()) {
+    T_ERROR("Empty synthetic data set description");
+    return false;
+  }
+
+  size_t p = 0;
+  while(p < SP_END && tokens[0] != patternNames[p]) { ++p; }
+  if(p == SP_END) {
+    T_ERROR("Unknown pattern '%s'; use noise, shells, ml or blobs",
+            tokens[0].c_str());
+    return false;
+  }
+  params.ePattern = static_cast<Pattern>(p);
+
+  for(size_t i=1; i < tokens.size(); ++i) {
+    const size_t eq = tokens[i].find('=');
+    const std::string key = tokens[i].substr(0, eq);
+    const std::string value = eq == std::string::npos ?
+                              "" : tokens[i].substr(eq+1);
+    bool ok = false;
+    if(key == "size") {
+      ok = parse_vector(value, params.vDomainSize) &&
+           params.vDomainSize.x > 0 && params.vDomainSize.y > 0 &&
+           params.vDomainSize.z > 0;
+    } else if(key == "brick") {
+      UINT64VECTOR3 v;
+      ok = parse_vector(value, v) && v.maxVal() <= 65536;
+      if(ok) { params.vMaxBrickSize = UINTVECTOR3(v); }
+    } else if(key == "overlap") {
+      ok = parse_number(value, params.iOverlap);
+    } else if(key == "bits") {
+      ok = parse_number(value, params.iBitWidth) &&
+           (params.iBitWidth == 8 || params.iBitWidth == 16);
+    } else if(key == "timesteps") {
+      ok = parse_number(value, params.iTimesteps) && params.iTimesteps > 0;
+    } else if(key == "empty") {
+      ok = parse_number(value, params.fEmptyFraction) &&
+           params.fEmptyFraction >= 0.0 && params.fEmptyFraction <= 1.0;
+    } else if(key == "seed") {
+      ok = parse_number(value, params.iSeed);
+    } else {
+      T_ERROR("Unknown key '%s' in '%s'", key.c_str(), spec.c_str());
+      return false;
+    }
+    if(!ok) {
+      T_ERROR("Invalid value '%s' for '%s'", value.c_str(), key.c_str());
+      return false;
+    }
+  }
+
+  const uint32_t iMinBrick = params.vMaxBrickSize.minVal();
+  if(iMinBrick <= 2*params.iOverlap) {
+    T_ERROR("Brick size %u must exceed twice the overlap of %u", iMinBrick,
+            params.iOverlap);
+    return false;
+  }
+  return true;
+}
+
+std::string SyntheticDataset::ToSpec(const Params& params) {
+  std::ostringstream spec;
+  spec << (params.ePattern < SP_END ? patternNames[params.ePattern] : "?")
+       << ":size=" << params.vDomainSize.x << "x" << params.vDomainSize.y
+       << "x" << params.vDomainSize.z
+       << ":brick=" << params.vMaxBrickSize.x << "x"
+       << params.vMaxBrickSize.y << "x" << params.vMaxBrickSize.z
+       << ":overlap=" << params.iOverlap
+       << ":bits=" << params.iBitWidth
+       << ":timesteps=" << params.iTimesteps
+       << ":empty=" << params.fEmptyFraction
+       << ":seed=" << params.iSeed;
+  return spec.str();
+}
+
+void SyntheticDataset::BuildHierarchy() {
+  const uint32_t o = m_Params.iOverlap;
+  m_vInnerBrickSize = m_Params.vMaxBrickSize - UINTVECTOR3(2*o, 2*o, 2*o);
+
+  // halve the domain until it fits into a single brick, like UVF does
+  UINT64VECTOR3 vDomain = m_Params.vDomainSize;
+  size_t iOffset = 0;
+  for(;;) {
+    UINTVECTOR3 vLayout;
+    for(size_t i=0; i < 3; ++i) {
+      vLayout[i] = static_cast<uint32_t>(
+        (vDomain[i] + m_vInnerBrickSize[i] - 1) / m_vInnerBrickSize[i]
+      );
+    }
+    m_vDomainSizes.push_back(vDomain);
+    m_vLayouts.push_back(vLayout);
+    m_vLODOffsets.push_back(iOffset);
+    iOffset += UINT64VECTOR3(vLayout).volume();
+    if(vLayout.volume() == 1) { break; }
+    vDomain = UINT64VECTOR3((vDomain.x+1)/2, (vDomain.y+1)/2, (vDomain.z+1)/2);
+  }
+  m_iBricksPerTimestep = iOffset;
+
+  // the data set spans [-0.5,0.5] along its largest axis
+  const FLOATVECTOR3 vExtent = FLOATVECTOR3(m_Params.vDomainSize) /
+                               float(m_Params.vDomainSize.maxVal());
+  m_vMaxUsedBrickSize = UINTVECTOR3(0,0,0);
+  for(size_t ts=0; ts < m_Params.iTimesteps; ++ts) {
+    for(size_t lod=0; lod < m_vLayouts.size(); ++lod) {
+      const UINTVECTOR3& vLayout = m_vLayouts[lod];
+      const FLOATVECTOR3 vDomainF(m_vDomainSizes[lod]);
+      size_t index = 0;
+      for(uint32_t z=0; z < vLayout.z; ++z) {
+        for(uint32_t y=0; y < vLayout.y; ++y) {
+          for(uint32_t x=0; x < vLayout.x; ++x, ++index) {
+            UINT64VECTOR3 vStart;
+            UINTVECTOR3 vCount;
+            BrickVoxels(lod, UINTVECTOR3(x,y,z), vStart, vCount);
+
+            BrickMD md;
+            md.extents = FLOATVECTOR3(vCount) / vDomainF * vExtent;
+            md.center = ((FLOATVECTOR3(vStart) + FLOATVECTOR3(vCount)*0.5f) /
+                         vDomainF - FLOATVECTOR3(0.5f, 0.5f, 0.5f)) *
+                        vExtent;
+            md.n_voxels = vCount + UINTVECTOR3(2*o, 2*o, 2*o);
+            AddBrick(BrickKey(ts, lod, index), md);
+
+            for(size_t i=0; i < 3; ++i) {
+              m_vMaxUsedBrickSize[i] = std::max(m_vMaxUsedBrickSize[i],
+                                                md.n_voxels[i]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void SyntheticDataset::PlaceBlobs() {
+  const UINTVECTOR3& vLayout = m_vLayouts[0];
+  const size_t iBricks = UINT64VECTOR3(vLayout).volume();
+  const size_t iFilled = static_cast<size_t>(
+    (1.0 - m_Params.fEmptyFraction) * double(iBricks) + 0.5
+  );
+
+  // the first iFilled bricks in hash order get a blob
+  std::vector<std::pair<uint32_t, size_t>> order(iBricks);
+  for(size_t i=0; i < iBricks; ++i) {
+    order[i] = std::make_pair(hash(static_cast<uint32_t>(i), 0, 0,
+                                   m_Params.iSeed), i);
+  }
+  std::sort(order.begin(), order.end());
+
+  const uint32_t o = m_Params.iOverlap;
+  Blob none = { DOUBLEVECTOR3(0,0,0), 0.0, 0.0, 0.0 };
+  m_vBlobs.assign(iBricks, none);
+  double fMaxSlope = 0.0;
+  for(size_t n=0; n < iFilled; ++n) {
+    const size_t i = order[n].second;
+    const UINTVECTOR3 vBrick(static_cast<uint32_t>(i % vLayout.x),
+                             static_cast<uint32_t>((i / vLayout.x) %
+                                                   vLayout.y),
+                             static_cast<uint32_t>(i / (vLayout.x *
+                                                        vLayout.y)));
+    UINT64VECTOR3 vStart;
+    UINTVECTOR3 vCount;
+    BrickVoxels(0, vBrick, vStart, vCount);
+    // Keep the blob off the outer 'o' voxels: they are the neighbours'
+    // overlap, and those bricks must stay empty.
+    if(vCount.minVal() < 2*o + 4) { continue; }
+    const DOUBLEVECTOR3 vRoom(DOUBLEVECTOR3(vCount) -
+                              DOUBLEVECTOR3(2.0*o, 2.0*o, 2.0*o));
+    const uint32_t h = hash(vBrick.x, vBrick.y, vBrick.z, m_Params.iSeed);
+    Blob& blob = m_vBlobs[i];
+    blob.fRadius = 0.5 * vRoom.minVal() * (0.5 + 0.5*unit(hash(h)));
+    for(size_t a=0; a < 3; ++a) {
+      const double fSlack = vRoom[a] - 2.0*blob.fRadius;
+      blob.vCenter[a] = double(vStart[a]) + o + blob.fRadius +
+                        fSlack * unit(hash(h + 1 + uint32_t(a)));
+    }
+    blob.fAmplitude = 0.5 + 0.5*unit(hash(h + 4));
+    blob.fPhase = unit(hash(h + 5));
+    // the radius shrinks to 90% over time, see BlobValue
+    fMaxSlope = std::max(fMaxSlope, fBlobSlope * blob.fAmplitude /
+                                    (0.9 * blob.fRadius));
+  }
+  m_fMaxGradient = fMaxSlope * m_fMaxValue;
+}
+
+void SyntheticDataset::BrickVoxels(size_t iLoD, const UINTVECTOR3& vBrick,
+                                   UINT64VECTOR3& vStart,
+                                   UINTVECTOR3& vCount) const {
+  const UINT64VECTOR3& vDomain = m_vDomainSizes[iLoD];
+  for(size_t i=0; i < 3; ++i) {
+    vStart[i] = uint64_t(vBrick[i]) * m_vInnerBrickSize[i];
+    vCount[i] = static_cast<uint32_t>(
+      std::min<uint64_t>(m_vInnerBrickSize[i], vDomain[i] - vStart[i])
+    );
+  }
+}
+
+size_t SyntheticDataset::MinMaxIndex(const BrickKey& key) const {
+  return std::get<0>(key) * m_iBricksPerTimestep +
+         m_vLODOffsets[std::get<1>(key)] + std::get<2>(key);
+}
+
+double SyntheticDataset::BlobValue(const Blob& blob, double fDistance,
+                                   double t) const {
+  const double r = blob.fRadius *
+                   (0.9 + 0.1*std::sin(2.0*pi*(t + blob.fPhase)));
+  if(blob.fRadius == 0.0 || fDistance >= r) { return 0.0; }
+  const double s = fDistance / r;
+  return blob.fAmplitude * (1.0-s*s) * (1.0-s*s);
+}
+
+double SyntheticDataset::Evaluate(const DOUBLEVECTOR3& pos, double t) const {
+  switch(m_Params.ePattern) {
+    case SP_NOISE: {
+      DOUBLEVECTOR3 p = (pos + DOUBLEVECTOR3(0.0, 0.0, t)) * fNoiseFrequency;
+      double f = 0.0, fAmplitude = 1.0, fNorm = 0.0;
+      for(uint32_t o=0; o < iNoiseOctaves; ++o) {
+        f += fAmplitude * value_noise(p, m_Params.iSeed + o);
+        fNorm += fAmplitude;
+        fAmplitude *= 0.5;
+        p = p * 2.0;
+      }
+      return f / fNorm;
+    }
+    case SP_SHELLS: {
+      const double r = (pos - DOUBLEVECTOR3(0.5, 0.5, 0.5)).length();
+      return 0.5 + 0.5*std::cos(2.0*pi*(fShellFrequency*r - t));
+    }
+    case SP_MARSCHNER_LOBB: {
+      // Marschner and Lobb, "An Evaluation of Reconstruction Filters for
+      // Volume Rendering", 1994; f_M = 6, alpha = 0.25
+      const double alpha = 0.25;
+      const DOUBLEVECTOR3 p = pos*2.0 - DOUBLEVECTOR3(1.0, 1.0, 1.0);
+      const double r = std::sqrt(p.x*p.x + p.y*p.y);
+      const double rho = std::cos(2.0*pi*6.0*std::cos(pi*r/2.0));
+      return (1.0 - std::sin(pi*p.z/2.0 + 2.0*pi*t) + alpha*(1.0+rho)) /
+             (2.0*(1.0+alpha));
+    }
+    case SP_BLOBS: {
+      const DOUBLEVECTOR3 v = pos * DOUBLEVECTOR3(m_Params.vDomainSize);
+      const UINTVECTOR3& vLayout = m_vLayouts[0];
+      size_t c[3];
+      for(size_t a=0; a < 3; ++a) {
+        c[a] = std::min<size_t>(static_cast<size_t>(std::max(0.0, v[a])) /
+                                m_vInnerBrickSize[a], vLayout[a]-1);
+      }
+      const Blob& blob = m_vBlobs[c[0] + vLayout.x*(c[1] + vLayout.y*c[2])];
+      return BlobValue(blob, (v - blob.vCenter).length(), t);
+    }
+    case SP_END: break;
+  }
+  return 0.0;
+}
+
+void SyntheticDataset::BoundBlobs(const DOUBLEVECTOR3& vLo,
+                                  const DOUBLEVECTOR3& vHi, double t,
+                                  double& fMin, double& fMax) const {
+  const UINTVECTOR3& vLayout = m_vLayouts[0];
+  size_t lo[3], hi[3];
+  for(size_t a=0; a < 3; ++a) {
+    lo[a] = std::min<size_t>(static_cast<size_t>(std::max(0.0, vLo[a])) /
+                             m_vInnerBrickSize[a], vLayout[a]-1);
+    hi[a] = std::min<size_t>(static_cast<size_t>(std::max(0.0, vHi[a])) /
+                             m_vInnerBrickSize[a], vLayout[a]-1);
+  }
+
+  // each blob is confined to its brick, so only those of the touched
+  // bricks matter; the falloff is radial, so the closest/farthest point of
+  // the box gives the max./min.
+  fMin = 0.0;
+  fMax = 0.0;
+  for(size_t z=lo[2]; z <= hi[2]; ++z) {
+    for(size_t y=lo[1]; y <= hi[1]; ++y) {
+      for(size_t x=lo[0]; x <= hi[0]; ++x) {
+        const Blob& blob = m_vBlobs[x + vLayout.x*(y + vLayout.y*z)];
+        if(blob.fRadius == 0.0) { continue; }
+        DOUBLEVECTOR3 vNear, vFar;
+        for(size_t a=0; a < 3; ++a) {
+          vNear[a] = std::max(0.0, std::max(vLo[a] - blob.vCenter[a],
+                                            blob.vCenter[a] - vHi[a]));
+          vFar[a] = std::max(std::fabs(blob.vCenter[a] - vLo[a]),
+                             std::fabs(blob.vCenter[a] - vHi[a]));
+        }
+        fMax = std::max(fMax, BlobValue(blob, vNear.length(), t));
+        if(lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2]) {
+          fMin = BlobValue(blob, vFar.length(), t);
+        }
+      }
+    }
+  }
+}
+
+void SyntheticDataset::BoundBrick(size_t iLoD, const UINTVECTOR3& vBrick,
+                                  uint32_t iSamples, double t, double& fMin,
+                                  double& fMax) const {
+  UINT64VECTOR3 vStart;
+  UINTVECTOR3 vCount;
+  BrickVoxels(iLoD, vBrick, vStart, vCount);
+  const UINT64VECTOR3& vDomain = m_vDomainSizes[iLoD];
+  const int64_t o = m_Params.iOverlap;
+
+  // voxel centers of the brick and its overlap, clamped like in Generate
+  DOUBLEVECTOR3 vLo, vHi;
+  uint64_t iVoxels[3];
+  for(size_t a=0; a < 3; ++a) {
+    const int64_t lo = std::max<int64_t>(int64_t(vStart[a]) - o, 0);
+    const int64_t hi = std::min<int64_t>(int64_t(vStart[a] + vCount[a]) + o,
+                                         int64_t(vDomain[a])) - 1;
+    vLo[a] = (lo + 0.5) / double(vDomain[a]);
+    vHi[a] = (hi + 0.5) / double(vDomain[a]);
+    iVoxels[a] = uint64_t(hi - lo + 1);
+  }
+
+  if(m_Params.ePattern == SP_BLOBS) {
+    const DOUBLEVECTOR3 vScale(m_Params.vDomainSize);
+    BoundBlobs(vLo * vScale, vHi * vScale, t, fMin, fMax);
+    return;
+  }
+
+  // Sample a coarse grid; no voxel center is further than half a cell
+  // diagonal from a sample, and the pattern cannot change faster than
+  // m_fLipschitz.  Axes that are sampled at every voxel are exact.
+  uint32_t n[3];
+  DOUBLEVECTOR3 vStep, vGap;
+  for(size_t a=0; a < 3; ++a) {
+    n[a] = static_cast<uint32_t>(std::min<uint64_t>(iVoxels[a], iSamples));
+    vStep[a] = n[a] > 1 ? (vHi[a] - vLo[a]) / (n[a]-1) : 0.0;
+    vGap[a] = n[a] == iVoxels[a] ? 0.0 : vStep[a];
+  }
+  fMin = std::numeric_limits<double>::max();
+  fMax = -std::numeric_limits<double>::max();
+  for(uint32_t z=0; z < n[2]; ++z) {
+    for(uint32_t y=0; y < n[1]; ++y) {
+      for(uint32_t x=0; x < n[0]; ++x) {
+        const double f = Evaluate(vLo + DOUBLEVECTOR3(x,y,z) * vStep, t);
+        fMin = std::min(fMin, f);
+        fMax = std::max(fMax, f);
+      }
+    }
+  }
+  const double fSlack = 0.5 * m_fLipschitz * vGap.length();
+  fMin = std::max(0.0, fMin - fSlack);
+  fMax = std::min(1.0, fMax + fSlack);
+}
+
+void SyntheticDataset::ComputeMinMax() {
+  m_vMinMax.resize(m_Params.iTimesteps * m_iBricksPerTimestep);
+  const uint32_t iSamples = static_cast<uint32_t>(std::max<double>(
+    iMinBoundSamples, std::min<double>(iMaxBoundSamples,
+      std::pow(fBoundBudget / double(m_iBricksPerTimestep), 1.0/3.0)
+    )
+  ));
+  for(size_t ts=0; ts < m_Params.iTimesteps; ++ts) {
+    const double t = double(ts) / double(m_Params.iTimesteps);
+    for(size_t lod=0; lod < m_vLayouts.size(); ++lod) {
+      const UINTVECTOR3& vLayout = m_vLayouts[lod];
+      const int64_t iBricks = int64_t(UINT64VECTOR3(vLayout).volume());
+#pragma omp parallel for schedule(dynamic, 16)
+      for(int64_t i=0; i < iBricks; ++i) {
+        const UINTVECTOR3 vBrick(
+          static_cast<uint32_t>(i % vLayout.x),
+          static_cast<uint32_t>((i / vLayout.x) % vLayout.y),
+          static_cast<uint32_t>(i / (int64_t(vLayout.x) * vLayout.y))
+        );
+        double fMin, fMax;
+        BoundBrick(lod, vBrick, iSamples, t, fMin, fMax);
+        // Generate rounds the same way
+        fMin = std::floor(fMin * m_fMaxValue + 0.5);
+        fMax = std::floor(fMax * m_fMaxValue + 0.5);
+        const BrickKey key(ts, lod, size_t(i));
+        m_vMinMax[MinMaxIndex(key)] = MinMaxBlock(
+          fMin, fMax, 0.0, fMax > fMin ? m_fMaxGradient : 0.0
+        );
+      }
+    }
+  }
+}
+
+void SyntheticDataset::ComputeHistograms() {
+  // The coarsest level stands in for the whole volume: one brick is cheap
+  // to generate and, being a point sampling, has the same distribution.
+  const size_t iLoD = m_vLayouts.size()-1;
+  const BrickKey key(0, iLoD, 0);
+  std::vector<uint16_t> data;
+  Generate(key, data);
+
+  const size_t iBins = static_cast<size_t>(m_fMaxValue) + 1;
+  const UINT64VECTOR3& vDomain = m_vDomainSizes[iLoD];
+  const UINTVECTOR3 vSize = GetBrickVoxelCounts(key);
+  const uint64_t o = m_Params.iOverlap;
+  const double fScale = double(m_Params.vDomainSize.volume()) /
+                        double(vDomain.volume());
+
+  std::vector<float> vGradients(vDomain.volume());
+  std::vector<uint64_t> hist1D(iBins, 0);
+  double fMaxGradient = 0.0;
+  size_t g = 0;
+  for(uint64_t z=0; z < vDomain.z; ++z) {
+    for(uint64_t y=0; y < vDomain.y; ++y) {
+      for(uint64_t x=0; x < vDomain.x; ++x, ++g) {
+        // position in the brick, which starts 'o' voxels before the domain
+        const uint64_t b[3] = { x+o, y+o, z+o };
+        const size_t i = size_t(b[0] + vSize.x*(b[1] + vSize.y*b[2]));
+        ++hist1D[data[i]];
+
+        // central differences; the brick is clamped at the domain border
+        DOUBLEVECTOR3 vGrad;
+        const uint64_t iStride[3] = { 1, vSize.x, uint64_t(vSize.x)*vSize.y };
+        for(size_t a=0; a < 3; ++a) {
+          const size_t lo = b[a] > 0 ? i - size_t(iStride[a]) : i;
+          const size_t hi = b[a]+1 < (&vSize.x)[a] ? i + size_t(iStride[a])
+                                                   : i;
+          vGrad[a] = (double(data[hi]) - double(data[lo])) * 0.5;
+        }
+        vGradients[g] = static_cast<float>(vGrad.length());
+        fMaxGradient = std::max(fMaxGradient, double(vGradients[g]));
+      }
+    }
+  }
+
+  const double fMaxCount = double(std::numeric_limits<uint32_t>::max());
+  m_pHist1D.reset(new Histogram1D(iBins));
+  for(size_t i=0; i < iBins; ++i) {
+    m_pHist1D->Set(i, static_cast<uint32_t>(
+      std::min(fMaxCount, double(hist1D[i]) * fScale)
+    ));
+  }
+
+  std::vector<uint64_t> hist2D(iBins * iGradientBins, 0);
+  g = 0;
+  for(uint64_t z=0; z < vDomain.z; ++z) {
+    for(uint64_t y=0; y < vDomain.y; ++y) {
+      for(uint64_t x=0; x < vDomain.x; ++x, ++g) {
+        const size_t i = size_t((x+o) + vSize.x*((y+o) + vSize.y*(z+o)));
+        const size_t iGrad = fMaxGradient > 0.0 ?
+          std::min(iGradientBins-1, static_cast<size_t>(
+            vGradients[g] / fMaxGradient * (iGradientBins-1) + 0.5
+          )) : 0;
+        ++hist2D[data[i] + iBins*iGrad];
+      }
+    }
+  }
+  m_pHist2D.reset(new Histogram2D(VECTOR2<size_t>(iBins, iGradientBins)));
+  for(size_t y=0; y < iGradientBins; ++y) {
+    for(size_t x=0; x < iBins; ++x) {
+      m_pHist2D->Set(VECTOR2<size_t>(x, y), static_cast<uint32_t>(
+        std::min(fMaxCount, double(hist2D[x + iBins*y]) * fScale)
+      ));
+    }
+  }
+}
+
+template<typename T>
+bool SyntheticDataset::Generate(const BrickKey& key,
+                                std::vector<T>& data) const {
+  const size_t ts = std::get<0>(key);
+  const size_t lod = std::get<1>(key);
+  if(ts >= m_Params.iTimesteps || lod >= m_vLayouts.size() ||
+     std::get<2>(key) >= UINT64VECTOR3(m_vLayouts[lod]).volume()) {
+    T_ERROR("No brick (%u, %u, %u) in this data set",
+            static_cast<unsigned>(ts), static_cast<unsigned>(lod),
+            static_cast<unsigned>(std::get<2>(key)));
+    return false;
+  }
+  const UINTVECTOR3& vLayout = m_vLayouts[lod];
+  const size_t index = std::get<2>(key);
+  const UINTVECTOR3 vBrick(static_cast<uint32_t>(index % vLayout.x),
+                           static_cast<uint32_t>((index / vLayout.x) %
+                                                 vLayout.y),
+                           static_cast<uint32_t>(index / (vLayout.x *
+                                                          vLayout.y)));
+  UINT64VECTOR3 vStart;
+  UINTVECTOR3 vCount;
+  BrickVoxels(lod, vBrick, vStart, vCount);
+
+  const int64_t o = m_Params.iOverlap;
+  const UINT64VECTOR3& vDomain = m_vDomainSizes[lod];
+  const UINTVECTOR3 vSize = vCount + UINTVECTOR3(2*uint32_t(o), 2*uint32_t(o),
+                                                 2*uint32_t(o));
+  const double t = double(ts) / double(m_Params.iTimesteps);
+  data.resize(UINT64VECTOR3(vSize).volume());
+
+  // voxels in the overlap outside of the domain repeat the border
+  std::vector<double> pos[3];
+  for(size_t a=0; a < 3; ++a) {
+    pos[a].resize(vSize[a]);
+    for(uint32_t v=0; v < vSize[a]; ++v) {
+      const int64_t g = std::max<int64_t>(0, std::min<int64_t>(
+        int64_t(vStart[a]) - o + v, int64_t(vDomain[a]) - 1
+      ));
+      pos[a][v] = (g + 0.5) / double(vDomain[a]);
+    }
+  }
+
+#pragma omp parallel for schedule(static) if(vSize.z > 16)
+  for(int64_t z=0; z < int64_t(vSize.z); ++z) {
+    size_t i = size_t(z) * vSize.x * vSize.y;
+    for(uint32_t y=0; y < vSize.y; ++y) {
+      for(uint32_t x=0; x < vSize.x; ++x, ++i) {
+        const double f = Evaluate(DOUBLEVECTOR3(pos[0][x], pos[1][y],
+                                                pos[2][size_t(z)]), t);
+        data[i] = static_cast<T>(std::floor(f * m_fMaxValue + 0.5));
+      }
+    }
+  }
+  return true;
+}
+
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<uint8_t>& data) const {
+  return Generate(k, data);
+}
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<int8_t>& data) const {
+  return Generate(k, data);
+}
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<uint16_t>& data) const {
+  return Generate(k, data);
+}
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<int16_t>& data) const {
+  return Generate(k, data);
+}
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<uint32_t>& data) const {
+  return Generate(k, data);
+}
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<int32_t>& data) const {
+  return Generate(k, data);
+}
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<float>& data) const {
+  return Generate(k, data);
+}
+bool SyntheticDataset::GetBrick(const BrickKey& k,
+                                std::vector<double>& data) const {
+  return Generate(k, data);
+}
+
+float SyntheticDataset::MaxGradientMagnitude() const {
+  return static_cast<float>(m_fMaxGradient);
+}
+
+UINTVECTOR3 SyntheticDataset::GetMaxBrickSize() const {
+  return m_Params.vMaxBrickSize;
+}
+UINTVECTOR3 SyntheticDataset::GetMaxUsedBrickSizes() const {
+  return m_vMaxUsedBrickSize;
+}
+UINTVECTOR3 SyntheticDataset::GetBrickOverlapSize() const {
+  return UINTVECTOR3(m_Params.iOverlap, m_Params.iOverlap,
+                     m_Params.iOverlap);
+}
+UINTVECTOR3 SyntheticDataset::GetEffectiveBrickSize(const BrickKey& k) const {
+  return GetBrickVoxelCounts(k) - GetBrickOverlapSize()*2;
+}
+UINTVECTOR3 SyntheticDataset::GetBrickLayout(size_t LoD, size_t) const {
+  return m_vLayouts[LoD];
+}
+
+uint64_t SyntheticDataset::GetLODLevelCount() const {
+  return m_vLayouts.size();
+}
+uint64_t SyntheticDataset::GetNumberOfTimesteps() const {
+  return m_Params.iTimesteps;
+}
+UINT64VECTOR3 SyntheticDataset::GetDomainSize(const size_t lod,
+                                              const size_t) const {
+  return m_vDomainSizes[lod];
+}
+size_t SyntheticDataset::GetLargestSingleBrickLOD(size_t) const {
+  return m_vLayouts.size()-1;
+}
+
+unsigned SyntheticDataset::GetBitWidth() const { return m_Params.iBitWidth; }
+uint64_t SyntheticDataset::GetComponentCount() const { return 1; }
+bool SyntheticDataset::GetIsSigned() const { return false; }
+bool SyntheticDataset::GetIsFloat() const { return false; }
+bool SyntheticDataset::IsSameEndianness() const { return true; }
+std::pair<double,double> SyntheticDataset::GetRange() const {
+  return std::make_pair(0.0, m_fMaxValue);
+}
+
+bool SyntheticDataset::ContainsData(const BrickKey& k, double isoval) const {
+  return m_vMinMax[MinMaxIndex(k)].maxScalar >= isoval;
+}
+bool SyntheticDataset::ContainsData(const BrickKey& k, double fMin,
+                                    double fMax) const {
+  const MinMaxBlock& mm = m_vMinMax[MinMaxIndex(k)];
+  return fMax >= mm.minScalar && fMin <= mm.maxScalar;
+}
+bool SyntheticDataset::ContainsData(const BrickKey& k, double fMin,
+                                    double fMax, double fMinGradient,
+                                    double fMaxGradient) const {
+  const MinMaxBlock& mm = m_vMinMax[MinMaxIndex(k)];
+  return fMax >= mm.minScalar && fMin <= mm.maxScalar &&
+         fMaxGradient >= mm.minGradient && fMinGradient <= mm.maxGradient;
+}
+MinMaxBlock SyntheticDataset::MaxMinForKey(const BrickKey& k) const {
+  return m_vMinMax[MinMaxIndex(k)];
+}
+
+bool SyntheticDataset::Export(uint64_t, const std::string& target,
+                              bool) const {
+  T_ERROR("Cannot export synthetic data to '%s'", target.c_str());
+  return false;
+}
+bool SyntheticDataset::ApplyFunction(uint64_t,
+                        bool (*)(void*, const UINT64VECTOR3&,
+                                 const UINT64VECTOR3&, void*),
+                        void*, uint64_t) const {
+  T_ERROR("Functions cannot be applied to synthetic data");
+  return false;
+}
+
+std::string SyntheticDataset::Filename() const {
+  return "synthetic:" + ToSpec(m_Params);
+}
+bool SyntheticDataset::CanRead(const std::string&,
+                               const std::vector<int8_t>&) const {
+  return false;
+}
+bool SyntheticDataset::Verify(const std::string&) const { return false; }
+Dataset* SyntheticDataset::Create(const std::string&, uint64_t, bool) const {
+  T_ERROR("Synthetic data sets are not read from files");
+  return NULL;
+}
+std::list<std::string> SyntheticDataset::Extensions() const {
+  return std::list<std::string>();
+}
+
+}
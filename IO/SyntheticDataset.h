@@ -0,0 +1,195 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    SyntheticDataset.h
+  \brief   A bricked, multi resolution data set that is generated on the fly.
+*/
+#pragma once
+
+#ifndef TUVOK_SYNTHETIC_DATASET_H
+#define TUVOK_SYNTHETIC_DATASET_H
+
+#include "StdTuvokDefines.h"
+#include <string>
+#include <vector>
+#include "LinearIndexDataset.h"
+
+namespace tuvok {
+
+/// Procedurally generated volume for benchmarks and tests.  Nothing lives on
+/// disk: the LOD hierarchy and the brick table are laid out like a UVF file
+/// would be, and GetBrick evaluates the pattern for the requested brick.
+/// The result only depends on the parameters, so runs are reproducible at
+/// any domain size.
+///
+/// Per brick min/max values are computed up front and are conservative.
+/// Bricks of the blob pattern that contain no blob report exactly 0, so the
+/// empty space fraction is directly visible to culling.
+class SyntheticDataset : public LinearIndexDataset {
+public:
+  enum Pattern {
+    SP_NOISE = 0,       ///< fractal value noise, dense everywhere
+    SP_SHELLS,          ///< concentric spherical shells
+    SP_MARSCHNER_LOBB,  ///< the Marschner-Lobb test signal
+    SP_BLOBS,           ///< sparse blobs, see Params::fEmptyFraction
+    SP_END
+  };
+
+  struct Params {
+    Params();
+    Pattern       ePattern;
+    UINT64VECTOR3 vDomainSize;
+    UINTVECTOR3   vMaxBrickSize;  ///< including the overlap
+    uint32_t      iOverlap;       ///< voxels added on each side of a brick
+    unsigned      iBitWidth;      ///< 8 or 16
+    uint64_t      iTimesteps;     ///< > 1: the pattern moves over time
+    /// SP_BLOBS: fraction of the finest level's bricks without any data
+    double        fEmptyFraction;
+    uint32_t      iSeed;
+  };
+
+  explicit SyntheticDataset(const Params& params);
+  virtual ~SyntheticDataset();
+
+  /// Parses "pattern[:key=value]*", e.g.
+  ///   blobs:size=512x512x256:brick=64:empty=0.9:timesteps=4
+  /// Patterns are noise, shells, ml and blobs; keys are size, brick (both
+  /// N or XxYxZ), overlap, bits, timesteps, empty and seed.  Keys that are
+  /// not given keep their defaults.
+  static bool ParseSpec(const std::string& spec, Params& params);
+  /// The parameters in the form ParseSpec reads.
+  static std::string ToSpec(const Params& params);
+
+  const Params& GetParams() const { return m_Params; }
+
+  virtual float MaxGradientMagnitude() const;
+
+  virtual bool GetBrick(const BrickKey&, std::vector<uint8_t>&) const;
+  virtual bool GetBrick(const BrickKey&, std::vector<int8_t>&) const;
+  virtual bool GetBrick(const BrickKey&, std::vector<uint16_t>&) const;
+  virtual bool GetBrick(const BrickKey&, std::vector<int16_t>&) const;
+  virtual bool GetBrick(const BrickKey&, std::vector<uint32_t>&) const;
+  virtual bool GetBrick(const BrickKey&, std::vector<int32_t>&) const;
+  virtual bool GetBrick(const BrickKey&, std::vector<float>&) const;
+  virtual bool GetBrick(const BrickKey&, std::vector<double>&) const;
+
+  virtual UINTVECTOR3 GetMaxBrickSize() const;
+  virtual UINTVECTOR3 GetMaxUsedBrickSizes() const;
+  virtual UINTVECTOR3 GetBrickOverlapSize() const;
+  virtual UINTVECTOR3 GetEffectiveBrickSize(const BrickKey&) const;
+  virtual UINTVECTOR3 GetBrickLayout(size_t LoD, size_t timestep) const;
+
+  virtual uint64_t GetLODLevelCount() const;
+  virtual uint64_t GetNumberOfTimesteps() const;
+  virtual UINT64VECTOR3 GetDomainSize(const size_t lod=0,
+                                      const size_t ts=0) const;
+  virtual size_t GetLargestSingleBrickLOD(size_t ts) const;
+
+  virtual unsigned GetBitWidth() const;
+  virtual uint64_t GetComponentCount() const;
+  virtual bool GetIsSigned() const;
+  virtual bool GetIsFloat() const;
+  virtual bool IsSameEndianness() const;
+  virtual std::pair<double,double> GetRange() const;
+
+  virtual bool ContainsData(const BrickKey&, double isoval) const;
+  virtual bool ContainsData(const BrickKey&, double fMin, double fMax) const;
+  virtual bool ContainsData(const BrickKey&, double fMin, double fMax,
+                            double fMinGradient, double fMaxGradient) const;
+  virtual MinMaxBlock MaxMinForKey(const BrickKey&) const;
+
+  /// There is no file behind this data set; these fail.
+  virtual bool Export(uint64_t iLODLevel, const std::string& targetFilename,
+                      bool bAppend) const;
+  virtual bool ApplyFunction(uint64_t iLODLevel,
+                        bool (*brickFunc)(void* pData,
+                                          const UINT64VECTOR3& vBrickSize,
+                                          const UINT64VECTOR3& vBrickOffset,
+                                          void* pUserContext),
+                        void *pUserContext,
+                        uint64_t iOverlap) const;
+
+  /// "synthetic:" followed by ToSpec(GetParams()).
+  virtual std::string Filename() const;
+  virtual const char* Name() const { return "Synthetic"; }
+  virtual bool CanRead(const std::string&, const std::vector<int8_t>&) const;
+  virtual bool Verify(const std::string&) const;
+  virtual Dataset* Create(const std::string&, uint64_t, bool) const;
+  virtual std::list<std::string> Extensions() const;
+
+  /// Pattern value in [0,1] at 'pos' (the domain mapped to [0,1]^3) and
+  /// time 't' in [0,1).
+  double Evaluate(const DOUBLEVECTOR3& pos, double t) const;
+
+private:
+  struct Blob {
+    DOUBLEVECTOR3 vCenter;     ///< in finest level voxels
+    double        fRadius;     ///< in finest level voxels, 0: no blob
+    double        fAmplitude;
+    double        fPhase;
+  };
+
+  void BuildHierarchy();
+  void PlaceBlobs();
+  void ComputeMinMax();
+  void ComputeHistograms();
+
+  /// First voxel of a brick (without overlap) and its voxel count.
+  void BrickVoxels(size_t iLoD, const UINTVECTOR3& vBrick,
+                   UINT64VECTOR3& vStart, UINTVECTOR3& vCount) const;
+  /// Index into m_vMinMax.
+  size_t MinMaxIndex(const BrickKey& key) const;
+  /// Conservative range of the pattern over the voxel centers of a brick,
+  /// including its overlap, from up to iSamples^3 evaluations.
+  void BoundBrick(size_t iLoD, const UINTVECTOR3& vBrick, uint32_t iSamples,
+                  double t, double& fMin, double& fMax) const;
+  /// Exact range of the blob pattern in a box of finest level voxel space.
+  void BoundBlobs(const DOUBLEVECTOR3& vLo, const DOUBLEVECTOR3& vHi,
+                  double t, double& fMin, double& fMax) const;
+  double BlobValue(const Blob& blob, double fDistance, double t) const;
+
+  template<typename T> bool Generate(const BrickKey& key,
+                                     std::vector<T>& data) const;
+
+  Params                     m_Params;
+  double                     m_fMaxValue;
+  double                     m_fLipschitz;  ///< bound on |grad| of Evaluate
+  double                     m_fMaxGradient;  ///< per finest level voxel
+  UINTVECTOR3                m_vInnerBrickSize;
+  UINTVECTOR3                m_vMaxUsedBrickSize;
+  std::vector<UINT64VECTOR3> m_vDomainSizes;  ///< per LOD
+  std::vector<UINTVECTOR3>   m_vLayouts;      ///< per LOD
+  std::vector<size_t>        m_vLODOffsets;   ///< first brick of each LOD
+  size_t                     m_iBricksPerTimestep;
+  std::vector<MinMaxBlock>   m_vMinMax;
+  std::vector<Blob>          m_vBlobs;  ///< one per finest level brick
+};
+
+}
+#endif // TUVOK_SYNTHETIC_DATASET_H
@@ -0,0 +1,363 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ \brief   Cache of compiled Lua chunks, used by LuaScripting::exec.
+ */
+
+#include "StdTuvokDefines.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef LUASCRIPTING_NO_TUVOK
+# include "3rdParty/LUA/lua.hpp"
+#else
+# include "Lua/lua.hpp"
+#endif
+
+#include "LuaChunkCache.h"
+
+namespace tuvok
+{
+
+//-----------------------------------------------------------------------------
+LuaChunkCache::LuaChunkCache(lua_State* L, size_t maxEntries)
+: mL(L)
+, mMaxEntries(maxEntries)
+, mHits(0)
+, mMisses(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+int LuaChunkCache::push(const std::string& chunk, int& numArgs)
+{
+  numArgs = 0;
+  bool hoisted = makeTemplate(chunk);
+
+  EntryMap::iterator it = mEntries.find(hoisted ? mTemplate : chunk);
+  if (it != mEntries.end())
+  {
+    ++mHits;
+    mLRU.splice(mLRU.begin(), mLRU, it->second.lru);
+    lua_rawgeti(mL, LUA_REGISTRYINDEX, it->second.ref);
+  }
+  else
+  {
+    ++mMisses;
+    if (hoisted && loadTemplate() != LUA_OK)
+    {
+      // Let the chunk's own text report the error.
+      lua_pop(mL, 1);
+      hoisted = false;
+    }
+    if (hoisted == false)
+    {
+      int status = luaL_loadstring(mL, chunk.c_str());
+      if (status != LUA_OK)
+        return status;
+    }
+
+    if (mMaxEntries > 0)
+    {
+      evict(mMaxEntries - 1);
+
+      // Anchor a copy of the function in the registry, leave the original on
+      // the stack.
+      lua_pushvalue(mL, -1);
+      Entry e;
+      e.ref = luaL_ref(mL, LUA_REGISTRYINDEX);
+      it = mEntries.insert(std::make_pair(hoisted ? mTemplate : chunk,
+                                          e)).first;
+      mLRU.push_front(&it->first);
+      it->second.lru = mLRU.begin();
+    }
+  }
+
+  if (hoisted)
+  {
+    pushLiterals(chunk);
+    numArgs = static_cast<int>(mLiterals.size());
+  }
+  return LUA_OK;
+}
+
+//-----------------------------------------------------------------------------
+bool LuaChunkCache::makeTemplate(const std::string& chunk)
+{
+  mTemplate.clear();
+  mLiterals.clear();
+
+  // Keeps the placeholders from clashing with the chunk's own names.
+  if (chunk.find("__lit") != std::string::npos)
+    return false;
+
+  const char* str = chunk.c_str();
+  const size_t n = chunk.size();
+  size_t copied = 0;
+  // Last token: strings are only hoisted after operators and opening
+  // brackets, after a name or a closing bracket they are call arguments.
+  char prev = 0;
+
+  size_t i = 0;
+  while (i < n)
+  {
+    const unsigned char c = static_cast<unsigned char>(str[i]);
+    const char next = i + 1 < n ? str[i + 1] : 0;
+
+    if (isspace(c))
+    {
+      ++i;
+      continue;
+    }
+
+    if (c == '-' && next == '-')
+    {
+      // Comment, long or up to the end of the line.
+      if (i + 2 < n && str[i + 2] == '[')
+      {
+        size_t j = i + 3;
+        while (j < n && str[j] == '=')
+          ++j;
+        if (j < n && str[j] == '[')
+        {
+          std::string close = "]" + std::string(j - i - 3, '=') + "]";
+          size_t end = chunk.find(close, j + 1);
+          if (end == std::string::npos)
+            return false;
+          i = end + close.size();
+          continue;
+        }
+      }
+      size_t end = chunk.find('\n', i);
+      i = end == std::string::npos ? n : end + 1;
+      continue;
+    }
+
+    if (c == '[' && (next == '[' || next == '='))
+    {
+      size_t j = i + 1;
+      while (j < n && str[j] == '=')
+        ++j;
+      if (j < n && str[j] == '[')
+      {
+        // Long strings stay in the template.
+        std::string close = "]" + std::string(j - i - 1, '=') + "]";
+        size_t end = chunk.find(close, j + 1);
+        if (end == std::string::npos)
+          return false;
+        i = end + close.size();
+        prev = ']';
+        continue;
+      }
+    }
+
+    if (isalpha(c) || c == '_')
+    {
+      size_t begin = i;
+      while (i < n && (isalnum(static_cast<unsigned char>(str[i])) ||
+                       str[i] == '_'))
+        ++i;
+      // An expression may follow these keywords, a call argument any other
+      // name.
+      static const char* const keywords[] = {
+        "return", "and", "or", "not", "in", "then", "do", "else", "elseif",
+        "until", "if", "while"
+      };
+      prev = 'a';
+      for (size_t k = 0; k < sizeof(keywords) / sizeof(keywords[0]); ++k)
+      {
+        if (chunk.compare(begin, i - begin, keywords[k]) == 0)
+        {
+          prev = '(';
+          break;
+        }
+      }
+      continue;
+    }
+
+    if (c == '.' && next == '.')
+    {
+      // Varargs would see the literals.
+      if (i + 2 < n && str[i + 2] == '.')
+        return false;
+      i += 2;
+      prev = '.';
+      continue;
+    }
+
+    Literal lit;
+    size_t end = i;
+    if (isdigit(c) || (c == '.' && isdigit(static_cast<unsigned char>(next))))
+    {
+      bool hex = c == '0' && (next == 'x' || next == 'X');
+      end = hex ? i + 2 : i;
+      while (end < n && (isdigit(static_cast<unsigned char>(str[end])) ||
+                         (hex && isxdigit(static_cast<unsigned char>(str[end])))
+                         || str[end] == '.'))
+        ++end;
+      if (end < n && (hex ? (str[end] == 'p' || str[end] == 'P')
+                          : (str[end] == 'e' || str[end] == 'E')))
+      {
+        ++end;
+        if (end < n && (str[end] == '+' || str[end] == '-'))
+          ++end;
+        while (end < n && isdigit(static_cast<unsigned char>(str[end])))
+          ++end;
+      }
+      if (end < n && (isalnum(static_cast<unsigned char>(str[end])) ||
+                      str[end] == '_' || str[end] == '.'))
+        return false;
+
+      // Lua converts numerals with strtod as well.
+      char* parsed = NULL;
+      lit.number = strtod(str + i, &parsed);
+      if (parsed != str + end)
+        return false;
+      lit.isString = false;
+      lit.begin = i;
+      lit.length = 0;
+    }
+    else if (c == '"' || c == '\'')
+    {
+      bool escaped = false;
+      end = i + 1;
+      while (end < n && str[end] != static_cast<char>(c))
+      {
+        if (str[end] == '\n')
+          return false;
+        if (str[end] == '\\')
+        {
+          escaped = true;
+          ++end;
+        }
+        ++end;
+      }
+      if (end >= n)
+        return false;
+      ++end;  // Closing quote.
+
+      if (escaped || prev == 0 || strchr("(,=[{+-*/%^<>~.#", prev) == NULL)
+      {
+        i = end;
+        prev = '"';
+        continue;
+      }
+      lit.isString = true;
+      lit.begin = i + 1;
+      lit.length = end - i - 2;
+      lit.number = 0.0;
+    }
+    else
+    {
+      ++i;
+      prev = static_cast<char>(c);
+      continue;
+    }
+
+    if (mLiterals.size() == MAX_LITERALS)
+      return false;
+    mLiterals.push_back(lit);
+
+    mTemplate.append(str + copied, i - copied);
+    mTemplate += "__lit";
+    mTemplate += std::to_string(static_cast<unsigned long long>(
+                                  mLiterals.size()));
+    if (end < n && (isalnum(static_cast<unsigned char>(str[end])) ||
+                    str[end] == '_'))
+      mTemplate += ' ';
+    copied = end;
+    i = end;
+    prev = '0';
+  }
+
+  if (mLiterals.empty())
+    return false;
+  mTemplate.append(str + copied, n - copied);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+int LuaChunkCache::loadTemplate()
+{
+  // The locals go in front of the first line, so line numbers in error
+  // messages stay those of the chunk.
+  std::string source = "local ";
+  for (size_t i = 1; i <= mLiterals.size(); ++i)
+  {
+    if (i > 1)
+      source += ',';
+    source += "__lit";
+    source += std::to_string(static_cast<unsigned long long>(i));
+  }
+  source += "=... ";
+  source += mTemplate;
+  return luaL_loadbuffer(mL, source.data(), source.size(), mTemplate.c_str());
+}
+
+//-----------------------------------------------------------------------------
+void LuaChunkCache::pushLiterals(const std::string& chunk)
+{
+  lua_checkstack(mL, static_cast<int>(mLiterals.size()));
+  for (std::vector<Literal>::const_iterator it = mLiterals.begin();
+       it != mLiterals.end(); ++it)
+  {
+    if (it->isString)
+      lua_pushlstring(mL, chunk.data() + it->begin, it->length);
+    else
+      lua_pushnumber(mL, it->number);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void LuaChunkCache::clear()
+{
+  evict(0);
+}
+
+//-----------------------------------------------------------------------------
+void LuaChunkCache::setMaxEntries(size_t maxEntries)
+{
+  mMaxEntries = maxEntries;
+  evict(mMaxEntries);
+}
+
+//-----------------------------------------------------------------------------
+void LuaChunkCache::evict(size_t maxEntries)
+{
+  while (mEntries.size() > maxEntries)
+  {
+    EntryMap::iterator it = mEntries.find(*mLRU.back());
+    luaL_unref(mL, LUA_REGISTRYINDEX, it->second.ref);
+    mLRU.pop_back();
+    mEntries.erase(it);
+  }
+}
+
+} // namespace tuvok
@@ -0,0 +1,133 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \brief   Cache of compiled Lua chunks, used by LuaScripting::exec.
+           For internal LuaScripting uses only.
+*/
+
+#ifndef TUVOK_LUA_CHUNK_CACHE_H_
+#define TUVOK_LUA_CHUNK_CACHE_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+namespace tuvok
+{
+
+/// Maps the text of a chunk to the function luaL_loadstring compiled from it.
+/// The functions are anchored in the Lua registry, the least recently used
+/// ones are released once more than getMaxEntries() chunks are cached.
+/// Replaying the same commands (console history, scripted animations) then
+/// skips lexing and parsing.
+///
+/// Numeric and string literals are hoisted out of the chunk first: the key
+/// is the chunk with every literal replaced by a local, and the compiled
+/// function takes the literals as its arguments. So
+/// "renderer.setRotation(0.5, 1)" and "renderer.setRotation(0.6, 1)" share
+/// one function. Strings with escape sequences, long strings and strings in
+/// call position (f "x") are left in place.
+///
+/// Does not release its registry references on destruction; it must not
+/// outlive the Lua state, and closing the state frees them anyway.
+class LuaChunkCache
+{
+public:
+  LuaChunkCache(lua_State* L, size_t maxEntries);
+
+  /// Pushes the compiled chunk and then its hoisted literals onto the stack,
+  /// compiling it on a miss. Calling the function with numArgs arguments
+  /// runs the chunk.
+  /// On a syntax error the error message is pushed instead (just like
+  /// luaL_loadstring), numArgs is 0 and nothing is cached.
+  /// \return The luaL_loadstring status, LUA_OK on success.
+  int push(const std::string& chunk, int& numArgs);
+
+  /// Releases all cached chunks.
+  void clear();
+
+  /// 0 disables caching.
+  void setMaxEntries(size_t maxEntries);
+  size_t getMaxEntries() const  {return mMaxEntries;}
+  size_t getNumEntries() const  {return mEntries.size();}
+
+  unsigned long long getHits() const    {return mHits;}
+  unsigned long long getMisses() const  {return mMisses;}
+
+private:
+  struct Entry
+  {
+    int                                     ref;
+    std::list<const std::string*>::iterator lru;
+  };
+  typedef std::unordered_map<std::string, Entry> EntryMap;
+
+  struct Literal
+  {
+    size_t  begin;    ///< Offset of the string's contents in the chunk.
+    size_t  length;   ///< 0 for numbers.
+    double  number;
+    bool    isString;
+  };
+
+  /// More literals are not hoisted; each one takes a local of the chunk.
+  enum { MAX_LITERALS = 32 };
+
+  /// Fills mTemplate and mLiterals from the chunk. Returns false if nothing
+  /// was hoisted, or if the chunk uses something the scan does not handle
+  /// (varargs, malformed literals), in which case it is cached verbatim.
+  bool makeTemplate(const std::string& chunk);
+
+  /// Compiles mTemplate, declaring the hoisted literals as locals.
+  int loadTemplate();
+
+  void pushLiterals(const std::string& chunk);
+
+  void evict(size_t maxEntries);
+
+  lua_State*                    mL;
+  size_t                        mMaxEntries;
+  EntryMap                      mEntries;
+  /// Keys of mEntries, most recently used first.
+  std::list<const std::string*> mLRU;
+
+  unsigned long long            mHits;
+  unsigned long long            mMisses;
+
+  /// Scratch space of makeTemplate, kept to reuse the allocations.
+  std::string                   mTemplate;
+  std::vector<Literal>          mLiterals;
+};
+
+} // namespace tuvok
+
+#endif
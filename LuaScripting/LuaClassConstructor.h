@@ -158,7 +158,8 @@ public:
     // deregisters all functions it has registered, so no residual light
     // user data will be left in Lua.
     lua_pushlightuserdata(L, static_cast<void*>(mSS));
-    lua_pushcclosure(L, proxyFunc, 4);
+    lua_pushinteger(L, 0);  // ExecFlags, see LuaScripting::updateExecFlags.
+    lua_pushcclosure(L, proxyFunc, 5);
 
     // Associate closure with __call metamethod.
     lua_setfield(L, -2, "__call");
@@ -240,18 +241,13 @@ private:
           lua_touserdata(L, lua_upvalueindex(1)));                            //
       LuaScripting* ss = static_cast<LuaScripting*>(                          //
                   lua_touserdata(L, lua_upvalueindex(3)));                    //
-
-      std::shared_ptr<LuaCFunAbstract> execParams(
-          new LuaCFunExec<FunPtr>());
-      std::shared_ptr<LuaCFunAbstract> emptyParams(
-          new LuaCFunExec<FunPtr>());
-      // Fill execParams. Function parameters start at index 2.
-      execParams->pullParamsFromStack(L, 2);
+      int execFlags = static_cast<int>(                                       //
+                  lua_tointeger(L, lua_upvalueindex(4)));                     //
 
       // Obtain reference to LuaScripting in order to invoke provenance.
       // See createCallableFuncTable for justification on pulling an
       // instance of LuaScripting out of Lua.
-      bool provExempt = ss->doProvenanceFromExec(L, execParams, emptyParams);
+      bool provExempt = ss->doProvenanceFromExec<FunPtr>(L, execFlags);
 
       // Places the instance table and its metatable at stack position -2 and
       // -1 respectively.
@@ -296,7 +292,7 @@ private:
         (*cbFptr)(reg, r, ss);
         lua_pop(L, 1);
 
-        ss->doHooks(L, 1, provExempt);
+        ss->doHooks(L, 1, provExempt, execFlags);
 
         // Places function table on the top of the stack.
         finalize(L, ss, reinterpret_cast<void*>(r), inst, mt, instTable,
@@ -357,18 +353,13 @@ private:
                       lua_touserdata(L, lua_upvalueindex(2)));                //
       LuaScripting* ss = static_cast<LuaScripting*>(                          //
                   lua_touserdata(L, lua_upvalueindex(4)));                    //
-
-      std::shared_ptr<LuaCFunAbstract> execParams(
-          new LuaCFunExec<FunPtr>());
-      std::shared_ptr<LuaCFunAbstract> emptyParams(
-          new LuaCFunExec<FunPtr>());
-      // Fill execParams. Function parameters start at index 2.
-      execParams->pullParamsFromStack(L, 2);
+      int execFlags = static_cast<int>(                                       //
+                  lua_tointeger(L, lua_upvalueindex(5)));                     //
 
       // Obtain reference to LuaScripting in order to invoke provenance.
       // See createCallableFuncTable for justification on pulling an
       // instance of LuaScripting out of Lua.
-      bool provExempt = ss->doProvenanceFromExec(L, execParams, emptyParams);
+      bool provExempt = ss->doProvenanceFromExec<FunPtr>(L, execFlags);
 
       // Places the instance table and its metatable at stack position -2 and -1
       // respectively.
@@ -412,7 +403,7 @@ private:
         (*cbFptr)(reg, r, ss);
         lua_pop(L, 1);
 
-        ss->doHooks(L, 1, provExempt);
+        ss->doHooks(L, 1, provExempt, execFlags);
 
         // Places function table on the top of the stack.
         finalize(L, ss, reinterpret_cast<void*>(r), inst, mt, instTable,
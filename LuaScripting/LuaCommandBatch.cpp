@@ -0,0 +1,107 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \brief   A list of bound function calls that LuaScripting::cexecBatch
+           executes as one command.
+*/
+
+#include "LuaScripting.h"
+#include "LuaCommandBatch.h"
+
+namespace tuvok
+{
+
+namespace
+{
+  /// Parameters of calls without any.
+  class LuaBatchNoArgs : public LuaBatchArgsAbstract
+  {
+  public:
+    int push(lua_State*) const {return 0;}
+  };
+}
+
+//-----------------------------------------------------------------------------
+LuaCommandBatch::LuaCommandBatch(bool coalesce)
+: mCoalesce(coalesce)
+, mNumCalls(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+void LuaCommandBatch::add(const std::string& fqName)
+{
+  static const std::shared_ptr<LuaBatchArgsAbstract> noArgs(
+      new LuaBatchNoArgs());
+  addCall(fqName, noArgs);
+}
+
+//-----------------------------------------------------------------------------
+void LuaCommandBatch::addCall(const std::string& fqName,
+                              std::shared_ptr<LuaBatchArgsAbstract> params)
+{
+  std::unordered_map<std::string, int>::iterator it =
+      mFunctionIndices.find(fqName);
+  int function;
+  if (it == mFunctionIndices.end())
+  {
+    function = static_cast<int>(mFunctions.size());
+    mFunctionIndices.insert(std::make_pair(fqName, function));
+    mFunctions.push_back(fqName);
+    mLastCall.push_back(mCalls.size());
+  }
+  else
+  {
+    function = it->second;
+    if (mCoalesce)
+    {
+      mCalls[mLastCall[function]].params.reset();
+      --mNumCalls;
+    }
+  }
+
+  Call call;
+  call.function = function;
+  call.params   = params;
+  mLastCall[function] = mCalls.size();
+  mCalls.push_back(call);
+  ++mNumCalls;
+}
+
+//-----------------------------------------------------------------------------
+void LuaCommandBatch::clear()
+{
+  mNumCalls = 0;
+  mFunctions.clear();
+  mFunctionIndices.clear();
+  mCalls.clear();
+  mLastCall.clear();
+}
+
+} // namespace tuvok
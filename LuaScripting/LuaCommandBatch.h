@@ -0,0 +1,283 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \brief   A list of bound function calls that LuaScripting::cexecBatch
+           executes as one command.
+*/
+
+#ifndef TUVOK_LUA_COMMAND_BATCH_H_
+#define TUVOK_LUA_COMMAND_BATCH_H_
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "LuaFunBinding.h"
+
+namespace tuvok
+{
+
+/// Parameters are stored by value, string literals as std::string.
+template <typename T>
+struct LuaBatchStorage { typedef T Type; };
+template <>
+struct LuaBatchStorage<const char*> { typedef std::string Type; };
+template <>
+struct LuaBatchStorage<char*> { typedef std::string Type; };
+
+/// Pushes the elements of a tuple onto the Lua stack, first element first.
+template <typename Tuple, size_t N = std::tuple_size<Tuple>::value>
+struct LuaBatchPushTuple
+{
+  static void push(lua_State* L, const Tuple& t)
+  {
+    LuaBatchPushTuple<Tuple, N - 1>::push(L, t);
+    LuaStrictStack<typename std::tuple_element<N - 1, Tuple>::type>::push(
+        L, std::get<N - 1>(t));
+  }
+};
+template <typename Tuple>
+struct LuaBatchPushTuple<Tuple, 0>
+{
+  static void push(lua_State*, const Tuple&) {}
+};
+
+/// Type erased parameters of one call.
+class LuaBatchArgsAbstract
+{
+public:
+  virtual ~LuaBatchArgsAbstract() {}
+
+  /// Pushes the parameters and returns how many were pushed.
+  virtual int push(lua_State* L) const = 0;
+};
+
+template <typename Tuple>
+class LuaBatchArgs : public LuaBatchArgsAbstract
+{
+public:
+  LuaBatchArgs(const Tuple& params) : mParams(params) {}
+
+  int push(lua_State* L) const
+  {
+    LuaBatchPushTuple<Tuple>::push(L, mParams);
+    return static_cast<int>(std::tuple_size<Tuple>::value);
+  }
+
+private:
+  Tuple mParams;
+};
+
+/// Collects calls to registered functions, in the same form cexec takes them,
+/// so LuaScripting::cexecBatch can run them back to back:
+///
+///   LuaCommandBatch batch(true);
+///   batch.add("renderer.setIsoValue", 0.3f);
+///   batch.add(inst.fqName() + ".setColor", r, g, b);
+///   ss->cexecBatch(batch);
+///
+/// Every function is looked up once per execution, no matter how often it
+/// is called, and all calls share a single undo/redo entry.
+///
+/// With coalescing enabled, adding a call to a function (a member function
+/// name includes its instance) replaces an earlier call to the same function,
+/// and the call runs at the position of the last one added. Only use this for
+/// setters, where the last value is all that matters.
+class LuaCommandBatch
+{
+public:
+  explicit LuaCommandBatch(bool coalesce = false);
+
+  /// Appends a call to the function with the fully qualified name fqName.
+  /// Batches may be built on any thread, so the arguments are not taken from
+  /// the (single threaded) LuaFreeListAllocator.
+  ///@{
+  void add(const std::string& fqName);
+  template <typename P1>
+  void add(const std::string& fqName, P1 p1)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1)));
+  }
+  template <typename P1, typename P2>
+  void add(const std::string& fqName, P1 p1, P2 p2)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2)));
+  }
+  template <typename P1, typename P2, typename P3>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3)));
+  }
+  template <typename P1, typename P2, typename P3, typename P4>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3, P4 p4)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type,
+                       typename LuaBatchStorage<P4>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3, p4)));
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type,
+                       typename LuaBatchStorage<P4>::Type,
+                       typename LuaBatchStorage<P5>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3, p4, p5)));
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5,
+            typename P6>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type,
+                       typename LuaBatchStorage<P4>::Type,
+                       typename LuaBatchStorage<P5>::Type,
+                       typename LuaBatchStorage<P6>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3, p4, p5, p6)));
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5,
+            typename P6, typename P7>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6,
+           P7 p7)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type,
+                       typename LuaBatchStorage<P4>::Type,
+                       typename LuaBatchStorage<P5>::Type,
+                       typename LuaBatchStorage<P6>::Type,
+                       typename LuaBatchStorage<P7>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3, p4, p5, p6, p7)));
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5,
+            typename P6, typename P7, typename P8>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6,
+           P7 p7, P8 p8)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type,
+                       typename LuaBatchStorage<P4>::Type,
+                       typename LuaBatchStorage<P5>::Type,
+                       typename LuaBatchStorage<P6>::Type,
+                       typename LuaBatchStorage<P7>::Type,
+                       typename LuaBatchStorage<P8>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3, p4, p5, p6, p7, p8)));
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5,
+            typename P6, typename P7, typename P8, typename P9>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6,
+           P7 p7, P8 p8, P9 p9)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type,
+                       typename LuaBatchStorage<P4>::Type,
+                       typename LuaBatchStorage<P5>::Type,
+                       typename LuaBatchStorage<P6>::Type,
+                       typename LuaBatchStorage<P7>::Type,
+                       typename LuaBatchStorage<P8>::Type,
+                       typename LuaBatchStorage<P9>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3, p4, p5, p6, p7, p8, p9)));
+  }
+  template <typename P1, typename P2, typename P3, typename P4, typename P5,
+            typename P6, typename P7, typename P8, typename P9, typename P10>
+  void add(const std::string& fqName, P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6,
+           P7 p7, P8 p8, P9 p9, P10 p10)
+  {
+    typedef std::tuple<typename LuaBatchStorage<P1>::Type,
+                       typename LuaBatchStorage<P2>::Type,
+                       typename LuaBatchStorage<P3>::Type,
+                       typename LuaBatchStorage<P4>::Type,
+                       typename LuaBatchStorage<P5>::Type,
+                       typename LuaBatchStorage<P6>::Type,
+                       typename LuaBatchStorage<P7>::Type,
+                       typename LuaBatchStorage<P8>::Type,
+                       typename LuaBatchStorage<P9>::Type,
+                       typename LuaBatchStorage<P10>::Type> Tuple;
+    addCall(fqName, std::make_shared<LuaBatchArgs<Tuple> >(
+        Tuple(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10)));
+  }
+  ///@}
+
+  /// Number of calls that will be executed.
+  size_t getNumCalls() const      {return mNumCalls;}
+  /// Number of distinct functions called.
+  size_t getNumFunctions() const  {return mFunctions.size();}
+
+  bool isCoalescing() const       {return mCoalesce;}
+
+  void clear();
+
+private:
+  friend class LuaScripting;
+
+  struct Call
+  {
+    int                                   function; ///< Index in mFunctions.
+    /// NULL if a later call to the same function replaced this one.
+    std::shared_ptr<LuaBatchArgsAbstract> params;
+  };
+
+  void addCall(const std::string& fqName,
+               std::shared_ptr<LuaBatchArgsAbstract> params);
+
+  bool                                  mCoalesce;
+  size_t                                mNumCalls;
+  std::vector<std::string>              mFunctions;
+  std::unordered_map<std::string, int>  mFunctionIndices;
+  std::vector<Call>                     mCalls;
+  /// Last call to each function, only maintained when coalescing.
+  std::vector<size_t>                   mLastCall;
+};
+
+} // namespace tuvok
+
+#endif
@@ -0,0 +1,146 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \brief   Free list allocator for the parameter objects created by the
+           function trampolines (see LuaCallback in LuaScripting.h).
+           For internal LuaScripting uses only.
+*/
+
+#ifndef TUVOK_LUA_FREE_LIST_ALLOCATOR_H_
+#define TUVOK_LUA_FREE_LIST_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+
+namespace tuvok
+{
+
+/// Number of blocks all LuaFreeListAllocators took from the heap, so tests
+/// and benchmarks can tell whether a call path allocates.
+inline unsigned long long& luaFreeListHeapBlocks()
+{
+  static unsigned long long blocks = 0;
+  return blocks;
+}
+
+/// Allocator keeping a small list of freed blocks for every type it is
+/// instantiated with. Used together with std::allocate_shared, the object and
+/// the shared_ptr control block come from a single block of the rebound type,
+/// so each function signature gets its own list.
+/// Like the Lua state the trampolines run in, this is not thread safe.
+template <typename T>
+class LuaFreeListAllocator
+{
+public:
+  typedef T               value_type;
+  typedef T*              pointer;
+  typedef const T*        const_pointer;
+  typedef T&              reference;
+  typedef const T&        const_reference;
+  typedef std::size_t     size_type;
+  typedef std::ptrdiff_t  difference_type;
+
+  template <typename U>
+  struct rebind { typedef LuaFreeListAllocator<U> other; };
+
+  LuaFreeListAllocator() {}
+  template <typename U>
+  LuaFreeListAllocator(const LuaFreeListAllocator<U>&) {}
+
+  pointer       address(reference r) const        {return &r;}
+  const_pointer address(const_reference r) const  {return &r;}
+  size_type     max_size() const  {return size_type(-1) / sizeof(T);}
+
+  void construct(pointer p, const T& val) {new (static_cast<void*>(p)) T(val);}
+  void destroy(pointer p)                 {p->~T();}
+
+  pointer allocate(size_type n, const void* = 0)
+  {
+    if (n == 1 && sFreeList != NULL)
+    {
+      Block* b = sFreeList;
+      sFreeList = b->next;
+      --sNumFree;
+      return reinterpret_cast<pointer>(b);
+    }
+    ++luaFreeListHeapBlocks();
+    return static_cast<pointer>(::operator new(blockSize(n)));
+  }
+
+  void deallocate(pointer p, size_type n)
+  {
+    if (n == 1 && sNumFree < MAX_FREE_BLOCKS)
+    {
+      Block* b = reinterpret_cast<Block*>(p);
+      b->next = sFreeList;
+      sFreeList = b;
+      ++sNumFree;
+      return;
+    }
+    ::operator delete(p);
+  }
+
+private:
+  /// Blocks beyond this many are handed back to the heap. Only the undo/redo
+  /// stack keeps parameter objects alive for longer, and clearing it should
+  /// not pin its memory.
+  enum { MAX_FREE_BLOCKS = 16 };
+
+  struct Block { Block* next; };
+
+  static size_type blockSize(size_type n)
+  {
+    size_type size = n * sizeof(T);
+    return size < sizeof(Block) ? sizeof(Block) : size;
+  }
+
+  // Plain pointers on purpose: they are zero initialized before any
+  // constructor runs, so blocks may still be returned during static
+  // destruction. The blocks left in the lists are reclaimed by the OS.
+  static Block*     sFreeList;
+  static size_type  sNumFree;
+};
+
+template <typename T>
+typename LuaFreeListAllocator<T>::Block* LuaFreeListAllocator<T>::sFreeList
+  = NULL;
+template <typename T>
+typename LuaFreeListAllocator<T>::size_type LuaFreeListAllocator<T>::sNumFree
+  = 0;
+
+template <typename T, typename U>
+bool operator==(const LuaFreeListAllocator<T>&, const LuaFreeListAllocator<U>&)
+{ return true; }
+template <typename T, typename U>
+bool operator!=(const LuaFreeListAllocator<T>&, const LuaFreeListAllocator<U>&)
+{ return false; }
+
+} // namespace tuvok
+
+#endif
@@ -0,0 +1,260 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ \brief   Memory allocator for the Lua state owned by LuaScripting.
+ */
+
+#include "StdTuvokDefines.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "LuaMemAllocator.h"
+
+namespace tuvok
+{
+
+// The first bytes of every chunk link it to the next one. Blocks start after
+// a full granule so they stay aligned.
+static const size_t CHUNK_HEADER = 16;
+
+//-----------------------------------------------------------------------------
+LuaMemAllocator::LuaMemAllocator()
+: mChunks(NULL)
+, mChunkPos(NULL)
+, mChunkEnd(NULL)
+, mCommandDepth(0)
+, mCommandStartAllocs(0)
+{
+  std::fill(mFreeLists, mFreeLists + NUM_CLASSES,
+            static_cast<FreeBlock*>(NULL));
+  memset(&mStats, 0, sizeof(mStats));
+}
+
+//-----------------------------------------------------------------------------
+LuaMemAllocator::~LuaMemAllocator()
+{
+  // Large blocks have all been freed by lua_close, small ones live in the
+  // chunks.
+  while (mChunks != NULL)
+  {
+    FreeBlock* next = mChunks->next;
+    free(mChunks);
+    mChunks = next;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void* LuaMemAllocator::luaAlloc(void* ud, void* ptr, size_t osize,
+                                size_t nsize)
+{
+  return static_cast<LuaMemAllocator*>(ud)->realloc(ptr, osize, nsize);
+}
+
+//-----------------------------------------------------------------------------
+void* LuaMemAllocator::realloc(void* ptr, size_t osize, size_t nsize)
+{
+  // For new blocks Lua passes the type of the object in osize.
+  if (ptr == NULL)
+    osize = 0;
+
+  if (nsize == 0)
+  {
+    if (ptr != NULL)
+    {
+      freeBlock(ptr, osize);
+      mStats.liveBytes -= osize;
+    }
+    return NULL;
+  }
+
+  // Lua assumes that shrinking never fails, so only growth is limited.
+  if (nsize > osize && mStats.limitBytes != 0 &&
+      mStats.liveBytes - osize + nsize > mStats.limitBytes)
+    return NULL;
+
+  void* block = NULL;
+  int newClass = sizeClass(nsize);
+  if (ptr != NULL && newClass >= 0 && newClass == sizeClass(osize))
+  {
+    // The block is still large enough.
+    block = ptr;
+  }
+  else if (ptr != NULL && newClass < 0 && sizeClass(osize) < 0)
+  {
+    block = ::realloc(ptr, nsize);
+    if (block == NULL)
+      return NULL;
+    mStats.reservedBytes = mStats.reservedBytes - osize + nsize;
+  }
+  else
+  {
+    block = allocBlock(nsize);
+    if (block == NULL)
+    {
+      if (nsize > osize)
+        return NULL;
+      // Shrinking into a small block failed because no new chunk could be
+      // allocated. Lua releases the block with the new size later, so it
+      // has to become a block of exactly that size class.
+      block = shrinkInPlace(ptr, osize, nsize);
+      if (block == NULL)
+        return NULL;
+      mStats.liveBytes = mStats.liveBytes - osize + nsize;
+      return block;
+    }
+    if (ptr != NULL)
+    {
+      memcpy(block, ptr, std::min(osize, nsize));
+      freeBlock(ptr, osize);
+    }
+    ++mStats.allocations;
+  }
+
+  mStats.liveBytes = mStats.liveBytes - osize + nsize;
+  mStats.peakBytes = std::max(mStats.peakBytes, mStats.liveBytes);
+  return block;
+}
+
+//-----------------------------------------------------------------------------
+int LuaMemAllocator::sizeClass(size_t size)
+{
+  if (size > MAX_SMALL_SIZE)
+    return -1;
+  return static_cast<int>((size - 1) / CLASS_GRANULARITY);
+}
+
+//-----------------------------------------------------------------------------
+size_t LuaMemAllocator::classSize(int sc)
+{
+  return static_cast<size_t>(sc + 1) * CLASS_GRANULARITY;
+}
+
+//-----------------------------------------------------------------------------
+void* LuaMemAllocator::shrinkInPlace(void* ptr, size_t osize, size_t nsize)
+{
+  size_t newSize = classSize(sizeClass(nsize));
+  int oldClass = sizeClass(osize);
+  if (oldClass >= 0)
+  {
+    // Class sizes are multiples of the granularity, so the tail is a small
+    // block of its own.
+    freeBlock(static_cast<char*>(ptr) + newSize, classSize(oldClass) - newSize);
+    return ptr;
+  }
+
+  // Turn the large block into a chunk holding only the new block, so it is
+  // released with the other chunks. Fails only if not even that much memory
+  // is left.
+  char* chunk = static_cast<char*>(::realloc(ptr, CHUNK_HEADER + newSize));
+  if (chunk == NULL)
+    return NULL;
+  memmove(chunk + CHUNK_HEADER, chunk, nsize);
+  reinterpret_cast<FreeBlock*>(chunk)->next = mChunks;
+  mChunks = reinterpret_cast<FreeBlock*>(chunk);
+  mStats.reservedBytes = mStats.reservedBytes - osize + CHUNK_HEADER + newSize;
+  return chunk + CHUNK_HEADER;
+}
+
+//-----------------------------------------------------------------------------
+void* LuaMemAllocator::allocBlock(size_t size)
+{
+  int sc = sizeClass(size);
+  if (sc >= 0)
+    return allocSmall(sc);
+
+  void* block = malloc(size);
+  if (block != NULL)
+    mStats.reservedBytes += size;
+  return block;
+}
+
+//-----------------------------------------------------------------------------
+void LuaMemAllocator::freeBlock(void* ptr, size_t size)
+{
+  int sc = sizeClass(size);
+  if (sc < 0)
+  {
+    free(ptr);
+    mStats.reservedBytes -= size;
+    return;
+  }
+
+  FreeBlock* b = static_cast<FreeBlock*>(ptr);
+  b->next = mFreeLists[sc];
+  mFreeLists[sc] = b;
+}
+
+//-----------------------------------------------------------------------------
+void* LuaMemAllocator::allocSmall(int sc)
+{
+  if (mFreeLists[sc] != NULL)
+  {
+    FreeBlock* b = mFreeLists[sc];
+    mFreeLists[sc] = b->next;
+    return b;
+  }
+
+  size_t blockSize = classSize(sc);
+  if (static_cast<size_t>(mChunkEnd - mChunkPos) < blockSize)
+  {
+    // The rest of the current chunk is lost, at most one block's worth.
+    char* chunk = static_cast<char*>(malloc(CHUNK_SIZE));
+    if (chunk == NULL)
+      return NULL;
+    reinterpret_cast<FreeBlock*>(chunk)->next = mChunks;
+    mChunks = reinterpret_cast<FreeBlock*>(chunk);
+    mChunkPos = chunk + CHUNK_HEADER;
+    mChunkEnd = chunk + CHUNK_SIZE;
+    mStats.reservedBytes += CHUNK_SIZE;
+  }
+
+  void* block = mChunkPos;
+  mChunkPos += blockSize;
+  return block;
+}
+
+//-----------------------------------------------------------------------------
+void LuaMemAllocator::beginCommand()
+{
+  if (mCommandDepth++ == 0)
+    mCommandStartAllocs = mStats.allocations;
+}
+
+//-----------------------------------------------------------------------------
+void LuaMemAllocator::endCommand()
+{
+  if (mCommandDepth > 0 && --mCommandDepth == 0)
+  {
+    ++mStats.commands;
+    mStats.commandAllocations += mStats.allocations - mCommandStartAllocs;
+  }
+}
+
+} // namespace tuvok
@@ -0,0 +1,132 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \brief   Memory allocator for the Lua state owned by LuaScripting.
+           For internal LuaScripting uses only.
+*/
+
+#ifndef TUVOK_LUA_MEM_ALLOCATOR_H_
+#define TUVOK_LUA_MEM_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tuvok
+{
+
+/// Allocation statistics of a Lua state.
+struct LuaMemStats
+{
+  uint64_t liveBytes;         ///< Bytes currently allocated by Lua.
+  uint64_t peakBytes;         ///< Maximum of liveBytes.
+  uint64_t reservedBytes;     ///< Bytes taken from the C heap.
+  uint64_t allocations;       ///< Number of blocks handed out to Lua.
+  uint64_t commands;          ///< Number of top level commands executed.
+  uint64_t commandAllocations;///< Blocks handed out during those commands.
+  uint64_t limitBytes;        ///< Hard limit on liveBytes, 0 = unlimited.
+};
+
+/// Lua allocator (see lua_Alloc) serving small blocks from size class free
+/// lists. The lists are refilled from large chunks, which are only returned
+/// to the C heap when the allocator is destroyed, so the churn of tables,
+/// closures and strings Lua creates per command does not reach malloc.
+/// Larger blocks are forwarded to realloc/free.
+///
+/// A Lua state is never used by two threads at the same time, so neither is
+/// its allocator; there is no locking.
+class LuaMemAllocator
+{
+public:
+  LuaMemAllocator();
+  ~LuaMemAllocator();
+
+  /// lua_Alloc compatible entry point, ud is the LuaMemAllocator.
+  static void* luaAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+  /// Command bracketing, used to compute allocations per command.
+  /// Nested commands are counted as part of the outermost one.
+  /// @{
+  void beginCommand();
+  void endCommand();
+  /// @}
+
+  /// Sets the maximum number of bytes Lua may hold, 0 disables the limit.
+  /// Allocations that would exceed the limit fail, which Lua reports as a
+  /// memory error to the calling script.
+  void setLimit(uint64_t bytes)   {mStats.limitBytes = bytes;}
+
+  const LuaMemStats& getStats() const {return mStats;}
+
+private:
+  LuaMemAllocator(const LuaMemAllocator&);            ///< unimplemented
+  LuaMemAllocator& operator=(const LuaMemAllocator&); ///< unimplemented
+
+  enum
+  {
+    CLASS_GRANULARITY = 16,
+    MAX_SMALL_SIZE    = 512,
+    NUM_CLASSES       = MAX_SMALL_SIZE / CLASS_GRANULARITY,
+    CHUNK_SIZE        = 64 * 1024
+  };
+
+  struct FreeBlock { FreeBlock* next; };
+
+  void* realloc(void* ptr, size_t osize, size_t nsize);
+
+  /// Size class for a small block of the given size, -1 for large blocks.
+  static int sizeClass(size_t size);
+  /// Size of the blocks of a small size class.
+  static size_t classSize(int sc);
+
+  void* allocBlock(size_t size);
+  void  freeBlock(void* ptr, size_t size);
+
+  /// Returns a block of the given class, carving it from the current chunk
+  /// if its free list is empty.
+  void* allocSmall(int sc);
+
+  /// Shrinks ptr into a small block of nsize bytes without allocating a new
+  /// one. Returns NULL if that is not possible either.
+  void* shrinkInPlace(void* ptr, size_t osize, size_t nsize);
+
+  FreeBlock*          mFreeLists[NUM_CLASSES];
+  /// Chunks are linked through their first bytes.
+  FreeBlock*          mChunks;
+  char*               mChunkPos;
+  char*               mChunkEnd;
+
+  int                 mCommandDepth;
+  uint64_t            mCommandStartAllocs;
+
+  LuaMemStats         mStats;
+};
+
+} // namespace tuvok
+
+#endif
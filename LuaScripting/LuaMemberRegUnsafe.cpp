@@ -126,6 +126,7 @@ void LuaMemberRegUnsafe::unregisterHooks()
     // destructor).
     lua_pushnil(L);
     lua_setfield(L, -2, mHookID.c_str());
+    mScriptSystem->updateExecFlags(lua_gettop(L) - 1);
 
     // Pop function table and hooks table off the stack.
     lua_pop(L, 2);
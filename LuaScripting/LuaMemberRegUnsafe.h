@@ -144,19 +144,15 @@ private:
       {
         LuaScripting* ss = static_cast<LuaScripting*>(
             lua_touserdata(L, lua_upvalueindex(4)));
-
-        std::shared_ptr<LuaCFunAbstract> execParams(
-            new LuaCFunExec<FunPtr>());
-        std::shared_ptr<LuaCFunAbstract> emptyParams(
-            new LuaCFunExec<FunPtr>());
-        // Fill execParams. Function parameters start at index 2 (callable
-        // table starts at index 1).
-        execParams->pullParamsFromStack(L, 2);
+        int execFlags = static_cast<int>(
+            lua_tointeger(L, lua_upvalueindex(5)));
 
         // Obtain reference to LuaScripting to invoke provenance.
         // See createCallableFuncTable for justification on pulling an
         // instance of LuaScripting out of Lua.
-        bool provExempt = ss->doProvenanceFromExec(L, execParams, emptyParams);
+        // Function parameters start at index 2 (callable table starts at
+        // index 1).
+        bool provExempt = ss->doProvenanceFromExec<FunPtr>(L, execFlags);
 
         ss->beginCommand();
         try
@@ -177,7 +173,7 @@ private:
         }
         ss->endCommand();
 
-        ss->doHooks(L, 1, provExempt);
+        ss->doHooks(L, 1, provExempt, execFlags);
       }
       else
       {
@@ -206,14 +202,10 @@ private:
       {
         LuaScripting* ss = static_cast<LuaScripting*>(
             lua_touserdata(L, lua_upvalueindex(4)));
+        int execFlags = static_cast<int>(
+            lua_tointeger(L, lua_upvalueindex(5)));
 
-        std::shared_ptr<LuaCFunAbstract> execParams(
-            new LuaCFunExec<FunPtr>());
-        std::shared_ptr<LuaCFunAbstract> emptyParams(
-            new LuaCFunExec<FunPtr>());
-        execParams->pullParamsFromStack(L, 2);
-
-        bool provExempt = ss->doProvenanceFromExec(L, execParams, emptyParams);
+        bool provExempt = ss->doProvenanceFromExec<FunPtr>(L, execFlags);
 
         ss->beginCommand();
         try
@@ -234,7 +226,7 @@ private:
         }
         ss->endCommand();
 
-        ss->doHooks(L, 1, provExempt);
+        ss->doHooks(L, 1, provExempt, execFlags);
       }
       else
       {
@@ -281,7 +273,8 @@ std::string LuaMemberRegUnsafe::registerFunction(T* C, FunPtr f,
   // deregisters all functions it has registered, so no residual light
   // user data will be left in Lua.
   lua_pushlightuserdata(L, static_cast<void*>(mScriptSystem));
-  lua_pushcclosure(L, proxyFunc, 4);
+  lua_pushinteger(L, 0);  // ExecFlags, see LuaScripting::updateExecFlags.
+  lua_pushcclosure(L, proxyFunc, 5);
 
   // Associate closure with __call metamethod.
   lua_setfield(L, -2, "__call");
@@ -415,6 +408,7 @@ void LuaMemberRegUnsafe::strictHookInternal(
   {
     // Associate closure with hook table.
     lua_setfield(L, hookTable, mHookID.c_str());
+    mScriptSystem->updateExecFlags(funcTable);
     mHookedFunctions.push_back(name);
   }
   else
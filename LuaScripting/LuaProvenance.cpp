@@ -136,6 +136,16 @@ bool LuaProvenance::isEnabled() const
   return mEnabled;
 }
 
+//-----------------------------------------------------------------------------
+bool LuaProvenance::isRecording() const
+{
+  if (mTemporarilyDisabled || mEnabled == false)
+    return false;
+
+  // Reentry either throws from logExecution or is ignored.
+  return mLoggingProvenance == false || mDoProvReenterException;
+}
+
 //-----------------------------------------------------------------------------
 void LuaProvenance::enableLogAll(bool enabled)
 {
@@ -466,13 +476,16 @@ void LuaProvenance::issueUndoInternal()
     // Iterate through all of the children, and undo those as well.
     // Note: Notice, we are undoing the parent first, then all of the children.
     //       This constitutes a reversal of the function calls from redo.
-
-    for (std::vector<UndoRedoItem>::iterator it = undoItem.childItems->begin();
-         it != undoItem.childItems->end(); it++)
+    //       The children of a command group were not called by the parent but
+    //       one after another, so they are undone last to first.
+    std::vector<UndoRedoItem>& children = *undoItem.childItems;
+    for (size_t i = 0; i < children.size(); ++i)
     {
+      const UndoRedoItem& child = undoItem.alsoRedoChildren
+          ? children[children.size() - 1 - i] : children[i];
       try
       {
-        performUndoRedoOp(it->function, it->undoParams, true);
+        performUndoRedoOp(child.function, child.undoParams, true);
       }
       catch (LuaProvenanceInvalidUndoOrRedo& e)
       {
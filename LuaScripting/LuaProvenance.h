@@ -55,6 +55,10 @@ public:
   bool isEnabled() const;
   void setEnabled(bool enabled);
 
+  /// Returns false if logExecution would return without recording anything.
+  /// Lets callers skip gathering the function parameters.
+  bool isRecording() const;
+
   /// Enable/Disable provenance logs of all commands.
   void enableLogAll(bool enabled);
 
@@ -40,6 +40,7 @@
 
 #include "StdTuvokDefines.h"
 #include <sstream>
+#include <chrono>
 #include <cstring>
 #include <functional>
 #include <iostream>
@@ -61,11 +62,15 @@
 
 #include "LuaScripting.h"
 #include "LuaProvenance.h"
+#include "LuaChunkCache.h"
 
 using namespace std;
 
 #define QUALIFIED_NAME_DELIMITER  "."
 
+// Commands kept compiled by exec and execRet.
+#define DEFAULT_CHUNK_CACHE_SIZE  256
+
 // Disable "'this' used in base member initializer list warning"
 // this is not referenced in either of the initialized classes,
 // but is merely stored.
@@ -86,6 +91,8 @@ const char* LuaScripting::TBL_MD_FUN_PDEFS      = "tblDefaults";
 const char* LuaScripting::TBL_MD_FUN_LAST_EXEC  = "tblLastExec";
 const char* LuaScripting::TBL_MD_HOOKS          = "tblHooks";
 const char* LuaScripting::TBL_MD_HOOK_INDEX     = "hookIndex";
+const char* LuaScripting::TBL_MD_HOOK_LIST      = "tblHookList";
+const char* LuaScripting::TBL_MD_NUM_STATIC_HOOKS = "numStaticHooks";
 const char* LuaScripting::TBL_MD_MEMBER_HOOKS   = "tblMHooks";
 const char* LuaScripting::TBL_MD_CPP_CLASS      = "scriptingCPP";
 const char* LuaScripting::TBL_MD_STACK_EXEMPT   = "stackExempt";
@@ -113,7 +120,8 @@ const char* LuaScripting::TBL_MD_TYPES_TABLE    = "typesTable";
 
 //-----------------------------------------------------------------------------
 LuaScripting::LuaScripting()
-: mMemberHookIndex(0)
+: mMemAllocator(new LuaMemAllocator())
+, mMemberHookIndex(0)
 , mGlobalInstanceID(0)
 , mGlobalTempInstRange(false)
 , mGlobalTempInstLow(0)
@@ -124,10 +132,17 @@ LuaScripting::LuaScripting()
 , mClassCons(new LuaClassConstructor(this))
 , mVerboseMode(false)
 {
-  mL = lua_newstate(luaInternalAlloc, NULL);
+  mL = lua_newstate(&LuaMemAllocator::luaAlloc, mMemAllocator.get());
 
   if (mL == NULL) throw LuaError("Failed to initialize Lua.");
 
+  mChunkCache.reset(new LuaChunkCache(mL, DEFAULT_CHUNK_CACHE_SIZE));
+
+  mHookStats.hookedCalls      = 0;
+  mHookStats.hooklessCalls    = 0;
+  mHookStats.hooksDispatched  = 0;
+  mHookStats.seconds          = 0.0;
+
   lua_atpanic(mL, &luaPanic);
   luaL_openlibs(mL);
 
@@ -201,6 +216,34 @@ void LuaScripting::removeAllRegistrations()
   unregisterAllFunctions();
 }
 
+//-----------------------------------------------------------------------------
+int LuaScripting::hookErrorHandler(lua_State* L)
+{
+  const char* msg = lua_tostring(L, 1);
+  luaL_traceback(L, L, msg != NULL ? msg : "(error object is not a string)",
+                 1);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+LuaScripting::HookStats LuaScripting::getHookStats() const
+{
+  HookStats stats = mHookStats;
+  stats.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  return stats;
+}
+
+//-----------------------------------------------------------------------------
+double LuaScripting::HookStats::hooksPerSecond(const HookStats& earlier) const
+{
+  double seconds = this->seconds - earlier.seconds;
+  if (seconds <= 0.0)
+    return 0.0;
+  return static_cast<double>(hooksDispatched - earlier.hooksDispatched)
+      / seconds;
+}
+
 #ifdef DETECTED_OS_WINDOWS
 #pragma warning( disable : 4702 )  // Unreachable code warning.
 #endif
@@ -255,22 +298,6 @@ int LuaScripting::luaPanic(lua_State* L)
 #pragma warning(default:4702)  // Reenable unreachable code warning
 #endif
 
-//-----------------------------------------------------------------------------
-void* LuaScripting::luaInternalAlloc(void* /*ud*/, void* ptr, size_t /*osize*/,
-                                     size_t nsize)
-{
-  // TODO: Convert to use new (mind the realloc).
-  if (nsize == 0)
-  {
-    free(ptr);
-    return NULL;
-  }
-  else
-  {
-    return realloc(ptr, nsize);
-  }
-}
-
 //-----------------------------------------------------------------------------
 static int nopFun()
 {
@@ -370,6 +397,65 @@ void LuaScripting::registerScriptFunctions()
       "system.", true);
 
   registerLuaUtilityFunctions();
+  registerMemoryFunctions();
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::registerMemoryFunctions()
+{
+  mMemberReg->registerFunction(this, &LuaScripting::getMemoryLiveBytes,
+                               "luaMemory.liveBytes",
+                               "Bytes currently allocated by Lua.",
+                               false);
+  setProvenanceExempt("luaMemory.liveBytes");
+
+  mMemberReg->registerFunction(this, &LuaScripting::getMemoryPeakBytes,
+                               "luaMemory.peakBytes",
+                               "Maximum number of bytes allocated by Lua.",
+                               false);
+  setProvenanceExempt("luaMemory.peakBytes");
+
+  mMemberReg->registerFunction(this, &LuaScripting::getMemoryAllocsPerCommand,
+                               "luaMemory.allocsPerCommand",
+                               "Average number of Lua allocations made by a "
+                               "top level command.",
+                               false);
+  setProvenanceExempt("luaMemory.allocsPerCommand");
+
+  mMemberReg->registerFunction(this, &LuaScripting::setMemoryLimit,
+                               "luaMemory.setLimit",
+                               "Limits the bytes Lua may allocate, 0 removes "
+                               "the limit. Exceeding it raises an error.",
+                               false);
+  setProvenanceExempt("luaMemory.setLimit");
+
+  mMemberReg->registerFunction(this, &LuaScripting::getMemoryLimit,
+                               "luaMemory.getLimit",
+                               "Returns the limit set with setLimit.",
+                               false);
+  setProvenanceExempt("luaMemory.getLimit");
+}
+
+//-----------------------------------------------------------------------------
+LuaMemStats LuaScripting::getMemoryStats() const
+{
+  return mMemAllocator->getStats();
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::setMemoryLimit(uint64_t bytes)
+{
+  mMemAllocator->setLimit(bytes);
+}
+
+//-----------------------------------------------------------------------------
+double LuaScripting::getMemoryAllocsPerCommand() const
+{
+  const LuaMemStats& stats = mMemAllocator->getStats();
+  if (stats.commands == 0)
+    return 0.0;
+  return static_cast<double>(stats.commandAllocations) /
+         static_cast<double>(stats.commands);
 }
 
 //-----------------------------------------------------------------------------
@@ -1650,7 +1736,8 @@ void LuaScripting::createCallableFuncTable(lua_CFunction proxyFunc,
   // deregisters all functions it has registered, so no residual light
   // user data will be left in Lua.
   lua_pushlightuserdata(mL, static_cast<void*>(this));
-  lua_pushcclosure(mL, proxyFunc, 3);
+  lua_pushinteger(mL, 0);   // ExecFlags, see updateExecFlags.
+  lua_pushcclosure(mL, proxyFunc, 4);
 
   // Associate closure with __call metamethod.
   lua_setfield(mL, -2, "__call");
@@ -1716,6 +1803,12 @@ void LuaScripting::populateWithMetadata(const std::string& name,
   lua_pushinteger(mL, 0);
   lua_setfield(mL, tableIndex, TBL_MD_HOOK_INDEX);
 
+  lua_newtable(mL);
+  lua_setfield(mL, tableIndex, TBL_MD_HOOK_LIST);
+
+  lua_pushinteger(mL, 0);
+  lua_setfield(mL, tableIndex, TBL_MD_NUM_STATIC_HOOKS);
+
   lua_pushboolean(mL, 0);
   lua_setfield(mL, tableIndex, TBL_MD_STACK_EXEMPT);
 
@@ -1963,100 +2056,59 @@ void LuaScripting::unregisterFunction(const std::string& fqName)
 }
 
 //-----------------------------------------------------------------------------
-void LuaScripting::doHooks(lua_State* L, int tableIndex, bool provExempt)
+void LuaScripting::dispatchHooks(lua_State* L, int tableIndex,
+                                 bool provExempt)
 {
   int stackTop = lua_gettop(L);
   int numArgs = stackTop - tableIndex;
 
   lua_checkstack(L, numArgs + 3);
 
-  int numStaticHooks = 0;
+  // Static hooks come first in the hook list, followed by member hooks.
+  // The list is rebuilt by updateExecFlags whenever the hooks tables change.
+  lua_getfield(L, tableIndex, TBL_MD_NUM_STATIC_HOOKS);
+  int numStaticHooks = static_cast<int>(lua_tointeger(L, -1));
+  lua_pop(L, 1);
 
-  // Obtain the hooks table and iterate over it calling the lua closures.
-  lua_getfield(L, tableIndex, TBL_MD_HOOKS);
-  int hookTable = lua_gettop(L);
+  lua_getfield(L, tableIndex, TBL_MD_HOOK_LIST);
+  int hookList = lua_gettop(L);
+  int numHooks = static_cast<int>(lua_rawlen(L, hookList));
 
-  try
-  {
-    lua_pushnil(L);
-    while (lua_next(L, hookTable))
-    {
-      // The value at the top of the stack is the lua closure to call.
-      // This call will automatically pop the function off the stack,
-      // so we don't need a pop at the end of the loop
+  // One message handler serves all hooks of the call.
+  lua_pushcfunction(L, &hookErrorHandler);
+  int errorHandler = lua_gettop(L);
 
-      // Push all of the arguments.
-      for (int i = 0; i < numArgs; i++)
-      {
-        lua_pushvalue(L, tableIndex + i + 1);
-      }
-      lua_pcall(L, numArgs, 0, 0);
+  ++mHookStats.hookedCalls;
 
-      ++numStaticHooks;
-    }
-    lua_pop(L, 1);  // Remove the hooks table.
-  }
-  catch (exception& e)
-  {
-    ostringstream os;
-    os << " Static Hook: " << e.what();
-    logExecFailure(os.str());
-    throw;
-  }
-  catch (...)
+  for (int h = 1; h <= numHooks; ++h)
   {
-    ostringstream os;
-    os << " Static Hook";
-    logExecFailure(os.str());
-    throw;
-  }
-
-  int numMemberHooks = 0;
-
-  // Obtain the member function hooks table, and iterate over it.
-  // XXX: Update to allow classes to register multiple hook for one function
-  //      I don't see a need for this now, so I'm not implementing it.
-  //      But a way to do it would be to make this member hooks table contain
-  //      tables named after the member hook references, and index the
-  //      function much like we index them in the hooks table above (with an
-  //      index stored in the table).
-  lua_getfield(L, tableIndex, TBL_MD_MEMBER_HOOKS);
-  hookTable = lua_gettop(L);
+    lua_rawgeti(L, hookList, h);
 
-  try
-  {
-    lua_pushnil(L);
-    while (lua_next(L, hookTable))
+    // Every call consumes its arguments, so they are pushed again for each
+    // hook (pushing copies references only).
+    for (int i = 0; i < numArgs; i++)
     {
-      // Push all of the arguments.
-      for (int i = 0; i < numArgs; i++)
-      {
-        lua_pushvalue(L, tableIndex + i + 1);
-      }
-      lua_pcall(L, numArgs, 0, 0);
+      lua_pushvalue(L, tableIndex + i + 1);
+    }
 
-      ++numMemberHooks;
+    // The hooked function has already run, so a failing hook is logged and
+    // does not fail the call.
+    if (lua_pcall(L, numArgs, 0, errorHandler) != LUA_OK)
+    {
+      const char* error = lua_tostring(L, -1);
+      ostringstream os;
+      os << (h <= numStaticHooks ? " Static Hook: " : " Member Hook: ")
+         << (error != NULL ? error : "unknown error");
+      logExecFailure(os.str());
+      lua_pop(L, 1);
     }
-    lua_pop(L, 1);  // Remove the member hooks table.
-  }
-  catch (exception& e)
-  {
-    ostringstream os;
-    os << " Member Hook: " << e.what();
-    logExecFailure(os.str());
-    throw;
-  }
-  catch (...)
-  {
-    ostringstream os;
-    os << " Member Hook";
-    logExecFailure(os.str());
-    throw;
+
+    ++mHookStats.hooksDispatched;
   }
+  lua_pop(L, 2);  // Remove the error handler and the hook list.
 
-  int totalHooks = numStaticHooks + numMemberHooks;
-  if (totalHooks > 0 && provExempt == false)
-    mProvenance->logHooks(numStaticHooks, numMemberHooks);
+  if (numHooks > 0 && provExempt == false)
+    mProvenance->logHooks(numStaticHooks, numHooks - numStaticHooks);
 
   assert(stackTop == lua_gettop(L));
 }
@@ -2071,39 +2123,97 @@ std::string LuaScripting::getNewMemberHookID()
 }
 
 //-----------------------------------------------------------------------------
-bool LuaScripting::doProvenanceFromExec(lua_State* L,
-                            std::shared_ptr<LuaCFunAbstract> funParams,
-                            std::shared_ptr<LuaCFunAbstract> emptyParams)
+bool LuaScripting::isProvenanceExempt(int execFlags) const
 {
-  if (mProvenance->isEnabled())
-  {
-    // Obtain fully qualified function name (doProvenanceFromExec is executed
-    // from the context of the exec function in one of the LuaCallback structs).
-    lua_getfield(L, 1, LuaScripting::TBL_MD_QNAME);
-    std::string fqName = lua_tostring(L, -1);
-    lua_pop(L, 1);
+  return mProvenance->isEnabled() == false ||
+         (execFlags & EXEC_PROV_EXEMPT) != 0;
+}
 
-    lua_getfield(L, 1, LuaScripting::TBL_MD_STACK_EXEMPT);
-    bool stackExempt = lua_toboolean(L, -1) ? true : false;
-    lua_pop(L, 1);
+//-----------------------------------------------------------------------------
+bool LuaScripting::isProvenanceRecording() const
+{
+  return mProvenance->isRecording();
+}
 
-    lua_getfield(L, 1, LuaScripting::TBL_MD_PROV_EXEMPT);
-    bool provExempt = lua_toboolean(L, -1) ? true : false;
-    lua_pop(L, 1);
+//-----------------------------------------------------------------------------
+void LuaScripting::logProvenanceFromExec(
+    lua_State* L, int execFlags,
+    std::shared_ptr<LuaCFunAbstract> funParams,
+    std::shared_ptr<LuaCFunAbstract> emptyParams)
+{
+  // Obtain fully qualified function name (this is executed from the context
+  // of the exec function in one of the LuaCallback structs).
+  lua_getfield(L, 1, LuaScripting::TBL_MD_QNAME);
+  std::string fqName = lua_tostring(L, -1);
+  lua_pop(L, 1);
 
-    if (provExempt == false)
+  mProvenance->logExecution(fqName,
+                            (execFlags & EXEC_STACK_EXEMPT) != 0,
+                            funParams,
+                            emptyParams);
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::updateExecFlags(int tableIndex)
+{
+  LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
+
+  lua_State* L = mL;
+  int execFlags = 0;
+
+  lua_getfield(L, tableIndex, TBL_MD_STACK_EXEMPT);
+  if (lua_toboolean(L, -1)) execFlags |= EXEC_STACK_EXEMPT;
+  lua_pop(L, 1);
+
+  lua_getfield(L, tableIndex, TBL_MD_PROV_EXEMPT);
+  if (lua_toboolean(L, -1)) execFlags |= EXEC_PROV_EXEMPT;
+  lua_pop(L, 1);
+
+  // Gather the closures of both hook tables into the hook list, so calls
+  // do not have to walk the tables.
+  lua_newtable(L);
+  int hookList = lua_gettop(L);
+  int numHooks = 0;
+  int numStaticHooks = 0;
+  const char* hookTables[] = {TBL_MD_HOOKS, TBL_MD_MEMBER_HOOKS};
+  for (int t = 0; t < 2; ++t)
+  {
+    lua_getfield(L, tableIndex, hookTables[t]);
+    if (lua_istable(L, -1))
     {
-      // Execute provenace.
-      mProvenance->logExecution(fqName,
-                                stackExempt,
-                                funParams,
-                                emptyParams);
+      int hookTable = lua_gettop(L);
+      lua_pushnil(L);
+      while (lua_next(L, hookTable))
+      {
+        lua_rawseti(L, hookList, ++numHooks);
+      }
     }
+    lua_pop(L, 1);
+    if (t == 0) numStaticHooks = numHooks;
+  }
+  lua_setfield(L, tableIndex, TBL_MD_HOOK_LIST);
+  lua_pushinteger(L, numStaticHooks);
+  lua_setfield(L, tableIndex, TBL_MD_NUM_STATIC_HOOKS);
+  if (numHooks > 0) execFlags |= EXEC_HAS_HOOKS;
 
-    return provExempt;
+  if (lua_getmetatable(L, tableIndex) == 0)
+    return;
+  lua_getfield(L, -1, "__call");
+
+  // The flags are always the closure's last upvalue.
+  int numUpvalues = 0;
+  while (lua_getupvalue(L, -1, numUpvalues + 1) != NULL)
+  {
+    lua_pop(L, 1);
+    ++numUpvalues;
+  }
+  if (numUpvalues > 0)
+  {
+    lua_pushinteger(L, execFlags);
+    lua_setupvalue(L, -2, numUpvalues);
   }
 
-  return true;
+  lua_pop(L, 2);  // Closure and metatable.
 }
 
 //-----------------------------------------------------------------------------
@@ -2128,6 +2238,8 @@ void LuaScripting::setUndoRedoStackExempt(const string& funcName)
   lua_pushnil(L);
   lua_setfield(L, -2, TBL_MD_FUN_LAST_EXEC);
 
+  updateExecFlags(lua_gettop(L));
+
   // Pop off the function table.
   lua_pop(L, 1);
 }
@@ -2149,6 +2261,8 @@ void LuaScripting::setProvenanceExempt(const std::string& fqName)
   lua_pushboolean(L, 1);
   lua_setfield(L, -2, TBL_MD_PROV_EXEMPT);
 
+  updateExecFlags(lua_gettop(L));
+
   // Pop off the function table.
   lua_pop(L, 1);
 }
@@ -2234,8 +2348,63 @@ void LuaScripting::executeFunctionOnStack(int nparams, int nret)
 void LuaScripting::exec(const std::string& cmd)
 {
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
-  luaL_loadstring(mL, cmd.c_str());
-  lua_call(mL, 0, 0);
+  int numArgs = pushChunk(cmd);
+  lua_call(mL, numArgs, 0);
+}
+
+//-----------------------------------------------------------------------------
+int LuaScripting::pushChunk(const std::string& chunk)
+{
+  // A syntax error leaves the message on the stack, calling it raises the
+  // error.
+  int numArgs = 0;
+  mChunkCache->push(chunk, numArgs);
+  return numArgs;
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::precompile(const std::string& cmd)
+{
+  LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
+  int numArgs = 0;
+  if (mChunkCache->push(cmd, numArgs) != LUA_OK)
+  {
+    std::ostringstream os;
+    os << "Unable to compile '" << cmd << "': " << lua_tostring(mL, -1);
+    lua_pop(mL, 1);
+    throw LuaError(os.str());
+  }
+  lua_pop(mL, 1 + numArgs);
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::precompileRet(const std::string& cmd)
+{
+  precompile("return " + cmd);
+}
+
+//-----------------------------------------------------------------------------
+void LuaScripting::setChunkCacheSize(size_t numChunks)
+{
+  mChunkCache->setMaxEntries(numChunks);
+}
+
+//-----------------------------------------------------------------------------
+size_t LuaScripting::getChunkCacheSize() const
+{
+  return mChunkCache->getMaxEntries();
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long LuaScripting::getChunkCacheHits() const
+{
+  return mChunkCache->getHits();
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long LuaScripting::getChunkCacheMisses() const
+{
+  return mChunkCache->getMisses();
 }
 
 //-----------------------------------------------------------------------------
@@ -2246,6 +2415,61 @@ void LuaScripting::cexec(const std::string& cmd)
   executeFunctionOnStack(0, 0);
 }
 
+//-----------------------------------------------------------------------------
+void LuaScripting::cexecBatch(const LuaCommandBatch& batch)
+{
+  LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
+
+  if (batch.getNumCalls() == 0) return;
+
+  // Function i's __call closure and table are stored at 2i+1 and 2i+2 once
+  // it has been looked up. Functions are looked up on their first call, so
+  // functions registered by earlier calls in the batch are found.
+  int resolvedCount = static_cast<int>(batch.getNumFunctions()) * 2;
+  lua_createtable(mL, resolvedCount, 0);
+  int resolved = lua_gettop(mL);
+
+  bool group = batch.getNumCalls() > 1 && mProvenance->isEnabled();
+  if (group) beginCommandGroup();
+
+  try
+  {
+    for (std::vector<LuaCommandBatch::Call>::const_iterator it =
+         batch.mCalls.begin(); it != batch.mCalls.end(); ++it)
+    {
+      if (!it->params) continue;
+
+      int closureIndex = it->function * 2 + 1;
+      lua_rawgeti(mL, resolved, closureIndex);
+      if (lua_isnil(mL, -1))
+      {
+        lua_pop(mL, 1);
+        prepForExecution(batch.mFunctions[it->function]);
+        lua_pushvalue(mL, -2);
+        lua_rawseti(mL, resolved, closureIndex);
+        lua_pushvalue(mL, -1);
+        lua_rawseti(mL, resolved, closureIndex + 1);
+      }
+      else
+      {
+        lua_rawgeti(mL, resolved, closureIndex + 1);
+      }
+
+      int nparams = it->params->push(mL);
+      executeFunctionOnStack(nparams, 0);
+    }
+  }
+  catch (...)
+  {
+    lua_settop(mL, resolved - 1);
+    if (group) endCommandGroup();
+    throw;
+  }
+
+  lua_pop(mL, 1);
+  if (group) endCommandGroup();
+}
+
 //-----------------------------------------------------------------------------
 void LuaScripting::resetFunDefault(int argumentPos, int ftableStackPos)
 {
@@ -2300,11 +2524,13 @@ void LuaScripting::setTempProvDisable(bool disable)
 void LuaScripting::beginCommand()
 {
   mProvenance->beginCommand();
+  mMemAllocator->beginCommand();
 }
 
 //-----------------------------------------------------------------------------
 void LuaScripting::endCommand()
 {
+  mMemAllocator->endCommand();
   mProvenance->endCommand();
 }
 
@@ -2989,6 +3215,65 @@ SUITE(TestLuaScriptingSystem)
     sc->setExpectedExceptionFlag(false);
   }
 
+  int hookCount = 0;
+  void countingHook(int)  {++hookCount;}
+  void failingHook(int)   {throw LuaError("failing hook");}
+  void hookedFun(int)     {}
+
+  TEST(HookDispatch)
+  {
+    TEST_HEADER;
+
+    unique_ptr<LuaScripting> sc(new LuaScripting());
+    sc->enableProvenance(false);
+
+    sc->registerFunction(&hookedFun, "hooked", "", false);
+    sc->registerFunction(&hookedFun, "hookless", "", false);
+    sc->strictHook(&countingHook, "hooked");
+    sc->strictHook(&countingHook, "hooked");
+
+    LuaScripting::HookStats before = sc->getHookStats();
+    hookCount = 0;
+    sc->cexec("hookless", 1);
+    CHECK_EQUAL(before.hookedCalls, sc->getHookStats().hookedCalls);
+    CHECK_EQUAL(before.hooklessCalls + 1, sc->getHookStats().hooklessCalls);
+    CHECK_EQUAL(0, hookCount);
+
+    sc->cexec("hooked", 1);
+    CHECK_EQUAL(before.hookedCalls + 1, sc->getHookStats().hookedCalls);
+    CHECK_EQUAL(before.hooksDispatched + 2,
+                sc->getHookStats().hooksDispatched);
+    CHECK_EQUAL(2, hookCount);
+
+    const int n = 1000;
+    before = sc->getHookStats();
+    hookCount = 0;
+    for (int i = 0; i < n; i++)
+    {
+      sc->cexec("hookless", i);
+      sc->cexec("hooked", i);
+    }
+    CHECK_EQUAL(before.hooklessCalls + n, sc->getHookStats().hooklessCalls);
+    CHECK_EQUAL(before.hookedCalls + n, sc->getHookStats().hookedCalls);
+    LuaScripting::HookStats after = sc->getHookStats();
+    CHECK_EQUAL(before.hooksDispatched + 2 * n, after.hooksDispatched);
+    CHECK_EQUAL(2 * n, hookCount);
+    CHECK(after.hooksPerSecond(before) > 0.0);
+
+    // A failing hook neither fails the call nor stops the other hooks.
+    sc->registerFunction(&hookedFun, "failHooked", "", false);
+    sc->strictHook(&failingHook, "failHooked");
+    sc->strictHook(&countingHook, "failHooked");
+    before = sc->getHookStats();
+    hookCount = 0;
+    sc->setExpectedExceptionFlag(true);
+    sc->cexec("failHooked", 1);
+    sc->setExpectedExceptionFlag(false);
+    CHECK_EQUAL(1, hookCount);
+    CHECK_EQUAL(before.hooksDispatched + 2,
+                sc->getHookStats().hooksDispatched);
+  }
+
   static int    i1  = 0;
   static string s1  = "nop";
   static bool   b1  = false;
@@ -3373,6 +3658,82 @@ SUITE(TestLuaScriptingSystem)
     CHECK_EQUAL("ref 1", r1.c_str());
   }
 
+  int batchA;
+  int batchACalls;
+  std::string batchB;
+
+  void setBatchA(int a)
+  {
+    batchA = a;
+    ++batchACalls;
+  }
+
+  void setBatchB(const std::string& b)
+  {
+    batchB = b;
+  }
+
+  TEST(TestCommandBatch)
+  {
+    TEST_HEADER;
+
+    unique_ptr<LuaScripting> sc(new LuaScripting());
+
+    sc->registerFunction(&setBatchA, "batch.a", "", true);
+    sc->setDefaults("batch.a", 0, true);
+    sc->registerFunction(&setBatchB, "batch.b", "", true);
+    sc->setDefaults("batch.b", "none", true);
+
+    LuaCommandBatch batch;
+    batch.add("batch.a", 1);
+    batch.add("batch.b", "one");
+    batch.add("batch.a", 2);
+    CHECK_EQUAL(3u, batch.getNumCalls());
+    CHECK_EQUAL(2u, batch.getNumFunctions());
+
+    batchACalls = 0;
+    sc->cexecBatch(batch);
+    CHECK_EQUAL(2, batchA);
+    CHECK_EQUAL(2, batchACalls);
+    CHECK_EQUAL("one", batchB.c_str());
+
+    // The whole batch is undone at once.
+    sc->cexec("provenance.undo");
+    CHECK_EQUAL(0, batchA);
+    CHECK_EQUAL("none", batchB.c_str());
+    sc->cexec("provenance.redo");
+    CHECK_EQUAL(2, batchA);
+    CHECK_EQUAL("one", batchB.c_str());
+
+    // Coalescing only runs the last call to each function.
+    LuaCommandBatch coalesced(true);
+    for (int i = 10; i <= 20; i++)
+      coalesced.add("batch.a", i);
+    coalesced.add("batch.b", "two");
+    CHECK_EQUAL(2u, coalesced.getNumCalls());
+
+    batchACalls = 0;
+    sc->cexecBatch(coalesced);
+    CHECK_EQUAL(20, batchA);
+    CHECK_EQUAL(1, batchACalls);
+    CHECK_EQUAL("two", batchB.c_str());
+
+    sc->cexec("provenance.undo");
+    CHECK_EQUAL(2, batchA);
+    CHECK_EQUAL("one", batchB.c_str());
+
+    // Calls before a failing one stay executed.
+    LuaCommandBatch failing;
+    failing.add("batch.a", 5);
+    failing.add("batch.missing", 6);
+    failing.add("batch.b", "three");
+    sc->setExpectedExceptionFlag(true);
+    CHECK_THROW(sc->cexecBatch(failing), LuaNonExistantFunction);
+    sc->setExpectedExceptionFlag(false);
+    CHECK_EQUAL(5, batchA);
+    CHECK_EQUAL("one", batchB.c_str());
+  }
+
   vector<int>     vecA;
   vector<string>  vecB;
 
@@ -3429,6 +3790,223 @@ SUITE(TestLuaScriptingSystem)
     CHECK_EQUAL(true, equal(vecB.begin(), vecB.end(), strArray, predString));
   }
 
+  // Runs the trampolines of a few signatures n times. The functions returning
+  // strings get the same arguments every time, so their results are interned
+  // after the first call.
+  void callBound(LuaScripting* sc, int n)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      sc->cexec("calls.dfun", i, 2, 3);
+      sc->cexec("calls.str_int2", 978, 42);
+      sc->cexec("calls.mixer", true, 10, 12.6f, 392.9, string("My sTrIng"));
+    }
+  }
+
+  struct CallCost
+  {
+    double luaAllocs;   ///< Lua allocations per call.
+    double heapBlocks;  ///< Parameter objects taken from the heap per call.
+  };
+
+  CallCost callCost(LuaScripting* sc, int n)
+  {
+    uint64_t allocs = sc->getMemoryStats().allocations;
+    unsigned long long blocks = luaFreeListHeapBlocks();
+    callBound(sc, n);
+    // 3 calls per iteration.
+    CallCost cost;
+    cost.luaAllocs  = double(sc->getMemoryStats().allocations - allocs) / (3*n);
+    cost.heapBlocks = double(luaFreeListHeapBlocks() - blocks) / (3*n);
+    return cost;
+  }
+
+  // Timings are up to tvkbench --lua; here the calls are checked not to
+  // allocate unless provenance records them.
+  TEST(BenchmarkFunctionCalls)
+  {
+    TEST_HEADER;
+
+    unique_ptr<LuaScripting> sc(new LuaScripting());
+
+    sc->registerFunction(&dfun, "calls.dfun", "", true);
+    sc->registerFunction(&str_int2, "calls.str_int2", "", true);
+    sc->registerFunction(&mixer, "calls.mixer", "", true);
+
+    // Interns the strings and grows the stack.
+    sc->enableProvenance(false);
+    callBound(sc.get(), 10);
+
+    CallCost cost = callCost(sc.get(), 1000);
+    CHECK_EQUAL(0.0, cost.luaAllocs);
+    CHECK_EQUAL(0.0, cost.heapBlocks);
+
+    sc->enableProvenance(true);
+    cost = callCost(sc.get(), 1000);
+    CHECK(cost.heapBlocks > 0.0);
+
+    sc->setProvenanceExempt("calls.dfun");
+    sc->setProvenanceExempt("calls.str_int2");
+    sc->setProvenanceExempt("calls.mixer");
+    cost = callCost(sc.get(), 1000);
+    CHECK_EQUAL(0.0, cost.luaAllocs);
+    CHECK_EQUAL(0.0, cost.heapBlocks);
+  }
+
+  TEST(TestProvenanceExemptCalls)
+  {
+    TEST_HEADER;
+
+    unique_ptr<LuaScripting> sc(new LuaScripting());
+
+    sc->registerFunction(&dfun, "calls.dfun", "", true);
+    sc->registerFunction(&str_int2, "calls.str_int2", "", true);
+    sc->registerFunction(&mixer, "calls.mixer", "", true);
+    sc->registerFunction(&set_i1, "calls.set_i1", "", true);
+
+    sc->enableProvenance(false);
+    callBound(sc.get(), 100);
+    sc->enableProvenance(true);
+    callBound(sc.get(), 100);
+
+    sc->cexec("calls.set_i1", 1);
+    sc->cexec("calls.set_i1", 2);
+
+    // Exempt calls run, but do not end up on the undo stack.
+    sc->setProvenanceExempt("calls.dfun");
+    sc->setProvenanceExempt("calls.str_int2");
+    sc->setProvenanceExempt("calls.mixer");
+    callBound(sc.get(), 100);
+
+    sc->cexec("provenance.undo");
+    CHECK_EQUAL(1, i1);
+
+    CHECK_EQUAL(42, sc->execRet<int>("calls.dfun(1,2,39)"));
+  }
+
+  TEST(TestMemoryLimit)
+  {
+    TEST_HEADER;
+
+    unique_ptr<LuaScripting> sc(new LuaScripting());
+
+    sc->registerFunction(&str_int, "str.int", "", true);
+    for (int i = 0; i < 100; i++)
+      sc->cexec("str.int", i);
+
+    LuaMemStats stats = sc->getMemoryStats();
+    CHECK_EQUAL(true, stats.liveBytes > 0);
+    CHECK_EQUAL(true, stats.peakBytes >= stats.liveBytes);
+    CHECK_EQUAL(true, stats.commands >= 100);
+    CHECK_EQUAL(true, sc->execRet<double>("luaMemory.liveBytes()") > 0.0);
+
+    // 1MB more than we are using now.
+    sc->exec("luaMemory.setLimit(luaMemory.liveBytes() + 1024 * 1024)");
+    sc->setExpectedExceptionFlag(true);
+    CHECK_THROW(
+        sc->exec("local t = {} for i = 1, 1000000 do t[i] = 'x' .. i end"),
+        LuaError);
+    sc->setExpectedExceptionFlag(false);
+
+    // Still usable after the failed allocation, and without the limit.
+    sc->setMemoryLimit(0);
+    sc->exec("collectgarbage()");
+    CHECK_EQUAL("(42)", sc->execRet<string>("str.int(42)").c_str());
+    sc->exec("local t = {} for i = 1, 100000 do t[i] = 'x' .. i end");
+  }
+
+  // Replays a console style command history, returns the number of commands.
+  int replayHistory(LuaScripting* sc)
+  {
+    const char* history[] = {
+      "str.int(97)",
+      "str.int2(978, 42)",
+      "mixer(true, 10, 12.6, 392.9, 'My sTrIng')",
+      "flt.flt2.int2.dbl2(2,2,1,4,5,5)",
+      "local a = str.int(3) local b = str.int2(4, 5) x = a .. b",
+    };
+    const int numCmds = sizeof(history) / sizeof(history[0]);
+
+    for (int c = 0; c < numCmds; c++)
+      sc->exec(history[c]);
+    return numCmds;
+  }
+
+  TEST(TestChunkCache)
+  {
+    TEST_HEADER;
+
+    unique_ptr<LuaScripting> sc(new LuaScripting());
+
+    sc->registerFunction(&str_int, "str.int", "", true);
+    sc->registerFunction(&str_int2, "str.int2", "", true);
+    sc->registerFunction(&flt_flt2_int2_dbl2, "flt.flt2.int2.dbl2", "", true);
+    sc->registerFunction(&mixer, "mixer", "", true);
+    sc->enableProvenance(false);
+
+    unsigned long long misses = sc->getChunkCacheMisses();
+    sc->precompileRet("str.int(97)");
+    CHECK_EQUAL(misses + 1, sc->getChunkCacheMisses());
+
+    unsigned long long hits = sc->getChunkCacheHits();
+    CHECK_EQUAL("(97)", sc->execRet<string>("str.int(97)").c_str());
+    CHECK_EQUAL("(97)", sc->execRet<string>("str.int(97)").c_str());
+    CHECK_EQUAL(hits + 2, sc->getChunkCacheHits());
+
+    // Literals are hoisted, commands differing only in them share a chunk.
+    misses = sc->getChunkCacheMisses();
+    for (int i = 0; i < 10; i++)
+    {
+      ostringstream cmd;
+      cmd << "str.int(" << i << ")";
+      ostringstream expected;
+      expected << "(" << i << ")";
+      CHECK_EQUAL(expected.str(), sc->execRet<string>(cmd.str()));
+    }
+    CHECK_EQUAL(misses, sc->getChunkCacheMisses());
+    CHECK_EQUAL("ab", sc->execRet<string>("'a' .. \"b\"").c_str());
+    hits = sc->getChunkCacheHits();
+    CHECK_EQUAL("cd", sc->execRet<string>("'c' .. \"d\"").c_str());
+    CHECK_EQUAL(hits + 1, sc->getChunkCacheHits());
+    CHECK_EQUAL(31.5, sc->execRet<double>("0x10 + 1.5e1 + .5"));
+    CHECK_EQUAL(32.5, sc->execRet<double>("0x10 + 1.5e1 + 1.5"));
+    CHECK_EQUAL(3, sc->execRet<int>("1 --[==[ 5 ]==] + 2 -- 7"));
+
+    // Left in place: escapes, string call arguments, long strings, and
+    // varargs turn hoisting off for the chunk.
+    CHECK_EQUAL("a\n'", sc->execRet<string>("'a\\n\\''").c_str());
+    CHECK_EQUAL("x", sc->execRet<string>("tostring 'x'").c_str());
+    CHECK_EQUAL("[x]y", sc->execRet<string>("[=[[x]]=] .. 'y'").c_str());
+    CHECK_EQUAL(0, sc->execRet<int>("select('#', ...) + 0"));
+
+    // Chunks are run from scratch every time.
+    sc->exec("counter = 0");
+    for (int i = 0; i < 3; i++)
+      sc->exec("local c = counter counter = c + 1");
+    CHECK_EQUAL(3, sc->execRet<int>("counter"));
+
+    sc->setExpectedExceptionFlag(true);
+    CHECK_THROW(sc->precompile("str.int(("), LuaError);
+    sc->setExpectedExceptionFlag(false);
+
+    // Without a cache every command is compiled again.
+    sc->setChunkCacheSize(0);
+    hits = sc->getChunkCacheHits();
+    replayHistory(sc.get());
+    replayHistory(sc.get());
+    CHECK_EQUAL(hits, sc->getChunkCacheHits());
+
+    // With one, a replayed history is compiled once.
+    sc->setChunkCacheSize(DEFAULT_CHUNK_CACHE_SIZE);
+    misses = sc->getChunkCacheMisses();
+    const int numCmds = replayHistory(sc.get());
+    CHECK_EQUAL(misses + numCmds, sc->getChunkCacheMisses());
+    hits = sc->getChunkCacheHits();
+    replayHistory(sc.get());
+    CHECK_EQUAL(hits + numCmds, sc->getChunkCacheHits());
+    CHECK_EQUAL(misses + numCmds, sc->getChunkCacheMisses());
+  }
+
   // More unit tests are spread out amongst the Lua* files.
 
   /// TODO: Add tests for passing shared_ptr's around, and how they work
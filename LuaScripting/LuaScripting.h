@@ -69,6 +69,9 @@ namespace std {
 #include "LuaCommon.h"
 #include "LuaError.h"
 #include "LuaFunBinding.h"
+#include "LuaCommandBatch.h"
+#include "LuaFreeListAllocator.h"
+#include "LuaMemAllocator.h"
 #include "LuaStackRAII.h"
 #include "LuaScriptingExecHeader.h"
 
@@ -76,6 +79,7 @@ namespace tuvok
 {
 
 class LuaProvenance;
+class LuaChunkCache;
 class LuaMemberRegUnsafe;
 class LuaClassConstructor;
 template <class T> class LuaClassRegistration;
@@ -252,6 +256,22 @@ public:
   template <typename T>
   T execRet(const std::string& cmd);
 
+  /// exec and execRet keep the most recently compiled commands, so running
+  /// the same command again does not parse it again, even if only its
+  /// literal arguments changed.
+  ///@{
+  /// Compiles a command ahead of time for exec / execRet without running it.
+  /// Throws LuaError if the command does not compile.
+  void precompile(const std::string& cmd);
+  void precompileRet(const std::string& cmd);
+
+  /// Number of compiled commands to keep, 0 disables the cache.
+  void setChunkCacheSize(size_t numChunks);
+  size_t getChunkCacheSize() const;
+  unsigned long long getChunkCacheHits() const;
+  unsigned long long getChunkCacheMisses() const;
+  ///@}
+
   /// The following functions allow you to call a function using C++ types.
   /// These function are more efficient than the exec functions given above.
   /// The general form of these functions is given in the below example
@@ -280,6 +300,13 @@ public:
   TUVOK_LUA_CEXEC_RET_FUNCTIONS
   ///@}
 
+  /// Executes all calls in the batch, in order. Cheaper than issuing them
+  /// one cexec at a time: the stack is set up once, each function is only
+  /// looked up once and, if provenance is enabled, the calls are grouped
+  /// into one undo/redo entry. Hooks still run after every call.
+  /// If a call throws, the calls after it are not executed.
+  void cexecBatch(const LuaCommandBatch& batch);
+
   /// The following functions allow you to specify default parameters to use
   /// for registered functions.
   /// This is so you can specify different undo/redo defaults (such as turning
@@ -334,6 +361,13 @@ public:
   bool isProvenanceEnabled() const;
   void enableProvenance(bool enable);
 
+  /// Memory used by the Lua state. Also available from Lua, see the
+  /// luaMemory table.
+  LuaMemStats getMemoryStats() const;
+  /// Limits the memory the Lua state may hold. Allocations beyond the limit
+  /// raise a Lua memory error. 0 (the default) means no limit.
+  void setMemoryLimit(uint64_t bytes);
+
   LuaClassInstance::IDType getCurGlobalInstID() const{return mGlobalInstanceID;}
   void incrementGlobalInstID()    {mGlobalInstanceID++;}
 
@@ -363,6 +397,8 @@ public:
   static const char* TBL_MD_FUN_LAST_EXEC;///< Parameters from last execution
   static const char* TBL_MD_HOOKS;        ///< Static function hooks table
   static const char* TBL_MD_HOOK_INDEX;   ///< Static function hook index
+  static const char* TBL_MD_HOOK_LIST;    ///< Array of all hook closures.
+  static const char* TBL_MD_NUM_STATIC_HOOKS; ///< Static hooks in HOOK_LIST.
   static const char* TBL_MD_MEMBER_HOOKS; ///< Class member function hook table
   static const char* TBL_MD_CPP_CLASS;    ///< Light user data to LuaScripting
   static const char* TBL_MD_STACK_EXEMPT; ///< True if undo/redo stack exempt
@@ -446,6 +482,20 @@ public:
   void endCommandGroup();
   /// @}
 
+  /// Hook dispatch counters.
+  struct HookStats
+  {
+    unsigned long long hookedCalls;     ///< Calls that dispatched hooks.
+    unsigned long long hooklessCalls;   ///< Calls to functions without hooks.
+    unsigned long long hooksDispatched; ///< Hook closures called.
+    double             seconds;         ///< Steady clock time of the sample.
+
+    /// Hooks dispatched per second since the earlier sample.
+    double hooksPerSecond(const HookStats& earlier) const;
+  };
+  /// Samples the counters; two samples give the dispatch rate.
+  HookStats getHookStats() const;
+
   /// Verbose print. Prints a message using log.info only if verbose is enabled.
   void vPrint(const char* fmt, ...);
 
@@ -462,13 +512,60 @@ private: // Used by LuaMemberRegUnsafe
   /// required to call the function directly after the table on the stack.
   /// There must be no other values on the stack above tableIndex other than the
   /// table and the parameters to call the function.
-  void doHooks(lua_State* L, int tableIndex, bool provExempt);
+  /// \param execFlags   The function's ExecFlags. Functions without hooks
+  ///                    return right away.
+  void doHooks(lua_State* L, int tableIndex, bool provExempt, int execFlags)
+  {
+    if ((execFlags & EXEC_HAS_HOOKS) == 0)
+    {
+      ++mHookStats.hooklessCalls;
+      return;
+    }
+    dispatchHooks(L, tableIndex, provExempt);
+  }
+
+  /// Calls every closure in the function's TBL_MD_HOOK_LIST.
+  void dispatchHooks(lua_State* L, int tableIndex, bool provExempt);
 
   /// Returns true if the function is provenance exempt.
   /// Used to tell whether or not we should log hooks later on.
-  bool doProvenanceFromExec(lua_State* L,
-                            std::shared_ptr<LuaCFunAbstract> funParams,
-                            std::shared_ptr<LuaCFunAbstract> emptyParams);
+  /// The parameters (starting at stack index 2) are only copied if
+  /// provenance is going to record them, so calls with provenance disabled
+  /// do not touch the heap.
+  /// \param execFlags   The function's ExecFlags, from its closure.
+  template <typename FunPtr>
+  bool doProvenanceFromExec(lua_State* L, int execFlags)
+  {
+    if (isProvenanceExempt(execFlags))
+      return true;
+
+    if (isProvenanceRecording())
+    {
+      typedef LuaCFunExec<FunPtr> ParamsType;
+      std::shared_ptr<LuaCFunAbstract> execParams =
+          std::allocate_shared<ParamsType>(LuaFreeListAllocator<ParamsType>());
+      std::shared_ptr<LuaCFunAbstract> emptyParams =
+          std::allocate_shared<ParamsType>(LuaFreeListAllocator<ParamsType>());
+      // Fill execParams. Function parameters start at index 2.
+      execParams->pullParamsFromStack(L, 2);
+      logProvenanceFromExec(L, execFlags, execParams, emptyParams);
+    }
+    return false;
+  }
+
+  /// True if provenance is disabled or the function is exempt from it.
+  bool isProvenanceExempt(int execFlags) const;
+  /// True if logProvenanceFromExec would actually record anything.
+  bool isProvenanceRecording() const;
+  /// Logs the execution of the function whose table is at stack index 1.
+  void logProvenanceFromExec(lua_State* L, int execFlags,
+                             std::shared_ptr<LuaCFunAbstract> funParams,
+                             std::shared_ptr<LuaCFunAbstract> emptyParams);
+
+  /// Copies the exemption flags of the function table at tableIndex into
+  /// the ExecFlags upvalue of its closure and rebuilds its TBL_MD_HOOK_LIST.
+  /// Needs to be called whenever the function's hook tables change.
+  void updateExecFlags(int tableIndex);
 
 private:
 
@@ -550,6 +647,16 @@ private:
   /// Leaves the table on the top of the Lua stack.
   void createCallableFuncTable(lua_CFunction proxyFunc, void* realFuncToCall);
 
+  /// Flags of a registered function that the function trampolines need on
+  /// every call. They are mirrored from the function table into the last
+  /// upvalue of the function's closure (see updateExecFlags).
+  enum ExecFlags
+  {
+    EXEC_STACK_EXEMPT = 1,  ///< Mirrors TBL_MD_STACK_EXEMPT
+    EXEC_PROV_EXEMPT  = 2,  ///< Mirrors TBL_MD_PROV_EXEMPT
+    EXEC_HAS_HOOKS    = 4   ///< TBL_MD_HOOK_LIST is not empty.
+  };
+
   /// Populates the table at the given index with the given function metadata.
   void populateWithMetadata(const std::string& name,
                             const std::string& description,
@@ -581,9 +688,23 @@ private:
   /// in the interpreter.
   static int luaPanic(lua_State* L);
 
-  /// Customized memory allocator called from within Lua.
-  static void* luaInternalAlloc(void* ud, void* ptr, size_t osize,
-                                size_t nsize);
+  /// Message handler for hook calls, appends a traceback to the error.
+  static int hookErrorHandler(lua_State* L);
+
+  /// Registers the luaMemory functions, which expose getMemoryStats.
+  void registerMemoryFunctions();
+
+  /// Pushes the compiled chunk and its arguments, see LuaChunkCache::push.
+  /// Returns the number of arguments.
+  int pushChunk(const std::string& chunk);
+
+  /// Lua accessors for the memory statistics.
+  /// @{
+  uint64_t getMemoryLiveBytes() const   {return getMemoryStats().liveBytes;}
+  uint64_t getMemoryPeakBytes() const   {return getMemoryStats().peakBytes;}
+  uint64_t getMemoryLimit() const       {return getMemoryStats().limitBytes;}
+  double   getMemoryAllocsPerCommand() const;
+  /// @}
 
   /// Expects the function table to be given at funTableIndex
   /// Copies the defaults table to the last exec table (used for undo/redo).
@@ -679,6 +800,12 @@ private:
   /// The one true Lua state.
   lua_State*                        mL;
 
+  /// Allocator of mL. Must outlive it.
+  std::unique_ptr<LuaMemAllocator>  mMemAllocator;
+
+  /// Commands compiled by exec and execRet.
+  std::unique_ptr<LuaChunkCache>    mChunkCache;
+
   /// List of registered modules/functions in Lua's global table.
   /// Used to iterate through all registered functions.
   std::vector<std::string>          mRegisteredGlobals;
@@ -690,6 +817,8 @@ private:
   /// hooks.
   int                               mMemberHookIndex;
 
+  HookStats                         mHookStats;
+
   /// Current global instance ID that will be used to create new Lua classes.
   LuaClassInstance::IDType          mGlobalInstanceID;
   bool                              mGlobalTempInstRange;
@@ -720,18 +849,13 @@ private:
       {
         LuaScripting* ss = static_cast<LuaScripting*>(
                     lua_touserdata(L, lua_upvalueindex(3)));
-
-        std::shared_ptr<LuaCFunAbstract> execParams(
-            new LuaCFunExec<FunPtr>());
-        std::shared_ptr<LuaCFunAbstract> emptyParams(
-            new LuaCFunExec<FunPtr>());
-        // Fill execParams. Function parameters start at index 2.
-        execParams->pullParamsFromStack(L, 2);
+        int execFlags = static_cast<int>(
+            lua_tointeger(L, lua_upvalueindex(4)));
 
         // Obtain reference to LuaScripting in order to invoke provenance.
         // See createCallableFuncTable for justification on pulling an
         // instance of LuaScripting out of Lua.
-        bool provExempt = ss->doProvenanceFromExec(L, execParams, emptyParams);
+        bool provExempt = ss->doProvenanceFromExec<FunPtr>(L, execFlags);
 
         // We are NOT a hook. Our parameters start at index 2 (because the
         // callable table is at the first index). We will want to call all
@@ -758,7 +882,7 @@ private:
         // Call registered hooks.
         // Note: The first parameter on the stack (not on the top, but
         // on the bottom) is the table associated with the function.
-        ss->doHooks(L, 1, provExempt);
+        ss->doHooks(L, 1, provExempt, execFlags);
       }
       else
       {
@@ -784,15 +908,10 @@ private:
       {
         LuaScripting* ss = static_cast<LuaScripting*>(
                     lua_touserdata(L, lua_upvalueindex(3)));
+        int execFlags = static_cast<int>(
+            lua_tointeger(L, lua_upvalueindex(4)));
 
-        std::shared_ptr<LuaCFunAbstract> execParams(
-            new LuaCFunExec<FunPtr>());
-        std::shared_ptr<LuaCFunAbstract> emptyParams(
-            new LuaCFunExec<FunPtr>());
-        // Fill execParams. Function parameters start at index 2.
-        execParams->pullParamsFromStack(L, 2);
-
-        bool provExempt = ss->doProvenanceFromExec(L, execParams, emptyParams);
+        bool provExempt = ss->doProvenanceFromExec<FunPtr>(L, execFlags);
 
         ss->beginCommand();
         try
@@ -813,7 +932,7 @@ private:
         }
         ss->endCommand();
 
-        ss->doHooks(L, 1, provExempt);
+        ss->doHooks(L, 1, provExempt, execFlags);
       }
       else
       {
@@ -935,9 +1054,8 @@ T LuaScripting::execRet(const std::string& cmd)
 {
   LuaStackRAII _a = LuaStackRAII(mL, 0, 0);
 
-  std::string retCmd = "return " + cmd;
-  luaL_loadstring(mL, retCmd.c_str());
-  lua_call(mL, 0, LUA_MULTRET);
+  int numArgs = pushChunk("return " + cmd);
+  lua_call(mL, numArgs, LUA_MULTRET);
   T ret = LuaStrictStack<T>::get(mL, lua_gettop(mL));
   lua_pop(mL, 1); // Pop return value.
   return ret;
@@ -1138,6 +1256,7 @@ void LuaScripting::strictHookInternal(
   {
     // Associate closure with hook table.
     lua_setfield(mL, hookTable, os.str().c_str());
+    updateExecFlags(funcTable);
   }
   else
   {
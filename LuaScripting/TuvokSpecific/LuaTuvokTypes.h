@@ -995,6 +995,84 @@ public:
   static Type        getDefault() { return Type(); }
 };
 
+// Performance counter statistics are only ever returned to Lua, as a table
+// with named fields; 'histogram' is 1 based, see PerfCounterStats::Bucket.
+template<>
+class LuaStrictStack<PerfCounterStats>
+{
+public:
+  typedef PerfCounterStats Type;
+
+  static Type get(lua_State* L, int pos)
+  {
+    luaL_checktype(L, pos, LUA_TTABLE);
+    Type ret;
+
+    lua_getfield(L, pos, "count");
+    ret.count = static_cast<uint64_t>(luaL_checknumber(L, -1));
+    lua_getfield(L, pos, "sum");
+    ret.sum = luaL_checknumber(L, -1);
+    lua_getfield(L, pos, "min");
+    ret.min = luaL_checknumber(L, -1);
+    lua_getfield(L, pos, "max");
+    ret.max = luaL_checknumber(L, -1);
+    lua_pop(L, 4);
+
+    lua_getfield(L, pos, "histogram");
+    if (lua_istable(L, -1))
+    {
+      for (int i = 0; i < Type::HISTOGRAM_BUCKETS; ++i)
+      {
+        lua_rawgeti(L, -1, i + 1);
+        ret.histogram[i] = static_cast<uint64_t>(lua_tonumber(L, -1));
+        lua_pop(L, 1);
+      }
+    }
+    lua_pop(L, 1);
+
+    return ret;
+  }
+
+  static void push(lua_State* L, const Type& in)
+  {
+    lua_newtable(L);
+    int tbl = lua_gettop(L);
+
+    lua_pushnumber(L, static_cast<lua_Number>(in.count));
+    lua_setfield(L, tbl, "count");
+    lua_pushnumber(L, in.sum);
+    lua_setfield(L, tbl, "sum");
+    lua_pushnumber(L, in.min);
+    lua_setfield(L, tbl, "min");
+    lua_pushnumber(L, in.max);
+    lua_setfield(L, tbl, "max");
+    lua_pushnumber(L, in.Mean());
+    lua_setfield(L, tbl, "mean");
+    lua_pushnumber(L, in.Percentile(0.5));
+    lua_setfield(L, tbl, "p50");
+    lua_pushnumber(L, in.Percentile(0.95));
+    lua_setfield(L, tbl, "p95");
+
+    lua_createtable(L, Type::HISTOGRAM_BUCKETS, 0);
+    for (int i = 0; i < Type::HISTOGRAM_BUCKETS; ++i)
+    {
+      lua_pushnumber(L, static_cast<lua_Number>(in.histogram[i]));
+      lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, tbl, "histogram");
+  }
+
+  static std::string getValStr(const Type& in)
+  {
+    std::ostringstream os;
+    os << "{count=" << in.count << ", sum=" << in.sum << ", min=" << in.min
+       << ", max=" << in.max << "}";
+    return os.str();
+  }
+  static std::string getTypeStr() { return "PerfCounterStats"; }
+  static Type        getDefault() { return Type(); }
+};
+
 
 } // namespace tuvok
 
@@ -36,6 +36,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <map>
 #include <sstream>
 #include <utility>
 #include "Basics/MathTools.h"
@@ -44,10 +46,12 @@
 #include "Basics/SysTools.h"
 #include "IO/Tuvok_QtPlugins.h"
 #include "IO/IOManager.h"
+#include "IO/SyntheticDataset.h"
 #include "IO/TransferFunction1D.h"
 #include "IO/TransferFunction2D.h"
 #include "AbstrRenderer.h"
 #include "Controller/Controller.h"
+#include "Controller/Tracer.h"
 #include "LuaScripting/LuaScripting.h"
 #include "LuaScripting/LuaClassInstance.h"
 #include "LuaScripting/TuvokSpecific/LuaTuvokTypes.h"
@@ -55,6 +59,8 @@
 #include "LuaScripting/TuvokSpecific/LuaTransferFun1DProxy.h"
 #include "LuaScripting/TuvokSpecific/LuaTransferFun2DProxy.h"
 #include "Renderer/GPUMemMan/GPUMemMan.h"
+#include "FrameCaptureQueue.h"
+#include "TIFFTileWriter.h"
 #include "RenderMesh.h"
 #include "ShaderDescriptor.h"
 
@@ -94,7 +100,6 @@ AbstrRenderer::AbstrRenderer(MasterController* pMasterController,
   m_eInterpolant(Linear),
   m_bSupportsMeshes(false),
   msecPassedCurrentFrame(-1.0f),
-  m_iLODNotOKCounter(0),
   decreaseScreenRes(false),
   decreaseScreenResNow(false),
   decreaseSamplingRate(false),
@@ -108,12 +113,13 @@ AbstrRenderer::AbstrRenderer(MasterController* pMasterController,
   m_iStartDelay(1000),
   m_iMinLODForCurrentView(0),
   m_iTimeSliceMSecs(100),
+  m_fNeededBrickShare(1.0),
+  m_fNeededVoxelShare(1.0),
   m_iIntraFrameCounter(0),
   m_iFrameCounter(0),
   m_iCheckCounter(0),
   m_iMaxLODIndex(0),
   m_iLODLimits(0,0),
-  m_iPerformanceBasedLODSkip(0),
   m_iCurrentLODOffset(0),
   m_iStartLODOffset(0),
   m_iTimestep(0),
@@ -121,6 +127,14 @@ AbstrRenderer::AbstrRenderer(MasterController* pMasterController,
   m_bConsiderPreviousDepthbuffer(true),
   m_iCurrentLOD(0),
   m_iBricksRenderedInThisSubFrame(0),
+  m_iStereoStepsRendered(0),
+  m_iDatasetGeneration(0),
+  m_pCandidateDataset(NULL),
+  m_iCandidateGeneration(0),
+  m_iCandidateTimestep(0),
+  m_iCandidateLOD(0),
+  m_bCandidatePowerOfTwo(false),
+  m_bTiledRendering(false),
   m_eRendererTarget(RT_INTERACTIVE),
   m_bMIPLOD(true),
   m_fMIPRotationAngle(0.0f),
@@ -241,10 +255,13 @@ bool AbstrRenderer::RegisterDataset(Dataset* ds) {
   }
 
   m_pDataset = ds;
+  ++m_iDatasetGeneration;
+  m_fNeededBrickShare = m_fNeededVoxelShare = 1.0;
   m_pLuaDatasetPtr->bind(m_pDataset, m_pMasterController->LuaScript());
 
   // find the maximum LOD index
   m_iMaxLODIndex = m_pDataset->GetLargestSingleBrickLOD(0);
+  m_LODController.Reset();
 
   // now that we know the range of the dataset, we can set the default
   // isoval to half the range.  For CV, we'll set the isovals to a bit above
@@ -272,6 +289,14 @@ bool AbstrRenderer::LoadRebricked(const std::string& filename,
   return this->RegisterDataset(ds);
 }
 
+bool AbstrRenderer::LoadSynthetic(const std::string& spec) {
+  SyntheticDataset::Params params;
+  if(!SyntheticDataset::ParseSpec(spec, params)) { return false; }
+  Dataset* ds = new SyntheticDataset(params);
+  Controller::Instance().MemMan()->AddDataset(ds, this);
+  return this->RegisterDataset(ds);
+}
+
 AbstrRenderer::~AbstrRenderer() {
   if (m_pDataset) m_pMasterController->MemMan()->FreeDataset(m_pDataset, this);
   if (m_p1DTrans) m_pMasterController->MemMan()->Free1DTrans(m_p1DTrans, this);
@@ -323,7 +348,10 @@ void AbstrRenderer::SetDataset(Dataset *vds) {
     Controller::Instance().MemMan()->FreeDataset(m_pDataset, this);
   }
   m_pDataset = vds;
+  ++m_iDatasetGeneration;
+  m_fNeededBrickShare = m_fNeededVoxelShare = 1.0;
   m_iMaxLODIndex = m_pDataset->GetLargestSingleBrickLOD(0);
+  m_LODController.Reset();
   Controller::Instance().MemMan()->AddDataset(m_pDataset, this);
   ScheduleCompleteRedraw();
 }
@@ -649,133 +677,94 @@ void AbstrRenderer::ScheduleRecompose(RenderRegion *renderRegion) {
 
 
 void AbstrRenderer::CompletedASubframe(RenderRegion* region) {
-  bool bRenderingFirstSubFrame =
-    (m_iCurrentLODOffset == m_iStartLODOffset) &&
-    (!this->decreaseScreenRes || this->decreaseScreenResNow) &&
-    (!this->decreaseSamplingRate || this->decreaseSamplingRateNow);
-  bool bSecondSubFrame =
-    !bRenderingFirstSubFrame &&
-    (m_iCurrentLODOffset == m_iStartLODOffset ||
-     (m_iCurrentLODOffset == m_iStartLODOffset-1 &&
-      !(this->decreaseScreenRes || this->decreaseSamplingRate)));
-
-  if (bRenderingFirstSubFrame) {
-    // time for current interaction LOD -> to detect if we are too slow
-    this->msecPassed[0] = this->msecPassedCurrentFrame;
-  } else if(bSecondSubFrame) {
-    this->msecPassed[1] = this->msecPassedCurrentFrame;
+  // the controller predicts full resolution, full sampling rate subframes
+  double fWorkScale = 1.0;
+  if (this->decreaseScreenResNow) {
+    fWorkScale /= double(m_fScreenResDecFactor) * m_fScreenResDecFactor;
+  }
+  if (this->decreaseSamplingRateNow) fWorkScale /= m_fSampleDecFactor;
+  m_LODController.CompletedSubframe(this->msecPassedCurrentFrame, fWorkScale);
+  if (Tracer::Enabled() && this->msecPassedCurrentFrame >= 0.0f) {
+    Tracer::Instance().Counter("lod", "MeasuredSubframeUs",
+                               int64_t(this->msecPassedCurrentFrame * 1000));
   }
+
   this->msecPassedCurrentFrame = 0.0f;
   region->isTargetBlank = false;
 }
 
-void AbstrRenderer::RestartTimer(const size_t iTimerIndex) {
-  this->msecPassed[iTimerIndex] = -1.0f;
+void AbstrRenderer::RestartTimers() {
+  m_LODController.CancelSubframe();
 }
 
-void AbstrRenderer::RestartTimers() {
-  RestartTimer(0);
-  RestartTimer(1);
-}
-
-void AbstrRenderer::ComputeMaxLODForCurrentView() {
-  if (m_eRendererTarget != RT_CAPTURE && this->msecPassed[0]>=0.0f) {
-    // if rendering is too slow use a lower resolution during interaction
-    if (this->msecPassed[0] > m_fMaxMSPerFrame) {
-      // wait for 3 frames before switching to lower lod (3 here is
-      // chosen more or less arbitrarily, can be changed if needed)
-      if (m_iLODNotOKCounter < 3) {
-        MESSAGE("Would increase start LOD but will give the renderer %u "
-                "more frame(s) time to become faster", 3 - m_iLODNotOKCounter);
-        m_iLODNotOKCounter++;
-      } else {
-        // We gave it a chance but rendering was too slow. So let's drop down
-        // in quality.
-        m_iLODNotOKCounter = 0;
-
-        // Easiest thing is to try rendering a lower quality LOD. So try this
-        // if possible.
-        uint64_t iPerformanceBasedLODSkip =
-          std::max<uint64_t>(1, m_iPerformanceBasedLODSkip) - 1;
-        if (m_iPerformanceBasedLODSkip != iPerformanceBasedLODSkip) {
-          MESSAGE("Increasing start LOD to %llu as it took %g ms "
-                  "to render the first LOD level (max is %g) ",
-                  m_iPerformanceBasedLODSkip, this->msecPassed[0],
-                  m_fMaxMSPerFrame);
-          this->msecPassed[0] = this->msecPassed[1];
-          m_iPerformanceBasedLODSkip = iPerformanceBasedLODSkip;
-        } else {
-          // Already at lowest quality LOD, so will need to try something else.
-          MESSAGE("Would like to increase start LOD as it took %g ms "
-                  "to render the first LOD level (max is %g) BUT CAN'T.",
-                  this->msecPassed[0], m_fMaxMSPerFrame);
-          if (m_bRenderLowResIntermediateResults) {
-            if (this->decreaseSamplingRate && this->decreaseScreenRes) {
-              MESSAGE("Even with UseAllMeans there is nothing that "
-                      "can be done to meet the specified framerate.");
-            } else {
-              if (!this->decreaseScreenRes) {
-                MESSAGE("UseAllMeans enabled: decreasing resolution "
-                        "to meet target framerate");
-                this->decreaseScreenRes = true;
-              } else {
-                MESSAGE("UseAllMeans enabled: decreasing sampling rate "
-                        "to meet target framerate");
-                this->decreaseSamplingRate = true;
-              }
-            }
-          } else {
-            MESSAGE("UseAllMeans disabled so framerate can not be met...");
-          }
-        }
-      }
-    } else {
-      // if finished rendering last frame (m_iBricksRenderedInThisSubFrame is
-      // from the last frame, not the new one we are about to start) and did
-      // this fast enough, use a higher resolution during interaction.
-      if (m_vCurrentBrickList.size() == m_iBricksRenderedInThisSubFrame &&
-          this->msecPassed[1] >= 0.0f &&
-          this->msecPassed[1] <= m_fMaxMSPerFrame) {
-        m_iLODNotOKCounter = 0;
-        // We're rendering fast, so lets step up the quality. Easiest thing to
-        // try first is rendering at normal sampling rate and resolution.
-        if (this->decreaseSamplingRate || this->decreaseScreenRes) {
-          if (this->decreaseSamplingRate) {
-            MESSAGE("Rendering at full resolution as this took only %g ms",
-                    this->msecPassed[0]);
-            this->decreaseSamplingRate = false;
-          } else {
-            if (this->decreaseScreenRes) {
-              MESSAGE("Rendering to full viewport as this took only %g ms",
-                      this->msecPassed[0]);
-              this->decreaseScreenRes = false;
-            }
-          }
-        } else {
-          // Let's try rendering at a higher quality LOD.
-          uint64_t iPerformanceBasedLODSkip =
-            std::min<uint64_t>(m_iMaxLODIndex - m_iMinLODForCurrentView,
-                             m_iPerformanceBasedLODSkip + 1);
-          if (m_iPerformanceBasedLODSkip != iPerformanceBasedLODSkip) {
-            MESSAGE("Decreasing start LOD to %llu as it took only %g ms "
-                    "to render the second LOD level",
-                    m_iPerformanceBasedLODSkip, this->msecPassed[1]);
-            m_iPerformanceBasedLODSkip = iPerformanceBasedLODSkip;
-          }
+/// The pixels of a region; the LOD controller is fed and asked with these.
+static uint64_t region_pixels(const RenderRegion& region) {
+  const UINTVECTOR2 vRegionSize = region.maxCoord - region.minCoord;
+  return uint64_t(vRegionSize.x) * vRegionSize.y;
+}
+
+void AbstrRenderer::ComputeMaxLODForCurrentView(uint64_t iPixels) {
+  if (m_eRendererTarget != RT_CAPTURE && m_LODController.IsTrained()) {
+    const size_t iLevels = size_t(m_pDataset->GetLODLevelCount());
+    vector<uint64_t> vTotalBricks(iLevels);
+    for (size_t i = 0;i<iLevels;i++) {
+      vTotalBricks[i] = m_pDataset->GetBrickCount(i, m_iTimestep);
+    }
+
+    double fPredicted = 0.0;
+    const uint64_t iStartLOD = m_LODController.ChooseLOD(
+      size_t(m_iMinLODForCurrentView), size_t(m_iMaxLODIndex),
+      size_t(m_iStartLODOffset), m_fMaxMSPerFrame, vTotalBricks,
+      iPixels, fPredicted
+    );
+    if (iStartLOD != m_iStartLODOffset) {
+      MESSAGE("Start LOD %llu is predicted to take %g ms (max is %g)",
+              iStartLOD, fPredicted, m_fMaxMSPerFrame);
+    }
+
+    // the coarsest level does not fit: use a lower resolution/sampling rate
+    // during interaction if allowed; give them up once it fits again
+    if (fPredicted > m_fMaxMSPerFrame) {
+      if (m_bRenderLowResIntermediateResults) {
+        if (!this->decreaseScreenRes) {
+          MESSAGE("UseAllMeans enabled: decreasing resolution "
+                  "to meet target framerate");
+          this->decreaseScreenRes = true;
+        } else if (!this->decreaseSamplingRate) {
+          MESSAGE("UseAllMeans enabled: decreasing sampling rate "
+                  "to meet target framerate");
+          this->decreaseSamplingRate = true;
         }
       } else {
-        if (m_vCurrentBrickList.size() == m_iBricksRenderedInThisSubFrame) {
-          MESSAGE("Start LOD seems to be ok");
-        }
+        MESSAGE("UseAllMeans disabled so framerate can not be met...");
       }
+    } else if ((this->decreaseScreenRes || this->decreaseSamplingRate) &&
+               fPredicted <= m_fMaxMSPerFrame *
+                 LODController::UPGRADE_MARGIN_PERCENT / 100.0) {
+      MESSAGE("Rendering at full resolution and sampling rate, predicted "
+              "to take %g ms", fPredicted);
+      this->decreaseScreenRes = false;
+      this->decreaseSamplingRate = false;
     }
 
-    m_iStartLODOffset = std::max(m_iMinLODForCurrentView,
-                                 m_iMaxLODIndex - m_iPerformanceBasedLODSkip);
+    m_iStartLODOffset = std::max(m_iMinLODForCurrentView, iStartLOD);
+
+    if (Tracer::Enabled()) {
+      Tracer& tracer = Tracer::Instance();
+      tracer.Counter("lod", "StartLOD", int64_t(m_iStartLODOffset));
+      tracer.Counter("lod", "PredictedSubframeUs", int64_t(fPredicted * 1000));
+      tracer.Counter("lod", "CostPerBrickNs",
+                     int64_t(m_LODController.GetCostPerBrick() * 1e6));
+      tracer.Counter("lod", "CostPerMFragmentUs",
+                     int64_t(m_LODController.GetCostPerFragment() * 1e9));
+      tracer.Counter("lod", "ReducedResolution",
+                     (this->decreaseScreenRes ? 1 : 0) +
+                     (this->decreaseSamplingRate ? 2 : 0));
+    }
   } else if (m_eRendererTarget != RT_INTERACTIVE){
     m_iStartLODOffset = m_iMinLODForCurrentView;
   } else {
-    // This is our very first frame, let's take it easy.
+    // Nothing measured yet, let's take it easy ...
     m_iStartLODOffset = m_iMaxLODIndex;
   }
 
@@ -786,6 +775,39 @@ void AbstrRenderer::ComputeMaxLODForCurrentView() {
   RestartTimers();
 }
 
+double AbstrRenderer::PredictLODCost(uint64_t iLOD) const {
+  if (!m_pDataset || !m_BrickCostModel.IsTrained()) return 0.0;
+  const size_t iLevel = static_cast<size_t>(
+    std::min<uint64_t>(iLOD, m_pDataset->GetLODLevelCount()-1));
+  const uint64_t iBricks = m_pDataset->GetBrickCount(iLevel, m_iTimestep);
+  const uint64_t iVoxels = m_pDataset->GetDomainSize(iLevel,
+                                                     m_iTimestep).volume();
+  // culling and empty space skipping drop about as many bricks on every
+  // level, the fine levels just have more of them
+  return m_BrickCostModel.Predict(
+    uint64_t(std::ceil(double(iBricks) * m_fNeededBrickShare)),
+    uint64_t(std::ceil(double(iVoxels) * m_fNeededVoxelShare)));
+}
+
+void AbstrRenderer::UpdateNeededShare() {
+  // the candidates are all bricks of the level the list was built from
+  uint64_t iVoxels = 0;
+  for (vector<BrickCandidate>::const_iterator c = m_vBrickCandidates.begin();
+       c != m_vBrickCandidates.end(); ++c) {
+    iVoxels += UINT64VECTOR3(c->brick.vVoxelCount).volume();
+  }
+  uint64_t iNeededVoxels = 0;
+  for (vector<Brick>::const_iterator b = m_vCurrentBrickList.begin();
+       b != m_vCurrentBrickList.end(); ++b) {
+    iNeededVoxels += UINT64VECTOR3(b->vVoxelCount).volume();
+  }
+  if (m_vBrickCandidates.empty() || iVoxels == 0) return;
+
+  m_fNeededBrickShare = double(m_vCurrentBrickList.size()) /
+                        double(m_vBrickCandidates.size());
+  m_fNeededVoxelShare = double(iNeededVoxels) / double(iVoxels);
+}
+
 void AbstrRenderer::ComputeMinLODForCurrentView() {
   // compute scale factor for domain
   UINTVECTOR3 vDomainSize = UINTVECTOR3(m_pDataset->GetDomainSize());
@@ -840,6 +862,52 @@ brick_distance(const Brick &b, const FLOATMATRIX4 &mat_modelview)
   return fDistance;
 }
 
+static vector<BrickKey> brick_keys(const vector<Brick>& vBricks) {
+  vector<BrickKey> vKeys;
+  vKeys.reserve(vBricks.size());
+  for (vector<Brick>::const_iterator b = vBricks.begin(); b != vBricks.end();
+       ++b) {
+    vKeys.push_back(b->kBrick);
+  }
+  return vKeys;
+}
+
+/// Rough number of ray samples a brick list costs: the screen area covered by
+/// each brick's bounding rectangle times the samples taken along a ray
+/// through it.  Bricks crossing the near plane count as covering the screen.
+static double
+brick_fragments(const vector<Brick>& vBricks, const FLOATMATRIX4& mat_mvp,
+                uint64_t iPixels, float fSampleRate)
+{
+  double fFragments = 0.0;
+  for (vector<Brick>::const_iterator b = vBricks.begin(); b != vBricks.end();
+       ++b) {
+    FLOATVECTOR2 vMin(1.0f, 1.0f), vMax(-1.0f, -1.0f);
+    bool bBehind = false;
+    for (size_t i = 0;i<8;i++) {
+      const FLOATVECTOR3 vCorner = b->vCenter + FLOATVECTOR3(
+        (i & 1) ? b->vExtension.x : -b->vExtension.x,
+        (i & 2) ? b->vExtension.y : -b->vExtension.y,
+        (i & 4) ? b->vExtension.z : -b->vExtension.z) * 0.5f;
+      const FLOATVECTOR4 vClip = FLOATVECTOR4(vCorner, 1.0f) * mat_mvp;
+      if (vClip.w <= 0.0f) { bBehind = true; break; }
+      const FLOATVECTOR2 vNDC(vClip.x / vClip.w, vClip.y / vClip.w);
+      vMin.x = std::min(vMin.x, vNDC.x); vMin.y = std::min(vMin.y, vNDC.y);
+      vMax.x = std::max(vMax.x, vNDC.x); vMax.y = std::max(vMax.y, vNDC.y);
+    }
+    double fCoverage = 1.0;
+    if (!bBehind) {
+      const float fWidth  = std::min(vMax.x, 1.0f) - std::max(vMin.x, -1.0f);
+      const float fHeight = std::min(vMax.y, 1.0f) - std::max(vMin.y, -1.0f);
+      if (fWidth <= 0.0f || fHeight <= 0.0f) continue;
+      fCoverage = fWidth * fHeight / 4.0;
+    }
+    fFragments += fCoverage * double(iPixels) *
+                  double(b->vVoxelCount.maxVal()) * fSampleRate;
+  }
+  return fFragments;
+}
+
 vector<Brick> AbstrRenderer::BuildLeftEyeSubFrameBrickList(
                              const FLOATMATRIX4& modelView,
                              const vector<Brick>& vRightEyeBrickList) const {
@@ -996,24 +1064,37 @@ bool AbstrRenderer::ContainsData(const BrickKey& key) const
   return bContainsData;
 }
 
-vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistanceCriterion) {
-  vector<Brick> vBrickList;
-  UINT64VECTOR3 vDomainSize = m_pDataset->GetDomainSize(0);
-
+void AbstrRenderer::UpdateBrickCandidates() {
   FLOATVECTOR3 vScale(float(m_pDataset->GetScale().x),
                       float(m_pDataset->GetScale().y),
                       float(m_pDataset->GetScale().z));
 
+  if (m_pCandidateDataset == m_pDataset &&
+      m_iCandidateGeneration == m_iDatasetGeneration &&
+      m_iCandidateTimestep == m_iTimestep &&
+      m_iCandidateLOD == m_iCurrentLOD &&
+      m_vCandidateScale == vScale &&
+      m_bCandidatePowerOfTwo == m_bUseOnlyPowerOfTwo &&
+      // catches bricks added to or removed from the dataset
+      m_vBrickCandidates.size() ==
+        m_pDataset->GetBrickCount(size_t(m_iCurrentLOD), m_iTimestep)) {
+    return;
+  }
+  m_pCandidateDataset = m_pDataset;
+  m_iCandidateGeneration = m_iDatasetGeneration;
+  m_iCandidateTimestep = m_iTimestep;
+  m_iCandidateLOD = m_iCurrentLOD;
+  m_vCandidateScale = vScale;
+  m_bCandidatePowerOfTwo = m_bUseOnlyPowerOfTwo;
+  m_vBrickCandidates.clear();
+
+  UINT64VECTOR3 vDomainSize = m_pDataset->GetDomainSize(0);
   FLOATVECTOR3 vDomainSizeCorrectedScale = vScale *
                                            FLOATVECTOR3(vDomainSize)/
                                            float(vDomainSize.maxVal());
 
   vScale /= vDomainSizeCorrectedScale.maxVal();
 
-  MESSAGE("Building active brick list from %u active bricks.",
-          static_cast<unsigned>(m_pDataset->GetBrickCount(size_t(m_iCurrentLOD),
-                                                          m_iTimestep)));
-
   BrickTable::const_iterator brick = m_pDataset->BricksBegin();
   for(; brick != m_pDataset->BricksEnd(); ++brick) {
     // skip over the brick if it's for the wrong timestep or LOD
@@ -1021,30 +1102,51 @@ vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistance
        std::get<1>(brick->first) != m_iCurrentLOD) {
       continue;
     }
-    const BrickMD& bmd = brick->second;
-    Brick b;
-    b.vExtension = bmd.extents * vScale;
-    b.vCenter = bmd.center * vScale;
-    b.vVoxelCount = bmd.n_voxels;
+    BrickCandidate c;
+    c.md = brick->second;
+    Brick& b = c.brick;
+    b.vExtension = c.md.extents * vScale;
+    b.vCenter = c.md.center * vScale;
+    b.vVoxelCount = c.md.n_voxels;
 #ifndef __clang__
     b.kBrick = brick->first;
 #else
     BrickKey key = brick->first;
     b.kBrick = key;
 #endif
+    std::pair<FLOATVECTOR3, FLOATVECTOR3> vTexcoords = m_pDataset->GetTextCoords(brick, m_bUseOnlyPowerOfTwo);
+    b.vTexcoordsMin = vTexcoords.first;
+    b.vTexcoordsMax = vTexcoords.second;
+    m_vBrickCandidates.push_back(c);
+  }
+}
+
+vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistanceCriterion) {
+  vector<Brick> vBrickList;
+  UpdateBrickCandidates();
+
+  MESSAGE("Building active brick list from %u active bricks.",
+          static_cast<unsigned>(m_pDataset->GetBrickCount(size_t(m_iCurrentLOD),
+                                                          m_iTimestep)));
+
+  vBrickList.reserve(m_vBrickCandidates.size());
+  vector<BrickCandidate>::const_iterator c = m_vBrickCandidates.begin();
+  for(; c != m_vBrickCandidates.end(); ++c) {
+    Brick b = c->brick;
+    const BrickKey& key = c->brick.kBrick;
 
     bool needed = false;
     for(auto reg = renderRegions.cbegin(); reg != renderRegions.cend(); ++reg) {
-      if(RegionNeedsBrick(**reg, brick->first, brick->second, b.bIsEmpty)) {
+      if(RegionNeedsBrick(**reg, key, c->md, b.bIsEmpty)) {
         needed = true;
         break;
       }
     }
     if(!needed) {
       MESSAGE("Skipping brick <%u,%u,%u> because it isn't relevant.",
-              static_cast<unsigned>(std::get<0>(brick->first)),
-              static_cast<unsigned>(std::get<1>(brick->first)),
-              static_cast<unsigned>(std::get<2>(brick->first)));
+              static_cast<unsigned>(std::get<0>(key)),
+              static_cast<unsigned>(std::get<1>(key)),
+              static_cast<unsigned>(std::get<2>(key)));
       continue;
     }
 
@@ -1053,20 +1155,16 @@ vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistance
               "because it is empty/invisible given the current vis parameters,"
               " but we'll keep it in the list in case it overlaps with other "
               "data (e.g. a mesh)",
-              static_cast<unsigned>(std::get<0>(brick->first)),
-              static_cast<unsigned>(std::get<1>(brick->first)),
-              static_cast<unsigned>(std::get<2>(brick->first)));
+              static_cast<unsigned>(std::get<0>(key)),
+              static_cast<unsigned>(std::get<1>(key)),
+              static_cast<unsigned>(std::get<2>(key)));
     } else {
-      std::pair<FLOATVECTOR3, FLOATVECTOR3> vTexcoords = m_pDataset->GetTextCoords(brick, m_bUseOnlyPowerOfTwo);
-      b.vTexcoordsMin = vTexcoords.first;
-      b.vTexcoordsMax = vTexcoords.second;
-
       // the depth order doesn't really matter for MIP rotations,
       // since we need to traverse every brick anyway.  So we do a
       // sort based on which bricks are already resident, to get a
       // good cache hit rate.
       if (bUseResidencyAsDistanceCriterion) {
-        if (IsVolumeResident(brick->first)) {
+        if (IsVolumeResident(key)) {
           b.fDistance = 0;
         } else {
           b.fDistance = 1;
@@ -1078,10 +1176,6 @@ vector<Brick> AbstrRenderer::BuildSubFrameBrickList(bool bUseResidencyAsDistance
         b.fDistance = brick_distance(b, GetFirst3DRegion()->modelView[0]);
       }
     }
-/*
-MESSAGE("considering brick <%zu,%zu,%zu>", std::get<0>(brick->first),
-            std::get<1>(brick->first), std::get<2>(brick->first));
-            */
 
     // add the brick to the list of active bricks
     vBrickList.push_back(b);
@@ -1123,7 +1217,14 @@ FLOATVECTOR3 AbstrRenderer::LuaGetVolumeAABBExtents() const {
 }
 
 void AbstrRenderer::PlanFrame(RenderRegion3D& region) {
+  TUVOK_TRACE("render", "PlanFrame");
   m_FrustumCullingLOD.SetViewMatrix(region.modelView[0]);
+  // bricks only the second eye sees have to be in the list, too
+  if (m_bDoStereoRendering) {
+    m_FrustumCullingLOD.SetSecondView(region.modelView[1], m_mProjection[1]);
+  } else {
+    m_FrustumCullingLOD.ClearSecondView();
+  }
   m_FrustumCullingLOD.Update();
 
   // let the mesh know about our current state, technically
@@ -1156,7 +1257,7 @@ void AbstrRenderer::PlanFrame(RenderRegion3D& region) {
     // figure out at what coarse level we need to start for the current view
     // this method takes the rendermode (capture or not) and the time it took
     // to render the last subframe into account
-    ComputeMaxLODForCurrentView();
+    ComputeMaxLODForCurrentView(region_pixels(region));
   }
 
   // plan if the frame is to be redrawn
@@ -1175,6 +1276,7 @@ void AbstrRenderer::PlanFrame(RenderRegion3D& region) {
         this->decreaseScreenResNow = false;
         this->decreaseSamplingRateNow = false;
         m_iBricksRenderedInThisSubFrame = 0;
+        m_iStereoStepsRendered = 0;
         this->doAnotherRedrawDueToLowResOutput = false;
       } else {
         if (m_iCurrentLODOffset > m_iMinLODForCurrentView) {
@@ -1195,12 +1297,37 @@ void AbstrRenderer::PlanFrame(RenderRegion3D& region) {
       MESSAGE("Building new brick list for LOD %llu...", m_iCurrentLOD);
       m_vCurrentBrickList = BuildSubFrameBrickList();
       MESSAGE("%u bricks made the cut.", uint32_t(m_vCurrentBrickList.size()));
+      UpdateNeededShare();
+      {
+        const uint64_t iPixels = region_pixels(region);
+        m_LODController.PlannedSubframe(
+          size_t(m_iCurrentLOD), m_vCurrentBrickList.size(),
+          m_pDataset->GetBrickCount(size_t(m_iCurrentLOD), m_iTimestep),
+          brick_fragments(m_vCurrentBrickList,
+                          region.modelView[0] * m_mProjection[0], iPixels,
+                          m_fSampleRateModifier),
+          iPixels
+        );
+        // the per brick GPU times are known long before enough subframes
+        // are measured; let them stand in for the first measurements
+        m_LODController.SeedSubframe(PredictLODCost(m_iCurrentLOD));
+      }
       if (m_bDoStereoRendering) {
         m_vLeftEyeBrickList =
           BuildLeftEyeSubFrameBrickList(region.modelView[1], m_vCurrentBrickList);
+        // isosurfaces are depth tested, any order is fine for both eyes
+        m_StereoSchedule.Build(brick_keys(m_vCurrentBrickList),
+                               brick_keys(m_vLeftEyeBrickList),
+                               m_eRenderMode != RM_ISOSURFACE);
+        MESSAGE("%u of %u bricks are shared by both eyes.",
+                uint32_t(m_StereoSchedule.GetSharedCount()),
+                uint32_t(m_vCurrentBrickList.size()));
+      } else {
+        m_StereoSchedule.Clear();
       }
 
       m_iBricksRenderedInThisSubFrame = 0;
+      m_iStereoStepsRendered = 0;
     }
   }
 
@@ -1238,6 +1365,7 @@ void AbstrRenderer::PlanHQMIPFrame(RenderRegion& renderRegion) {
   m_vCurrentBrickList = BuildSubFrameBrickList(true);
 
   m_iBricksRenderedInThisSubFrame = 0;
+  m_iStereoStepsRendered = 0;
 
   // update frame states
   m_iIntraFrameCounter = 0;
@@ -1760,6 +1888,344 @@ bool AbstrRenderer::CaptureSingleFrame(const std::string&, bool) const {
   return false;
 }
 
+bool AbstrRenderer::CaptureSingleFrameAsync(const std::string& strFilename,
+                                            bool bPreserveTransparency) {
+  return CaptureSingleFrame(strFilename, bPreserveTransparency);
+}
+
+bool AbstrRenderer::FinishCaptures() {
+  return true;
+}
+
+void AbstrRenderer::TakeCaptureReports(std::vector<CaptureReport>&) { }
+
+void AbstrRenderer::AddSequenceCameraKey(float fTime,
+                                         const FLOATMATRIX4& rotation,
+                                         const FLOATMATRIX4& translation) {
+  m_CaptureSequence.AddCameraKey(fTime, rotation, translation);
+}
+
+void AbstrRenderer::AddSequenceTFKey(float fTime) {
+  if (!m_p1DTrans) {
+    T_ERROR("No 1D transfer function to add as a key.");
+    return;
+  }
+  m_CaptureSequence.AddTransferFunctionKey(fTime, m_p1DTrans->GetColorData());
+}
+
+void AbstrRenderer::ClearSequence() {
+  m_CaptureSequence.Clear();
+}
+
+namespace {
+  /// a frame handed to the encoder whose report is outstanding
+  struct SequenceFrame {
+    uint32_t iFrame;
+    double   fRenderMs;
+  };
+  typedef std::map<std::string, SequenceFrame> PendingFrames;
+
+  struct SequenceStats {
+    SequenceStats() : iWritten(0), iFailed(0), fRenderMs(0), fEncodeMs(0) {}
+    uint32_t iWritten;
+    uint32_t iFailed;
+    double   fRenderMs;
+    double   fEncodeMs;
+  };
+
+  void LogFrame(const std::string& strFilename, const SequenceFrame& frame,
+                double fEncodeMs, SequenceStats& stats) {
+    MESSAGE("Sequence frame %u: rendered in %g ms, encoded in %g ms",
+            frame.iFrame, frame.fRenderMs, fEncodeMs);
+    if (!CaptureSequence::AppendLog(strFilename, frame.iFrame,
+                                    frame.fRenderMs, fEncodeMs)) {
+      WARNING("Could not log frame %u to %s.", frame.iFrame,
+              CaptureSequence::LogFilename(strFilename).c_str());
+    }
+    ++stats.iWritten;
+    stats.fRenderMs += frame.fRenderMs;
+    stats.fEncodeMs += fEncodeMs;
+  }
+
+  void LogReports(const std::string& strFilename,
+                  const std::vector<CaptureReport>& reports,
+                  PendingFrames& pending, SequenceStats& stats) {
+    for (std::vector<CaptureReport>::const_iterator r = reports.begin();
+         r != reports.end(); ++r) {
+      PendingFrames::iterator frame = pending.find(r->strFilename);
+      if (frame == pending.end()) continue; // not one of ours
+      if (r->bSuccess) {
+        LogFrame(strFilename, frame->second, r->fEncodeMs, stats);
+      } else {
+        T_ERROR("Could not write sequence frame %s.", r->strFilename.c_str());
+        ++stats.iFailed;
+      }
+      pending.erase(frame);
+    }
+  }
+}
+
+bool AbstrRenderer::CaptureImageSequence(const std::string& strFilename,
+                                         uint32_t iFrames,
+                                         bool bPreserveTransparency,
+                                         bool bResume) {
+  std::shared_ptr<RenderRegion3D> region = GetFirst3DRegion();
+  if (!region || !m_pDataset) {
+    T_ERROR("Sequence capture needs a 3D region and a dataset.");
+    return false;
+  }
+
+  std::set<uint32_t> done;
+  if (bResume) {
+    done = CaptureSequence::ReadLog(strFilename);
+    MESSAGE("Resuming sequence %s, %u of %u frames exist already.",
+            strFilename.c_str(), uint32_t(done.size()), iFrames);
+  } else {
+    remove(CaptureSequence::LogFilename(strFilename).c_str());
+  }
+
+  const ERendererTarget eTarget = m_eRendererTarget;
+  m_eRendererTarget = RT_CAPTURE;
+
+  // the keys only drive the sequence; the user's view comes back afterwards
+  const FLOATMATRIX4 mRotation = region->rotation;
+  const FLOATMATRIX4 mTranslation = region->translation;
+  std::vector<FLOATVECTOR4> vUserColors;
+  if (m_CaptureSequence.HasTransferFunctionKeys() && m_p1DTrans) {
+    vUserColors = m_p1DTrans->GetColorData();
+  }
+
+  PendingFrames pending;
+  SequenceStats stats;
+  std::vector<CaptureReport> reports;
+  std::vector<FLOATVECTOR4> colors;
+  bool bAborted = false;
+
+  for (uint32_t i = 0;i<iFrames && !bAborted;i++) {
+    if (done.count(i)) continue;
+
+    const float fTime = m_CaptureSequence.FrameTime(i, iFrames);
+    if (m_CaptureSequence.HasCameraKeys()) {
+      FLOATMATRIX4 rotation, translation;
+      m_CaptureSequence.Camera(fTime, rotation, translation);
+      SetRotationRR(region.get(), rotation);
+      SetTranslation(region.get(), translation);
+    }
+    if (m_CaptureSequence.HasTransferFunctionKeys() && m_p1DTrans) {
+      m_CaptureSequence.TransferFunction(fTime, colors);
+      // an unchanged transfer function keeps everything on the GPU valid
+      if (colors.size() != m_p1DTrans->GetSize()) {
+        WARNING("Transfer function keys do not match the size of the "
+                "current transfer function, ignoring them.");
+      } else if (colors != m_p1DTrans->GetColorData()) {
+        m_p1DTrans->GetColorData() = colors;
+        Changed1DTrans();
+      }
+    }
+    // each frame is rendered from scratch, even if no key changed it
+    ScheduleWindowRedraw(region.get());
+
+    const uint64_t iStart = Tracer::Now();
+    {
+      TUVOK_TRACE("capture", "RenderSequenceFrame");
+      do {
+        if (!Paint()) {
+          T_ERROR("Rendering sequence frame %u failed.", i);
+          bAborted = true;
+          break;
+        }
+      } while (CheckForRedraw());
+    }
+    if (bAborted) break;
+
+    SequenceFrame frame;
+    frame.iFrame = i;
+    frame.fRenderMs = double(Tracer::Now() - iStart) / 1e6;
+    const std::string strFrame = CaptureSequence::FrameFilename(strFilename,
+                                                                i);
+    if (!CaptureSingleFrameAsync(strFrame, bPreserveTransparency)) {
+      T_ERROR("Could not capture sequence frame %s.", strFrame.c_str());
+      ++stats.iFailed;
+    } else {
+      pending[strFrame] = frame;
+    }
+
+    reports.clear();
+    TakeCaptureReports(reports);
+    LogReports(strFilename, reports, pending, stats);
+  }
+
+  const bool bFinished = FinishCaptures();
+  reports.clear();
+  TakeCaptureReports(reports);
+  LogReports(strFilename, reports, pending, stats);
+  // synchronous renderers do not report; their frames are complete now
+  for (PendingFrames::const_iterator frame = pending.begin();
+       bFinished && frame != pending.end(); ++frame) {
+    LogFrame(strFilename, frame->second, 0.0, stats);
+  }
+
+  m_eRendererTarget = eTarget;
+  if (m_CaptureSequence.HasCameraKeys()) {
+    SetRotationRR(region.get(), mRotation);
+    SetTranslation(region.get(), mTranslation);
+  }
+  if (!vUserColors.empty() && vUserColors != m_p1DTrans->GetColorData()) {
+    m_p1DTrans->GetColorData() = vUserColors;
+    Changed1DTrans();
+  }
+  ScheduleCompleteRedraw();
+
+  if (stats.iWritten) {
+    MESSAGE("Sequence %s: wrote %u frames, %g ms rendering and %g ms "
+            "encoding per frame on average.", strFilename.c_str(),
+            stats.iWritten, stats.fRenderMs / stats.iWritten,
+            stats.fEncodeMs / stats.iWritten);
+  }
+  return !bAborted && bFinished && stats.iFailed == 0;
+}
+
+bool AbstrRenderer::ReadFrame(std::vector<uint16_t>&, UINTVECTOR2&) const {
+  T_ERROR("This renderer can not read back frames.");
+  return false;
+}
+
+FLOATMATRIX4 AbstrRenderer::TileProjection() const {
+  FLOATMATRIX4 m;
+  if (!m_bTiledRendering) return m;
+
+  // the window in normalized device coordinates of the full image; y is
+  // counted from the top in m_vTileOffset but points up in NDC
+  const FLOATVECTOR2 vImage(m_vTiledImageSize);
+  const FLOATVECTOR2 vTile(m_vWinSize);
+  const float fLeft = -1.0f + 2.0f * m_vTileOffset.x / vImage.x;
+  const float fTop  =  1.0f - 2.0f * m_vTileOffset.y / vImage.y;
+  const float fRight  = fLeft + 2.0f * vTile.x / vImage.x;
+  const float fBottom = fTop  - 2.0f * vTile.y / vImage.y;
+
+  // scale and shift that window onto [-1,1]; the shift is applied to clip
+  // coordinates, so it goes into the w row
+  m.m11 = vImage.x / vTile.x;
+  m.m22 = vImage.y / vTile.y;
+  m.m41 = -(fLeft + fRight) / (fRight - fLeft);
+  m.m42 = -(fBottom + fTop) / (fTop - fBottom);
+  return m;
+}
+
+namespace {
+  /// Copies the top left corner of a bottom-up RGBA frame into a top-down
+  /// tile with iSamples (3 or 4) samples per pixel.
+  void CropTile(const std::vector<uint16_t>& vFrame,
+                const UINTVECTOR2& vFrameSize, const UINTVECTOR2& vTileSize,
+                uint32_t iSamples, std::vector<uint16_t>& vTile) {
+    vTile.resize(size_t(vTileSize.area()) * iSamples);
+    uint16_t* pDst = &vTile[0];
+    for (uint32_t y = 0;y<vTileSize.y;y++) {
+      const uint16_t* pSrc = &vFrame[size_t(vFrameSize.y-1-y) *
+                                     vFrameSize.x * 4];
+      if (iSamples == 4) {
+        std::copy(pSrc, pSrc + vTileSize.x*4, pDst);
+        pDst += vTileSize.x*4;
+      } else {
+        for (uint32_t x = 0;x<vTileSize.x;x++, pSrc += 4) {
+          *pDst++ = pSrc[0];
+          *pDst++ = pSrc[1];
+          *pDst++ = pSrc[2];
+        }
+      }
+    }
+  }
+}
+
+bool AbstrRenderer::CaptureTiled(const std::string& strFilename,
+                                 const UINTVECTOR2& vImageSize,
+                                 bool bPreserveTransparency) {
+  std::shared_ptr<RenderRegion3D> region = GetFirst3DRegion();
+  if (!region || !m_pDataset) {
+    T_ERROR("Tiled capture needs a 3D region and a dataset.");
+    return false;
+  }
+  if (region->minCoord != UINTVECTOR2(0,0) || region->maxCoord != m_vWinSize) {
+    T_ERROR("Tiled capture needs a single 3D view.");
+    return false;
+  }
+  if (m_bDoStereoRendering) {
+    T_ERROR("Tiled capture does not support stereo rendering.");
+    return false;
+  }
+
+  // TIFF tiles are multiples of 16 pixels; the windows overlap a little
+  // and each one contributes its top left vTileSize pixels
+  const UINTVECTOR2 vTileSize((m_vWinSize.x / 16) * 16,
+                              (m_vWinSize.y / 16) * 16);
+  if (!TIFFTileWriter::IsValidTileSize(vTileSize)) {
+    T_ERROR("The window is too small for tiled capture.");
+    return false;
+  }
+  const uint32_t iSamples = bPreserveTransparency ? 4 : 3;
+  TIFFTileWriter tiff;
+  if (!tiff.Open(strFilename, vImageSize, vTileSize, iSamples, 16)) {
+    return false;
+  }
+
+  const ERendererTarget eTarget = m_eRendererTarget;
+  m_eRendererTarget = RT_CAPTURE;
+  m_bTiledRendering = true;
+  m_vTiledImageSize = vImageSize;
+
+  const UINTVECTOR2 vTiles = tiff.GetTileCount();
+  std::vector<uint16_t> vFrame, vTile;
+  bool bOK = true;
+  const uint64_t iStart = Tracer::Now();
+
+  for (uint32_t y = 0;y<vTiles.y && bOK;y++) {
+    for (uint32_t i = 0;i<vTiles.x && bOK;i++) {
+      // every other row runs backwards, so consecutive tiles are always
+      // neighbours and most of the bricks they need are still resident
+      const uint32_t x = (y % 2) ? vTiles.x-1-i : i;
+      m_vTileOffset = UINTVECTOR2(x * vTileSize.x, y * vTileSize.y);
+      // PlanFrame culls before the viewport is set for the frame
+      SetViewPort(region->minCoord, region->maxCoord, false);
+      ScheduleWindowRedraw(region.get());
+
+      {
+        TUVOK_TRACE("capture", "RenderTile");
+        do {
+          if (!Paint()) {
+            T_ERROR("Rendering tile %u,%u failed.", x, y);
+            bOK = false;
+            break;
+          }
+        } while (CheckForRedraw());
+      }
+      if (!bOK) break;
+
+      UINTVECTOR2 vFrameSize;
+      if (!ReadFrame(vFrame, vFrameSize) ||
+          vFrameSize.x < vTileSize.x || vFrameSize.y < vTileSize.y) {
+        T_ERROR("Could not read back tile %u,%u.", x, y);
+        bOK = false;
+        break;
+      }
+      CropTile(vFrame, vFrameSize, vTileSize, iSamples, vTile);
+      bOK = tiff.WriteTile(x, y, &vTile[0]);
+    }
+  }
+  if (bOK) bOK = tiff.Close();
+
+  m_bTiledRendering = false;
+  m_eRendererTarget = eTarget;
+  SetViewPort(region->minCoord, region->maxCoord, false);
+  ScheduleCompleteRedraw();
+
+  if (bOK) {
+    MESSAGE("Wrote %ux%u image %s in %u tiles, %g s.", vImageSize.x,
+            vImageSize.y, strFilename.c_str(), vTiles.area(),
+            double(Tracer::Now() - iStart) / 1e9);
+  }
+  return bOK;
+}
+
 /// Hacks!  These just do nothing.
 void AbstrRenderer::PH_ClearWorkingSet() { }
 UINTVECTOR4 AbstrRenderer::PH_RecalculateVisibility() {
@@ -2118,6 +2584,11 @@ void AbstrRenderer::RegisterLuaFunctions(
                     "loadDataset", "", true);
   id = reg.function(&AbstrRenderer::LoadRebricked,
                     "loadRebricked", "load a rebricked DS", true);
+  id = reg.function(&AbstrRenderer::LoadSynthetic,
+                    "loadSynthetic", "Generates a data set in memory, e.g. "
+                    "'blobs:size=512:brick=64:empty=0.9'. Patterns: noise, "
+                    "shells, ml, blobs; keys: size, brick, overlap, bits, "
+                    "timesteps, empty, seed.", true);
 
   id = reg.function(&AbstrRenderer::GetUseOnlyPowerOfTwo,
                     "getUseOnlyPowerOfTwo", "", false);
@@ -2251,6 +2722,39 @@ void AbstrRenderer::RegisterLuaFunctions(
 
   id = reg.function(&AbstrRenderer::CaptureSingleFrame,
                     "captureSingleFrame", "Captures current FBO state.", true);
+  id = reg.function(&AbstrRenderer::CaptureSingleFrameAsync,
+                    "captureSingleFrameAsync",
+                    "Captures current FBO state; the image is written in the "
+                    "background.", true);
+  id = reg.function(&AbstrRenderer::FinishCaptures, "finishCaptures",
+                    "Waits until all asynchronous captures are written.",
+                    false);
+  id = reg.function(&AbstrRenderer::CaptureImageSequence, "captureSequence",
+                    "Renders and writes the frames of the current sequence.",
+                    false);
+  ss->addParamInfo(id, 0, "filename", "name of the images, numbered "
+                   "automatically");
+  ss->addParamInfo(id, 1, "frames", "number of frames");
+  ss->addParamInfo(id, 2, "transparency", "preserve transparency");
+  ss->addParamInfo(id, 3, "resume", "skip the frames that a previous run "
+                   "logged as written");
+  id = reg.function(&AbstrRenderer::AddSequenceCameraKey,
+                    "addSequenceCameraKey",
+                    "Adds a rotation and translation key to the sequence.",
+                    false);
+  ss->addParamInfo(id, 0, "time", "time of the key");
+  id = reg.function(&AbstrRenderer::AddSequenceTFKey, "addSequenceTFKey",
+                    "Adds the current 1D transfer function as a key to the "
+                    "sequence.", false);
+  ss->addParamInfo(id, 0, "time", "time of the key");
+  id = reg.function(&AbstrRenderer::ClearSequence, "clearSequence",
+                    "Removes all sequence keys.", false);
+  id = reg.function(&AbstrRenderer::CaptureTiled, "captureTiled",
+                    "Renders the 3D view in window sized tiles into a TIFF "
+                    "image of any size.", false);
+  ss->addParamInfo(id, 0, "filename", "TIFF file to write");
+  ss->addParamInfo(id, 1, "size", "width and height of the image");
+  ss->addParamInfo(id, 2, "transparency", "preserve transparency");
   reg.function(&AbstrRenderer::vecRegion, "createVecRegion", "creates a "
                "std::vector<LuaClassInstance> from a single LuaClassInstance",
                true);
@@ -44,8 +44,12 @@
 #include <memory>
 
 #include "../StdTuvokDefines.h"
+#include "../Renderer/BrickCostModel.h"
+#include "../Renderer/CaptureSequence.h"
 #include "../Renderer/CullingLOD.h"
+#include "../Renderer/LODController.h"
 #include "../Renderer/RenderRegion.h"
+#include "../Renderer/StereoBrickScheduler.h"
 #include "../IO/Dataset.h"
 #include "../Basics/Plane.h"
 #include "../Basics/GeometryGenerator.h"
@@ -62,6 +66,7 @@ namespace tuvok {
 
 class MasterController;
 class RenderMesh;
+struct CaptureReport;
 class LuaDatasetProxy;
 class LuaTransferFun1DProxy;
 class LuaTransferFun2DProxy;
@@ -183,7 +188,7 @@ class AbstrRenderer {
     void UpdateData(const BrickKey&,
                     std::shared_ptr<float> fp, size_t len);
 */
-    void ClearBricks() { m_pDataset->Clear(); }
+    void ClearBricks() { m_pDataset->Clear(); ++m_iDatasetGeneration; }
 
 
     virtual void Set1DTrans(const std::vector<unsigned char>& rgba) = 0;
@@ -398,6 +403,45 @@ class AbstrRenderer {
     virtual void ToggleStereoFrame();
     virtual bool CaptureSingleFrame(const std::string& strFilename,
                                     bool bPreserveTransparency) const;
+    /// Like CaptureSingleFrame, but the image is written in the background
+    /// while rendering goes on; FinishCaptures() waits for it.
+    virtual bool CaptureSingleFrameAsync(const std::string& strFilename,
+                                         bool bPreserveTransparency);
+    /// \return false if any asynchronous capture failed
+    virtual bool FinishCaptures();
+    /// Appends the reports of the asynchronous captures written since the
+    /// last call.  Renderers that capture synchronously report nothing.
+    virtual void TakeCaptureReports(std::vector<CaptureReport>& reports);
+
+    /** Renders iFrames frames along the sequence keys, each one to
+     * convergence in RT_CAPTURE mode, and writes them to numbered files:
+     * "movie.png" becomes movie_00000.png, movie_00001.png, ...
+     * Every written frame is recorded with its render and encode time in
+     * a log next to the images (movie.log); with bResume the frames listed
+     * there are skipped.  The context must be current. */
+    bool CaptureImageSequence(const std::string& strFilename,
+                              uint32_t iFrames, bool bPreserveTransparency,
+                              bool bResume);
+    void AddSequenceCameraKey(float fTime, const FLOATMATRIX4& rotation,
+                              const FLOATMATRIX4& translation);
+    /// adds the current 1D transfer function as a key
+    void AddSequenceTFKey(float fTime);
+    void ClearSequence();
+
+    /** Renders the first 3D region at vImageSize pixels, which may be far
+     * larger than the window, and writes it to a 16 bit TIFF.  The
+     * projection is cut into window sized sub-frusta that are rendered to
+     * convergence one after the other; the LOD is selected for the full
+     * image.  Each tile goes to disk as soon as it is done, so the image is
+     * never held in memory, and neighbouring tiles are rendered in
+     * succession to reuse the resident bricks.  The context must be
+     * current. */
+    bool CaptureTiled(const std::string& strFilename,
+                      const UINTVECTOR2& vImageSize,
+                      bool bPreserveTransparency);
+    /// Reads back the last rendered frame as 16 bit RGBA, bottom row first.
+    virtual bool ReadFrame(std::vector<uint16_t>& vRGBA,
+                           UINTVECTOR2& vSize) const;
 
     virtual void ScheduleCompleteRedraw();
     /** Query whether or not we should redraw the next frame, else we should
@@ -462,6 +506,9 @@ class AbstrRenderer {
     virtual bool LoadRebricked(const std::string& strFilename,
                                const UINTVECTOR3 bsize,
                                size_t minmaxMode);
+    /// generates a SyntheticDataset, see SyntheticDataset::ParseSpec for
+    /// the format of 'spec'.
+    virtual bool LoadSynthetic(const std::string& spec);
 
     virtual bool Initialize(std::shared_ptr<Context> ctx);
 
@@ -714,9 +761,8 @@ class AbstrRenderer {
 
     /// parameters for dynamic resolution adjustments
     ///@{
-    float  msecPassed[2]; // time taken for last two frames
     float  msecPassedCurrentFrame; // time taken for our current rendering
-    uint32_t m_iLODNotOKCounter; // n frames waited for render to become faster
+    LODController m_LODController; ///< picks the start LOD from predictions
     bool decreaseScreenRes; ///< dec.'d display resolution (lower n_fragments)
     bool decreaseScreenResNow;
     bool decreaseSamplingRate; ///< dec.'d sampling rate (less shader work)
@@ -732,6 +778,11 @@ class AbstrRenderer {
     uint32_t m_iStartDelay;
     uint64_t m_iMinLODForCurrentView;
     uint32_t m_iTimeSliceMSecs;
+    BrickCostModel m_BrickCostModel; ///< GPU time of the bricks rendered
+    /// Share of the bricks and voxels of its level the last planned subframe
+    /// needed, i.e. what culling and empty space skipping left over.
+    double m_fNeededBrickShare;
+    double m_fNeededVoxelShare;
     ///@}
 
     uint64_t            m_iIntraFrameCounter;
@@ -739,7 +790,6 @@ class AbstrRenderer {
     uint32_t            m_iCheckCounter;
     uint64_t            m_iMaxLODIndex;
     UINTVECTOR2         m_iLODLimits;
-    uint64_t            m_iPerformanceBasedLODSkip;
     uint64_t            m_iCurrentLODOffset;
     uint64_t            m_iStartLODOffset;
     size_t              m_iTimestep;
@@ -750,6 +800,35 @@ class AbstrRenderer {
     uint64_t            m_iBricksRenderedInThisSubFrame;
     std::vector<Brick>  m_vCurrentBrickList;
     std::vector<Brick>  m_vLeftEyeBrickList;
+    /// stereo: which bricks of the two lists are rendered while a brick is
+    /// bound, and how many of these steps are done
+    StereoBrickScheduler m_StereoSchedule;
+    uint64_t            m_iStereoStepsRendered;
+    /// The bricks of one timestep and LOD with their geometry, so that
+    /// BuildSubFrameBrickList neither scans the whole brick table nor
+    /// recomputes texture coordinates for every frame; only the view and
+    /// transfer function dependent tests are redone.
+    struct BrickCandidate {
+      Brick   brick;
+      BrickMD md;
+    };
+    std::vector<BrickCandidate> m_vBrickCandidates;
+    /// bumped whenever the dataset is replaced or its bricks are cleared,
+    /// a new dataset may well get the address of the old one
+    uint64_t            m_iDatasetGeneration;
+    const Dataset*      m_pCandidateDataset;
+    uint64_t            m_iCandidateGeneration;
+    size_t              m_iCandidateTimestep;
+    uint64_t            m_iCandidateLOD;
+    FLOATVECTOR3        m_vCandidateScale;
+    bool                m_bCandidatePowerOfTwo;
+    CaptureSequence     m_CaptureSequence;
+    /// set during CaptureTiled: the window shows the part of the
+    /// m_vTiledImageSize image that starts m_vTileOffset pixels from its top
+    /// left corner
+    bool                m_bTiledRendering;
+    UINTVECTOR2         m_vTiledImageSize;
+    UINTVECTOR2         m_vTileOffset;
     ERendererTarget     m_eRendererTarget;
     bool                m_bMIPLOD;
     float               m_fMIPRotationAngle;
@@ -825,7 +904,16 @@ class AbstrRenderer {
 
     virtual void        ScheduleRecompose(RenderRegion *renderRegion=NULL);
     void                ComputeMinLODForCurrentView();
-    void                ComputeMaxLODForCurrentView();
+    /// \param iPixels size of the region the frame is planned for
+    void                ComputeMaxLODForCurrentView(uint64_t iPixels);
+    /// Time in ms m_BrickCostModel predicts for rendering the bricks of the
+    /// given LOD the current view needs, assuming the same share of them is
+    /// needed as in the last planned subframe; 0 as long as the model has
+    /// not seen enough bricks.
+    double              PredictLODCost(uint64_t iLOD) const;
+    /// measures m_fNeededBrickShare and m_fNeededVoxelShare for the brick
+    /// list just built
+    void                UpdateNeededShare();
     virtual void        PlanFrame(RenderRegion3D& region);
     void                PlanHQMIPFrame(RenderRegion& renderRegion);
     /// @return true if the brick is needed to render the given region
@@ -836,13 +924,27 @@ class AbstrRenderer {
     bool Clipped(const RenderRegion&, const Brick&) const;
     /// does the current brick contain relevant data?
     bool ContainsData(const BrickKey&) const;
+    /// Maps the clip space of the full tiled image onto the current tile;
+    /// multiplied onto the projection.  Identity unless tiled.
+    FLOATMATRIX4        TileProjection() const;
+    /// refills m_vBrickCandidates if the dataset, its generation, the
+    /// timestep, LOD or scale changed
+    void                UpdateBrickCandidates();
     std::vector<Brick>  BuildSubFrameBrickList(bool bUseResidencyAsDistanceCriterion=false);
     std::vector<Brick>  BuildLeftEyeSubFrameBrickList(
                           const FLOATMATRIX4& modelview,
                           const std::vector<Brick>& vRightEyeBrickList
                         ) const;
+    /// true once the current subframe rendered anything.  In stereo
+    /// m_iBricksRenderedInThisSubFrame only counts bricks done for both
+    /// eyes, so it stays 0 while the first steps render a single eye.
+    bool SubframeStarted() const {
+      return m_bDoStereoRendering ? m_iStereoStepsRendered > 0
+                                  : m_iBricksRenderedInThisSubFrame > 0;
+    }
     void                CompletedASubframe(RenderRegion* region);
-    void                RestartTimer(const size_t iTimerIndex);
+    /// The subframe in progress is not measured, e.g. after the render
+    /// regions changed.
     void                RestartTimers();
     double              MaxValue() const;
     bool                OnlyRecomposite(RenderRegion* region) const;
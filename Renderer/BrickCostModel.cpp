@@ -0,0 +1,91 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    BrickCostModel.cpp
+*/
+
+#include "BrickCostModel.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace tuvok;
+
+BrickCostModel::BrickCostModel(uint32_t iHalfLife) :
+  m_fDecay(std::pow(0.5, 1.0 / std::max<uint32_t>(1, iHalfLife)))
+{
+  Reset();
+}
+
+void BrickCostModel::Reset() {
+  m_fW = m_fV = m_fT = m_fVV = m_fVT = 0.0;
+  m_fOverhead = 0.0;
+  m_fCostPerVoxel = 0.0;
+  m_iSamples = 0;
+}
+
+void BrickCostModel::AddSample(uint64_t iVoxels, double fMSecs) {
+  if (!(fMSecs >= 0.0)) return; // negative or NaN: clock hiccup
+
+  const double v = double(iVoxels);
+  m_fW  = m_fW  * m_fDecay + 1.0;
+  m_fV  = m_fV  * m_fDecay + v;
+  m_fT  = m_fT  * m_fDecay + fMSecs;
+  m_fVV = m_fVV * m_fDecay + v*v;
+  m_fVT = m_fVT * m_fDecay + v*fMSecs;
+  ++m_iSamples;
+  Fit();
+}
+
+void BrickCostModel::Fit() {
+  const double fMeanV = m_fV / m_fW;
+  const double fMeanT = m_fT / m_fW;
+  const double fVarV  = m_fVV / m_fW - fMeanV*fMeanV;
+  const double fCov   = m_fVT / m_fW - fMeanV*fMeanT;
+
+  // weighted least squares; needs a noticeable spread of brick sizes
+  if (fMeanV > 0.0 && fVarV > 0.01 * fMeanV*fMeanV) {
+    m_fCostPerVoxel = std::max(0.0, fCov / fVarV);
+    m_fOverhead = std::max(0.0, fMeanT - m_fCostPerVoxel * fMeanV);
+  } else if (fMeanV > 0.0) {
+    m_fCostPerVoxel = fMeanT / fMeanV;
+    m_fOverhead = 0.0;
+  } else {
+    m_fCostPerVoxel = 0.0;
+    m_fOverhead = fMeanT;
+  }
+}
+
+double BrickCostModel::Predict(uint64_t iVoxels) const {
+  return Predict(1, iVoxels);
+}
+
+double BrickCostModel::Predict(uint64_t iBricks, uint64_t iVoxels) const {
+  if (!IsTrained()) return 0.0;
+  return double(iBricks) * m_fOverhead + double(iVoxels) * m_fCostPerVoxel;
+}
@@ -0,0 +1,89 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    BrickCostModel.h
+  \brief   Online estimate of the time it takes to render a brick.
+*/
+#pragma once
+
+#ifndef BRICKCOSTMODEL_H
+#define BRICKCOSTMODEL_H
+
+#include "../StdTuvokDefines.h"
+
+namespace tuvok {
+
+  /**
+   \class BrickCostModel
+   \brief Predicts brick render times from the voxel count of the brick
+
+   Fits cost = overhead + voxels * costPerVoxel to the measured brick times
+   with exponentially decaying weights, so the model follows changes of the
+   view, transfer function or sampling rate within a few dozen bricks.  If
+   all bricks have (nearly) the same size the overhead can not be told apart
+   from the per voxel cost and the model degenerates to a plain cost per
+   voxel.
+  */
+  class BrickCostModel
+  {
+  public:
+    //! \param iHalfLife number of samples after which a sample has lost half
+    //!                  its weight
+    BrickCostModel(uint32_t iHalfLife = 32);
+
+    void AddSample(uint64_t iVoxels, double fMSecs);
+    void Reset();
+
+    //! the model only predicts something after MIN_SAMPLES samples
+    bool IsTrained() const { return m_iSamples >= MIN_SAMPLES; }
+    uint64_t GetSampleCount() const { return m_iSamples; }
+
+    //! predicted time in ms for a brick with iVoxels voxels, 0 if untrained
+    double Predict(uint64_t iVoxels) const;
+    //! predicted time in ms for iBricks bricks with iVoxels voxels in total
+    double Predict(uint64_t iBricks, uint64_t iVoxels) const;
+
+    double GetOverhead() const { return m_fOverhead; }
+    double GetCostPerVoxel() const { return m_fCostPerVoxel; }
+
+  private:
+    enum { MIN_SAMPLES = 4 };
+
+    void Fit();
+
+    double   m_fDecay;
+    //! decayed sums of weights, v, t, v*v and v*t
+    double   m_fW, m_fV, m_fT, m_fVV, m_fVT;
+    double   m_fOverhead;
+    double   m_fCostPerVoxel;
+    uint64_t m_iSamples;
+  };
+
+}
+#endif // BRICKCOSTMODEL_H
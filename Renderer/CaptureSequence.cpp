@@ -0,0 +1,246 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    CaptureSequence.cpp
+*/
+
+#include "CaptureSequence.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "Basics/SysTools.h"
+
+using namespace tuvok;
+
+namespace {
+  // m[r][c] is array[r*4+c]; only the upper 3x3 block is used
+  FLOATVECTOR4 ToQuaternion(const FLOATMATRIX4& mat) {
+    const float* m = mat.array;
+    FLOATVECTOR4 q;
+    const float fTrace = m[0] + m[5] + m[10];
+    if (fTrace > 0.0f) {
+      const float s = 2.0f * std::sqrt(fTrace + 1.0f);
+      q = FLOATVECTOR4((m[9]-m[6])/s, (m[2]-m[8])/s, (m[4]-m[1])/s, 0.25f*s);
+    } else if (m[0] > m[5] && m[0] > m[10]) {
+      const float s = 2.0f * std::sqrt(1.0f + m[0] - m[5] - m[10]);
+      q = FLOATVECTOR4(0.25f*s, (m[1]+m[4])/s, (m[2]+m[8])/s, (m[9]-m[6])/s);
+    } else if (m[5] > m[10]) {
+      const float s = 2.0f * std::sqrt(1.0f + m[5] - m[0] - m[10]);
+      q = FLOATVECTOR4((m[1]+m[4])/s, 0.25f*s, (m[6]+m[9])/s, (m[2]-m[8])/s);
+    } else {
+      const float s = 2.0f * std::sqrt(1.0f + m[10] - m[0] - m[5]);
+      q = FLOATVECTOR4((m[2]+m[8])/s, (m[6]+m[9])/s, 0.25f*s, (m[4]-m[1])/s);
+    }
+    return q;
+  }
+
+  FLOATMATRIX4 ToMatrix(const FLOATVECTOR4& q) {
+    FLOATMATRIX4 mat;
+    float* m = mat.array;
+    const float x = q.x, y = q.y, z = q.z, w = q.w;
+    m[0] = 1-2*(y*y+z*z); m[1] = 2*(x*y-z*w);   m[2] = 2*(x*z+y*w);
+    m[4] = 2*(x*y+z*w);   m[5] = 1-2*(x*x+z*z); m[6] = 2*(y*z-x*w);
+    m[8] = 2*(x*z-y*w);   m[9] = 2*(y*z+x*w);   m[10] = 1-2*(x*x+y*y);
+    return mat;
+  }
+
+  float Dot(const FLOATVECTOR4& a, const FLOATVECTOR4& b) {
+    return a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+  }
+
+  FLOATVECTOR4 Slerp(const FLOATVECTOR4& a, FLOATVECTOR4 b, float t) {
+    float fCos = Dot(a, b);
+    // take the short way around
+    if (fCos < 0.0f) {
+      b = b * -1.0f;
+      fCos = -fCos;
+    }
+    FLOATVECTOR4 q;
+    if (fCos > 0.9995f) {
+      // nearly parallel, lerp is precise enough and avoids dividing by ~0
+      q = a * (1.0f-t) + b * t;
+    } else {
+      const float fAngle = std::acos(fCos);
+      const float fSin = std::sin(fAngle);
+      q = a * (std::sin((1.0f-t)*fAngle) / fSin) +
+          b * (std::sin(t*fAngle) / fSin);
+    }
+    return q * (1.0f / std::sqrt(Dot(q, q)));
+  }
+
+  template <typename Key>
+  bool KeyBefore(const Key& key, float fTime) { return key.fTime < fTime; }
+
+  /// index of the key at or after fTime in a non-empty, sorted vector and
+  /// the weight of that key; the key before it has weight 1-t
+  template <typename Key>
+  size_t Locate(const std::vector<Key>& keys, float fTime, float& t) {
+    typename std::vector<Key>::const_iterator it =
+      std::lower_bound(keys.begin(), keys.end(), fTime, KeyBefore<Key>);
+    if (it == keys.begin()) { t = 1.0f; return 0; }
+    if (it == keys.end())   { t = 1.0f; return keys.size()-1; }
+    const Key& prev = *(it-1);
+    t = (fTime - prev.fTime) / (it->fTime - prev.fTime);
+    return size_t(it - keys.begin());
+  }
+
+  template <typename Key>
+  void Insert(std::vector<Key>& keys, const Key& key) {
+    typename std::vector<Key>::iterator it =
+      std::lower_bound(keys.begin(), keys.end(), key.fTime, KeyBefore<Key>);
+    if (it != keys.end() && it->fTime == key.fTime) *it = key;
+    else keys.insert(it, key);
+  }
+}
+
+void CaptureSequence::AddCameraKey(float fTime, const FLOATMATRIX4& rotation,
+                                   const FLOATMATRIX4& translation) {
+  CameraKey key;
+  key.fTime = fTime;
+  key.qRotation = ToQuaternion(rotation);
+  key.translation = translation;
+  Insert(m_vCameraKeys, key);
+}
+
+void CaptureSequence::AddTransferFunctionKey(
+  float fTime, const std::vector<FLOATVECTOR4>& colors)
+{
+  TFKey key;
+  key.fTime = fTime;
+  key.colors = colors;
+  Insert(m_vTFKeys, key);
+}
+
+void CaptureSequence::Clear() {
+  m_vCameraKeys.clear();
+  m_vTFKeys.clear();
+}
+
+float CaptureSequence::StartTime() const {
+  float fStart = m_vCameraKeys.empty() ? 0.0f : m_vCameraKeys.front().fTime;
+  if (!m_vTFKeys.empty()) {
+    fStart = m_vCameraKeys.empty() ? m_vTFKeys.front().fTime
+                                   : std::min(fStart, m_vTFKeys.front().fTime);
+  }
+  return fStart;
+}
+
+float CaptureSequence::EndTime() const {
+  float fEnd = m_vCameraKeys.empty() ? 0.0f : m_vCameraKeys.back().fTime;
+  if (!m_vTFKeys.empty()) {
+    fEnd = m_vCameraKeys.empty() ? m_vTFKeys.back().fTime
+                                 : std::max(fEnd, m_vTFKeys.back().fTime);
+  }
+  return fEnd;
+}
+
+float CaptureSequence::FrameTime(uint32_t iFrame,
+                                 uint32_t iFrameCount) const {
+  const float fStart = StartTime();
+  if (iFrameCount < 2) return fStart;
+  return fStart + (EndTime() - fStart) * float(iFrame) / float(iFrameCount-1);
+}
+
+void CaptureSequence::Camera(float fTime, FLOATMATRIX4& rotation,
+                             FLOATMATRIX4& translation) const {
+  if (m_vCameraKeys.empty()) return;
+  float t;
+  const size_t i = Locate(m_vCameraKeys, fTime, t);
+  const CameraKey& next = m_vCameraKeys[i];
+  if (t >= 1.0f || i == 0) {
+    rotation = ToMatrix(next.qRotation);
+    translation = next.translation;
+    return;
+  }
+  const CameraKey& prev = m_vCameraKeys[i-1];
+  rotation = ToMatrix(Slerp(prev.qRotation, next.qRotation, t));
+  for (size_t e = 0;e<16;e++) {
+    translation.array[e] = prev.translation.array[e] * (1.0f-t) +
+                           next.translation.array[e] * t;
+  }
+}
+
+void CaptureSequence::TransferFunction(
+  float fTime, std::vector<FLOATVECTOR4>& colors) const
+{
+  if (m_vTFKeys.empty()) return;
+  float t;
+  const size_t i = Locate(m_vTFKeys, fTime, t);
+  const TFKey& next = m_vTFKeys[i];
+  if (t >= 1.0f || i == 0) {
+    colors = next.colors;
+    return;
+  }
+  const TFKey& prev = m_vTFKeys[i-1];
+  colors.resize(std::min(prev.colors.size(), next.colors.size()));
+  for (size_t c = 0;c<colors.size();c++) {
+    colors[c] = prev.colors[c] * (1.0f-t) + next.colors[c] * t;
+  }
+}
+
+std::string CaptureSequence::FrameFilename(const std::string& strPattern,
+                                           uint32_t iFrame) {
+  const std::string strExt = SysTools::GetExt(strPattern);
+  const std::string strBase = strExt.empty() ? strPattern :
+    strPattern.substr(0, strPattern.size() - strExt.size() - 1);
+  char number[16];
+  snprintf(number, sizeof(number), "_%05u", iFrame);
+  return strBase + number + (strExt.empty() ? "" : "." + strExt);
+}
+
+std::string CaptureSequence::LogFilename(const std::string& strPattern) {
+  return SysTools::ChangeExt(strPattern, "log");
+}
+
+std::set<uint32_t> CaptureSequence::ReadLog(const std::string& strPattern) {
+  std::set<uint32_t> frames;
+  std::ifstream log(LogFilename(strPattern).c_str());
+  std::string line;
+  while (std::getline(log, line)) {
+    std::istringstream fields(line);
+    uint32_t iFrame;
+    if (!(fields >> iFrame)) continue;  // blank or garbled line
+    // the log is written after the image, but the image may be gone since
+    if (SysTools::FileExists(FrameFilename(strPattern, iFrame))) {
+      frames.insert(iFrame);
+    }
+  }
+  return frames;
+}
+
+bool CaptureSequence::AppendLog(const std::string& strPattern, uint32_t iFrame,
+                                double fRenderMs, double fEncodeMs) {
+  std::ofstream log(LogFilename(strPattern).c_str(),
+                    std::ios::out | std::ios::app);
+  if (!log.is_open()) return false;
+  log << iFrame << " " << fRenderMs << " " << fEncodeMs << "\n";
+  return !log.fail();
+}
@@ -0,0 +1,112 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    CaptureSequence.h
+  \brief   Camera and transfer function keys of a captured image sequence.
+*/
+#pragma once
+
+#ifndef TUVOK_CAPTURESEQUENCE_H
+#define TUVOK_CAPTURESEQUENCE_H
+
+#include "../StdTuvokDefines.h"
+#include <set>
+#include <string>
+#include <vector>
+#include "Basics/Vectors.h"
+
+namespace tuvok {
+
+  /**
+   \class CaptureSequence
+   \brief Keys of a sequence rendered by AbstrRenderer::CaptureSequence
+
+   Camera keys hold the rotation and translation of the 3D region,
+   transfer function keys the colors of the 1D transfer function.  Between
+   two keys rotations are interpolated spherically and everything else
+   linearly; before the first and after the last key the nearest key holds.
+   Key times are arbitrary (seconds, frame numbers, ...); the sequence spans
+   the earliest to the latest key.
+
+   The class also keeps the progress log of a sequence, one line per frame
+   that was written, so an interrupted capture can be resumed.
+  */
+  class CaptureSequence
+  {
+  public:
+    CaptureSequence() {}
+
+    void AddCameraKey(float fTime, const FLOATMATRIX4& rotation,
+                      const FLOATMATRIX4& translation);
+    //! all transfer function keys must have the same number of entries
+    void AddTransferFunctionKey(float fTime,
+                                const std::vector<FLOATVECTOR4>& colors);
+    void Clear();
+
+    bool HasCameraKeys() const { return !m_vCameraKeys.empty(); }
+    bool HasTransferFunctionKeys() const { return !m_vTFKeys.empty(); }
+    //! time of frame iFrame of iFrameCount evenly spaced frames
+    float FrameTime(uint32_t iFrame, uint32_t iFrameCount) const;
+
+    void Camera(float fTime, FLOATMATRIX4& rotation,
+                FLOATMATRIX4& translation) const;
+    void TransferFunction(float fTime,
+                          std::vector<FLOATVECTOR4>& colors) const;
+
+    //! file name of frame iFrame: "movie.png" becomes "movie_00042.png"
+    static std::string FrameFilename(const std::string& strPattern,
+                                     uint32_t iFrame);
+    //! name of the progress log of a sequence
+    static std::string LogFilename(const std::string& strPattern);
+    //! frames recorded in the log whose files still exist
+    static std::set<uint32_t> ReadLog(const std::string& strPattern);
+    //! appends a frame to the log
+    static bool AppendLog(const std::string& strPattern, uint32_t iFrame,
+                          double fRenderMs, double fEncodeMs);
+
+  private:
+    struct CameraKey {
+      float        fTime;
+      FLOATVECTOR4 qRotation;  ///< unit quaternion (x,y,z,w)
+      FLOATMATRIX4 translation;
+    };
+    struct TFKey {
+      float                     fTime;
+      std::vector<FLOATVECTOR4> colors;
+    };
+
+    float StartTime() const;
+    float EndTime() const;
+
+    std::vector<CameraKey> m_vCameraKeys;  ///< sorted by time
+    std::vector<TFKey>     m_vTFKeys;      ///< sorted by time
+  };
+}
+
+#endif // TUVOK_CAPTURESEQUENCE_H
@@ -49,7 +49,8 @@ CullingLOD::CullingLOD(float fScreenSpaceError) :
     m_iPixelCountY(1),
     m_fScreenSpaceError(fScreenSpaceError),
     m_fLODFactor(1.0f),
-    m_bPassAll(false)
+    m_bPassAll(false),
+    m_bSecondView(false)
 {
 }
 
@@ -81,6 +82,13 @@ void CullingLOD::SetViewMatrix(const FLOATMATRIX4& mViewMatrix) {
   m_mViewMatrix = mViewMatrix;
 }
 
+void CullingLOD::SetSecondView(const FLOATMATRIX4& mViewMatrix,
+                               const FLOATMATRIX4& mProjectionMatrix) {
+  m_bSecondView = true;
+  m_mSecondViewMatrix = mViewMatrix;
+  m_mSecondProjectionMatrix = mProjectionMatrix;
+}
+
 void CullingLOD::SetModelMatrix(const FLOATMATRIX4& mModelMatrix) {
   m_mModelMatrix = mModelMatrix;
 }
@@ -89,37 +97,46 @@ void CullingLOD::Update()
 {
   m_mModelViewMatrix = m_mModelMatrix * m_mViewMatrix;
   m_mModelViewProjectionMatrix = m_mModelViewMatrix * m_mProjectionMatrix;
+  ExtractPlanes(m_mModelViewProjectionMatrix, m_Planes);
+
+  if (m_bSecondView) {
+    ExtractPlanes(m_mModelMatrix * m_mSecondViewMatrix * m_mSecondProjectionMatrix,
+                  m_SecondPlanes);
+  }
+}
 
+void CullingLOD::ExtractPlanes(const FLOATMATRIX4& mMVP, FLOATVECTOR4 planes[6])
+{
   // right clip-plane
-  m_Planes[0].x = -m_mModelViewProjectionMatrix.m11 + m_mModelViewProjectionMatrix.m14;
-  m_Planes[0].y = -m_mModelViewProjectionMatrix.m21 + m_mModelViewProjectionMatrix.m24;
-  m_Planes[0].z = -m_mModelViewProjectionMatrix.m31 + m_mModelViewProjectionMatrix.m34;
-  m_Planes[0].w = -m_mModelViewProjectionMatrix.m41 + m_mModelViewProjectionMatrix.m44;
+  planes[0].x = -mMVP.m11 + mMVP.m14;
+  planes[0].y = -mMVP.m21 + mMVP.m24;
+  planes[0].z = -mMVP.m31 + mMVP.m34;
+  planes[0].w = -mMVP.m41 + mMVP.m44;
   // left clip-plane
-  m_Planes[1].x = m_mModelViewProjectionMatrix.m11 + m_mModelViewProjectionMatrix.m14;
-  m_Planes[1].y = m_mModelViewProjectionMatrix.m21 + m_mModelViewProjectionMatrix.m24;
-  m_Planes[1].z = m_mModelViewProjectionMatrix.m31 + m_mModelViewProjectionMatrix.m34;
-  m_Planes[1].w = m_mModelViewProjectionMatrix.m41 + m_mModelViewProjectionMatrix.m44;
+  planes[1].x = mMVP.m11 + mMVP.m14;
+  planes[1].y = mMVP.m21 + mMVP.m24;
+  planes[1].z = mMVP.m31 + mMVP.m34;
+  planes[1].w = mMVP.m41 + mMVP.m44;
   // top clip-plane
-  m_Planes[2].x = -m_mModelViewProjectionMatrix.m12 + m_mModelViewProjectionMatrix.m14;
-  m_Planes[2].y = -m_mModelViewProjectionMatrix.m22 + m_mModelViewProjectionMatrix.m24;
-  m_Planes[2].z = -m_mModelViewProjectionMatrix.m32 + m_mModelViewProjectionMatrix.m34;
-  m_Planes[2].w = -m_mModelViewProjectionMatrix.m42 + m_mModelViewProjectionMatrix.m44;
+  planes[2].x = -mMVP.m12 + mMVP.m14;
+  planes[2].y = -mMVP.m22 + mMVP.m24;
+  planes[2].z = -mMVP.m32 + mMVP.m34;
+  planes[2].w = -mMVP.m42 + mMVP.m44;
   // bottom clip-plane
-  m_Planes[3].x = m_mModelViewProjectionMatrix.m12 + m_mModelViewProjectionMatrix.m14;
-  m_Planes[3].y = m_mModelViewProjectionMatrix.m22 + m_mModelViewProjectionMatrix.m24;
-  m_Planes[3].z = m_mModelViewProjectionMatrix.m32 + m_mModelViewProjectionMatrix.m34;
-  m_Planes[3].w = m_mModelViewProjectionMatrix.m42 + m_mModelViewProjectionMatrix.m44;
+  planes[3].x = mMVP.m12 + mMVP.m14;
+  planes[3].y = mMVP.m22 + mMVP.m24;
+  planes[3].z = mMVP.m32 + mMVP.m34;
+  planes[3].w = mMVP.m42 + mMVP.m44;
   // far clip-plane
-  m_Planes[4].x =  m_mModelViewProjectionMatrix.m13 + m_mModelViewProjectionMatrix.m14;
-  m_Planes[4].y =  m_mModelViewProjectionMatrix.m23 + m_mModelViewProjectionMatrix.m24;
-  m_Planes[4].z =  m_mModelViewProjectionMatrix.m33 + m_mModelViewProjectionMatrix.m34;
-  m_Planes[4].w =  m_mModelViewProjectionMatrix.m43 + m_mModelViewProjectionMatrix.m44;
+  planes[4].x =  mMVP.m13 + mMVP.m14;
+  planes[4].y =  mMVP.m23 + mMVP.m24;
+  planes[4].z =  mMVP.m33 + mMVP.m34;
+  planes[4].w =  mMVP.m43 + mMVP.m44;
   // near clip-plane
-  m_Planes[5].x = -m_mModelViewProjectionMatrix.m13 + m_mModelViewProjectionMatrix.m14;
-  m_Planes[5].y = -m_mModelViewProjectionMatrix.m23 + m_mModelViewProjectionMatrix.m24;
-  m_Planes[5].z = -m_mModelViewProjectionMatrix.m33 + m_mModelViewProjectionMatrix.m34;
-  m_Planes[5].w = -m_mModelViewProjectionMatrix.m43 + m_mModelViewProjectionMatrix.m44;
+  planes[5].x = -mMVP.m13 + mMVP.m14;
+  planes[5].y = -mMVP.m23 + mMVP.m24;
+  planes[5].z = -mMVP.m33 + mMVP.m34;
+  planes[5].w = -mMVP.m43 + mMVP.m44;
 }
 
 int CullingLOD::GetLODLevel(const FLOATVECTOR3& vfCenter,
@@ -144,9 +161,17 @@ bool CullingLOD::IsVisible(const FLOATVECTOR3& vCenter,
 
   FLOATVECTOR3 vHalfExtent = 0.5f * vfExtent;
 
+  return Intersects(m_Planes, vCenter, vHalfExtent) ||
+         (m_bSecondView && Intersects(m_SecondPlanes, vCenter, vHalfExtent));
+}
+
+bool CullingLOD::Intersects(const FLOATVECTOR4 planes[6],
+                            const FLOATVECTOR3& vCenter,
+                            const FLOATVECTOR3& vHalfExtent)
+{
   for (uint32_t uiPlane = 0; uiPlane < 6; uiPlane++)
   {
-    FLOATVECTOR4 plane = m_Planes[uiPlane];
+    FLOATVECTOR4 plane = planes[uiPlane];
     if (
       plane.x * vCenter.x + plane.y * vCenter.y + plane.z * vCenter.z + plane.w
       <= -(vHalfExtent.x * fabs(plane.x) + vHalfExtent.y * fabs(plane.y) + vHalfExtent.z * fabs(plane.z))
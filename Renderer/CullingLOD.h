@@ -53,6 +53,11 @@ class CullingLOD
     void SetProjectionMatrix(const FLOATMATRIX4& mProjectionMatrix);
     void SetModelMatrix(const FLOATMATRIX4& mModelMatrix);
     void SetViewMatrix(const FLOATMATRIX4& mViewMatrix);
+    /// For stereo: IsVisible also passes bricks in the frustum of this
+    /// second view.  The LOD is still computed for the first view.
+    void SetSecondView(const FLOATMATRIX4& mViewMatrix,
+                       const FLOATMATRIX4& mProjectionMatrix);
+    void ClearSecondView() {m_bSecondView = false;}
     void Update();
     void SetPassAll(bool bPassAll) {m_bPassAll = bPassAll;}
 
@@ -65,6 +70,11 @@ class CullingLOD
     float        GetLoDFactor() const {return m_fLODFactor;}
 
   private:
+    static void ExtractPlanes(const FLOATMATRIX4& mMVP, FLOATVECTOR4 planes[6]);
+    static bool Intersects(const FLOATVECTOR4 planes[6],
+                           const FLOATVECTOR3& vCenter,
+                           const FLOATVECTOR3& vHalfExtent);
+
     FLOATMATRIX4 m_mModelViewProjectionMatrix;
     FLOATMATRIX4 m_mModelViewMatrix;
     FLOATMATRIX4 m_mProjectionMatrix;
@@ -79,6 +89,10 @@ class CullingLOD
     float        m_fScreenSpaceError;
     float        m_fLODFactor;
     bool         m_bPassAll;
+    bool         m_bSecondView;
+    FLOATMATRIX4 m_mSecondViewMatrix;
+    FLOATMATRIX4 m_mSecondProjectionMatrix;
+    FLOATVECTOR4 m_SecondPlanes[6];
 };
 
 }
@@ -0,0 +1,106 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    FrameCapture.cpp
+*/
+
+#include "FrameCapture.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define TUVOK_FRAMECAPTURE_SSE2
+# include <emmintrin.h>
+#endif
+
+using namespace tuvok;
+
+namespace {
+  /// 16.16 fixed point 255/alpha, so demultiplying needs no division
+  struct ReciprocalTable {
+    ReciprocalTable() {
+      table[0] = 0;
+      for (uint32_t a = 1;a<256;a++) table[a] = (255u*65536u + a/2) / a;
+    }
+    uint32_t table[256];
+  };
+  const ReciprocalTable reciprocal;
+
+#ifdef TUVOK_FRAMECAPTURE_SSE2
+  /// demultiplies the pixel in the low 4 32 bit lanes of px
+  inline __m128i Demultiply(__m128i px) {
+    const __m128 c = _mm_cvtepi32_ps(px);
+    const __m128 a = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,3,3));
+    // alpha 0 gives NaN, which converts to 0x80000000 and saturates to 0
+    const __m128 scaled = _mm_add_ps(_mm_mul_ps(c, _mm_div_ps(
+                                       _mm_set1_ps(255.0f), a)),
+                                     _mm_set1_ps(0.5f));
+    return _mm_cvttps_epi32(scaled);
+  }
+#endif
+}
+
+void FrameCapture::FlipRows(void* pData, size_t iRowBytes, size_t iRows) {
+  uint8_t* pTop = static_cast<uint8_t*>(pData);
+  uint8_t* pBottom = pTop + (iRows ? iRows-1 : 0) * iRowBytes;
+  for (;pTop < pBottom;pTop += iRowBytes, pBottom -= iRowBytes) {
+    std::swap_ranges(pTop, pTop + iRowBytes, pBottom);
+  }
+}
+
+void FrameCapture::DemultiplyAlpha(uint8_t* pData, size_t iPixels) {
+  size_t i = 0;
+#ifdef TUVOK_FRAMECAPTURE_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha = _mm_set1_epi32(int(0xFF000000));
+  for (;i+4<=iPixels;i+=4) {
+    __m128i* p = reinterpret_cast<__m128i*>(pData + i*4);
+    const __m128i px = _mm_loadu_si128(p);
+    const __m128i lo = _mm_unpacklo_epi8(px, zero);
+    const __m128i hi = _mm_unpackhi_epi8(px, zero);
+    const __m128i r01 = _mm_packs_epi32(
+      Demultiply(_mm_unpacklo_epi16(lo, zero)),
+      Demultiply(_mm_unpackhi_epi16(lo, zero)));
+    const __m128i r23 = _mm_packs_epi32(
+      Demultiply(_mm_unpacklo_epi16(hi, zero)),
+      Demultiply(_mm_unpackhi_epi16(hi, zero)));
+    const __m128i result = _mm_packus_epi16(r01, r23);
+    // keep the original alpha
+    _mm_storeu_si128(p, _mm_or_si128(_mm_andnot_si128(alpha, result),
+                                     _mm_and_si128(alpha, px)));
+  }
+#endif
+  for (;i<iPixels;i++) {
+    uint8_t* p = pData + i*4;
+    const uint32_t r = reciprocal.table[p[3]];
+    for (size_t c = 0;c<3;c++) {
+      p[c] = uint8_t(std::min<uint32_t>(255, (p[c]*r + 32768) >> 16));
+    }
+  }
+}
@@ -39,6 +39,7 @@
 #define FRAMECAPTURE_H
 
 #include <string>
+#include <vector>
 #include "../StdTuvokDefines.h"
 #include "../Basics/Vectors.h"
 
@@ -60,42 +61,41 @@ class FrameCapture {
 
     virtual bool CaptureSingleFrame(const std::string& strFilename,
                                     bool bPreserveTransparency) const = 0;
-  private:
 
-#ifndef TUVOK_NO_QT
-  static int DemultiplyAlpha(unsigned char cmp,  unsigned char alpha)  {
-    return int(0.5f+float(cmp)/(float(alpha)/255.0f));
-  }
-#endif
+    /// reverses the order of iRows rows of iRowBytes bytes each, in place
+    static void FlipRows(void* pData, size_t iRowBytes, size_t iRows);
+    /// converts iPixels premultiplied RGBA pixels to straight alpha, in place
+    static void DemultiplyAlpha(uint8_t* pData, size_t iPixels);
 
+    /// compacts iPixels RGBA pixels to RGB, in place
     template <typename T>
-    static void RGBAToRGB(const std::vector<T>& in, std::vector<T>& out) {
+    static void RGBAToRGB(T* pData, size_t iPixels) {
       size_t j = 0;
-      for (size_t i = 0;i<in.size();i+=4) {
-        out[j++] = in[i+0];
-        out[j++] = in[i+1];
-        out[j++] = in[i+2];
+      for (size_t i = 0;i<iPixels*4;i+=4) {
+        pData[j++] = pData[i+0];
+        pData[j++] = pData[i+1];
+        pData[j++] = pData[i+2];
       }
     }
 
-  protected:
-
+    /** Writes RGBA data as read back from OpenGL (bottom row first).
+     * The image is flipped, converted and demultiplied in place, so vData
+     * holds garbage afterwards.  This function has no state and may run on
+     * any thread, see FrameCaptureQueue. */
     template <typename T>
-    bool SaveImage(const std::string& strFilename, 
-                   const UINTVECTOR2& vSize,
-                   const std::vector<T>& vInputData, 
-                   bool bPreserveTransparency) const {
-    
-      // OpenGL Data is upside down so first flip it  
-      std::vector<T> vData(vInputData.size());
-      size_t i = 0;
-      for (int y = 0;y<int(vSize.y);y++) {
-        int j = int(vSize.x)*4*(int(vSize.y-1) - y);
-        for (int x = 0;x<int(vSize.x)*4;x++) {
-          vData[i++] = vInputData[j++];
-        }
+    static bool SaveImage(const std::string& strFilename, 
+                          const UINTVECTOR2& vSize,
+                          std::vector<T>& vData, 
+                          bool bPreserveTransparency) {
+      if (vData.size() < size_t(vSize.area())*4) {
+        T_ERROR("Unable to save image %s: not enough data.",
+                strFilename.c_str());
+        return false;
       }
 
+      // OpenGL Data is upside down so first flip it  
+      FlipRows(&vData[0], size_t(vSize.x)*4*sizeof(T), vSize.y);
+
       // capture TIFF files and run our own exporter on them
       std::string extension = SysTools::ToLowerCase(SysTools::GetExt(strFilename));  
       if (extension == "tif" || extension == "tiff") {
@@ -105,9 +105,9 @@ class FrameCapture {
             // so there is no need to demultiply here
             TTIFFWriter::Write(strFilename.c_str(), vSize.x, vSize.y, TTIFFWriter::TT_RGBA, vData);
           } else {
-            std::vector<T> vDataRGB(vSize.area()*3);
-            RGBAToRGB(vData, vDataRGB);
-            TTIFFWriter::Write(strFilename.c_str(), vSize.x, vSize.y, TTIFFWriter::TT_RGB, vDataRGB);
+            RGBAToRGB(&vData[0], vSize.area());
+            vData.resize(size_t(vSize.area())*3);
+            TTIFFWriter::Write(strFilename.c_str(), vSize.x, vSize.y, TTIFFWriter::TT_RGB, vData);
           }
         } catch (const ttiff_error& e) {
           T_ERROR("Unable to save image %s: %s.",strFilename.c_str(), e.what());
@@ -125,30 +125,21 @@ class FrameCapture {
             return false;
           }
 
+          if (bPreserveTransparency) {
+            DemultiplyAlpha(reinterpret_cast<uint8_t*>(&vData[0]),
+                            vSize.area());
+          }
+
           QImage qTargetFile(QSize(vSize.x, vSize.y), QImage::Format_ARGB32);
 
           size_t i = 0;
-          if (bPreserveTransparency) {
-            for (size_t y = 0;y<vSize.y;y++) {
-              for (size_t x = 0;x<vSize.x;x++) {
-                qTargetFile.setPixel(int(x),int(y),
-                                      qRgba(DemultiplyAlpha(vData[i+0],vData[i+3]),
-                                            DemultiplyAlpha(vData[i+1],vData[i+3]),
-                                            DemultiplyAlpha(vData[i+2],vData[i+3]),
-                                            int(vData[i+3])));
-                i+=4;
-              }
-            }
-          } else {
-            for (size_t y = 0;y<vSize.y;y++) {
-              for (size_t x = 0;x<vSize.x;x++) {
-                qTargetFile.setPixel(int(x),int(y),
-                                    qRgba(int(vData[i+0]),
-                                          int(vData[i+1]),
-                                          int(vData[i+2]),
-                                          255));
-                i+=4;
-              }
+          for (int y = 0;y<int(vSize.y);y++) {
+            QRgb* pLine = reinterpret_cast<QRgb*>(qTargetFile.scanLine(y));
+            for (size_t x = 0;x<vSize.x;x++) {
+              pLine[x] = qRgba(int(vData[i+0]), int(vData[i+1]),
+                               int(vData[i+2]),
+                               bPreserveTransparency ? int(vData[i+3]) : 255);
+              i+=4;
             }
           }
 
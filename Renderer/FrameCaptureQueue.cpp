@@ -0,0 +1,176 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    FrameCaptureQueue.cpp
+*/
+
+#include "FrameCaptureQueue.h"
+#include <algorithm>
+#include <cstring>
+#include "FrameCapture.h"
+#include "Controller/Tracer.h"
+
+using namespace tuvok;
+
+class FrameCaptureQueue::Worker : public ThreadClass {
+  public:
+    explicit Worker(FrameCaptureQueue* pQueue) : m_pQueue(pQueue) {
+      StartThread();
+    }
+    ~Worker() {
+      RequestThreadStop();
+      JoinThread();
+    }
+
+  protected:
+    virtual void ThreadMain(void*) {
+      Tracer::Instance().SetThreadName("FrameCapture");
+      std::unique_ptr<Image> image;
+      while (m_pQueue->Next(image)) {
+        TUVOK_TRACE("capture", "EncodeFrame");
+        const uint64_t iStart = Tracer::Now();
+        if (image->pMapped) CopyMapped(*image);
+        const bool bSuccess = image->b16Bit
+          ? FrameCapture::SaveImage(image->strFilename, image->vSize,
+                                    image->vData16, image->bTransparency)
+          : FrameCapture::SaveImage(image->strFilename, image->vSize,
+                                    image->vData8, image->bTransparency);
+        m_pQueue->Done(std::move(image), bSuccess,
+                       double(Tracer::Now() - iStart) / 1e6);
+      }
+    }
+
+  private:
+    /// copies the pixels out of the renderer's buffer so it can be reused
+    static void CopyMapped(Image& image) {
+      const size_t iValues = size_t(image.vSize.area()) * 4;
+      if (image.b16Bit) {
+        memcpy(&image.vData16[0], image.pMapped, iValues*sizeof(uint16_t));
+      } else {
+        memcpy(&image.vData8[0], image.pMapped, iValues*sizeof(uint8_t));
+      }
+      image.pMapped = NULL;
+      image.pMappedInUse->store(false, std::memory_order_release);
+      image.pMappedInUse = NULL;
+    }
+
+    FrameCaptureQueue* m_pQueue;
+};
+
+FrameCaptureQueue::FrameCaptureQueue(size_t iWorkers, size_t iMaxQueued) :
+  m_iMaxQueued(std::max<size_t>(iMaxQueued, 1)),
+  m_iBusy(0),
+  m_iFailed(0),
+  m_bStop(false)
+{
+  iWorkers = std::max<size_t>(iWorkers, 1);
+  for (size_t i = 0;i<iWorkers;i++) {
+    m_vWorkers.push_back(std::unique_ptr<Worker>(new Worker(this)));
+  }
+}
+
+FrameCaptureQueue::~FrameCaptureQueue() {
+  Wait();
+  {
+    SCOPEDLOCK(m_Guard);
+    m_bStop = true;
+    m_WorkAvailable.WakeAll();
+  }
+  m_vWorkers.clear();
+}
+
+std::unique_ptr<FrameCaptureQueue::Image> FrameCaptureQueue::Acquire() {
+  SCOPEDLOCK(m_Guard);
+  if (m_vFree.empty()) return std::unique_ptr<Image>(new Image());
+  std::unique_ptr<Image> image(std::move(m_vFree.back()));
+  m_vFree.pop_back();
+  return image;
+}
+
+void FrameCaptureQueue::Enqueue(std::unique_ptr<Image> image) {
+  SCOPEDLOCK(m_Guard);
+  while (m_Queue.size() >= m_iMaxQueued) {
+    TUVOK_TRACE("capture", "WaitForEncoder");
+    m_SpaceAvailable.Wait(m_Guard);
+  }
+  m_Queue.push_back(std::move(image));
+  m_WorkAvailable.WakeOne();
+}
+
+bool FrameCaptureQueue::Wait() {
+  SCOPEDLOCK(m_Guard);
+  while (!m_Queue.empty() || m_iBusy) m_Idle.Wait(m_Guard);
+  const bool bSuccess = m_iFailed == 0;
+  m_iFailed = 0;
+  return bSuccess;
+}
+
+size_t FrameCaptureQueue::GetPending() const {
+  SCOPEDLOCK(m_Guard);
+  return m_Queue.size() + m_iBusy;
+}
+
+bool FrameCaptureQueue::Next(std::unique_ptr<Image>& image) {
+  SCOPEDLOCK(m_Guard);
+  while (m_Queue.empty() && !m_bStop) m_WorkAvailable.Wait(m_Guard);
+  if (m_Queue.empty()) return false;
+
+  image = std::move(m_Queue.front());
+  m_Queue.pop_front();
+  ++m_iBusy;
+  m_SpaceAvailable.WakeOne();
+  return true;
+}
+
+void FrameCaptureQueue::TakeReports(std::vector<CaptureReport>& reports) {
+  SCOPEDLOCK(m_Guard);
+  reports.insert(reports.end(), m_Reports.begin(), m_Reports.end());
+  m_Reports.clear();
+}
+
+void FrameCaptureQueue::Done(std::unique_ptr<Image> image, bool bSuccess,
+                             double fEncodeMs) {
+  SCOPEDLOCK(m_Guard);
+  --m_iBusy;
+  if (!bSuccess) ++m_iFailed;
+
+  CaptureReport report;
+  report.strFilename = image->strFilename;
+  report.fEncodeMs = fEncodeMs;
+  report.bSuccess = bSuccess;
+  m_Reports.push_back(report);
+  if (m_Reports.size() > MAX_REPORTS) m_Reports.pop_front();
+
+  // enough buffers to keep the queue and all workers busy
+  if (m_vFree.size() < m_iMaxQueued + m_vWorkers.size()) {
+    image->strFilename.clear();
+    m_vFree.push_back(std::move(image));
+  }
+  if (m_Queue.empty() && m_iBusy == 0) m_Idle.WakeAll();
+}
@@ -0,0 +1,136 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    FrameCaptureQueue.h
+  \brief   Worker threads that encode captured frames.
+*/
+#pragma once
+
+#ifndef TUVOK_FRAMECAPTUREQUEUE_H
+#define TUVOK_FRAMECAPTUREQUEUE_H
+
+#include "../StdTuvokDefines.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Basics/Vectors.h"
+#include "Basics/Threads.h"
+
+namespace tuvok {
+
+/// Outcome of an image written by a FrameCaptureQueue.
+struct CaptureReport {
+  std::string strFilename;
+  double      fEncodeMs;  ///< flip, conversion and encoding
+  bool        bSuccess;
+};
+
+/** \class FrameCaptureQueue
+ * Bounded queue of images waiting to be written by a pool of threads.
+ *
+ * The renderer acquires an image, fills it with pixels read back from the
+ * GPU and enqueues it; a worker flips, converts and encodes it with
+ * FrameCapture::SaveImage while the next frame renders.  Enqueue() blocks
+ * while the queue is full, so a slow disk throttles the renderer instead of
+ * eating all memory.  Written images go back to a free list and their
+ * buffers are reused. */
+class FrameCaptureQueue {
+  public:
+    struct Image {
+      Image() : bTransparency(false), b16Bit(false), pMapped(NULL),
+                pMappedInUse(NULL) {}
+
+      std::string           strFilename;
+      UINTVECTOR2           vSize;
+      bool                  bTransparency;
+      bool                  b16Bit;  ///< data are in vData16, else in vData8
+      /// RGBA, bottom row first, as read by glReadPixels
+      std::vector<uint8_t>  vData8;
+      std::vector<uint16_t> vData16;
+      /// If set, the data are still in this buffer, e.g. a mapped pixel
+      /// buffer object.  A worker copies them into vData8/vData16, which
+      /// must be sized already, and then clears *pMappedInUse; the buffer
+      /// has to stay valid until then.
+      const void*           pMapped;
+      std::atomic<bool>*    pMappedInUse;
+    };
+
+    /// Starts iWorkers threads; Enqueue() blocks while iMaxQueued images
+    /// are waiting.
+    FrameCaptureQueue(size_t iWorkers = 2, size_t iMaxQueued = 4);
+    /// Writes all queued images, then stops the workers.
+    ~FrameCaptureQueue();
+
+    /// An image from the free list or a new one.
+    std::unique_ptr<Image> Acquire();
+    /// Hands the image to the workers.
+    void Enqueue(std::unique_ptr<Image> image);
+    /// Waits until every enqueued image has been written.
+    /// \return false if an image failed since the last call
+    bool Wait();
+    /// number of images queued or being written
+    size_t GetPending() const;
+    /// Appends the reports of the images written since the last call; only
+    /// the latest MAX_REPORTS are kept.
+    void TakeReports(std::vector<CaptureReport>& reports);
+
+    enum { MAX_REPORTS = 1024 };
+
+  private:
+    FrameCaptureQueue(const FrameCaptureQueue&);            ///< unimplemented
+    FrameCaptureQueue& operator=(const FrameCaptureQueue&); ///< unimplemented
+
+    class Worker;
+    friend class Worker;
+
+    /// Blocks until an image is available.
+    /// \return false if the queue is stopping and empty
+    bool Next(std::unique_ptr<Image>& image);
+    void Done(std::unique_ptr<Image> image, bool bSuccess, double fEncodeMs);
+
+    const size_t                        m_iMaxQueued;
+    std::vector<std::unique_ptr<Worker>> m_vWorkers;
+
+    /// guards everything below
+    mutable CriticalSection             m_Guard;
+    WaitCondition                       m_WorkAvailable;
+    WaitCondition                       m_SpaceAvailable;
+    WaitCondition                       m_Idle;
+    std::deque<std::unique_ptr<Image>>  m_Queue;
+    std::vector<std::unique_ptr<Image>> m_vFree;
+    std::deque<CaptureReport>           m_Reports;
+    size_t                              m_iBusy;
+    size_t                              m_iFailed;
+    bool                                m_bStop;
+};
+
+}
+#endif // TUVOK_FRAMECAPTUREQUEUE_H
@@ -41,7 +41,7 @@
 
 #ifdef DETECTED_OS_WINDOWS
 # include <GL/wglew.h>
-#else
+#elif !defined(TUVOK_NO_GLX)
 # include <GL/glxew.h>
 #endif
 #include "../Context.h"
@@ -53,6 +53,8 @@ class GLContext : public Context {
 public:
 #ifdef DETECTED_OS_WINDOWS
   #define GetContext wglGetCurrentContext
+#elif defined(TUVOK_HAVE_EGL) || defined(TUVOK_HAVE_OSMESA)
+  #define GetContext GLStateManager::CurrentNativeContext
 #else
   #define GetContext glXGetCurrentContext
 #endif
@@ -37,6 +37,8 @@
 */
 #include "GLFBOTex.h"
 #include "GLCommon.h"
+#include "GLStateManager.h"
+#include "GLTextureReadback.h"
 #include <Controller/Controller.h>
 
 #ifdef WIN32
@@ -113,6 +115,7 @@ GLFBOTex::GLFBOTex(MasterController* pMasterController, GLenum minfilter,
   {
       T_ERROR("GL Error during texture creation!");
       GL(glDeleteTextures(m_iNumBuffers,m_hTexture));
+      GLStateManager::Current().TexturesDeleted(m_iNumBuffers, m_hTexture);
       delete[] m_hTexture;
       m_hTexture=NULL;
       return;
@@ -124,7 +127,7 @@ GLFBOTex::GLFBOTex(MasterController* pMasterController, GLenum minfilter,
                                 width,height));
 #else
     GL(glGenTextures(1,&m_hDepthBuffer));
-    GL(glBindTexture(GL_TEXTURE_2D,m_hDepthBuffer));
+    GLStateManager::Current().BindTexture(GL_TEXTURE_2D,m_hDepthBuffer);
     GL(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE));
     GL(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE));
     GL(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST));
@@ -146,6 +149,7 @@ GLFBOTex::GLFBOTex(MasterController* pMasterController, GLenum minfilter,
 GLFBOTex::~GLFBOTex(void) {
   if (m_hTexture) {
     GL(glDeleteTextures(m_iNumBuffers,m_hTexture));
+    GLStateManager::Current().TexturesDeleted(m_iNumBuffers, m_hTexture);
     delete[] m_hTexture;
     m_hTexture=NULL;
   }
@@ -158,7 +162,10 @@ GLFBOTex::~GLFBOTex(void) {
 #ifdef GLFBOTEX_DEPTH_RENDERBUFFER
   if (m_hDepthBuffer) GL(glDeleteRenderbuffersEXT(1,&m_hDepthBuffer));
 #else
-  if (m_hDepthBuffer) GL(glDeleteTextures(1,&m_hDepthBuffer));
+  if (m_hDepthBuffer) {
+    GL(glDeleteTextures(1,&m_hDepthBuffer));
+    GLStateManager::Current().TexturesDeleted(1, &m_hDepthBuffer);
+  }
 #endif
   m_hDepthBuffer=0;
   --m_iCount;
@@ -188,7 +195,7 @@ bool GLFBOTex::initTextures(GLenum minfilter, GLenum magfilter,
   //glDeleteTextures(m_iNumBufers,m_hTexture);
   GL(glGenTextures(m_iNumBuffers,m_hTexture));
   for (int i=0; i<m_iNumBuffers; i++) {
-    GL_RET(glBindTexture(GL_TEXTURE_2D, m_hTexture[i]));
+    GLStateManager::Current().BindTexture(GL_TEXTURE_2D, m_hTexture[i]);
     GL_RET(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minfilter));
     GL_RET(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magfilter));
     GL_RET(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapmode));
@@ -308,8 +315,9 @@ void GLFBOTex::Read(unsigned int iTargetUnit, int iBuffer) {
   assert(iBuffer>=0);
   assert(iBuffer<m_iNumBuffers);
   m_LastTexUnit[iBuffer]=texunit;
-  GL(glActiveTextureARB(texunit));
-  GL(glBindTexture(GL_TEXTURE_2D,m_hTexture[iBuffer]));
+  GLStateManager& state = GLStateManager::Current();
+  state.SetActiveTexUnit(iTargetUnit);
+  state.BindTexture(GL_TEXTURE_2D,m_hTexture[iBuffer]);
 }
 
 void GLFBOTex::ReadDepth(unsigned int iTargetUnit) {
@@ -320,14 +328,16 @@ void GLFBOTex::ReadDepth(unsigned int iTargetUnit) {
   }
 #endif
   m_LastDepthTextUnit=texunit;
-  GL(glActiveTextureARB(texunit));
-  GL(glBindTexture(GL_TEXTURE_2D,m_hDepthBuffer));
+  GLStateManager& state = GLStateManager::Current();
+  state.SetActiveTexUnit(iTargetUnit);
+  state.BindTexture(GL_TEXTURE_2D,m_hDepthBuffer);
 }
 
 // Finish reading from the depth texture
 void GLFBOTex::FinishDepthRead() {
-  GL(glActiveTextureARB(m_LastDepthTextUnit));
-  GL(glBindTexture(GL_TEXTURE_2D,0));
+  GLStateManager& state = GLStateManager::Current();
+  state.SetActiveTexUnit(m_LastDepthTextUnit - GL_TEXTURE0);
+  state.BindTexture(GL_TEXTURE_2D,0);
   m_LastDepthTextUnit=0;
 }
 
@@ -392,8 +402,9 @@ void GLFBOTex::FourDrawBuffers() {
 void GLFBOTex::FinishRead(int iBuffer) {
   assert(iBuffer>=0);
   assert(iBuffer<m_iNumBuffers);
-  GL(glActiveTextureARB(m_LastTexUnit[iBuffer]));
-  GL(glBindTexture(GL_TEXTURE_2D,0));
+  GLStateManager& state = GLStateManager::Current();
+  state.SetActiveTexUnit(m_LastTexUnit[iBuffer] - GL_TEXTURE0);
+  state.BindTexture(GL_TEXTURE_2D,0);
   m_LastTexUnit[iBuffer]=0;
 }
 
@@ -411,6 +422,31 @@ void GLFBOTex::ReadBackPixels(int x, int y, int sX, int sY, void* pData) {
   FinishWrite(0);
 }
 
+std::shared_ptr<GLTextureReadback>
+GLFBOTex::ReadBackPixelsAsync(int x, int y, int sX, int sY,
+                              std::shared_ptr<GLTextureReadback> reuse) {
+  const UINTVECTOR3 vSize(sX, sY, 1);
+  std::shared_ptr<GLTextureReadback> readback(reuse);
+  if (!readback || !readback->Restart(vSize, UINTVECTOR3(0,0,0), vSize,
+                                      4*sizeof(float))) {
+    readback.reset(
+      new GLTextureReadback(vSize, UINTVECTOR3(0,0,0), vSize, 4*sizeof(float),
+                            std::shared_ptr<void>())
+    );
+  }
+
+  Write(0,0,false);
+  if (GLEW_ARB_color_buffer_float) {
+    GL(glClampColorARB(GL_CLAMP_READ_COLOR, GL_FALSE));
+  } else if (GLEW_VERSION_3_0) {
+    GL(glClampColor(GL_CLAMP_READ_COLOR, GL_FALSE));
+  }
+  GL(glReadBuffer(GL_COLOR_ATTACHMENT0));
+  readback->StartReadPixels(x, y, GL_RGBA, GL_FLOAT);
+  FinishWrite(0);
+  return readback;
+}
+
 uint64_t GLFBOTex::GetCPUSize() const {
     return EstimateCPUSize(m_iSizeX, m_iSizeY, GLCommon::gl_byte_width(m_type) * GLCommon::gl_components(m_format),
                            m_hDepthBuffer!=0, m_iNumBuffers);
@@ -435,31 +471,33 @@ uint64_t GLFBOTex::EstimateGPUSize(GLsizei width, GLsizei height,
 }
 
 void GLFBOTex::SetData(const UINTVECTOR2& offset, const UINTVECTOR2& size, const void *pixels, int iBuffer, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT ,1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
+  GLStateManager& state = GLStateManager::Current();
+  state.SetPixelStore(GL_PACK_ALIGNMENT ,1);
+  state.SetPixelStore(GL_UNPACK_ALIGNMENT ,1);
 
-  GLint prevTex=0;
-  if (bRestoreBinding) GL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex));
+  GLuint prevTex=0;
+  if (bRestoreBinding) prevTex = state.GetBoundTexture(GL_TEXTURE_2D);
 
-  GL(glBindTexture(GL_TEXTURE_2D, m_hTexture[iBuffer]));
+  state.BindTexture(GL_TEXTURE_2D, m_hTexture[iBuffer]);
   GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 
     offset.x, offset.y,
     size.x, size.y,
     m_format, m_type, (GLvoid*)pixels));
 
-  if (bRestoreBinding && GLuint(prevTex) != m_hTexture[iBuffer]) GL(glBindTexture(GL_TEXTURE_2D, prevTex));
+  if (bRestoreBinding && prevTex != m_hTexture[iBuffer]) state.BindTexture(GL_TEXTURE_2D, prevTex);
 }
 
 void GLFBOTex::SetData(const void *pixels, int iBuffer, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT ,1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
+  GLStateManager& state = GLStateManager::Current();
+  state.SetPixelStore(GL_PACK_ALIGNMENT ,1);
+  state.SetPixelStore(GL_UNPACK_ALIGNMENT ,1);
 
-  GLint prevTex=0;
-  if (bRestoreBinding) GL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex));
+  GLuint prevTex=0;
+  if (bRestoreBinding) prevTex = state.GetBoundTexture(GL_TEXTURE_2D);
 
-  GL(glBindTexture(GL_TEXTURE_2D, m_hTexture[iBuffer]));
+  state.BindTexture(GL_TEXTURE_2D, m_hTexture[iBuffer]);
   GL(glTexImage2D(GL_TEXTURE_2D, 0, m_intformat, m_iSizeX, m_iSizeY,
     0, m_format, m_type, (GLvoid*)pixels));
 
-  if (bRestoreBinding && GLuint(prevTex) != m_hTexture[iBuffer]) GL(glBindTexture(GL_TEXTURE_2D, prevTex));
+  if (bRestoreBinding && prevTex != m_hTexture[iBuffer]) state.BindTexture(GL_TEXTURE_2D, prevTex);
 }
@@ -39,6 +39,7 @@
 #define TUVOK_GLFBOTEX_H_
 
 #include "../../StdTuvokDefines.h"
+#include <memory>
 #include "GLObject.h"
 #include "GLTexture.h"
 
@@ -91,6 +92,13 @@ public:
   static void FourDrawBuffers();
 
   void ReadBackPixels(int x, int y, int sX, int sY, void* pData);
+  /// like ReadBackPixels, but returns without waiting for the GPU; the
+  /// result holds sX*sY RGBA float pixels.  A previous result of the same
+  /// size passed as reuse is restarted and returned, keeping its buffers.
+  std::shared_ptr<GLTextureReadback> ReadBackPixelsAsync(int x, int y,
+    int sX, int sY,
+    std::shared_ptr<GLTextureReadback> reuse =
+      std::shared_ptr<GLTextureReadback>());
   GLuint Width() const {return m_iSizeX;}
   GLuint Height() const {return m_iSizeY;}
 
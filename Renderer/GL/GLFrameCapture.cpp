@@ -35,18 +35,39 @@
 */
 #include "GLFrameCapture.h"
 
+#include <thread>
 #include "Basics/Vectors.h"
 #include "Controller/Controller.h"
+#include "Controller/Tracer.h"
 #include "GLInclude.h"
 #include "GLFBOTex.h"
+#include "GLStateManager.h"
 #include "GLTargetBinder.h"
 
 using namespace tuvok;
 
+namespace {
+  /// Sets up a tightly packed read of the bound framebuffer's first color
+  /// attachment and returns the size of the viewport to read.
+  UINTVECTOR2 BeginReadback() {
+    GLStateManager::Current().SetPixelStore(GL_PACK_ALIGNMENT, 1);
+    GL(glReadBuffer(GL_COLOR_ATTACHMENT0));
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    return UINTVECTOR2(viewport[2], viewport[3]);
+  }
+}
+
+GLFrameCapture::GLFrameCapture() :
+  FrameCapture(),
+  m_iNextReadback(0),
+  m_bFailed(false)
+{
+}
+
 
 bool GLFrameCapture::CaptureSingleFrame(const std::string& strFilename, bool bPreserveTransparency) const {
-  GLint viewport[4];
-  glGetIntegerv(GL_VIEWPORT, viewport);
+  const UINTVECTOR2 vSize = BeginReadback();
 
   // for TIFF capture in 16 bit 
   std::string extension = SysTools::ToLowerCase(SysTools::GetExt(strFilename));  
@@ -55,35 +76,29 @@ bool GLFrameCapture::CaptureSingleFrame(const std::string& strFilename, bool bPr
     // trying to capture 4k images on a 32 bit build
     std::vector<uint16_t> image;
     try {
-      image.resize(viewport[2]*viewport[3]*4);
+      image.resize(size_t(vSize.area())*4);
     } catch (...) {
       image.clear();
     }
     if ( image.empty() ) return false;
  
-    GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-    GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-    GL(glReadBuffer(GL_COLOR_ATTACHMENT0));
-    GL(glReadPixels(0,0,viewport[2],viewport[3],GL_RGBA,GL_UNSIGNED_SHORT,&image[0]));
+    GL(glReadPixels(0,0,vSize.x,vSize.y,GL_RGBA,GL_UNSIGNED_SHORT,&image[0]));
 
-    return SaveImage(strFilename, UINTVECTOR2(viewport[2], viewport[3]), image, bPreserveTransparency);
+    return SaveImage(strFilename, vSize, image, bPreserveTransparency);
   } else {
     // testing new here to avoid a crash when 
     // trying to capture 4k images on a 32 bit build
     std::vector<uint8_t> image;
     try {
-      image.resize(viewport[2]*viewport[3]*4);
+      image.resize(size_t(vSize.area())*4);
     } catch (...) {
       image.clear();
     }
     if ( image.empty() ) return false;
  
-    GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-    GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-    GL(glReadBuffer(GL_COLOR_ATTACHMENT0));
-    GL(glReadPixels(0,0,viewport[2],viewport[3],GL_RGBA,GL_UNSIGNED_BYTE,&image[0]));
+    GL(glReadPixels(0,0,vSize.x,vSize.y,GL_RGBA,GL_UNSIGNED_BYTE,&image[0]));
 
-    return SaveImage(strFilename, UINTVECTOR2(viewport[2], viewport[3]), image, bPreserveTransparency);
+    return SaveImage(strFilename, vSize, image, bPreserveTransparency);
 
   }
 }
@@ -99,3 +114,186 @@ bool GLFrameCapture::CaptureSingleFrame(const std::string& filename,
   return rv;
 }
 
+bool GLFrameCapture::ReadFrame(GLFBOTex* from, std::vector<uint16_t>& vRGBA,
+                               UINTVECTOR2& vSize) const {
+  GLTargetBinder bind(&Controller::Instance());
+  bind.Bind(from);
+
+  vSize = BeginReadback();
+  try {
+    vRGBA.resize(size_t(vSize.area())*4);
+  } catch (...) {
+    vRGBA.clear();
+  }
+  if (vRGBA.empty()) return false;
+
+  GL(glReadPixels(0,0,vSize.x,vSize.y,GL_RGBA,GL_UNSIGNED_SHORT,&vRGBA[0]));
+  bind.Unbind();
+  return true;
+}
+
+FrameCaptureQueue& GLFrameCapture::Queue() {
+  if (!m_pQueue) m_pQueue.reset(new FrameCaptureQueue());
+  return *m_pQueue;
+}
+
+bool GLFrameCapture::CaptureSingleFrameAsync(const std::string& strFilename,
+                                             bool bPreserveTransparency) {
+  TUVOK_TRACE("capture", "CaptureSingleFrameAsync");
+  const UINTVECTOR2 vSize = BeginReadback();
+
+  std::unique_ptr<FrameCaptureQueue::Image> image = Queue().Acquire();
+  image->strFilename = strFilename;
+  image->vSize = vSize;
+  image->bTransparency = bPreserveTransparency;
+  // for TIFF capture in 16 bit 
+  const std::string extension =
+    SysTools::ToLowerCase(SysTools::GetExt(strFilename));
+  image->b16Bit = extension == "tif" || extension == "tiff";
+  const size_t iBytes = size_t(image->vSize.area()) * 4 *
+                        (image->b16Bit ? sizeof(uint16_t) : sizeof(uint8_t));
+  const GLenum type = image->b16Bit ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+
+  // testing new here to avoid a crash when 
+  // trying to capture 4k images on a 32 bit build
+  try {
+    if (image->b16Bit) image->vData16.resize(image->vSize.area()*4);
+    else               image->vData8.resize(image->vSize.area()*4);
+  } catch (...) {
+    T_ERROR("Not enough memory to capture %s.", strFilename.c_str());
+    Failed(strFilename);
+    return false;
+  }
+
+  if (!GLEW_VERSION_2_1 && !GLEW_ARB_pixel_buffer_object) {
+    // no way to read asynchronously, but encoding still overlaps
+    void* pData = image->b16Bit ? static_cast<void*>(&image->vData16[0])
+                                : static_cast<void*>(&image->vData8[0]);
+    GL(glReadPixels(0,0,vSize.x,vSize.y,GL_RGBA,type,pData));
+    Queue().Enqueue(std::move(image));
+    return true;
+  }
+
+  Readback& r = m_Readbacks[m_iNextReadback];
+  m_iNextReadback = (m_iNextReadback+1) % NUM_READBACKS;
+  // the capture before last; long done by now
+  if (r.image) Complete(r);
+  Unmap(r);
+
+  if (!r.iPBO) GL(glGenBuffers(1, &r.iPBO));
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, r.iPBO));
+  GL(glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(iBytes), NULL,
+                  GL_STREAM_READ));
+  GL(glReadPixels(0,0,vSize.x,vSize.y,GL_RGBA,type,NULL));
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  if (GLEW_VERSION_3_2 || GLEW_ARB_sync) {
+    r.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+  r.image = std::move(image);
+
+  // the previous capture has had a whole frame to arrive; enqueue it now
+  // unless it would stall
+  Readback& previous = m_Readbacks[m_iNextReadback];
+  if (previous.image && previous.sync) {
+    const GLenum result = glClientWaitSync(previous.sync, 0, 0);
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+      Complete(previous);
+    }
+  }
+  return true;
+}
+
+bool GLFrameCapture::CaptureSingleFrameAsync(const std::string& filename,
+                                             GLFBOTex* from,
+                                             bool transparency)
+{
+  GLTargetBinder bind(&Controller::Instance());
+  bind.Bind(from);
+  bool rv = this->CaptureSingleFrameAsync(filename, transparency);
+  bind.Unbind();
+  return rv;
+}
+
+void GLFrameCapture::Complete(Readback& r) {
+  TUVOK_TRACE("capture", "MapReadback");
+  if (r.sync) {
+    glDeleteSync(r.sync);
+    r.sync = 0;
+  }
+
+  // mapping waits for the read to finish; the worker copies the pixels out
+  // and the buffer is unmapped once the slot is needed again
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, r.iPBO));
+  const void* pMapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  if (pMapped) {
+    r.bMapped = true;
+    r.bInUse = true;
+    r.image->pMapped = pMapped;
+    r.image->pMappedInUse = &r.bInUse;
+    Queue().Enqueue(std::move(r.image));
+  } else {
+    T_ERROR("Could not map read back buffer for %s.",
+            r.image->strFilename.c_str());
+    Failed(r.image->strFilename);
+    r.image.reset();
+  }
+}
+
+void GLFrameCapture::Unmap(Readback& r) {
+  if (!r.bMapped) return;
+  // the copy is the first thing a worker does with an image
+  if (r.bInUse.load(std::memory_order_acquire)) {
+    TUVOK_TRACE("capture", "WaitForMappedCopy");
+    while (r.bInUse.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, r.iPBO));
+  GL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  r.bMapped = false;
+}
+
+void GLFrameCapture::Failed(const std::string& strFilename) {
+  m_bFailed = true;
+  CaptureReport report;
+  report.strFilename = strFilename;
+  report.fEncodeMs = 0.0;
+  report.bSuccess = false;
+  m_vFailed.push_back(report);
+  if (m_vFailed.size() > FrameCaptureQueue::MAX_REPORTS) {
+    m_vFailed.erase(m_vFailed.begin());
+  }
+}
+
+void GLFrameCapture::TakeReports(std::vector<CaptureReport>& reports) {
+  reports.insert(reports.end(), m_vFailed.begin(), m_vFailed.end());
+  m_vFailed.clear();
+  if (m_pQueue) m_pQueue->TakeReports(reports);
+}
+
+bool GLFrameCapture::FinishCaptures() {
+  // oldest first, so the images are enqueued in the order of the calls
+  for (size_t i = 0;i<NUM_READBACKS;i++) {
+    Readback& r = m_Readbacks[(m_iNextReadback+i) % NUM_READBACKS];
+    if (r.image) Complete(r);
+  }
+  bool bSuccess = !m_bFailed;
+  m_bFailed = false;
+  if (m_pQueue) bSuccess = m_pQueue->Wait() && bSuccess;
+  for (size_t i = 0;i<NUM_READBACKS;i++) Unmap(m_Readbacks[i]);
+  return bSuccess;
+}
+
+void GLFrameCapture::Release() {
+  FinishCaptures();
+  for (size_t i = 0;i<NUM_READBACKS;i++) {
+    Readback& r = m_Readbacks[i];
+    if (r.iPBO) {
+      GL(glDeleteBuffers(1, &r.iPBO));
+      r.iPBO = 0;
+    }
+  }
+}
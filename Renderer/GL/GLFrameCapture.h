@@ -40,8 +40,12 @@
 #define GLFRAMECAPTURE_H
 
 #include "../../StdTuvokDefines.h"
+#include <atomic>
+#include <memory>
 #include <vector>
+#include "GLInclude.h"
 #include "../FrameCapture.h"
+#include "../FrameCaptureQueue.h"
 
 namespace tuvok {
 
@@ -49,7 +53,7 @@ class GLFBOTex;
 
 class GLFrameCapture : public FrameCapture {
   public:
-    GLFrameCapture() : FrameCapture() {}
+    GLFrameCapture();
     virtual ~GLFrameCapture() {}
 
     virtual bool CaptureSingleFrame(const std::string& strFilename,
@@ -58,7 +62,62 @@ class GLFrameCapture : public FrameCapture {
     virtual bool CaptureSingleFrame(const std::string& filename,
                                     GLFBOTex* from,
                                     bool transparency=false) const;
-};
 
+    /// Reads the viewport of 'from' as 16 bit RGBA, bottom row first.
+    bool ReadFrame(GLFBOTex* from, std::vector<uint16_t>& vRGBA,
+                   UINTVECTOR2& vSize) const;
+
+    /** Captures the bound framebuffer without waiting for the GPU or the
+     * encoder.  The pixels are read into a pixel buffer object and the
+     * previous capture, which the GPU has finished in the meantime, is
+     * handed to the FrameCaptureQueue.  So rendering of the next frame
+     * overlaps with encoding this one.  Errors are reported later by
+     * FinishCaptures(). */
+    bool CaptureSingleFrameAsync(const std::string& strFilename,
+                                 bool bPreserveTransparency);
+    bool CaptureSingleFrameAsync(const std::string& filename,
+                                 GLFBOTex* from,
+                                 bool transparency=false);
+    /// Waits until all asynchronous captures are written.
+    /// \return false if any of them failed
+    bool FinishCaptures();
+    /// see FrameCaptureQueue::TakeReports
+    void TakeReports(std::vector<CaptureReport>& reports);
+
+    /// Finishes all captures and deletes the GL objects; needs the context
+    /// current that made the captures.
+    void Release();
+
+  private:
+    GLFrameCapture(const GLFrameCapture&);            ///< unimplemented
+    GLFrameCapture& operator=(const GLFrameCapture&); ///< unimplemented
+
+    struct Readback {
+      Readback() : iPBO(0), sync(0), bMapped(false), bInUse(false) {}
+      GLuint iPBO;
+      GLsync sync;
+      /// set while a read into iPBO is in flight
+      std::unique_ptr<FrameCaptureQueue::Image> image;
+      /// iPBO is mapped and handed to a worker with image
+      bool bMapped;
+      /// cleared by the worker once it copied the mapped pixels
+      std::atomic<bool> bInUse;
+    };
+    enum { NUM_READBACKS = 2 };
+
+    /// maps the PBO of r and hands it to the workers with its image
+    void Complete(Readback& r);
+    /// waits until the worker is done with r's mapped PBO and unmaps it
+    void Unmap(Readback& r);
+    /// reports a capture that failed before it reached the queue
+    void Failed(const std::string& strFilename);
+    FrameCaptureQueue& Queue();
+
+    Readback                           m_Readbacks[NUM_READBACKS];
+    size_t                             m_iNextReadback;
+    bool                               m_bFailed;
+    std::vector<CaptureReport>         m_vFailed;
+    std::unique_ptr<FrameCaptureQueue> m_pQueue;  ///< created on first use
+};
 }
 #endif // GLFRAMECAPTURE_H
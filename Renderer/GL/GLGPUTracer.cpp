@@ -0,0 +1,131 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLGPUTracer.cpp
+*/
+
+#include "GLGPUTracer.h"
+#include "Controller/Tracer.h"
+
+using namespace tuvok;
+
+GLGPUTracer::GLGPUTracer() :
+  m_iClockOffset(0),
+  m_iCalibrationAge(0),
+  m_bCalibrated(false)
+{
+}
+
+GLGPUTracer::~GLGPUTracer() {
+  // queries must be released with the context current, see Release()
+}
+
+bool GLGPUTracer::IsSupported() {
+  return GLTimerQueryPool::IsSupported();
+}
+
+void GLGPUTracer::Calibrate() {
+  GLint64 iGPUNow = 0;
+  GL(glGetInteger64v(GL_TIMESTAMP, &iGPUNow));
+  m_iClockOffset = static_cast<int64_t>(Tracer::Now()) - iGPUNow;
+  m_iCalibrationAge = 0;
+  m_bCalibrated = true;
+}
+
+void GLGPUTracer::Begin(const char* category, const char* name) {
+  const bool bRecord = Tracer::Enabled() && IsSupported();
+  m_vOpen.push_back(bRecord);
+  if (!bRecord) return;
+
+  Span span;
+  span.category = category;
+  span.name = name;
+  span.begin = m_Queries.New();
+  span.end = 0;
+  GL(glQueryCounter(span.begin, GL_TIMESTAMP));
+  m_Spans.push_back(span);
+}
+
+void GLGPUTracer::End() {
+  if (m_vOpen.empty()) return;
+  const bool bRecorded = m_vOpen.back();
+  m_vOpen.pop_back();
+  if (!bRecorded) return;
+
+  for (std::deque<Span>::reverse_iterator s = m_Spans.rbegin();
+       s != m_Spans.rend(); ++s) {
+    if (s->end == 0) {
+      s->end = m_Queries.New();
+      GL(glQueryCounter(s->end, GL_TIMESTAMP));
+      return;
+    }
+  }
+}
+
+void GLGPUTracer::Collect() {
+  if (m_Spans.empty()) return;
+  // the clocks drift apart slowly; re-measure now and then
+  if (!m_bCalibrated || ++m_iCalibrationAge > 600) Calibrate();
+
+  // spans finish in the order they were opened, except that an outer span
+  // ends after its children; stop at the first one that is not done.
+  while (!m_Spans.empty()) {
+    Span& s = m_Spans.front();
+    if (s.end == 0) break;
+    GLint iAvailable = 0;
+    GL(glGetQueryObjectiv(s.end, GL_QUERY_RESULT_AVAILABLE, &iAvailable));
+    if (!iAvailable) break;
+
+    GLuint64 iBegin = 0, iEnd = 0;
+    GL(glGetQueryObjectui64v(s.begin, GL_QUERY_RESULT, &iBegin));
+    GL(glGetQueryObjectui64v(s.end, GL_QUERY_RESULT, &iEnd));
+    const int64_t iStart = static_cast<int64_t>(iBegin) + m_iClockOffset;
+    if (iStart > 0 && iEnd >= iBegin) {
+      Tracer::Instance().Complete(s.category, s.name,
+                                  static_cast<uint64_t>(iStart),
+                                  iEnd - iBegin, NULL, 0,
+                                  Tracer::GPU_THREAD_ID);
+    }
+    m_Queries.Recycle(s.begin);
+    m_Queries.Recycle(s.end);
+    m_Spans.pop_front();
+  }
+}
+
+void GLGPUTracer::Release() {
+  for (std::deque<Span>::const_iterator s = m_Spans.begin();
+       s != m_Spans.end(); ++s) {
+    m_Queries.Recycle(s->begin);
+    if (s->end) m_Queries.Recycle(s->end);
+  }
+  m_Spans.clear();
+  m_vOpen.clear();
+  m_Queries.Release();
+  m_bCalibrated = false;
+}
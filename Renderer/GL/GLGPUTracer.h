@@ -0,0 +1,110 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLGPUTracer.h
+  \brief   GPU timer-query spans for the Tracer timeline.
+*/
+#pragma once
+
+#ifndef TUVOK_GLGPUTRACER_H
+#define TUVOK_GLGPUTRACER_H
+
+#include "../../StdTuvokDefines.h"
+#include <deque>
+#include <vector>
+#include "GLInclude.h"
+#include "GLTimerQueryPool.h"
+
+namespace tuvok {
+
+/** \class GLGPUTracer
+ * Measures spans of GL commands with GL_TIMESTAMP queries and adds them to
+ * the Tracer under Tracer::GPU_THREAD_ID.
+ *
+ * Results are fetched by Collect() only once the GPU has made them
+ * available, typically a frame or two later, so tracing never stalls the
+ * pipeline.  Does nothing if tracing is disabled or the GL lacks
+ * ARB_timer_query.  All methods need the context current that owns the
+ * queries. */
+class GLGPUTracer {
+  public:
+    GLGPUTracer();
+    ~GLGPUTracer();
+
+    static bool IsSupported();
+
+    /// Spans nest; End() closes the innermost open one.
+    void Begin(const char* category, const char* name);
+    void End();
+    /// Hands finished spans to the Tracer; call once per frame.
+    void Collect();
+    /// Deletes all queries; pending spans are dropped.
+    void Release();
+
+  private:
+    GLGPUTracer(const GLGPUTracer&);            ///< unimplemented
+    GLGPUTracer& operator=(const GLGPUTracer&); ///< unimplemented
+
+    struct Span {
+      const char* category;
+      const char* name;
+      GLuint      begin;
+      GLuint      end;   ///< 0 while the span is open
+    };
+
+    /// Measures the offset between the GL and the Tracer clock.
+    void   Calibrate();
+
+    std::deque<Span>    m_Spans;
+    /// One entry per open Begin(): whether it issued a query.
+    std::vector<bool>   m_vOpen;
+    GLTimerQueryPool    m_Queries;
+    int64_t             m_iClockOffset;    ///< Tracer::Now() - GL_TIMESTAMP
+    uint32_t            m_iCalibrationAge; ///< Collect() calls since then
+    bool                m_bCalibrated;
+};
+
+/// Scoped GLGPUTracer span.
+class GLGPUTraceScope {
+  public:
+    GLGPUTraceScope(GLGPUTracer& tracer, const char* category,
+                    const char* name) : m_Tracer(tracer) {
+      m_Tracer.Begin(category, name);
+    }
+    ~GLGPUTraceScope() { m_Tracer.End(); }
+
+  private:
+    GLGPUTraceScope(const GLGPUTraceScope&);            ///< unimplemented
+    GLGPUTraceScope& operator=(const GLGPUTraceScope&); ///< unimplemented
+
+    GLGPUTracer& m_Tracer;
+};
+
+}
+#endif // TUVOK_GLGPUTRACER_H
@@ -3,6 +3,7 @@
 #include "Basics/SysTools.h" // for Paper Hack file log 
 #include "Controller/Controller.h"
 #include "Controller/StackTimer.h"
+#include "Controller/Tracer.h"
 #include "IO/TransferFunction1D.h"
 #include "IO/TransferFunction2D.h"
 #include "IO/FileBackedDataset.h"
@@ -645,6 +646,7 @@ void GLGridLeaper::SetRendermode(AbstrRenderer::ERenderMode eRenderMode) {
 }
 
 UINTVECTOR4 GLGridLeaper::RecomputeBrickVisibility(bool bForceSynchronousUpdate) {
+  TUVOK_TRACE("visibility", "RecomputeBrickVisibility");
   // (totalProcessedBrickCount, emptyBrickCount, childEmptyBrickCount)
   UINTVECTOR4 vEmptyBrickCount(0, 0, 0, 0);
   if (!m_pVolumePool) return vEmptyBrickCount;
@@ -912,7 +914,7 @@ uint32_t GLGridLeaper::UpdateToVolumePool(std::vector<UINTVECTOR4>& hash) {
 }
 
 bool GLGridLeaper::Render3DRegion(RenderRegion3D& rr) {
-  tuvok::Controller::Instance().IncrementPerfCounter(PERF_SUBFRAMES, 1.0);
+  tuvok::PerfCounters::Instance().Add(PERF_SUBFRAMES, 1.0);
 #ifdef GLGRIDLEAPER_PROFILE
   GL(glFinish());
 #endif
@@ -8,6 +8,7 @@
 #include <GL/glew.h>
 #include "Basics/nonstd.h"
 #include "IO/UVF/ExtendedOctree/VolumeTools.h"
+#include "Controller/Controller.h"
 #include "Controller/StackTimer.h"
 #include "GLHashTable.h"
 #include "GLInclude.h"
@@ -15,6 +16,7 @@
 #include "GLFBOTex.h"
 #include "GLTexture1D.h"
 #include "GLTexture2D.h"
+#include "GLTextureReadback.h"
 #include "Renderer/ShaderDescriptor.h"
 
 using namespace tuvok;
@@ -92,8 +94,9 @@ std::vector<UINTVECTOR4> GLHashTable::GetData() {
 #ifdef GLHASHTABLE_PROFILE
   GL(glFinish());
 #endif
+  // read into the buffer we already have instead of allocating a new one
   TimedStatement(PERF_READ_HTABLE,
-    m_pRawData = std::static_pointer_cast<uint32_t>(m_pHashTableTex->GetData());
+    m_pHashTableTex->ReadbackAsync(m_pRawData)->Get();
   );
   std::vector<UINTVECTOR4> requests;
   StackTimer condense(PERF_CONDENSE_HTABLE);
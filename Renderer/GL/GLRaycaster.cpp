@@ -348,7 +348,7 @@ void GLRaycaster::RenderBox(const RenderRegion& renderRegion,
 void GLRaycaster::Render3DPreLoop(const RenderRegion3D &) {
 
   // render nearplane into buffer
-  if (m_iBricksRenderedInThisSubFrame == 0) {
+  if (!SubframeStarted()) {
     GPUState localState = m_BaseState;
     localState.enableBlend = false;
     localState.depthMask = false;
@@ -388,7 +388,7 @@ void GLRaycaster::Render3DInLoop(const RenderRegion3D& renderRegion,
                                                                     
   const Brick& b = (eStereoID == SI_LEFT_OR_MONO) ? m_vCurrentBrickList[iCurrentBrick] : m_vLeftEyeBrickList[iCurrentBrick];
 
-  if (m_iBricksRenderedInThisSubFrame == 0 && m_eRenderMode == RM_ISOSURFACE){
+  if (!SubframeStarted() && m_eRenderMode == RM_ISOSURFACE){
     m_TargetBinder.Bind(m_pFBOIsoHit[size_t(eStereoID)], 0, m_pFBOIsoHit[size_t(eStereoID)], 1);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     if (m_bDoClearView) {
@@ -47,6 +47,7 @@
 #include "Basics/SystemInfo.h"
 #include "Basics/SysTools.h"
 #include "Controller/Controller.h"
+#include "Controller/Tracer.h"
 #include "IO/FileBackedDataset.h"
 #include "IO/TransferFunction1D.h"
 #include "IO/TransferFunction2D.h"
@@ -58,8 +59,10 @@
 #include "Renderer/writebrick.h"
 #include "GLFBOTex.h"
 #include "GLSLProgram.h"
+#include "GLStateManager.h"
 #include "GLTexture1D.h"
 #include "GLTexture2D.h"
+#include "GLTextureReadback.h"
 #include "GLVolume3DTex.h"
 
 using namespace std;
@@ -107,7 +110,15 @@ GLRenderer::GLRenderer(MasterController* pMasterController,
   m_pProgramMeshBTF(NULL),
   m_texFormat16(GL_RGBA16),
   m_texFormat32(GL_RGBA),
-  m_aDepthStorage(NULL)
+  m_aDepthStorage(NULL),
+  m_iDepthPBO(0),
+  m_bDepthStorageEmpty(false),
+  m_bPickReadbackValid(false),
+  m_vPickOrigin(0,0),
+  m_vPickSize(0,0),
+  m_vPickCenter(0,0),
+  m_bPickPrefetch(false),
+  m_bIsoHitComplete(false)
 {
   m_pProgram1DTrans[0]   = NULL;
   m_pProgram1DTrans[1]   = NULL;
@@ -127,7 +138,7 @@ GLRenderer::~GLRenderer() {
 
   m_Meshes.clear();
 
-  DeleteDepthStorage();
+  delete [] m_aDepthStorage;
 }
 
 void GLRenderer::InitBaseState() {
@@ -552,6 +563,7 @@ bool GLRenderer::Continue3DDraw() {
 }
 
 bool GLRenderer::Render3DRegion(RenderRegion3D& region3D) {
+  TUVOK_TRACE("render", "Render3DRegion");
   PlanFrame(region3D);
 
   // decreaseScreenResNow could have changed after calling PlanFrame.
@@ -560,9 +572,12 @@ bool GLRenderer::Render3DRegion(RenderRegion3D& region3D) {
   // execute the frame
   float fMsecPassed = 0.0f;
   bool bJobDone = false;
-  if (!Execute3DFrame(region3D, fMsecPassed, bJobDone) ) {
-    T_ERROR("Could not execute the 3D frame, aborting.");
-    return false;
+  {
+    GLGPUTraceScope gpuTrace(m_GPUTracer, "render", "Execute3DFrame");
+    if (!Execute3DFrame(region3D, fMsecPassed, bJobDone) ) {
+      T_ERROR("Could not execute the 3D frame, aborting.");
+      return false;
+    }
   }
   this->msecPassedCurrentFrame += fMsecPassed;
   return bJobDone;
@@ -572,6 +587,9 @@ bool GLRenderer::Paint() {
   if (!AbstrRenderer::Paint()) return false;
 
   m_pContext->GetStateManager()->Apply(m_BaseState);
+  // the host application may have bound its own textures since our last
+  // frame, so do not trust the cached bindings across Paint calls
+  GLStateManager::Current().InvalidateTextureState();
 
   if (m_bDatasetIsInvalid) return true;
 
@@ -639,6 +657,7 @@ bool GLRenderer::Paint() {
           } else {
             justCompletedRegions[i] = Render3DRegion(region3D);
           }
+          IsoHitChanged(justCompletedRegions[i] != 0);
           // are we done rendering or do we need to render at higher quality?
           region3D.redrawMask = Continue3DDraw();
         } else if (renderRegions[i]->is2D()) {  // in a 2D view mode
@@ -659,6 +678,11 @@ bool GLRenderer::Paint() {
     }
   }
   EndFrame(justCompletedRegions);
+  m_pMasterController->EndPerfFrame();
+  m_GPUTracer.Collect();
+  if (Tracer::Enabled()) {
+    Tracer::Instance().FrameMarker(PerfCounters::Instance().GetFrameCount());
+  }
 
   // reset render states
   m_bFirstDrawAfterResize = false;
@@ -757,6 +781,8 @@ void GLRenderer::TargetIsBlankButFrameIsNotFinished(const RenderRegion* region)
 }
 
 void GLRenderer::EndFrame(const vector<char>& justCompletedRegions) {
+  TUVOK_TRACE("composite", "EndFrame");
+  GLGPUTraceScope gpuTrace(m_GPUTracer, "composite", "EndFrame");
   // For a single region we can support stereo and we can also optimize the
   // code by swapping the buffers instead of copying data from one to the
   // other.
@@ -879,12 +905,18 @@ void GLRenderer::SetViewPort(UINTVECTOR2 viLowerLeft, UINTVECTOR2 viUpperRight,
   glViewport(viLowerLeft.x,viLowerLeft.y,viSize.x,viSize.y);
 
   float fAspect =(float)viSize.x/(float)viSize.y;
+  uint32_t iLODPixelsY = originalPixelsY;
+  if (m_bTiledRendering) {
+    // a tile is a window into the full image: same frustum, same LOD
+    fAspect = float(m_vTiledImageSize.x)/float(m_vTiledImageSize.y);
+    iLODPixelsY = m_vTiledImageSize.y;
+  }
   ComputeViewAndProjection(fAspect);
 
   // forward the projection matrix to the culling object
   m_FrustumCullingLOD.SetProjectionMatrix(m_mProjection[0]);
   m_FrustumCullingLOD.SetScreenParams(m_fFOV, fAspect, m_fZNear, m_fZFar,
-                                      originalPixelsY);
+                                      iLODPixelsY);
 
 }
 
@@ -917,6 +949,10 @@ void GLRenderer::ComputeViewAndProjection(float fAspect) {
       m_mProjection[0].setProjection();
     }
   }
+  if (m_bTiledRendering) {
+    m_mProjection[0] = m_mProjection[0] * TileProjection();
+    m_mProjection[0].setProjection();
+  }
 }
 
 void GLRenderer::RenderSlice(const RenderRegion2D& region, double fSliceIndex,
@@ -1340,7 +1376,8 @@ void GLRenderer::NewFrameClear(const RenderRegion& renderRegion) {
   for (size_t i = 0;i<iStereoBufferCount;i++) {
     m_TargetBinder.Bind(m_pFBO3DImageNext[i]);
 
-    if (m_bConsiderPreviousDepthbuffer && m_aDepthStorage) {
+    if (m_bConsiderPreviousDepthbuffer && HasDepthStorage() &&
+        !m_bDepthStorageEmpty) {
       GL(glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT));
       GL(glMatrixMode(GL_PROJECTION));
       GL(glLoadIdentity());
@@ -1348,10 +1385,19 @@ void GLRenderer::NewFrameClear(const RenderRegion& renderRegion) {
       GL(glLoadIdentity());
       GL(glRasterPos2f(-1.0,-1.0));
       m_pContext->GetStateManager()->SetColorMask(false);
-      GL(glDrawPixels(m_vWinSize.x, m_vWinSize.y, GL_DEPTH_COMPONENT, GL_FLOAT,
-                      m_aDepthStorage));
+      if (m_iDepthPBO) {
+        // the depths never leave the GPU
+        GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_iDepthPBO));
+        GL(glDrawPixels(m_vWinSize.x, m_vWinSize.y, GL_DEPTH_COMPONENT,
+                        GL_FLOAT, NULL));
+        GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+      } else {
+        GL(glDrawPixels(m_vWinSize.x, m_vWinSize.y, GL_DEPTH_COMPONENT,
+                        GL_FLOAT, m_aDepthStorage));
+      }
       m_pContext->GetStateManager()->SetColorMask(true);
     } else {
+      // a cleared depth buffer is all we would draw for an empty storage
       GL(glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT));
     }
   }
@@ -1491,7 +1537,7 @@ void GLRenderer::PostSubframe(const RenderRegion& renderRegion)
 bool GLRenderer::Execute3DFrame(RenderRegion3D& renderRegion,
                                 float& fMsecPassed, bool& completedJob) {
   // are we starting a new LOD level?
-  if (m_iBricksRenderedInThisSubFrame == 0) {
+  if (!SubframeStarted()) {
     fMsecPassed = 0;
     PreSubframe(renderRegion);
   }
@@ -1682,6 +1728,26 @@ bool GLRenderer::CaptureSingleFrame(const std::string& strFilename,
                                            bPreserveTransparency);
 }
 
+bool GLRenderer::CaptureSingleFrameAsync(const std::string& strFilename,
+                                         bool bPreserveTransparency) {
+  return m_FrameCapture.CaptureSingleFrameAsync(strFilename,
+                                                GetLastFBO(),
+                                                bPreserveTransparency);
+}
+
+bool GLRenderer::FinishCaptures() {
+  return m_FrameCapture.FinishCaptures();
+}
+
+void GLRenderer::TakeCaptureReports(std::vector<CaptureReport>& reports) {
+  m_FrameCapture.TakeReports(reports);
+}
+
+bool GLRenderer::ReadFrame(std::vector<uint16_t>& vRGBA,
+                           UINTVECTOR2& vSize) const {
+  return m_FrameCapture.ReadFrame(GetLastFBO(), vRGBA, vSize);
+}
+
 void GLRenderer::Cleanup() {
   m_TargetBinder.Unbind(); // make sure nothing is bound before we delete the buffers
 
@@ -1717,14 +1783,25 @@ void GLRenderer::Cleanup() {
     m_pLogoTex =NULL;
   }
 
+  // our context may go away with us, do not leave released targets behind
+  if (m_pContext) mm.FlushFBOPool(m_pContext->GetShareGroupID());
+
   // opengl may not be enabed yet so be careful calling gl functions
   if (glDeleteBuffers) GL(glDeleteBuffers(1, &m_GeoBuffer));
+  m_GPUTracer.Release();
+  m_TimeSlicer.Release();
+  m_FrameCapture.Release();
+  m_pPickReadback.reset();
+  m_bPickReadbackValid = false;
+  if (m_iDepthPBO && glDeleteBuffers) GL(glDeleteBuffers(1, &m_iDepthPBO));
+  m_iDepthPBO = 0;
 
   CleanupShaders();
 }
 
 void GLRenderer::CreateOffscreenBuffers() {
   m_TargetBinder.Unbind(); // make sure nothing is bound before we delete the buffers
+  IsoHitChanged(false);
 
   GPUMemMan &mm = *(Controller::Instance().MemMan());
 
@@ -2635,6 +2712,8 @@ bool GLRenderer::RegisterDataset(Dataset* ds) {
 }
 
 void GLRenderer::Recompose3DView(const RenderRegion3D& renderRegion) {
+  TUVOK_TRACE("composite", "Recompose3DView");
+  GLGPUTraceScope gpuTrace(m_GPUTracer, "composite", "Recompose3DView");
   MESSAGE("Recompositing...");
   NewFrameClear(renderRegion);
 
@@ -2665,18 +2744,42 @@ bool GLRenderer::Render3DView(const RenderRegion3D& renderRegion,
   Render3DPreLoop(renderRegion);
   size_t iStereoBufferCount = (m_bDoStereoRendering) ? 2 : 1;
 
-  // loop over all bricks in the current LOD level
+  // loop over all bricks in the current LOD level.  With timer queries the
+  // GPU time of the bricks is measured asynchronously and we stop as soon as
+  // the next brick is predicted to exceed the time slice; otherwise each
+  // brick has to be waited for.
+  const bool bTimeSliced = m_eRendererTarget != RT_HEADLESS;
+  const bool bQueries = GLTimeSlicer::IsSupported();
   m_Timer.Start();
+  if (bQueries) m_TimeSlicer.Begin(m_BrickCostModel);
   uint32_t bricks_this_call = 0;
   fMsecPassed = 0;
 
   while (m_vCurrentBrickList.size() > m_iBricksRenderedInThisSubFrame &&
-         (m_eRendererTarget == RT_HEADLESS || fMsecPassed < m_iTimeSliceMSecs)) {
+         (!bTimeSliced || fMsecPassed < m_iTimeSliceMSecs)) {
+    // in stereo mode the schedule tells which eyes render the bound brick
+    size_t iBrick[2] = {size_t(m_iBricksRenderedInThisSubFrame),
+                        StereoBrickScheduler::NO_BRICK};
+    if (m_bDoStereoRendering) {
+      const StereoBrickScheduler::Step& step =
+        m_StereoSchedule.GetStep(size_t(m_iStereoStepsRendered));
+      iBrick[0] = step.iBrick[0];
+      iBrick[1] = step.iBrick[1];
+    }
+    const Brick& brick = (iBrick[0] != StereoBrickScheduler::NO_BRICK)
+                         ? m_vCurrentBrickList[iBrick[0]]
+                         : m_vLeftEyeBrickList[iBrick[1]];
+    const uint64_t iVoxels = UINT64VECTOR3(brick.vVoxelCount).volume();
+    if (bQueries && bTimeSliced && bricks_this_call > 0 &&
+        !m_TimeSlicer.Fits(iVoxels, m_iTimeSliceMSecs)) {
+      break;
+    }
+
     MESSAGE("  Brick %u of %u",
             static_cast<unsigned>(m_iBricksRenderedInThisSubFrame+1),
             static_cast<unsigned>(m_vCurrentBrickList.size()));
 
-    const BrickKey& bkey = m_vCurrentBrickList[size_t(m_iBricksRenderedInThisSubFrame)].kBrick;
+    const BrickKey& bkey = brick.kBrick;
 
     MESSAGE("  Requesting texture from MemMan");
 
@@ -2687,22 +2790,11 @@ bool GLRenderer::Render3DView(const RenderRegion3D& renderRegion,
       return false;
     }
 
-    Render3DInLoop(renderRegion, size_t(m_iBricksRenderedInThisSubFrame), SI_LEFT_OR_MONO);
-    if (m_bDoStereoRendering) {
-      if (m_vLeftEyeBrickList[size_t(m_iBricksRenderedInThisSubFrame)].kBrick !=
-          m_vCurrentBrickList[size_t(m_iBricksRenderedInThisSubFrame)].kBrick) {
-        const BrickKey& left_eye_key = m_vLeftEyeBrickList[size_t(m_iBricksRenderedInThisSubFrame)].kBrick;
-
-        UnbindVolumeTex();
-        if(BindVolumeTex(left_eye_key, m_iIntraFrameCounter++)) {
-          MESSAGE("  Binding Texture (left eye)");
-        } else {
-          T_ERROR("Cannot bind texture (left eye), GetVolume returned invalid volume");
-          return false;
-        }
-      }
-
-      Render3DInLoop(renderRegion, size_t(m_iBricksRenderedInThisSubFrame),SI_RIGHT);
+    if (iBrick[0] != StereoBrickScheduler::NO_BRICK) {
+      Render3DInLoop(renderRegion, iBrick[0], SI_LEFT_OR_MONO);
+    }
+    if (iBrick[1] != StereoBrickScheduler::NO_BRICK) {
+      Render3DInLoop(renderRegion, iBrick[1], SI_RIGHT);
     }
 
     // release the 3D texture
@@ -2712,20 +2804,36 @@ bool GLRenderer::Render3DView(const RenderRegion3D& renderRegion,
     }
 
     // count the bricks rendered
-    m_iBricksRenderedInThisSubFrame++;
+    if (m_bDoStereoRendering) {
+      m_iStereoStepsRendered++;
+      m_iBricksRenderedInThisSubFrame =
+        m_StereoSchedule.GetBricksDone(size_t(m_iStereoStepsRendered));
+    } else {
+      m_iBricksRenderedInThisSubFrame++;
+    }
 
-    if (m_eRendererTarget != RT_CAPTURE) {
+    if (bQueries) {
+      m_TimeSlicer.BrickSubmitted(iVoxels);
+      fMsecPassed = float(std::max<double>(m_Timer.Elapsed(),
+                                   m_TimeSlicer.PredictedElapsed()));
+    } else {
+      if (m_eRendererTarget != RT_CAPTURE) {
 #ifdef DETECTED_OS_APPLE
-      // really (hopefully) force a pipleine flush
-      unsigned char dummy[4];
-      glReadPixels(0,0,1,1,GL_RGBA,GL_UNSIGNED_BYTE,dummy);
+        // really (hopefully) force a pipleine flush
+        unsigned char dummy[4];
+        glReadPixels(0,0,1,1,GL_RGBA,GL_UNSIGNED_BYTE,dummy);
 #else
-      // let's pretend this actually does what it should
-      glFinish();
+        // let's pretend this actually does what it should
+        glFinish();
 #endif
+      }
+      // time this loop
+      const float fBrickStart = fMsecPassed;
+      fMsecPassed = float(m_Timer.Elapsed());
+      if (m_eRendererTarget != RT_CAPTURE) {
+        m_BrickCostModel.AddSample(iVoxels, fMsecPassed - fBrickStart);
+      }
     }
-    // time this loop
-    fMsecPassed = float(m_Timer.Elapsed());
 
     ++bricks_this_call;
   }
@@ -2833,9 +2941,7 @@ void GLRenderer::ComposeSurfaceImage(const RenderRegion &renderRegion, EStereoID
 void GLRenderer::CVFocusHasChanged(LuaClassInstance luaRegion) {
   // read back the 3D position from the framebuffer
   float vec[4];
-  m_pFBOIsoHit[0]->ReadBackPixels(m_vCVMousePos.x, 
-                                  m_vWinSize.y-m_vCVMousePos.y,
-                                  1, 1, vec);
+  ReadIsoHit(INTVECTOR2(m_vCVMousePos.x, m_vWinSize.y-m_vCVMousePos.y), vec);
 
   shared_ptr<LuaScripting> ss = m_pMasterController->LuaScript();
   RenderRegion* region = luaRegion.getRawPointer<RenderRegion>(ss);
@@ -2862,8 +2968,7 @@ FLOATVECTOR3 GLRenderer::Pick(const UINTVECTOR2& mousePos) const
 
   // readback the pos from the FB
   float vec[4];
-  m_pFBOIsoHit[0]->ReadBackPixels(mousePos.x, m_vWinSize.y-mousePos.y,
-                                  1, 1, vec);
+  ReadIsoHit(INTVECTOR2(mousePos.x, m_vWinSize.y-mousePos.y), vec);
 
   if(vec[3] == 0.0f) {
     throw std::range_error("No intersection.");
@@ -2871,20 +2976,102 @@ FLOATVECTOR3 GLRenderer::Pick(const UINTVECTOR2& mousePos) const
   return FLOATVECTOR3(vec[0], vec[1], vec[2]);
 }
 
+void GLRenderer::IsoHitChanged(bool bFrameCompleted) {
+  m_bPickReadbackValid = false;
+  m_bIsoHitComplete = bFrameCompleted;
+  if (m_bIsoHitComplete && m_bPickPrefetch && m_pFBOIsoHit[0] &&
+      m_eRenderMode == RM_ISOSURFACE) {
+    StartPickReadback();
+  }
+}
+
+void GLRenderer::StartPickReadback() const {
+  m_vPickSize = INTVECTOR2(
+    std::min<int>(PICK_REGION_SIZE, m_vWinSize.x),
+    std::min<int>(PICK_REGION_SIZE, m_vWinSize.y)
+  );
+  if (m_vPickSize.x <= 0 || m_vPickSize.y <= 0) return;
+
+  m_vPickOrigin = INTVECTOR2(
+    MathTools::Clamp(m_vPickCenter.x - m_vPickSize.x/2, 0,
+                     int(m_vWinSize.x) - m_vPickSize.x),
+    MathTools::Clamp(m_vPickCenter.y - m_vPickSize.y/2, 0,
+                     int(m_vWinSize.y) - m_vPickSize.y)
+  );
+  m_pPickReadback = m_pFBOIsoHit[0]->ReadBackPixelsAsync(
+    m_vPickOrigin.x, m_vPickOrigin.y, m_vPickSize.x, m_vPickSize.y,
+    m_pPickReadback
+  );
+  m_bPickReadbackValid = true;
+}
+
+void GLRenderer::ReadIsoHit(const INTVECTOR2& vPixel, float vec[4]) const {
+  m_bPickPrefetch = true;
+
+  const bool bInRegion = m_bPickReadbackValid && m_pPickReadback &&
+    vPixel.x >= m_vPickOrigin.x && vPixel.x < m_vPickOrigin.x+m_vPickSize.x &&
+    vPixel.y >= m_vPickOrigin.y && vPixel.y < m_vPickOrigin.y+m_vPickSize.y;
+  if (bInRegion && m_pPickReadback->IsReady()) {
+    const float* pHits = static_cast<const float*>(m_pPickReadback->Get().get());
+    const size_t iIndex = size_t(vPixel.y - m_vPickOrigin.y) * m_vPickSize.x +
+                          size_t(vPixel.x - m_vPickOrigin.x);
+    std::copy(pHits + 4*iIndex, pHits + 4*iIndex + 4, vec);
+    return;
+  }
+
+  // a single pixel is cheaper than waiting for the whole region
+  m_pFBOIsoHit[0]->ReadBackPixels(vPixel.x, vPixel.y, 1, 1, vec);
+  // the region read is still on its way, keep it for the next picks
+  if (bInRegion) return;
+
+  // the next picks will most likely be close to this one
+  m_vPickCenter = vPixel;
+  if (m_bIsoHitComplete) StartPickReadback();
+}
+
 void GLRenderer::SaveEmptyDepthBuffer() {
-  if (m_aDepthStorage == NULL) return;
-  for (size_t i = 0;i<m_vWinSize.area();i++) m_aDepthStorage[i] = 1.0f;
+  m_bDepthStorageEmpty = true;
 }
 
 void GLRenderer::SaveDepthBuffer() {
-  if (m_aDepthStorage == NULL) return;
-  glReadPixels(0, 0, m_vWinSize.x, m_vWinSize.y, GL_DEPTH_COMPONENT, GL_FLOAT,
-               m_aDepthStorage);
+  if (m_iDepthPBO) {
+    // stays on the GPU until NewFrameClear draws it, so nothing waits here
+    GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_iDepthPBO));
+    GL(glReadPixels(0, 0, m_vWinSize.x, m_vWinSize.y, GL_DEPTH_COMPONENT,
+                    GL_FLOAT, NULL));
+    GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  } else if (m_aDepthStorage) {
+    glReadPixels(0, 0, m_vWinSize.x, m_vWinSize.y, GL_DEPTH_COMPONENT,
+                 GL_FLOAT, m_aDepthStorage);
+  } else {
+    return;
+  }
+  m_bDepthStorageEmpty = false;
 }
 
 void GLRenderer::CreateDepthStorage() {
   DeleteDepthStorage();
-  m_aDepthStorage = new float[m_vWinSize.area()];
+  m_bDepthStorageEmpty = true;
+
+  if (GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object) {
+    GL(glGenBuffers(1, &m_iDepthPBO));
+    GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_iDepthPBO));
+    GL(glBufferData(GL_PIXEL_PACK_BUFFER,
+                    GLsizeiptr(m_vWinSize.area() * sizeof(float)), NULL,
+                    GL_STREAM_COPY));
+    GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  } else {
+    m_aDepthStorage = new float[m_vWinSize.area()];
+  }
+}
+
+void GLRenderer::DeleteDepthStorage() {
+  if (m_iDepthPBO) {
+    GL(glDeleteBuffers(1, &m_iDepthPBO));
+    m_iDepthPBO = 0;
+  }
+  delete [] m_aDepthStorage;
+  m_aDepthStorage = NULL;
 }
 
 void GLRenderer::UpdateLightParamsInShaders() {
@@ -46,6 +46,8 @@
 #include "GLTargetBinder.h"
 #include "GLStateManager.h"
 #include "GLFrameCapture.h"
+#include "GLGPUTracer.h"
+#include "GLTimeSlicer.h"
 #include "RenderMeshGL.h"
 
 namespace tuvok {
@@ -55,6 +57,7 @@ class GLTexture1D;
 class GLTexture2D;
 class GLVolume;
 class GLSLProgram;
+class GLTextureReadback;
 
 class GLRenderer : public AbstrRenderer {
   public:
@@ -112,6 +115,8 @@ class GLRenderer : public AbstrRenderer {
     void CopyImageToDisplayBuffer();
   protected:
     GLTargetBinder  m_TargetBinder;
+    GLGPUTracer     m_GPUTracer;
+    GLTimeSlicer    m_TimeSlicer;
     GLTexture1D*    m_p1DTransTex;
     GLTexture2D*    m_p2DTransTex;
     std::vector<unsigned char> m_p1DData;
@@ -154,6 +159,11 @@ class GLRenderer : public AbstrRenderer {
     void DrawBackGradient() const;
     bool CaptureSingleFrame(const std::string& strFilename,
                             bool bPreserveTransparency) const;
+    bool CaptureSingleFrameAsync(const std::string& strFilename,
+                                 bool bPreserveTransparency);
+    bool FinishCaptures();
+    void TakeCaptureReports(std::vector<CaptureReport>& reports);
+    bool ReadFrame(std::vector<uint16_t>& vRGBA, UINTVECTOR2& vSize) const;
 
     virtual bool Continue3DDraw();
 
@@ -265,14 +275,41 @@ class GLRenderer : public AbstrRenderer {
     GLenum          m_texFormat32; ///< 32bit internal texture format to use
 
   private:
+    /// side length of the iso hit region read back around the last pick
+    enum { PICK_REGION_SIZE = 64 };
+
+    /// previous depth buffer; kept on the GPU in m_iDepthPBO if the GL has
+    /// pixel buffer objects, in m_aDepthStorage otherwise
     float*          m_aDepthStorage;
+    GLuint          m_iDepthPBO;
+    bool            m_bDepthStorageEmpty; ///< as if all depths were 1
+
+    /// m_pFBOIsoHit[0] around m_vPickCenter, read back after the last
+    /// completed frame, so picks near the previous one need not stall.  The
+    /// handle and its pixel buffer are reused for every read back.
+    mutable std::shared_ptr<GLTextureReadback> m_pPickReadback;
+    mutable bool       m_bPickReadbackValid; ///< m_pPickReadback is current
+    mutable INTVECTOR2 m_vPickOrigin;
+    mutable INTVECTOR2 m_vPickSize;
+    mutable INTVECTOR2 m_vPickCenter;
+    mutable bool       m_bPickPrefetch;   ///< there has been a pick
+    bool               m_bIsoHitComplete; ///< iso hit FBO has a full frame
 
     void SetBrickDepShaderVarsSlice(const UINTVECTOR3& vVoxelCount) const;
     void RenderCoordArrows(const RenderRegion& renderRegion) const;
     void SaveEmptyDepthBuffer();
     void SaveDepthBuffer();
     void CreateDepthStorage();
-    void DeleteDepthStorage() {delete [] m_aDepthStorage;}
+    void DeleteDepthStorage();
+    bool HasDepthStorage() const {
+      return m_iDepthPBO != 0 || m_aDepthStorage != NULL;
+    }
+
+    /// called after rendering into the iso hit FBO
+    void IsoHitChanged(bool bFrameCompleted);
+    void StartPickReadback() const;
+    /// iso hit position at window pixel vPixel (GL convention, y up)
+    void ReadIsoHit(const INTVECTOR2& vPixel, float vec[4]) const;
 
     void TargetIsBlankButFrameIsNotFinished(const RenderRegion* region);
 };
@@ -46,6 +46,12 @@
 using namespace std;
 using namespace tuvok;
 
+namespace {
+  // slices of the bricks seen in the last few frames; progressive
+  // refinement and stereo revisit them with the same view
+  const uint64_t iGeometryCacheBudget = 64ull * 1024 * 1024;
+}
+
 GLSBVR::GLSBVR(MasterController* pMasterController,              
                bool bUseOnlyPowerOfTwo, 
                bool bDownSampleTo8Bits, 
@@ -60,6 +66,7 @@ GLSBVR::GLSBVR(MasterController* pMasterController,
   m_pProgram1DTransMesh[1] = NULL;
   m_pProgram2DTransMesh[0] = NULL;
   m_pProgram2DTransMesh[1] = NULL;
+  m_SBVRGeogen.SetGeometryCacheBudget(iGeometryCacheBudget);
 }
 
 GLSBVR::~GLSBVR() {
@@ -342,10 +349,11 @@ void GLSBVR::Render3DPreLoop(const RenderRegion3D&) {
 GLsizei iStructSize = GLsizei(sizeof(VERTEX_FORMAT));
 
 void GLSBVR::RenderProxyGeometry() const {
-  if (m_SBVRGeogen.m_vSliceTriangles.empty()) return;
+  const std::vector<VERTEX_FORMAT>& vSlices = m_SBVRGeogen.GetSliceTriangles();
+  if (vSlices.empty()) return;
 
   GL(glBindBuffer(GL_ARRAY_BUFFER, m_GeoBuffer));
-  GL(glBufferData(GL_ARRAY_BUFFER, GLsizei(m_SBVRGeogen.m_vSliceTriangles.size())*iStructSize, &m_SBVRGeogen.m_vSliceTriangles[0], GL_STREAM_DRAW));
+  GL(glBufferData(GL_ARRAY_BUFFER, GLsizei(vSlices.size())*iStructSize, &vSlices[0], GL_STREAM_DRAW));
   GL(glVertexPointer(3, GL_FLOAT, iStructSize, BUFFER_OFFSET(0)));
   if (m_SBVRGeogen.HasMesh()) {
     GL(glTexCoordPointer(4 , GL_FLOAT, iStructSize, BUFFER_OFFSET(12)));
@@ -357,7 +365,7 @@ void GLSBVR::RenderProxyGeometry() const {
   
   GL(glEnableClientState(GL_VERTEX_ARRAY));
   GL(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
-  GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(m_SBVRGeogen.m_vSliceTriangles.size())));
+  GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(vSlices.size())));
   GL(glDisableClientState(GL_VERTEX_ARRAY));
   GL(glDisableClientState(GL_TEXTURE_COORD_ARRAY));
   GL(glDisableClientState(GL_NORMAL_ARRAY));
@@ -370,7 +378,7 @@ void GLSBVR::Render3DInLoop(const RenderRegion3D& renderRegion,
 
   const Brick& b = (eStereoID == SI_LEFT_OR_MONO) ? m_vCurrentBrickList[iCurrentBrick] : m_vLeftEyeBrickList[iCurrentBrick];
   
-  if (m_iBricksRenderedInThisSubFrame == 0 && m_eRenderMode == RM_ISOSURFACE){
+  if (!SubframeStarted() && m_eRenderMode == RM_ISOSURFACE){
     m_TargetBinder.Bind(m_pFBOIsoHit[size_t(eStereoID)], 0, m_pFBOIsoHit[size_t(eStereoID)], 1);
     GL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
     if (m_bDoClearView) {
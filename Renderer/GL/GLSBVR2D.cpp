@@ -48,6 +48,12 @@
 using namespace std;
 using namespace tuvok;
 
+namespace {
+  // slices of the bricks seen in the last few frames; progressive
+  // refinement and stereo revisit them with the same view
+  const uint64_t iGeometryCacheBudget = 64ull * 1024 * 1024;
+}
+
 GLSBVR2D::GLSBVR2D(MasterController* pMasterController, 
                    bool bUseOnlyPowerOfTwo,
                    bool bDownSampleTo8Bits,
@@ -59,6 +65,7 @@ GLSBVR2D::GLSBVR2D(MasterController* pMasterController,
   m_bUse3DTexture(false)
 {
   m_bSupportsMeshes = false; // not fully implemented yet
+  m_SBVRGeogen.SetGeometryCacheBudget(iGeometryCacheBudget);
 }
 
 GLSBVR2D::~GLSBVR2D() {
@@ -353,9 +360,12 @@ void move_slice(struct slice_geom& to, struct slice_geom& from) {
 }
 
 void GLSBVR2D::RenderProxyGeometry2D() const {
+  const std::vector<VERTEX_FORMAT>& vSlicesX = m_SBVRGeogen.GetSliceTrianglesX();
+  const std::vector<VERTEX_FORMAT>& vSlicesY = m_SBVRGeogen.GetSliceTrianglesY();
+  const std::vector<VERTEX_FORMAT>& vSlicesZ = m_SBVRGeogen.GetSliceTrianglesZ();
   GLVolume2DTex* pGLVolume =  static_cast<GLVolume2DTex*>(m_pGLVolume);
 
-  if (!m_SBVRGeogen.m_vSliceTrianglesX.empty()) {
+  if (!vSlicesX.empty()) {
     // set coordinate shuffle matrix
     glMatrixMode(GL_TEXTURE);
     float m[16] = {0,0,1,0,
@@ -375,8 +385,8 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
     // 1800 entries (i.e. 600 verts).  So this should make sure we do
     // all our allocations up front.
     geom.texcoords.reserve(2048); geom.tris.reserve(2048);
-    for(size_t i=0; i < m_SBVRGeogen.m_vSliceTrianglesX.size(); ++i) {
-      const float depth = m_SBVRGeogen.m_vSliceTrianglesX[i].m_vVertexData.x -
+    for(size_t i=0; i < vSlicesX.size(); ++i) {
+      const float depth = vSlicesX[i].m_vVertexData.x -
                           0.5f/pGLVolume->GetSizeX(); // compensate for OpenGL sampling at the texel center
 
       const unsigned iCurrentTexID = static_cast<unsigned>(depth*(pGLVolume->GetSizeX()));
@@ -393,12 +403,12 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
         iLastTexID = iCurrentTexID;
       }
       const float fraction = depth*(pGLVolume->GetSizeX()) - iCurrentTexID;
-      geom.texcoords.push_back(m_SBVRGeogen.m_vSliceTrianglesX[i].m_vVertexData.z);
-      geom.texcoords.push_back(m_SBVRGeogen.m_vSliceTrianglesX[i].m_vVertexData.y);
+      geom.texcoords.push_back(vSlicesX[i].m_vVertexData.z);
+      geom.texcoords.push_back(vSlicesX[i].m_vVertexData.y);
       geom.texcoords.push_back(fraction);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesX[i].m_vPos.x);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesX[i].m_vPos.y);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesX[i].m_vPos.z);
+      geom.tris.push_back(vSlicesX[i].m_vPos.x);
+      geom.tris.push_back(vSlicesX[i].m_vPos.y);
+      geom.tris.push_back(vSlicesX[i].m_vPos.z);
     }
 
     // copy the last geom over
@@ -410,7 +420,7 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
     submit_vert_arrays(pGLVolume, slices, 0);
   }
 
-  if (!m_SBVRGeogen.m_vSliceTrianglesY.empty()) {
+  if (!vSlicesY.empty()) {
     // set coordinate shuffle matrix
     glMatrixMode(GL_TEXTURE);
     float m[16] = {1,0,0,0,
@@ -427,8 +437,8 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
     size_t slc_idx = 0; // index into 'slices'.
     slice_geom geom;
     geom.texcoords.reserve(2048); geom.tris.reserve(2048);
-    for (size_t i = 0;i<m_SBVRGeogen.m_vSliceTrianglesY.size();i++) {
-      const float depth = m_SBVRGeogen.m_vSliceTrianglesY[i].m_vVertexData.y -
+    for (size_t i = 0;i<vSlicesY.size();i++) {
+      const float depth = vSlicesY[i].m_vVertexData.y -
                           0.5f/pGLVolume->GetSizeY(); // compensate for OpenGL sampling at the texel center
 
       const unsigned iCurrentTexID = static_cast<unsigned>(depth*(pGLVolume->GetSizeY()));
@@ -445,12 +455,12 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
       }
       
       const float fraction = depth*(pGLVolume->GetSizeY()) - iCurrentTexID;
-      geom.texcoords.push_back(m_SBVRGeogen.m_vSliceTrianglesY[i].m_vVertexData.x);
-      geom.texcoords.push_back(m_SBVRGeogen.m_vSliceTrianglesY[i].m_vVertexData.z);
+      geom.texcoords.push_back(vSlicesY[i].m_vVertexData.x);
+      geom.texcoords.push_back(vSlicesY[i].m_vVertexData.z);
       geom.texcoords.push_back(fraction);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesY[i].m_vPos.x);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesY[i].m_vPos.y);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesY[i].m_vPos.z);
+      geom.tris.push_back(vSlicesY[i].m_vPos.x);
+      geom.tris.push_back(vSlicesY[i].m_vPos.y);
+      geom.tris.push_back(vSlicesY[i].m_vPos.z);
     }
     // copy the last geom over
     slice_geom g;
@@ -460,7 +470,7 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
     submit_vert_arrays(pGLVolume, slices, 1);
   }
 
-  if (!m_SBVRGeogen.m_vSliceTrianglesZ.empty()) {
+  if (!vSlicesZ.empty()) {
     // set coordinate shuffle matrix
     glMatrixMode(GL_TEXTURE);
     glLoadIdentity();
@@ -472,8 +482,8 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
     size_t slc_idx = 0; // index into 'slices'.
     slice_geom geom;
     geom.texcoords.reserve(2048); geom.tris.reserve(2048);
-    for (size_t i = 0;i<m_SBVRGeogen.m_vSliceTrianglesZ.size();i++) {
-      const float depth = m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vVertexData.z -
+    for (size_t i = 0;i<vSlicesZ.size();i++) {
+      const float depth = vSlicesZ[i].m_vVertexData.z -
                           0.5f/pGLVolume->GetSizeZ(); // compensate for OpenGL sampling at the texel center
       const unsigned iCurrentTexID = static_cast<unsigned>(depth*(pGLVolume->GetSizeZ()));
       if (i == 0) iLastTexID = iCurrentTexID;
@@ -489,12 +499,12 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
       }
 
       const float fraction = depth*(pGLVolume->GetSizeZ()) - iCurrentTexID;
-      geom.texcoords.push_back(m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vVertexData.x);
-      geom.texcoords.push_back(m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vVertexData.y);
+      geom.texcoords.push_back(vSlicesZ[i].m_vVertexData.x);
+      geom.texcoords.push_back(vSlicesZ[i].m_vVertexData.y);
       geom.texcoords.push_back(fraction);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vPos.x);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vPos.y);
-      geom.tris.push_back(m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vPos.z);
+      geom.tris.push_back(vSlicesZ[i].m_vPos.x);
+      geom.tris.push_back(vSlicesZ[i].m_vPos.y);
+      geom.tris.push_back(vSlicesZ[i].m_vPos.z);
     }
     // copy the last geom over
     slice_geom g;
@@ -507,39 +517,42 @@ void GLSBVR2D::RenderProxyGeometry2D() const {
 }
 
 void GLSBVR2D::RenderProxyGeometry3D() const {
-  if(!m_SBVRGeogen.m_vSliceTrianglesX.empty()) {
+  const std::vector<VERTEX_FORMAT>& vSlicesX = m_SBVRGeogen.GetSliceTrianglesX();
+  const std::vector<VERTEX_FORMAT>& vSlicesY = m_SBVRGeogen.GetSliceTrianglesY();
+  const std::vector<VERTEX_FORMAT>& vSlicesZ = m_SBVRGeogen.GetSliceTrianglesZ();
+  if(!vSlicesX.empty()) {
     glBegin(GL_TRIANGLES);
-      for (size_t i = 0;i<m_SBVRGeogen.m_vSliceTrianglesX.size();i++) {
-        glTexCoord3f(m_SBVRGeogen.m_vSliceTrianglesX[i].m_vVertexData.x,
-                     m_SBVRGeogen.m_vSliceTrianglesX[i].m_vVertexData.y,
-                     m_SBVRGeogen.m_vSliceTrianglesX[i].m_vVertexData.z);
-        glVertex3f(m_SBVRGeogen.m_vSliceTrianglesX[i].m_vPos.x,
-                   m_SBVRGeogen.m_vSliceTrianglesX[i].m_vPos.y,
-                   m_SBVRGeogen.m_vSliceTrianglesX[i].m_vPos.z);
+      for (size_t i = 0;i<vSlicesX.size();i++) {
+        glTexCoord3f(vSlicesX[i].m_vVertexData.x,
+                     vSlicesX[i].m_vVertexData.y,
+                     vSlicesX[i].m_vVertexData.z);
+        glVertex3f(vSlicesX[i].m_vPos.x,
+                   vSlicesX[i].m_vPos.y,
+                   vSlicesX[i].m_vPos.z);
       }
     glEnd();
   }
-  if(!m_SBVRGeogen.m_vSliceTrianglesY.empty()) {
+  if(!vSlicesY.empty()) {
     glBegin(GL_TRIANGLES);
-      for (size_t i = 0;i<m_SBVRGeogen.m_vSliceTrianglesY.size();i++) {
-        glTexCoord3f(m_SBVRGeogen.m_vSliceTrianglesY[i].m_vVertexData.x,
-                     m_SBVRGeogen.m_vSliceTrianglesY[i].m_vVertexData.y,
-                     m_SBVRGeogen.m_vSliceTrianglesY[i].m_vVertexData.z);
-        glVertex3f(m_SBVRGeogen.m_vSliceTrianglesY[i].m_vPos.x,
-                   m_SBVRGeogen.m_vSliceTrianglesY[i].m_vPos.y,
-                   m_SBVRGeogen.m_vSliceTrianglesY[i].m_vPos.z);
+      for (size_t i = 0;i<vSlicesY.size();i++) {
+        glTexCoord3f(vSlicesY[i].m_vVertexData.x,
+                     vSlicesY[i].m_vVertexData.y,
+                     vSlicesY[i].m_vVertexData.z);
+        glVertex3f(vSlicesY[i].m_vPos.x,
+                   vSlicesY[i].m_vPos.y,
+                   vSlicesY[i].m_vPos.z);
       }
     glEnd();
   }
-  if(!m_SBVRGeogen.m_vSliceTrianglesZ.empty()) {
+  if(!vSlicesZ.empty()) {
     glBegin(GL_TRIANGLES);
-      for (size_t i = 0;i<m_SBVRGeogen.m_vSliceTrianglesZ.size();i++) {
-        glTexCoord3f(m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vVertexData.x,
-                     m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vVertexData.y,
-                     m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vVertexData.z);
-        glVertex3f(m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vPos.x,
-                   m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vPos.y,
-                   m_SBVRGeogen.m_vSliceTrianglesZ[i].m_vPos.z);
+      for (size_t i = 0;i<vSlicesZ.size();i++) {
+        glTexCoord3f(vSlicesZ[i].m_vVertexData.x,
+                     vSlicesZ[i].m_vVertexData.y,
+                     vSlicesZ[i].m_vVertexData.z);
+        glVertex3f(vSlicesZ[i].m_vPos.x,
+                   vSlicesZ[i].m_vPos.y,
+                   vSlicesZ[i].m_vPos.z);
       }
     glEnd();
   }
@@ -551,7 +564,7 @@ void GLSBVR2D::Render3DInLoop(const RenderRegion3D& renderRegion,
 
   const Brick& b = (eStereoID == SI_LEFT_OR_MONO) ? m_vCurrentBrickList[iCurrentBrick] : m_vLeftEyeBrickList[iCurrentBrick];
 
-  if (m_iBricksRenderedInThisSubFrame == 0 && m_eRenderMode == RM_ISOSURFACE){
+  if (!SubframeStarted() && m_eRenderMode == RM_ISOSURFACE){
     m_TargetBinder.Bind(m_pFBOIsoHit[size_t(eStereoID)], 0, m_pFBOIsoHit[size_t(eStereoID)], 1);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     if (m_bDoClearView) {
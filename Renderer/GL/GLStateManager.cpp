@@ -27,9 +27,61 @@
 */
 #include "GLStateManager.h"
 #include "GLInclude.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <map>
+#include "Basics/Threads.h"
+#ifdef DETECTED_OS_WINDOWS
+# include <GL/wglew.h>
+#elif defined(DETECTED_OS_APPLE)
+# include <OpenGL/OpenGL.h>
+#else
+# ifndef TUVOK_NO_GLX
+#  include <GL/glxew.h>
+# endif
+# ifdef TUVOK_HAVE_EGL
+#  include <EGL/egl.h>
+# endif
+# ifdef TUVOK_HAVE_OSMESA
+#  include <GL/osmesa.h>
+# endif
+#endif
+
+#ifndef TUVOK_THREAD_LOCAL
+# ifdef _MSC_VER
+#  define TUVOK_THREAD_LOCAL __declspec(thread)
+# else
+#  define TUVOK_THREAD_LOCAL __thread
+# endif
+#endif
 
 using namespace tuvok;
 
+namespace {
+  // Every caching state manager registers itself with the native context it
+  // was created in, so resources can find the manager without knowing their
+  // renderer.  Contexts live on different threads, e.g. the render threads
+  // of several windows, so the map is guarded.
+  typedef std::map<const void*, GLStateManager*> ManagerMap;
+  ManagerMap& Managers() {
+    static ManagerMap managers;
+    return managers;
+  }
+  CriticalSection& ManagersGuard() {
+    static CriticalSection guard;
+    return guard;
+  }
+  // bumped on every change of Managers(), invalidates the caches below
+  std::atomic<uint64_t> iManagersGeneration(1);
+
+  // one entry lookup cache in front of Managers(), per thread as every
+  // thread has its own current context
+  TUVOK_THREAD_LOCAL const void* pLastContext = NULL;
+  TUVOK_THREAD_LOCAL GLStateManager* pLastManager = NULL;
+  TUVOK_THREAD_LOCAL uint64_t iLastGeneration = 0;
+}
+
 GLenum BLEND_FUNCToGL(const BLEND_FUNC& func) {
   switch (func) {
     case BF_ZERO : return  GL_ZERO; break;
@@ -118,6 +170,9 @@ DEPTH_FUNC GLToDEPTH_FUNC(const GLenum& func) {
 void GLStateManager::Apply(const GPUState& state, bool bForce) {
   GL_CHECK();
 
+  // a forced apply means someone else touched the GL state
+  if (bForce) InvalidateTextureState();
+
   SetEnableDepthTest(state.enableDepthTest, bForce);
   SetDepthFunc(state.depthFunc, bForce);
   SetEnableCullFace(state.enableCullFace, bForce);
@@ -188,6 +243,9 @@ void GLStateManager::GetFromOpenGL()
   m_InternalState.enableBlend         = glIsEnabled(GL_BLEND) != 0;
   m_InternalState.enableScissor       = glIsEnabled(GL_SCISSOR_TEST) != 0;
   m_InternalState.enableLighting      = glIsEnabled(GL_LIGHTING) != 0;
+
+  glGetIntegerv(GL_ACTIVE_TEXTURE, &e);
+  m_InternalState.activeTexUnit = size_t(e - GL_TEXTURE0);
   m_InternalState.enableColorMaterial = glIsEnabled(GL_COLOR_MATERIAL) != 0;
 
   for(size_t i=0; i < StateLightCount; ++i) {
@@ -205,6 +263,7 @@ void GLStateManager::GetFromOpenGL()
       m_InternalState.enableTex[i] = TEX_NONE;
     }
   }
+  glActiveTexture(GLenum(GL_TEXTURE0 + m_InternalState.activeTexUnit));
   GLboolean	 b;
   glGetBooleanv(GL_DEPTH_WRITEMASK, &b);
   m_InternalState.depthMask = b != 0;
@@ -227,6 +286,12 @@ void GLStateManager::GetFromOpenGL()
   glGetFloatv(GL_LINE_WIDTH, &f); 
   m_InternalState.lineWidth = f;
 
+  GLint iAlignment;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &iAlignment);
+  m_iPackAlignment = iAlignment;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &iAlignment);
+  m_iUnpackAlignment = iAlignment;
+
   GL_CHECK();
 }
 
@@ -345,9 +410,11 @@ void GLStateManager::SetEnableTex(size_t i, const STATE_TEX& value, bool bForce)
 }
 
 void GLStateManager::SetActiveTexUnit(const size_t iUnit, bool bForce) {
-  if (bForce || iUnit != m_InternalState.activeTexUnit) {
+  if (bForce || !m_bCaching || iUnit != m_InternalState.activeTexUnit) {
     m_InternalState.activeTexUnit = iUnit;
     glActiveTexture(GLenum(GL_TEXTURE0 + m_InternalState.activeTexUnit));
+  } else {
+    ++m_iRedundantCallsAvoided;
   }
 }
 
@@ -389,6 +456,176 @@ void GLStateManager::SetLineWidth(const float value, bool bForce) {
   }
 }
 
-GLStateManager::GLStateManager() : StateManager() {
+int GLStateManager::TargetIndex(GLenum target) {
+  switch (target) {
+    case GL_TEXTURE_1D : return 0;
+    case GL_TEXTURE_2D : return 1;
+    case GL_TEXTURE_3D : return 2;
+  }
+  return -1;
+}
+
+GLenum GLStateManager::TargetBinding(GLenum target) {
+  switch (target) {
+    case GL_TEXTURE_1D : return GL_TEXTURE_BINDING_1D;
+    case GL_TEXTURE_2D : return GL_TEXTURE_BINDING_2D;
+    case GL_TEXTURE_3D : return GL_TEXTURE_BINDING_3D;
+  }
+  assert(false && "unsupported texture target");
+  return GL_TEXTURE_BINDING_2D;
+}
+
+void GLStateManager::SetPixelStore(GLenum pname, GLint value, bool bForce) {
+  GLint* pCached = NULL;
+  switch (pname) {
+    case GL_PACK_ALIGNMENT   : pCached = &m_iPackAlignment; break;
+    case GL_UNPACK_ALIGNMENT : pCached = &m_iUnpackAlignment; break;
+  }
+  if (pCached && m_bCaching && !bForce && *pCached == value) {
+    ++m_iRedundantCallsAvoided;
+    return;
+  }
+  glPixelStorei(pname, value);
+  if (pCached && m_bCaching) *pCached = value;
+}
+
+size_t GLStateManager::GetActiveTexUnit() {
+  if (m_bCaching) {
+    ++m_iRedundantCallsAvoided;
+  } else {
+    GLint iUnit;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &iUnit);
+    m_InternalState.activeTexUnit = size_t(iUnit - GL_TEXTURE0);
+  }
+  return m_InternalState.activeTexUnit;
+}
+
+void GLStateManager::BindTexture(GLenum target, GLuint iTexture, bool bForce) {
+  const int iTarget = TargetIndex(target);
+  const size_t iUnit = m_InternalState.activeTexUnit;
+  if (!m_bCaching || iTarget < 0 || iUnit >= iMaxCachedTexUnits) {
+    GL(glBindTexture(target, iTexture));
+    return;
+  }
+  if (!bForce && m_iBoundTex[iUnit][iTarget] == iTexture) {
+    ++m_iRedundantCallsAvoided;
+    return;
+  }
+  GL(glBindTexture(target, iTexture));
+  m_iBoundTex[iUnit][iTarget] = iTexture;
+}
+
+GLuint GLStateManager::GetBoundTexture(GLenum target) {
+  const int iTarget = TargetIndex(target);
+  const size_t iUnit = m_InternalState.activeTexUnit;
+  const bool bCached = m_bCaching && iTarget >= 0 &&
+                       iUnit < iMaxCachedTexUnits;
+  if (bCached && m_iBoundTex[iUnit][iTarget] != iUnknownBinding) {
+    ++m_iRedundantCallsAvoided;
+    return m_iBoundTex[iUnit][iTarget];
+  }
+  GLint iTexture = 0;
+  glGetIntegerv(TargetBinding(target), &iTexture);
+  if (bCached) m_iBoundTex[iUnit][iTarget] = GLuint(iTexture);
+  return GLuint(iTexture);
+}
+
+void GLStateManager::TexturesDeleted(GLsizei iCount, const GLuint* pTextures) {
+  // texture names are shared between contexts and may be reused, so the
+  // stale bindings have to go from all managers
+  SCOPEDLOCK(ManagersGuard());
+  for (ManagerMap::const_iterator m = Managers().begin();
+       m != Managers().end(); ++m) {
+    for (size_t u = 0;u<iMaxCachedTexUnits;u++) {
+      for (size_t t = 0;t<3;t++) {
+        GLuint& iBound = m->second->m_iBoundTex[u][t];
+        if (std::find(pTextures, pTextures+iCount, iBound) !=
+            pTextures+iCount) {
+          iBound = (m->second == this) ? 0 : iUnknownBinding;
+        }
+      }
+    }
+  }
+}
+
+void GLStateManager::InvalidateTextureState() {
+  m_iPackAlignment = 0;
+  m_iUnpackAlignment = 0;
+  for (size_t u = 0;u<iMaxCachedTexUnits;u++) {
+    for (size_t t = 0;t<3;t++) {
+      m_iBoundTex[u][t] = iUnknownBinding;
+    }
+  }
+}
+
+const void* GLStateManager::CurrentNativeContext() {
+#ifdef DETECTED_OS_WINDOWS
+  return wglGetCurrentContext();
+#elif defined(DETECTED_OS_APPLE)
+  return CGLGetCurrentContext();
+#else
+  const void* pContext = NULL;
+# ifndef TUVOK_NO_GLX
+  pContext = glXGetCurrentContext();
+# endif
+# ifdef TUVOK_HAVE_EGL
+  if (!pContext) pContext = eglGetCurrentContext();
+# endif
+# ifdef TUVOK_HAVE_OSMESA
+  if (!pContext) pContext = OSMesaGetCurrentContext();
+# endif
+  return pContext;
+#endif
+}
+
+GLStateManager& GLStateManager::Current() {
+  static GLStateManager passThrough(false);
+
+  const void* pContext = CurrentNativeContext();
+  const uint64_t iGeneration =
+    iManagersGeneration.load(std::memory_order_acquire);
+  if (pContext != pLastContext || iGeneration != iLastGeneration) {
+    SCOPEDLOCK(ManagersGuard());
+    ManagerMap::const_iterator m = Managers().find(pContext);
+    pLastContext = pContext;
+    pLastManager = (m == Managers().end()) ? NULL : m->second;
+    iLastGeneration = iGeneration;
+  }
+  return pLastManager ? *pLastManager : passThrough;
+}
+
+GLStateManager::GLStateManager() :
+  StateManager(),
+  m_bCaching(true),
+  m_pNativeContext(CurrentNativeContext()),
+  m_iPackAlignment(0),
+  m_iUnpackAlignment(0),
+  m_iRedundantCallsAvoided(0)
+{
+  InvalidateTextureState();
   GetFromOpenGL();
+  // the latest manager for a context wins, e.g. if a context was recreated
+  // without destroying its old manager first
+  SCOPEDLOCK(ManagersGuard());
+  Managers()[m_pNativeContext] = this;
+  iManagersGeneration.fetch_add(1, std::memory_order_release);
+}
+
+GLStateManager::GLStateManager(bool bCaching) :
+  StateManager(),
+  m_bCaching(bCaching),
+  m_pNativeContext(NULL),
+  m_iPackAlignment(0),
+  m_iUnpackAlignment(0),
+  m_iRedundantCallsAvoided(0)
+{
+  InvalidateTextureState();
+}
+
+GLStateManager::~GLStateManager() {
+  if (!m_bCaching) return;
+  SCOPEDLOCK(ManagersGuard());
+  ManagerMap::iterator m = Managers().find(m_pNativeContext);
+  if (m != Managers().end() && m->second == this) Managers().erase(m);
+  iManagersGeneration.fetch_add(1, std::memory_order_release);
 }
@@ -32,6 +32,7 @@
 
 #include "../StateManager.h"
 #include "StdTuvokDefines.h"
+#include "GLInclude.h"
 
 namespace tuvok {
 
@@ -42,6 +43,7 @@ namespace tuvok {
   class GLStateManager : public StateManager {
     public:
       GLStateManager();
+      virtual ~GLStateManager();
      
       virtual void Apply(const GPUState& state, bool bForce=false);
 
@@ -62,9 +64,63 @@ namespace tuvok {
       virtual void SetBlendFunction(const BLEND_FUNC src, const BLEND_FUNC dest, bool bForce=false);
       virtual void SetLineWidth(const float value, bool bForce=false);
 
+      /** Pixel store state and texture bindings are changed by the GL
+       * resources themselves rather than through a GPUState.  They are
+       * cached here so that uploads neither re-set unchanged state nor need
+       * to glGet the previous binding to restore it. */
+      ///@{
+      /// sets GL_PACK_ALIGNMENT or GL_UNPACK_ALIGNMENT
+      void SetPixelStore(GLenum pname, GLint value, bool bForce=false);
+      /// the active texture unit, only queried from GL when not caching
+      size_t GetActiveTexUnit();
+      /// binds iTexture to target on the active texture unit
+      void BindTexture(GLenum target, GLuint iTexture, bool bForce=false);
+      /// the texture bound to target on the active texture unit
+      GLuint GetBoundTexture(GLenum target);
+      /// GL unbinds deleted textures, call this after glDeleteTextures
+      void TexturesDeleted(GLsizei iCount, const GLuint* pTextures);
+      /// forgets the cached pixel store and bindings, use this when code
+      /// outside of tuvok may have changed them
+      void InvalidateTextureState();
+      ///@}
+
+      /// number of GL calls and queries skipped because the state was known
+      uint64_t GetRedundantCallsAvoided() const {
+        return m_iRedundantCallsAvoided;
+      }
+
+      /** The state manager of the GL context current on this thread.  If
+       * the current context has no state manager a pass-through manager is
+       * returned which forwards every call to GL. */
+      static GLStateManager& Current();
+      /// The window system's context current on this thread, NULL if none.
+      /// Headless builds also look for EGL and OSMesa contexts.
+      static const void* CurrentNativeContext();
+
   protected:
       void GetFromOpenGL();
 
+  private:
+      /// creates the pass-through manager used without a known context
+      explicit GLStateManager(bool bCaching);
+
+      static const size_t iMaxCachedTexUnits = 32;
+      static const GLuint iUnknownBinding = GLuint(-1);
+
+      /// index into m_iBoundTex for target, or -1 if the target is not cached
+      static int TargetIndex(GLenum target);
+      static GLenum TargetBinding(GLenum target);
+
+      bool m_bCaching;
+      /// the native context this manager tracks the state of
+      const void* m_pNativeContext;
+      /// current pack and unpack alignment, 0 if unknown
+      GLint m_iPackAlignment;
+      GLint m_iUnpackAlignment;
+      /// 1D, 2D and 3D texture bound to each unit, iUnknownBinding if unknown
+      GLuint m_iBoundTex[iMaxCachedTexUnits][3];
+      uint64_t m_iRedundantCallsAvoided;
+
   };
 
 } //namespace tuvok
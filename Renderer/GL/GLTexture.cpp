@@ -39,6 +39,8 @@
 #include <cassert>
 
 #include "GLSLProgram.h"
+#include "GLStateManager.h"
+#include "GLTextureReadback.h"
 
 using namespace tuvok;
 
@@ -64,6 +66,7 @@ GLTexture::~GLTexture() {
 
 void GLTexture::Delete() {
   glDeleteTextures(1,&m_iGLID);
+  GLStateManager::Current().TexturesDeleted(1, &m_iGLID);
   m_iGLID = UINT32_INVALID;
 }
 
@@ -80,3 +83,61 @@ void GLTexture::SetFilter(GLint iMagFilter, GLint iMinFilter) {
 size_t GLTexture::SizePerElement() const {
   return GLCommon::gl_byte_width(m_type) * GLCommon::gl_components(m_format);
 }
+
+std::shared_ptr<void> GLTexture::GetData() {
+  return ReadbackAsync()->Get();
+}
+
+std::shared_ptr<GLTextureReadback>
+GLTexture::ReadbackAsync(std::shared_ptr<void> pDest) {
+  return ReadbackAsync(UINTVECTOR3(0,0,0), Extent(), pDest);
+}
+
+std::shared_ptr<GLTextureReadback>
+GLTexture::ReadbackAsync(const UINTVECTOR3& vOffset, const UINTVECTOR3& vSize,
+                         std::shared_ptr<void> pDest) {
+  const UINTVECTOR3 vExtent = Extent();
+  assert(vOffset.x + vSize.x <= vExtent.x &&
+         vOffset.y + vSize.y <= vExtent.y &&
+         vOffset.z + vSize.z <= vExtent.z);
+
+  std::shared_ptr<GLTextureReadback> readback(
+    new GLTextureReadback(vExtent, vOffset, vSize, SizePerElement(), pDest)
+  );
+
+  SetPixelAlignment();
+  BindForUpdate(Target(), false);
+  readback->Start(Target(), m_format, m_type);
+  return readback;
+}
+
+GLuint GLTexture::BindForUpdate(GLenum target, bool bRestoreBinding) const {
+  GLStateManager& state = GLStateManager::Current();
+  const GLuint iPrevTex = bRestoreBinding ? state.GetBoundTexture(target)
+                                          : m_iGLID;
+  state.BindTexture(target, m_iGLID);
+  return iPrevTex;
+}
+
+void GLTexture::RestoreBinding(GLenum target, GLuint iPrevTex) const {
+  if (iPrevTex != m_iGLID) GLStateManager::Current().BindTexture(target, iPrevTex);
+}
+
+void GLTexture::BindToUnit(GLenum target, uint32_t iUnit) const {
+  GLStateManager& state = GLStateManager::Current();
+  const size_t iPrevUnit = state.GetActiveTexUnit();
+
+  state.SetActiveTexUnit(iUnit);
+  state.BindTexture(target, m_iGLID);
+
+  GL(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, m_iMagFilter));
+  GL(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, m_iMinFilter));
+
+  state.SetActiveTexUnit(iPrevUnit);
+}
+
+void GLTexture::SetPixelAlignment() {
+  GLStateManager& state = GLStateManager::Current();
+  state.SetPixelStore(GL_PACK_ALIGNMENT, 1);
+  state.SetPixelStore(GL_UNPACK_ALIGNMENT, 1);
+}
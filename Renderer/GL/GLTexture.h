@@ -40,12 +40,15 @@
 #define TUVOK_GLTEXTURE_H
 
 #include "../../StdTuvokDefines.h"
+#include <memory>
 #include <string>
 #include "GLObject.h"
+#include "Basics/Vectors.h"
 
 namespace tuvok {
 
 class GLSLProgram;
+class GLTextureReadback;
 
 /** \class GLTexture
  * Abstracted texture usage.
@@ -80,8 +83,20 @@ class GLTexture : public GLObject {
     /** \return The OpenGL identifier for this texture. */
     GLuint GetGLID() const {return m_iGLID;}
 
-    /// expensive read back of texture data
-    virtual std::shared_ptr<void> GetData() = 0;
+    /// expensive read back of texture data, waits for the GPU
+    std::shared_ptr<void> GetData();
+
+    /** Starts reading back the texture without waiting for the GPU.
+     * \param pDest memory for the data, e.g. the result of an earlier
+     *        read back; allocated by the read back if NULL
+     * \return handle to wait for and fetch the data */
+    std::shared_ptr<GLTextureReadback>
+    ReadbackAsync(std::shared_ptr<void> pDest=std::shared_ptr<void>());
+    /// reads back the region of vSize texels starting at vOffset, unused
+    /// dimensions have offset 0 and size 1
+    std::shared_ptr<GLTextureReadback>
+    ReadbackAsync(const UINTVECTOR3& vOffset, const UINTVECTOR3& vSize,
+                  std::shared_ptr<void> pDest=std::shared_ptr<void>());
 
   protected:
     GLuint m_iGLID;
@@ -92,6 +107,22 @@ class GLTexture : public GLObject {
     GLenum m_type;
 
     size_t SizePerElement() const;
+
+    /// GL_TEXTURE_1D, GL_TEXTURE_2D or GL_TEXTURE_3D
+    virtual GLenum Target() const = 0;
+    /// size of the texture, unused dimensions are 1
+    virtual UINTVECTOR3 Extent() const = 0;
+
+    /** Binds this texture to target on the active unit so it can be
+     * modified.
+     * \return the texture to pass to RestoreBinding afterwards */
+    GLuint BindForUpdate(GLenum target, bool bRestoreBinding) const;
+    /// rebinds the texture that was bound before BindForUpdate
+    void RestoreBinding(GLenum target, GLuint iPrevTex) const;
+    /// binds to the given unit and sets the filter mode, keeps the active unit
+    void BindToUnit(GLenum target, uint32_t iUnit) const;
+    /// sets tightly packed rows for uploads and readbacks
+    static void SetPixelAlignment();
 };
 }
 #endif // TUVOK_GLTEXTURE_H
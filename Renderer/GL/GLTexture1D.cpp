@@ -49,10 +49,9 @@ GLTexture1D::GLTexture1D(uint32_t iSize, GLint internalformat, GLenum format,
   m_iSize(GLuint(iSize))
 {
   GL(glGenTextures(1, &m_iGLID));
-  GL(glBindTexture(GL_TEXTURE_1D, m_iGLID));
+  BindForUpdate(GL_TEXTURE_1D, false);
 
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  SetPixelAlignment();
 
   GL(glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, wrap));
   GL(glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, iMagFilter));
@@ -62,50 +61,25 @@ GLTexture1D::GLTexture1D(uint32_t iSize, GLint internalformat, GLenum format,
 }
 
 void GLTexture1D::SetData(uint32_t offset, uint32_t size, const void *pixels, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  SetPixelAlignment();
 
-  GLint prevTex=0;
-  if (bRestoreBinding) {
-    GL(glGetIntegerv(GL_TEXTURE_BINDING_1D, &prevTex));
-    if (GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_1D, m_iGLID));
-  } else {
-    GL(glBindTexture(GL_TEXTURE_1D, m_iGLID));
-  }
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_1D, bRestoreBinding);
 
   GL(glTexSubImage1D(GL_TEXTURE_1D, 0, 
                      offset,
                      size,
                      m_format, m_type, (GLvoid*)pixels));
 
-  if (bRestoreBinding && GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_1D, GLuint(prevTex)));
+  RestoreBinding(GL_TEXTURE_1D, prevTex);
 }
 
 void GLTexture1D::SetData(const void *pixels, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  SetPixelAlignment();
 
-  GLint prevTex=0;
-  if (bRestoreBinding) {
-    GL(glGetIntegerv(GL_TEXTURE_BINDING_1D, &prevTex));
-    if (GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_1D, m_iGLID));
-  } else {
-    GL(glBindTexture(GL_TEXTURE_1D, m_iGLID));
-  }
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_1D, bRestoreBinding);
 
   GL(glTexImage1D(GL_TEXTURE_1D, 0, m_internalformat, m_iSize, 0, m_format,
                   m_type, (GLvoid*)pixels));
 
-  if (bRestoreBinding && GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_1D, GLuint(prevTex)));
-}
-
-std::shared_ptr<void> GLTexture1D::GetData() {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-  GL(glBindTexture(GL_TEXTURE_1D, m_iGLID));
-
-  const size_t sz = m_iSize * this->SizePerElement();
-  std::shared_ptr<void> data(new char[sz]);
-  GL(glGetTexImage(GL_TEXTURE_1D, 0, m_format, m_type, data.get()));
-  return data;
+  RestoreBinding(GL_TEXTURE_1D, prevTex);
 }
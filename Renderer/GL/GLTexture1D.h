@@ -52,23 +52,12 @@ class GLTexture1D : public GLTexture {
     virtual ~GLTexture1D() {}
 
     virtual void Bind(uint32_t iUnit=0) const {
-      GLint iPrevUint;
-      GL(glGetIntegerv(GL_ACTIVE_TEXTURE, &iPrevUint));
-
-      GL(glActiveTexture(GLenum(GL_TEXTURE0 + iUnit)));
-      GL(glBindTexture(GL_TEXTURE_1D, m_iGLID));
-
-      GL(glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, m_iMagFilter));
-      GL(glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, m_iMinFilter));
-
-      GL(glActiveTexture(iPrevUint));
+      BindToUnit(GL_TEXTURE_1D, iUnit);
     }
     virtual void SetData(const void *pixels, bool bRestoreBinding=true);
     void SetData(uint32_t offset, uint32_t size, const void *pixels,
                  bool bRestoreBinding=true);
 
-    virtual std::shared_ptr<void> GetData();
-
     virtual uint64_t GetCPUSize() const {
       return uint64_t(m_iSize*SizePerElement());
     }
@@ -79,6 +68,11 @@ class GLTexture1D : public GLTexture {
     uint32_t GetSize() const {return uint32_t(m_iSize);}
 
   protected:
+    virtual GLenum Target() const {return GL_TEXTURE_1D;}
+    virtual UINTVECTOR3 Extent() const {
+      return UINTVECTOR3(uint32_t(m_iSize), 1, 1);
+    }
+
     GLuint m_iSize;
 };
 }
@@ -51,14 +51,10 @@ GLTexture2D::GLTexture2D(uint32_t iSizeX, uint32_t iSizeY, GLint internalformat,
   m_iSizeX(GLuint(iSizeX)),
   m_iSizeY(GLuint(iSizeY))
 {
-  GLint prevTex;
-  GL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex));
-
   GL(glGenTextures(1, &m_iGLID));
-  GL(glBindTexture(GL_TEXTURE_2D, m_iGLID));
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_2D, true);
 
-  GL(glPixelStorei(GL_PACK_ALIGNMENT ,1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
+  SetPixelAlignment();
 
   GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapX));
   GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapY));
@@ -68,46 +64,27 @@ GLTexture2D::GLTexture2D(uint32_t iSizeX, uint32_t iSizeY, GLint internalformat,
                   GLuint(m_iSizeX),GLuint(m_iSizeY), 0, m_format, m_type,
                   (GLvoid*)pixels));
 
-  GL(glBindTexture(GL_TEXTURE_2D, prevTex));
+  RestoreBinding(GL_TEXTURE_2D, prevTex);
 }
 
 void GLTexture2D::SetData(const UINTVECTOR2& offset, const UINTVECTOR2& size, const void *pixels, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT ,1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
-
-  GLint prevTex=0;
-  if (bRestoreBinding) GL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex));
+  SetPixelAlignment();
 
-  GL(glBindTexture(GL_TEXTURE_2D, m_iGLID));
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_2D, bRestoreBinding);
   GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 
                      offset.x, offset.y,
                      size.x, size.y,
                      m_format, m_type, (GLvoid*)pixels));
 
-  if (bRestoreBinding && GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_2D, prevTex));
+  RestoreBinding(GL_TEXTURE_2D, prevTex);
 }
 
 void GLTexture2D::SetData(const void *pixels, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT ,1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
-
-  GLint prevTex=0;
-  if (bRestoreBinding) GL(glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex));
+  SetPixelAlignment();
 
-  GL(glBindTexture(GL_TEXTURE_2D, m_iGLID));
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_2D, bRestoreBinding);
   GL(glTexImage2D(GL_TEXTURE_2D, 0, m_internalformat, m_iSizeX, m_iSizeY,
                   0, m_format, m_type, (GLvoid*)pixels));
 
-  if (bRestoreBinding && GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_2D, prevTex));
-}
-
-std::shared_ptr<void> GLTexture2D::GetData() {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-  GL(glBindTexture(GL_TEXTURE_2D, m_iGLID));
-
-  const size_t sz = m_iSizeX * m_iSizeY * SizePerElement();
-  std::shared_ptr<void> data(new char[sz]);
-  GL(glGetTexImage(GL_TEXTURE_2D, 0, m_format, m_type, data.get()));
-  return data;
+  RestoreBinding(GL_TEXTURE_2D, prevTex);
 }
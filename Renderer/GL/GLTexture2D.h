@@ -55,24 +55,13 @@ class GLTexture2D : public GLTexture {
     virtual ~GLTexture2D() {}
 
     virtual void Bind(uint32_t iUnit=0) const {
-      GLint iPrevUint;
-      GL(glGetIntegerv(GL_ACTIVE_TEXTURE, &iPrevUint));
-
-      GL(glActiveTexture(GLenum(GL_TEXTURE0 + iUnit)));
-      GL(glBindTexture(GL_TEXTURE_2D, m_iGLID));
-
-      GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_iMagFilter));
-      GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_iMinFilter));
-
-      GL(glActiveTexture(iPrevUint));
+      BindToUnit(GL_TEXTURE_2D, iUnit);
     }
 
     virtual void SetData(const void *pixels, bool bRestoreBinding=true);
     void SetData(const UINTVECTOR2& offset, const UINTVECTOR2& size,
                  const void *pixels, bool bRestoreBinding=true);
 
-    virtual std::shared_ptr<void> GetData();
-
     virtual uint64_t GetCPUSize() const {
       return uint64_t(m_iSizeX*m_iSizeY*SizePerElement());
     }
@@ -85,6 +74,11 @@ class GLTexture2D : public GLTexture {
     }
 
   protected:
+    virtual GLenum Target() const {return GL_TEXTURE_2D;}
+    virtual UINTVECTOR3 Extent() const {
+      return UINTVECTOR3(uint32_t(m_iSizeX), uint32_t(m_iSizeY), 1);
+    }
+
     GLuint m_iSizeX;
     GLuint m_iSizeY;
 };
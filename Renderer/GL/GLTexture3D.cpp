@@ -50,11 +50,8 @@ GLTexture3D::GLTexture3D(uint32_t iSizeX, uint32_t iSizeY, uint32_t iSizeZ,
   m_iSizeY(GLuint(iSizeY)),
   m_iSizeZ(GLuint(iSizeZ))
 {
-  GLint prevTex;
-  GL(glGetIntegerv(GL_TEXTURE_BINDING_3D, &prevTex));
-
   GL(glGenTextures(1, &m_iGLID));
-  GL(glBindTexture(GL_TEXTURE_3D, m_iGLID));
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_3D, true);
 
   GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, wrapX));
   GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, wrapY));
@@ -62,8 +59,7 @@ GLTexture3D::GLTexture3D(uint32_t iSizeX, uint32_t iSizeY, uint32_t iSizeZ,
   GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, iMagFilter));
   GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, iMinFilter));
 
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  SetPixelAlignment();
 
   glTexImage3D(GL_TEXTURE_3D, 0, m_internalformat,
                m_iSizeX, m_iSizeY, m_iSizeZ,
@@ -77,34 +73,26 @@ GLTexture3D::GLTexture3D(uint32_t iSizeX, uint32_t iSizeY, uint32_t iSizeZ,
             static_cast<unsigned int>(err));
   }
 
-  GL(glBindTexture(GL_TEXTURE_3D, prevTex));
+  RestoreBinding(GL_TEXTURE_3D, prevTex);
 }
 
 void GLTexture3D::SetData(const UINTVECTOR3& offset, const UINTVECTOR3& size,
                           const void *pixels, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-
-  GLint prevTex=0;
-  if (bRestoreBinding) GL(glGetIntegerv(GL_TEXTURE_BINDING_3D, &prevTex));
+  SetPixelAlignment();
 
-  GL(glBindTexture(GL_TEXTURE_3D, m_iGLID));
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_3D, bRestoreBinding);
   GL(glTexSubImage3D(GL_TEXTURE_3D, 0, 
                      offset.x, offset.y, offset.z,
                      size.x, size.y, size.z,
                      m_format, m_type, (GLvoid*)pixels));
 
-  if (bRestoreBinding && GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_3D, prevTex));
+  RestoreBinding(GL_TEXTURE_3D, prevTex);
 }
 
 void GLTexture3D::SetData(const void *pixels, bool bRestoreBinding) {
-  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-
-  GLint prevTex=0;
-  if (bRestoreBinding) GL(glGetIntegerv(GL_TEXTURE_BINDING_3D, &prevTex));
+  SetPixelAlignment();
 
-  GL(glBindTexture(GL_TEXTURE_3D, m_iGLID));
+  const GLuint prevTex = BindForUpdate(GL_TEXTURE_3D, bRestoreBinding);
   glTexImage3D(GL_TEXTURE_3D, 0, m_internalformat,
                m_iSizeX, m_iSizeY, m_iSizeZ,
                0, m_format, m_type, (GLvoid*)pixels);
@@ -117,17 +105,5 @@ void GLTexture3D::SetData(const void *pixels, bool bRestoreBinding) {
             static_cast<unsigned int>(err));
   }
 
-  if (bRestoreBinding && GLuint(prevTex) != m_iGLID) GL(glBindTexture(GL_TEXTURE_3D, prevTex));
-}
-
-std::shared_ptr<void> GLTexture3D::GetData()
-{
-  GL(glPixelStorei(GL_PACK_ALIGNMENT ,1));
-  GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
-  GL(glBindTexture(GL_TEXTURE_3D, m_iGLID));
-
-  const size_t sz = m_iSizeX * m_iSizeY * m_iSizeZ * SizePerElement();
-  std::shared_ptr<void> data(new char[sz]);
-  GL(glGetTexImage(GL_TEXTURE_3D, 0, m_format, m_type, data.get()));
-  return data;
+  RestoreBinding(GL_TEXTURE_3D, prevTex);
 }
@@ -58,24 +58,13 @@ class GLTexture3D : public GLTexture {
     virtual ~GLTexture3D() {}
 
     virtual void Bind(uint32_t iUnit=0) const {
-      GLint iPrevUint;
-      GL(glGetIntegerv(GL_ACTIVE_TEXTURE, &iPrevUint));
-
-      GL(glActiveTexture(GLenum(GL_TEXTURE0 + iUnit)));
-      GL(glBindTexture(GL_TEXTURE_3D, m_iGLID));
-
-      GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, m_iMagFilter));
-      GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, m_iMinFilter));
-
-      GL(glActiveTexture(iPrevUint));
+      BindToUnit(GL_TEXTURE_3D, iUnit);
     }
     
     virtual void SetData(const void *pixels, bool bRestoreBinding=true);
     void SetData(const UINTVECTOR3& offset, const UINTVECTOR3& size,
                  const void *pixels, bool bRestoreBinding=true);
 
-    virtual std::shared_ptr<void> GetData();
-
     virtual uint64_t GetCPUSize() const {
       return uint64_t(m_iSizeX*m_iSizeY*m_iSizeZ*SizePerElement());
     }
@@ -89,6 +78,11 @@ class GLTexture3D : public GLTexture {
     }
 
   protected:
+    virtual GLenum Target() const {return GL_TEXTURE_3D;}
+    virtual UINTVECTOR3 Extent() const {
+      return GetSize();
+    }
+
     GLuint m_iSizeX;
     GLuint m_iSizeY;
     GLuint m_iSizeZ;
@@ -0,0 +1,219 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLTextureReadback.cpp
+*/
+
+#include "GLTextureReadback.h"
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include "Basics/nonstd.h"
+
+using namespace tuvok;
+
+namespace {
+  size_t Voxels(const UINTVECTOR3& v) {
+    return size_t(v.x) * size_t(v.y) * size_t(v.z);
+  }
+}
+
+GLTextureReadback::GLTextureReadback(const UINTVECTOR3& vExtent,
+                                     const UINTVECTOR3& vOffset,
+                                     const UINTVECTOR3& vSize,
+                                     size_t iElementSize,
+                                     std::shared_ptr<void> pDest) :
+  m_vExtent(vExtent),
+  m_vOffset(vOffset),
+  m_vSize(vSize),
+  m_iElementSize(iElementSize),
+  m_pDest(pDest),
+  m_iPBO(0),
+  m_iPBOSize(0),
+  m_Sync(0),
+  m_bDone(false)
+{
+  if (!m_pDest) {
+    m_pDest = std::shared_ptr<void>(new char[GetSize()],
+                                    nonstd::DeleteArray<char>());
+  }
+}
+
+GLTextureReadback::~GLTextureReadback() {
+  Release();
+}
+
+size_t GLTextureReadback::GetSize() const {
+  return Voxels(m_vSize) * m_iElementSize;
+}
+
+bool GLTextureReadback::Restart(const UINTVECTOR3& vExtent,
+                                const UINTVECTOR3& vOffset,
+                                const UINTVECTOR3& vSize,
+                                size_t iElementSize) {
+  if (vExtent != m_vExtent || vSize != m_vSize ||
+      iElementSize != m_iElementSize) {
+    return false;
+  }
+  ReleaseSync();
+  m_vOffset = vOffset;
+  m_bDone = false;
+  return true;
+}
+
+void GLTextureReadback::BindPBO(size_t iBytes) {
+  if (!m_iPBO) GL(glGenBuffers(1, &m_iPBO));
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_iPBO));
+  if (m_iPBOSize != iBytes) {
+    GL(glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(iBytes), NULL,
+                    GL_STREAM_READ));
+    m_iPBOSize = iBytes;
+  }
+}
+
+void GLTextureReadback::Start(GLenum target, GLenum format, GLenum type) {
+  const bool bFullRead = m_vSize == m_vExtent;
+
+  if (!GLEW_VERSION_2_1 && !GLEW_ARB_pixel_buffer_object) {
+    // no way to read asynchronously, so at least do not stall twice
+    if (bFullRead) {
+      GL(glGetTexImage(target, 0, format, type, m_pDest.get()));
+    } else {
+      std::vector<char> full(Voxels(m_vExtent) * m_iElementSize);
+      GL(glGetTexImage(target, 0, format, type, &full[0]));
+      CopyRegion(&full[0]);
+    }
+    m_bDone = true;
+    return;
+  }
+
+  // glGetTexImage has no notion of sub regions, so the full level goes into
+  // the PBO and the region is cut out when the buffer is mapped
+  BindPBO(Voxels(m_vExtent) * m_iElementSize);
+  GL(glGetTexImage(target, 0, format, type, NULL));
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  Fence();
+}
+
+void GLTextureReadback::StartReadPixels(GLint x, GLint y, GLenum format,
+                                        GLenum type) {
+  assert(m_vSize == m_vExtent);
+
+  if (!GLEW_VERSION_2_1 && !GLEW_ARB_pixel_buffer_object) {
+    GL(glReadPixels(x, y, m_vSize.x, m_vSize.y, format, type, m_pDest.get()));
+    m_bDone = true;
+    return;
+  }
+
+  BindPBO(GetSize());
+  GL(glReadPixels(x, y, m_vSize.x, m_vSize.y, format, type, NULL));
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  Fence();
+}
+
+void GLTextureReadback::Fence() {
+  if (GLEW_VERSION_3_2 || GLEW_ARB_sync) {
+    m_Sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+bool GLTextureReadback::IsReady() {
+  return Wait(0);
+}
+
+bool GLTextureReadback::Wait(uint64_t iTimeoutNs) {
+  // without a fence we cannot tell, mapping the buffer will wait for us
+  if (m_bDone || !m_Sync) return true;
+
+  const GLenum result = glClientWaitSync(m_Sync, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                         iTimeoutNs);
+  if (result == GL_WAIT_FAILED) {
+    WARNING("Waiting for texture read back failed.");
+    return true;
+  }
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+std::shared_ptr<void> GLTextureReadback::Get() {
+  if (m_bDone) return m_pDest;
+
+  // the fence is only an optimization for IsReady; mapping synchronizes
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_iPBO));
+  const void* pMapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (pMapped) {
+    CopyRegion(pMapped);
+    GL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+  } else {
+    T_ERROR("Could not map texture read back buffer.");
+  }
+  GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  // the PBO stays for the next Restart()
+  ReleaseSync();
+  m_bDone = true;
+  return m_pDest;
+}
+
+void GLTextureReadback::CopyRegion(const void* pSource) {
+  const char* pSrc = static_cast<const char*>(pSource);
+  char* pDst = static_cast<char*>(m_pDest.get());
+
+  if (m_vSize == m_vExtent) {
+    memcpy(pDst, pSrc, GetSize());
+    return;
+  }
+
+  const size_t iRowBytes = m_vSize.x * m_iElementSize;
+  for (uint32_t z = 0;z<m_vSize.z;z++) {
+    for (uint32_t y = 0;y<m_vSize.y;y++) {
+      const size_t iSrcIndex =
+        (size_t(m_vOffset.z + z) * m_vExtent.y + (m_vOffset.y + y)) *
+        m_vExtent.x + m_vOffset.x;
+      memcpy(pDst, pSrc + iSrcIndex * m_iElementSize, iRowBytes);
+      pDst += iRowBytes;
+    }
+  }
+}
+
+void GLTextureReadback::ReleaseSync() {
+  if (m_Sync) {
+    glDeleteSync(m_Sync);
+    m_Sync = 0;
+  }
+}
+
+void GLTextureReadback::Release() {
+  ReleaseSync();
+  if (m_iPBO) {
+    GL(glDeleteBuffers(1, &m_iPBO));
+    m_iPBO = 0;
+  }
+}
@@ -0,0 +1,114 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLTextureReadback.h
+  \brief   Pending read back of (a region of) a texture.
+*/
+#pragma once
+
+#ifndef TUVOK_GLTEXTUREREADBACK_H
+#define TUVOK_GLTEXTUREREADBACK_H
+
+#include "../../StdTuvokDefines.h"
+#include <memory>
+#include "GLInclude.h"
+#include "Basics/Vectors.h"
+
+namespace tuvok {
+
+/** \class GLTextureReadback
+ * Handle to a texture read back started with GLTexture::ReadbackAsync or
+ * GLFBOTex::ReadBackPixelsAsync.
+ *
+ * The texture is copied into a pixel pack buffer and a fence is inserted
+ * behind the copy, so the CPU can do other work until the data arrive.
+ * If the GL lacks pixel buffer objects the data are read synchronously and
+ * the handle is ready right away.  The pixel buffer lives as long as the
+ * handle, so a handle that is restarted for every frame does not create
+ * GL objects all the time.  All methods must be called with the context
+ * current that started the read back. */
+class GLTextureReadback {
+  public:
+    ~GLTextureReadback();
+
+    /// true if Get() will not stall on the GPU
+    bool IsReady();
+    /// waits up to iTimeoutNs nanoseconds for the GPU
+    /// \return true if the data have arrived
+    bool Wait(uint64_t iTimeoutNs);
+    /** Waits for the data and copies them to the destination memory.
+     * Calling Get() again returns the same memory without copying.
+     * \return the destination, the requested region tightly packed */
+    std::shared_ptr<void> Get();
+
+    /// size of the requested region in bytes
+    size_t GetSize() const;
+
+  private:
+    friend class GLTexture;
+    friend class GLFBOTex;
+
+    GLTextureReadback(const UINTVECTOR3& vExtent, const UINTVECTOR3& vOffset,
+                      const UINTVECTOR3& vSize, size_t iElementSize,
+                      std::shared_ptr<void> pDest);
+    GLTextureReadback(const GLTextureReadback&); ///< unimplemented
+    GLTextureReadback& operator=(const GLTextureReadback&); ///< unimplemented
+
+    /// Prepares another read of the same size; the destination memory is
+    /// reused, so data previously returned by Get() are overwritten.
+    /// \return false if the sizes differ and a new handle is needed
+    bool Restart(const UINTVECTOR3& vExtent, const UINTVECTOR3& vOffset,
+                 const UINTVECTOR3& vSize, size_t iElementSize);
+    /// issues the read of the texture bound to target into the PBO
+    void Start(GLenum target, GLenum format, GLenum type);
+    /// issues a glReadPixels of m_vSize pixels at (x,y) of the current read
+    /// buffer into the PBO
+    void StartReadPixels(GLint x, GLint y, GLenum format, GLenum type);
+    /// creates the PBO if needed, gives it iBytes of storage and binds it
+    void BindPBO(size_t iBytes);
+    /// inserts the fence behind the read
+    void Fence();
+    /// copies the requested region of the full image in pSource
+    void CopyRegion(const void* pSource);
+    void ReleaseSync();
+    void Release();
+
+    UINTVECTOR3 m_vExtent;
+    UINTVECTOR3 m_vOffset;
+    UINTVECTOR3 m_vSize;
+    size_t      m_iElementSize;
+    std::shared_ptr<void> m_pDest;
+    GLuint      m_iPBO;
+    size_t      m_iPBOSize;   ///< bytes of storage of m_iPBO
+    GLsync      m_Sync;
+    bool        m_bDone;
+};
+
+}
+#endif // TUVOK_GLTEXTUREREADBACK_H
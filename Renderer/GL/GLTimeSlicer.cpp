@@ -0,0 +1,154 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLTimeSlicer.cpp
+*/
+
+#include "GLTimeSlicer.h"
+#include <algorithm>
+#include "Renderer/BrickCostModel.h"
+
+using namespace tuvok;
+
+GLTimeSlicer::GLTimeSlicer() :
+  m_pModel(NULL),
+  m_Queries(8),
+  m_iSlice(0),
+  m_iLastTimestamp(0),
+  m_bHaveLast(false),
+  m_iSliceStart(0),
+  m_bSliceStarted(false),
+  m_fInFlight(0.0),
+  m_iInFlight(0)
+{
+}
+
+bool GLTimeSlicer::IsSupported() {
+  return GLTimerQueryPool::IsSupported();
+}
+
+void GLTimeSlicer::Issue(const Pending& p) {
+  GL(glQueryCounter(p.query, GL_TIMESTAMP));
+  m_Pending.push_back(p);
+}
+
+void GLTimeSlicer::Begin(BrickCostModel& model) {
+  m_pModel = &model;
+  Poll();
+
+  ++m_iSlice;
+  m_bSliceStarted = false;
+  m_fInFlight = 0.0;
+  m_iInFlight = 0;
+
+  Pending p;
+  p.query = m_Queries.New();
+  p.iVoxels = 0;
+  p.fPredicted = 0.0;
+  p.iSlice = m_iSlice;
+  p.bStart = true;
+  Issue(p);
+}
+
+void GLTimeSlicer::BrickSubmitted(uint64_t iVoxels) {
+  Pending p;
+  p.query = m_Queries.New();
+  p.iVoxels = iVoxels;
+  p.fPredicted = m_pModel ? m_pModel->Predict(iVoxels) : 0.0;
+  p.iSlice = m_iSlice;
+  p.bStart = false;
+  m_fInFlight += p.fPredicted;
+  ++m_iInFlight;
+  Issue(p);
+  Poll();
+}
+
+void GLTimeSlicer::Poll() {
+  while (!m_Pending.empty()) {
+    Pending& p = m_Pending.front();
+    GLint iAvailable = 0;
+    GL(glGetQueryObjectiv(p.query, GL_QUERY_RESULT_AVAILABLE, &iAvailable));
+    if (!iAvailable) return;
+
+    GLuint64 iTimestamp = 0;
+    GL(glGetQueryObjectui64v(p.query, GL_QUERY_RESULT, &iTimestamp));
+
+    if (p.bStart) {
+      if (p.iSlice == m_iSlice) {
+        m_iSliceStart = iTimestamp;
+        m_bSliceStarted = true;
+      }
+    } else if (m_bHaveLast && iTimestamp >= m_iLastTimestamp) {
+      if (m_pModel) {
+        m_pModel->AddSample(p.iVoxels,
+                            double(iTimestamp - m_iLastTimestamp) / 1.0e6);
+      }
+    }
+    if (!p.bStart && p.iSlice == m_iSlice) {
+      m_fInFlight = std::max(0.0, m_fInFlight - p.fPredicted);
+      --m_iInFlight;
+    }
+    m_iLastTimestamp = iTimestamp;
+    m_bHaveLast = true;
+
+    m_Queries.Recycle(p.query);
+    m_Pending.pop_front();
+  }
+}
+
+double GLTimeSlicer::PredictedElapsed() const {
+  double fDone = 0.0;
+  if (m_bSliceStarted && m_iLastTimestamp > m_iSliceStart) {
+    fDone = double(m_iLastTimestamp - m_iSliceStart) / 1.0e6;
+  }
+  return fDone + m_fInFlight;
+}
+
+bool GLTimeSlicer::Fits(uint64_t iVoxels, double fBudgetMs) {
+  Poll();
+  // nothing to predict with yet; keep the GPU busy, but only a little ahead
+  if (!m_pModel || !m_pModel->IsTrained()) {
+    return m_iInFlight < UNTRAINED_IN_FLIGHT;
+  }
+  const double fNext = m_pModel ? m_pModel->Predict(iVoxels) : 0.0;
+  return PredictedElapsed() + fNext <= fBudgetMs;
+}
+
+void GLTimeSlicer::Release() {
+  for (std::deque<Pending>::const_iterator p = m_Pending.begin();
+       p != m_Pending.end(); ++p) {
+    m_Queries.Recycle(p->query);
+  }
+  m_Pending.clear();
+  m_Queries.Release();
+  m_bHaveLast = false;
+  m_bSliceStarted = false;
+  m_fInFlight = 0.0;
+  m_iInFlight = 0;
+}
@@ -0,0 +1,116 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLTimeSlicer.h
+  \brief   Frame budget bookkeeping with asynchronous GL timer queries.
+*/
+#pragma once
+
+#ifndef TUVOK_GLTIMESLICER_H
+#define TUVOK_GLTIMESLICER_H
+
+#include "../../StdTuvokDefines.h"
+#include <deque>
+#include "GLInclude.h"
+#include "GLTimerQueryPool.h"
+
+namespace tuvok {
+
+class BrickCostModel;
+
+/** \class GLTimeSlicer
+ * Decides how many bricks fit into a time slice without draining the GL
+ * pipeline.
+ *
+ * A GL_TIMESTAMP query is placed at the start of the slice and behind every
+ * brick.  The difference of two consecutive timestamps is the GPU time of a
+ * brick; it trains the BrickCostModel once the result is available, usually
+ * one or two bricks later.  The elapsed time of the slice is what the GPU
+ * has provably finished plus the model's prediction for the bricks still in
+ * flight.  The slicer never waits for a query: while the model is
+ * untrained, a slice ends once UNTRAINED_IN_FLIGHT of its bricks are not
+ * known to be finished.  All methods need the context current that owns
+ * the queries. */
+class GLTimeSlicer {
+  public:
+    GLTimeSlicer();
+
+    static bool IsSupported();
+
+    /// Starts a new slice; results still pending from the last slice keep
+    /// training the model.
+    void Begin(BrickCostModel& model);
+    /// Must follow the GL commands of each brick.
+    void BrickSubmitted(uint64_t iVoxels);
+    /// Predicted GPU time in ms since Begin() until all submitted bricks
+    /// are done.
+    double PredictedElapsed() const;
+    /// true if a brick with iVoxels voxels is predicted to finish within
+    /// fBudgetMs of Begin().
+    bool Fits(uint64_t iVoxels, double fBudgetMs);
+
+    /// Deletes all queries.
+    void Release();
+
+    /// bricks of a slice that may be unfinished while nothing can be
+    /// predicted yet
+    enum { UNTRAINED_IN_FLIGHT = 2 };
+
+  private:
+    GLTimeSlicer(const GLTimeSlicer&);            ///< unimplemented
+    GLTimeSlicer& operator=(const GLTimeSlicer&); ///< unimplemented
+
+    struct Pending {
+      GLuint   query;
+      uint64_t iVoxels;
+      double   fPredicted; ///< ms, as added to m_fInFlight
+      uint64_t iSlice;
+      bool     bStart;     ///< timestamp at Begin(), not behind a brick
+    };
+
+    void   Issue(const Pending& p);
+    /// Consumes the results that are available.
+    void   Poll();
+
+    BrickCostModel*     m_pModel;
+    std::deque<Pending> m_Pending;
+    GLTimerQueryPool    m_Queries;
+    uint64_t            m_iSlice;
+    GLuint64            m_iLastTimestamp;  ///< ns, last resolved timestamp
+    bool                m_bHaveLast;
+    GLuint64            m_iSliceStart;     ///< ns, GPU time of Begin()
+    bool                m_bSliceStarted;   ///< m_iSliceStart is known
+    double              m_fInFlight;       ///< ms predicted for unresolved
+                                           ///< bricks of this slice
+    uint32_t            m_iInFlight;       ///< unresolved bricks of this
+                                           ///< slice
+};
+
+}
+#endif // TUVOK_GLTIMESLICER_H
@@ -0,0 +1,65 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLTimerQueryPool.cpp
+*/
+
+#include "GLTimerQueryPool.h"
+
+using namespace tuvok;
+
+GLTimerQueryPool::GLTimerQueryPool(size_t iBatch) :
+  m_iBatch(iBatch ? iBatch : 1)
+{
+}
+
+bool GLTimerQueryPool::IsSupported() {
+  return GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+}
+
+GLuint GLTimerQueryPool::New() {
+  if (m_vFree.empty()) {
+    m_vFree.resize(m_iBatch);
+    GL(glGenQueries(GLsizei(m_iBatch), &m_vFree[0]));
+  }
+  GLuint id = m_vFree.back();
+  m_vFree.pop_back();
+  return id;
+}
+
+void GLTimerQueryPool::Recycle(GLuint query) {
+  m_vFree.push_back(query);
+}
+
+void GLTimerQueryPool::Release() {
+  if (!m_vFree.empty() && glDeleteQueries) {
+    GL(glDeleteQueries(GLsizei(m_vFree.size()), &m_vFree[0]));
+  }
+  m_vFree.clear();
+}
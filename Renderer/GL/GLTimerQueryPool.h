@@ -0,0 +1,70 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    GLTimerQueryPool.h
+  \brief   Recycles GL query objects for timer queries.
+*/
+#pragma once
+
+#ifndef TUVOK_GLTIMERQUERYPOOL_H
+#define TUVOK_GLTIMERQUERYPOOL_H
+
+#include "../../StdTuvokDefines.h"
+#include <vector>
+#include "GLInclude.h"
+
+namespace tuvok {
+
+/** \class GLTimerQueryPool
+ * Hands out query objects for glQueryCounter and takes them back once their
+ * results are read, so timing every frame does not create and delete GL
+ * objects all the time.  Queries are generated in batches.  All methods need
+ * the context current that owns the queries. */
+class GLTimerQueryPool {
+  public:
+    explicit GLTimerQueryPool(size_t iBatch=16);
+
+    /// true if the GL has GL_TIMESTAMP queries
+    static bool IsSupported();
+
+    /// A free query, new ones are generated if there is none.
+    GLuint New();
+    /// Returns a query whose result is no longer needed.
+    void Recycle(GLuint query);
+    /// Deletes all recycled queries; queries still handed out are not
+    /// affected.
+    void Release();
+
+  private:
+    const size_t        m_iBatch;
+    std::vector<GLuint> m_vFree;
+};
+
+}
+#endif // TUVOK_GLTIMERQUERYPOOL_H
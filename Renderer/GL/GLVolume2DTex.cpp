@@ -36,6 +36,7 @@
 #include "GLVolume2DTex.h"
 #include "GLTexture2D.h"
 #include "GLCommon.h"
+#include "GLStateManager.h"
 #include <cstring> // for memcpy
 
 using namespace tuvok;
@@ -100,15 +101,16 @@ void GLVolume2DTex::Bind(uint32_t iUnit,
     switch (m_wrapZ) {
       default:
                WARNING("Unsupported wrap mode, falling back to GL_CLAMP");
-      case GL_CLAMP :  
-               GLint iPrevUint;
-               GL(glGetIntegerv(GL_ACTIVE_TEXTURE, &iPrevUint));
+      case GL_CLAMP : {
+               GLStateManager& state = GLStateManager::Current();
+               const size_t iPrevUnit = state.GetActiveTexUnit();
 
-               GL(glActiveTexture(GLenum(GL_TEXTURE0 + iUnit)));
-               GL(glBindTexture(GL_TEXTURE_2D, 0));
+               state.SetActiveTexUnit(iUnit);
+               state.BindTexture(GL_TEXTURE_2D, 0);
 
-               GL(glActiveTexture(iPrevUint));
+               state.SetActiveTexUnit(iPrevUnit);
                break;
+             }
       case GL_CLAMP_TO_EDGE : 
                if (iDepth < 0) 
                  m_pTextures[iStack][0]->Bind(iUnit);
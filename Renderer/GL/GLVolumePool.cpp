@@ -16,7 +16,9 @@
 #include "Basics/Threads.h"
 #include "IO/LinearIndexDataset.h"
 #include "IO/UVF/ExtendedOctree/VolumeTools.h"
+#include "Controller/Controller.h"
 #include "Controller/StackTimer.h"
+#include "Controller/Tracer.h"
 #include "Renderer/VisibilityState.h"
 #include "Renderer/writebrick.h"
 #include "GLSLProgram.h"
@@ -761,6 +763,7 @@ void GLVolumePool::UploadFirstBrick(const UINTVECTOR3& m_vVoxelSize, void* pData
 }
 
 bool GLVolumePool::UploadBrick(const BrickElemInfo& metaData, void* pData) {
+  TUVOK_TRACE("upload", "UploadBrick");
   // in this frame we already replaced all bricks (except the single low-res brick)
   // in the pool so now we should render them first
   if (m_iInsertPos >= m_vPoolSlotData.size()-1)
@@ -1381,7 +1384,7 @@ namespace {
       else
         iPagedBricks++;
 
-      tuvok::Controller::Instance().IncrementPerfCounter(PERF_POOL_UPLOADED_MEM, double(vUploadMem.size() * sizeof(T)));
+      tuvok::PerfCounters::Instance().Add(PERF_POOL_UPLOADED_MEM, double(vUploadMem.size() * sizeof(T)));
     }
     return iPagedBricks;
   }
@@ -1489,7 +1492,7 @@ namespace {
           else
             iPagedBricks++;
 
-          tuvok::Controller::Instance().IncrementPerfCounter(PERF_POOL_UPLOADED_MEM, double(vUploadMem.size() * sizeof(T)));
+          tuvok::PerfCounters::Instance().Add(PERF_POOL_UPLOADED_MEM, double(vUploadMem.size() * sizeof(T)));
 
         } else {
           vBrickMetadata[brickIndex] = BI_EMPTY;
@@ -1719,6 +1722,7 @@ uint32_t GLVolumePool::UploadBricks(const std::vector<UINTVECTOR4>& vBrickIDs,
   uint32_t iPagedBricks = 0;
 
   StackTimer brick_upload(PERF_UPLOAD_BRICKS);
+  TraceScope trace("paging", "UploadBricks");
   if (!vBrickIDs.empty())
   {
     PrepareForPaging();
@@ -1779,6 +1783,7 @@ uint32_t GLVolumePool::UploadBricks(const std::vector<UINTVECTOR4>& vBrickIDs,
 #endif
     }
   }
+  trace.SetArg("bricks", iPagedBricks);
   return iPagedBricks;
 }
 
@@ -1861,6 +1866,7 @@ bool AsyncVisibilityUpdater::Continue()
 void AsyncVisibilityUpdater::ThreadMain(void*)
 {
   PredicateFunction pContinue = std::bind(&AsyncVisibilityUpdater::Continue, this);
+  Tracer::Instance().SetThreadName("AsyncVisibilityUpdater");
 
   while (m_bContinue) {
     {
@@ -1873,6 +1879,7 @@ void AsyncVisibilityUpdater::ThreadMain(void*)
       }
       m_eState = Busy;
     }
+    TUVOK_TRACE("visibility", "AsyncVisibilityUpdate");
 
 #ifdef GLVOLUMEPOOL_PROFILE
     m_Stats.fTimeInterruptions = 0.0;
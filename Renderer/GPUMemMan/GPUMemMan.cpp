@@ -59,6 +59,7 @@
 #include "IO/TuvokSizes.h"
 #include "Renderer/AbstrRenderer.h"
 #include "Renderer/ShaderDescriptor.h"
+#include "Renderer/GL/GLCommon.h"
 #include "Renderer/GL/GLError.h"
 #include "Renderer/GL/GLTexture1D.h"
 #include "Renderer/GL/GLTexture2D.h"
@@ -75,6 +76,12 @@
 
 using namespace std;
 using namespace std::placeholders;
+
+namespace {
+  // GPU memory of released render targets kept per share group; enough for
+  // a full set of 16bit offscreen buffers at 1080p
+  const uint64_t iDefaultFBOPoolBudget = 256ull * 1024 * 1024;
+}
 using namespace tuvok;
 
 GPUMemMan::GPUMemMan(MasterController* masterController) :
@@ -84,6 +91,11 @@ GPUMemMan::GPUMemMan(MasterController* masterController) :
   m_iAllocatedCPUMemory(0),
   m_iFrameCounter(0),
   m_iInCoreSize(DEFAULT_INCORESIZE),
+  m_iFBOPoolBudget(iDefaultFBOPoolBudget),
+  m_iFBOPoolHits(0),
+  m_iFBOPoolMisses(0),
+  m_iFBOPoolIdleGPUMemory(0),
+  m_iFBOReleaseCounter(0),
   m_pMemReg(new LuaMemberReg(masterController->LuaScript()))
 {
   if (masterController && masterController->IOMan()) {
@@ -160,7 +172,8 @@ GPUMemMan::~GPUMemMan() {
 
   for (FBOListIter i = m_vpFBOList.begin();
        i < m_vpFBOList.end(); ++i) {
-    dbg.Warning(_func_, "Detected unfreed FBO.");
+    // released targets waiting in the pool are not leaks
+    if ((*i)->bInUse) dbg.Warning(_func_, "Detected unfreed FBO.");
 
     m_iAllocatedGPUMemory -= (*i)->pFBOTex->GetGPUSize();
     m_iAllocatedCPUMemory -= (*i)->pFBOTex->GetCPUSize();
@@ -911,6 +924,12 @@ GLVolume* GPUMemMan::AllocOrGetVolume(Dataset* pDataset,
   const uint64_t iBitWidth = pDataset->GetBitWidth();
   const uint64_t iCompCount = pDataset->GetComponentCount();
 
+  // released render targets go before any brick does
+  if (m_iAllocatedCPUMemory + iNeededCPUMemory >
+      m_SystemInfo.GetMaxUsableCPUMem()) {
+    TrimFBOPool(iShareGroupID, 0);
+  }
+
   // for OpenGL we ignore the GPU memory load and let GL do the paging
   if (m_iAllocatedCPUMemory + iNeededCPUMemory >
       m_SystemInfo.GetMaxUsableCPUMem()) {
@@ -1069,10 +1088,43 @@ GLFBOTex* GPUMemMan::GetFBO(GLenum minfilter, GLenum magfilter,
                             GLenum intformat, GLenum format, GLenum type,
                             int iShareGroupID,
                             bool bHaveDepth, int iNumBuffers) {
+  // recycle a released target with the same parameters if we have one,
+  // prefer the most recently released one as it is most likely still
+  // resident on the GPU
+  FBOListIter best = m_vpFBOList.end();
+  for (FBOListIter i = m_vpFBOList.begin(); i < m_vpFBOList.end(); ++i) {
+    if (!(*i)->bInUse &&
+        (*i)->Matches(minfilter, magfilter, wrapmode, width, height,
+                      intformat, format, type, bHaveDepth, iNumBuffers,
+                      iShareGroupID) &&
+        (best == m_vpFBOList.end() ||
+         (*i)->iLastRelease > (*best)->iLastRelease)) {
+      best = i;
+    }
+  }
+  if (best != m_vpFBOList.end()) {
+    MESSAGE("Reusing FBO of size %i x %i", int(width), int(height));
+    ++m_iFBOPoolHits;
+    (*best)->bInUse = true;
+    m_iFBOPoolIdleGPUMemory -= (*best)->pFBOTex->GetGPUSize();
+    // the contents are left over from the last user; renderers clear their
+    // targets before drawing, so don't touch the caller's GL state here
+    return (*best)->pFBOTex;
+  }
+  ++m_iFBOPoolMisses;
+
   MESSAGE("Creating new FBO of size %i x %i", int(width), int(height));
 
   uint64_t m_iCPUMemEstimate = GLFBOTex::EstimateCPUSize(width, height,
-                                                         bHaveDepth, iNumBuffers);
+                                 GLCommon::gl_byte_width(type) *
+                                 GLCommon::gl_components(format),
+                                 bHaveDepth, iNumBuffers);
+
+  // released targets are the cheapest thing to give up
+  if (m_iAllocatedCPUMemory + m_iCPUMemEstimate >
+      m_SystemInfo.GetMaxUsableCPUMem()) {
+    TrimFBOPool(iShareGroupID, 0);
+  }
 
   // if we are running out of mem, kick out bricks to create room for the FBO
   while (m_iAllocatedCPUMemory + m_iCPUMemEstimate >
@@ -1119,6 +1171,7 @@ GLFBOTex* GPUMemMan::GetFBO(GLenum minfilter, GLenum magfilter,
 
   if(!e->pFBOTex->Valid()) {
     T_ERROR("FBO creation failed!");
+    delete e;
     return NULL;
   }
 
@@ -1140,19 +1193,71 @@ GLFBOTex* GPUMemMan::GetFBO(GLenum minfilter, GLenum magfilter,
 void GPUMemMan::FreeFBO(GLFBOTex* pFBO) {
   for (size_t i = 0;i<m_vpFBOList.size();i++) {
     if (m_vpFBOList[i]->pFBOTex == pFBO) {
-      MESSAGE("Freeing FBO ");
-      m_iAllocatedGPUMemory -= m_vpFBOList[i]->pFBOTex->GetGPUSize();
-      m_iAllocatedCPUMemory -= m_vpFBOList[i]->pFBOTex->GetCPUSize();
-
-      delete m_vpFBOList[i];
+      FBOListElem* e = m_vpFBOList[i];
+      if (!e->bInUse) {
+        WARNING("FBO freed twice.");
+        return;
+      }
+      // keep it around for the next request with the same parameters
+      e->bInUse = false;
+      e->iLastRelease = ++m_iFBOReleaseCounter;
+      m_iFBOPoolIdleGPUMemory += pFBO->GetGPUSize();
 
-      m_vpFBOList.erase(m_vpFBOList.begin()+i);
+      TrimFBOPool(e->m_iShareGroupID, m_iFBOPoolBudget);
       return;
     }
   }
   WARNING("FBO to free not found.");
 }
 
+void GPUMemMan::DeleteFBO(size_t iIndex) {
+  FBOListElem* e = m_vpFBOList[iIndex];
+  MESSAGE("Freeing FBO ");
+  if (!e->bInUse) m_iFBOPoolIdleGPUMemory -= e->pFBOTex->GetGPUSize();
+  m_iAllocatedGPUMemory -= e->pFBOTex->GetGPUSize();
+  m_iAllocatedCPUMemory -= e->pFBOTex->GetCPUSize();
+
+  delete e;
+
+  m_vpFBOList.erase(m_vpFBOList.begin()+iIndex);
+}
+
+uint64_t GPUMemMan::TrimFBOPool(int iShareGroupID, uint64_t iMaxIdleGPUMem) {
+  uint64_t iIdle = 0;
+  for (FBOListIter i = m_vpFBOList.begin(); i < m_vpFBOList.end(); ++i) {
+    if (!(*i)->bInUse && (*i)->m_iShareGroupID == iShareGroupID)
+      iIdle += (*i)->pFBOTex->GetGPUSize();
+  }
+
+  uint64_t iFreed = 0;
+  while (iIdle > iMaxIdleGPUMem) {
+    size_t iOldest = m_vpFBOList.size();
+    for (size_t i = 0;i<m_vpFBOList.size();i++) {
+      const FBOListElem* e = m_vpFBOList[i];
+      if (!e->bInUse && e->m_iShareGroupID == iShareGroupID &&
+          (iOldest == m_vpFBOList.size() ||
+           e->iLastRelease < m_vpFBOList[iOldest]->iLastRelease)) {
+        iOldest = i;
+      }
+    }
+    assert(iOldest < m_vpFBOList.size());
+
+    const uint64_t iSize = m_vpFBOList[iOldest]->pFBOTex->GetGPUSize();
+    DeleteFBO(iOldest);
+    iIdle -= iSize;
+    iFreed += iSize;
+  }
+  return iFreed;
+}
+
+void GPUMemMan::SetFBOPoolBudget(uint64_t iBytes) {
+  m_iFBOPoolBudget = iBytes;
+}
+
+void GPUMemMan::FlushFBOPool(int iShareGroupID) {
+  TrimFBOPool(iShareGroupID, 0);
+}
+
 struct deref_glsl : public std::binary_function<GLSLListElem*, GLSLListElem*,
                                                 bool> {
   bool operator ()(const GLSLListElem* a, const GLSLListElem* b) const {
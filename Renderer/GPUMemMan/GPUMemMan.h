@@ -33,7 +33,7 @@
 #include <deque>
 #include <utility>
 #include "../../StdTuvokDefines.h"
-#include "3rdParty/GLEW/GL/glew.h"
+#include <GL/glew.h>
 #include "Basics/Vectors.h"
 #include "GPUMemManDataStructs.h"
 
@@ -122,6 +122,21 @@ class GPUMemMan {
                      bool bHaveDepth=false, int iNumBuffers=1);
     void FreeFBO(GLFBOTex* pFBO);
 
+    /// Released render targets are kept and handed out again to requests
+    /// with identical parameters.  Per share group, at most the budget's
+    /// worth of released targets is kept; the least recently released go
+    /// first.  A recycled target still holds its previous contents.
+    ///@{
+    void SetFBOPoolBudget(uint64_t iBytes);
+    uint64_t GetFBOPoolBudget() const {return m_iFBOPoolBudget;}
+    /// deletes all released render targets of the share group, the share
+    /// group's context must be current
+    void FlushFBOPool(int iShareGroupID);
+    uint64_t GetFBOPoolHits() const {return m_iFBOPoolHits;}
+    uint64_t GetFBOPoolMisses() const {return m_iFBOPoolMisses;}
+    uint64_t GetFBOPoolIdleGPUMem() const {return m_iFBOPoolIdleGPUMemory;}
+    ///@}
+
     GLSLProgram* GetGLSLProgram(const ShaderDescriptor& sdesc,
                                 int iShareGroupID);
     void FreeGLSLProgram(GLSLProgram* pGLSLProgram);
@@ -164,6 +179,12 @@ class GPUMemMan {
 
     uint64_t                    m_iInCoreSize;
 
+    uint64_t                    m_iFBOPoolBudget;
+    uint64_t                    m_iFBOPoolHits;
+    uint64_t                    m_iFBOPoolMisses;
+    uint64_t                    m_iFBOPoolIdleGPUMemory;
+    uint64_t                    m_iFBOReleaseCounter;
+
     std::vector<unsigned char>  m_vUploadHub;
 
     std::unique_ptr<LuaMemberReg> m_pMemReg;
@@ -181,6 +202,11 @@ class GPUMemMan {
     void DeleteArbitraryBrick(int iShareGroupID);
     void Delete3DTexture(size_t iIndex);
     void Delete3DTexture(const GLVolumeListIter &tex);
+    /// deletes least recently released render targets of the share group
+    /// until at most iMaxIdleGPUMem bytes of them are left, returns the
+    /// number of bytes freed
+    uint64_t TrimFBOPool(int iShareGroupID, uint64_t iMaxIdleGPUMem);
+    void DeleteFBO(size_t iIndex);
     void RegisterLuaCommands();
 };
 }
@@ -44,7 +44,7 @@
 #include <memory>
 #include <string>
 #include <vector>
-#include "3rdParty/GLEW/GL/glew.h"
+#include <GL/glew.h>
 #include "boost/noncopyable.hpp"
 #include "Basics/Vectors.h"
 #include "IO/Brick.h"
@@ -229,10 +229,6 @@ namespace tuvok {
   // framebuffer objects
   class FBOListElem {
   public:
-    FBOListElem(GLFBOTex* _pFBOTex, int iShareGroupID) : 
-        pFBOTex(_pFBOTex),
-        m_iShareGroupID(iShareGroupID)
-    {}
     FBOListElem(MasterController* pMasterController, GLenum minfilter,
                 GLenum magfilter, GLenum wrapmode,
                 GLsizei width, GLsizei height, GLenum intformat,
@@ -243,13 +239,54 @@ namespace tuvok {
                            wrapmode, width, height, intformat, 
                            format, type,
                            bHaveDepth, iNumBuffers)),
-      m_iShareGroupID(iShareGroupID)
+      m_iShareGroupID(iShareGroupID),
+      bInUse(true),
+      iLastRelease(0),
+      m_minfilter(minfilter),
+      m_magfilter(magfilter),
+      m_wrapmode(wrapmode),
+      m_width(width),
+      m_height(height),
+      m_intformat(intformat),
+      m_format(format),
+      m_type(type),
+      m_bHaveDepth(bHaveDepth),
+      m_iNumBuffers(iNumBuffers)
     {}
 
     ~FBOListElem() { delete pFBOTex; }
 
+    /// true if this render target was created with exactly these parameters
+    bool Matches(GLenum minfilter, GLenum magfilter, GLenum wrapmode,
+                 GLsizei width, GLsizei height, GLenum intformat,
+                 GLenum format, GLenum type, bool bHaveDepth,
+                 int iNumBuffers, int iShareGroupID) const {
+      return m_width == width && m_height == height &&
+             m_intformat == intformat && m_format == format &&
+             m_type == type && m_iNumBuffers == iNumBuffers &&
+             m_bHaveDepth == bHaveDepth && m_minfilter == minfilter &&
+             m_magfilter == magfilter && m_wrapmode == wrapmode &&
+             m_iShareGroupID == iShareGroupID;
+    }
+
     GLFBOTex* const pFBOTex;
     int m_iShareGroupID;
+    /// false while the target sits in the pool waiting to be recycled
+    bool bInUse;
+    /// value of the pool's release counter when this target was released
+    uint64_t iLastRelease;
+
+  private:
+    GLenum  m_minfilter;
+    GLenum  m_magfilter;
+    GLenum  m_wrapmode;
+    GLsizei m_width;
+    GLsizei m_height;
+    GLenum  m_intformat;
+    GLenum  m_format;
+    GLenum  m_type;
+    bool    m_bHaveDepth;
+    int     m_iNumBuffers;
   };
   typedef std::deque<FBOListElem*> FBOList;
   typedef FBOList::iterator FBOListIter;
@@ -0,0 +1,209 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    LODController.cpp
+*/
+
+#include "LODController.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace tuvok;
+
+LODController::Level::Level() :
+  bPlanned(false),
+  fVisibleFraction(1.0),
+  fFragmentsPerPixel(0.0),
+  bMeasured(false),
+  fCorrection(1.0),
+  fLastMs(-1.0)
+{
+}
+
+LODController::LODController(uint32_t iHalfLife) :
+  m_fDecay(std::pow(0.5, 1.0 / std::max<uint32_t>(1, iHalfLife)))
+{
+  Reset();
+}
+
+void LODController::Reset() {
+  m_fBB = m_fBF = m_fFF = m_fBT = m_fFT = 0.0;
+  m_fCostPerBrick = 0.0;
+  m_fCostPerFragment = 0.0;
+  m_iSamples = 0;
+  m_vLevels.clear();
+  m_bPlanned = false;
+  m_iPlannedLOD = 0;
+  m_fPlannedBricks = 0.0;
+  m_fPlannedFragments = 0.0;
+}
+
+LODController::Level& LODController::GetLevel(size_t iLOD) {
+  if (iLOD >= m_vLevels.size()) m_vLevels.resize(iLOD+1);
+  return m_vLevels[iLOD];
+}
+
+void LODController::PlannedSubframe(size_t iLOD, uint64_t iListBricks,
+                                    uint64_t iTotalBricks, double fFragments,
+                                    uint64_t iPixels) {
+  Level& level = GetLevel(iLOD);
+  level.bPlanned = true;
+  level.fVisibleFraction = iTotalBricks ?
+                           double(iListBricks) / double(iTotalBricks) : 1.0;
+  level.fFragmentsPerPixel = iPixels ? fFragments / double(iPixels) : 0.0;
+
+  m_bPlanned = true;
+  m_iPlannedLOD = iLOD;
+  m_fPlannedBricks = double(iListBricks);
+  m_fPlannedFragments = fFragments;
+}
+
+void LODController::CompletedSubframe(double fMSecs, double fWorkScale) {
+  if (!m_bPlanned) return;
+  m_bPlanned = false;
+  // negative or NaN: the timer was restarted in between
+  if (!(fMSecs >= 0.0) || m_fPlannedBricks <= 0.0) return;
+
+  const double b = m_fPlannedBricks;
+  const double f = m_fPlannedFragments * fWorkScale;
+  AddSample(b, f, fMSecs);
+
+  Level& level = GetLevel(m_iPlannedLOD);
+  level.fLastMs = fMSecs;
+  // the correction only covers what the model misses at full resolution
+  const double fModeled = b * m_fCostPerBrick + f * m_fCostPerFragment;
+  if (fModeled > 0.0) {
+    const double fRatio = std::min(4.0, std::max(0.25, fMSecs / fModeled));
+    level.fCorrection = level.bMeasured ? 0.7 * level.fCorrection + 0.3 * fRatio
+                                        : fRatio;
+    level.bMeasured = true;
+  }
+}
+
+void LODController::SeedSubframe(double fMSecs) {
+  if (IsTrained() || !m_bPlanned || !(fMSecs > 0.0) ||
+      m_fPlannedBricks <= 0.0) return;
+  AddSample(m_fPlannedBricks, m_fPlannedFragments, fMSecs);
+}
+
+void LODController::AddSample(double b, double f, double fMSecs) {
+  m_fBB = m_fBB * m_fDecay + b*b;
+  m_fBF = m_fBF * m_fDecay + b*f;
+  m_fFF = m_fFF * m_fDecay + f*f;
+  m_fBT = m_fBT * m_fDecay + b*fMSecs;
+  m_fFT = m_fFT * m_fDecay + f*fMSecs;
+  ++m_iSamples;
+  Fit();
+}
+
+void LODController::Fit() {
+  // weighted least squares without intercept for the two costs
+  const double fDet = m_fBB * m_fFF - m_fBF * m_fBF;
+  if (m_fFF <= 0.0) {
+    // nothing but empty bricks so far
+    m_fCostPerBrick = m_fBB > 0.0 ? m_fBT / m_fBB : 0.0;
+    m_fCostPerFragment = 0.0;
+  } else if (fDet > 1e-6 * m_fBB * m_fFF) {
+    m_fCostPerBrick    = (m_fFF * m_fBT - m_fBF * m_fFT) / fDet;
+    m_fCostPerFragment = (m_fBB * m_fFT - m_fBF * m_fBT) / fDet;
+    if (m_fCostPerBrick < 0.0) {
+      m_fCostPerBrick = 0.0;
+      m_fCostPerFragment = m_fFT / m_fFF;
+    } else if (m_fCostPerFragment < 0.0) {
+      m_fCostPerBrick = m_fBT / m_fBB;
+      m_fCostPerFragment = 0.0;
+    }
+  } else {
+    // bricks and fragments grew in lockstep (e.g. only one level was seen
+    // so far), so the time can not be told apart; split it evenly
+    m_fCostPerBrick = 0.5 * m_fBT / m_fBB;
+    m_fCostPerFragment = 0.5 * m_fFT / m_fFF;
+  }
+}
+
+int LODController::Nearest(size_t iLOD, bool bMeasured) const {
+  int iBest = -1;
+  size_t iBestDistance = 0;
+  for (size_t i = 0;i<m_vLevels.size();i++) {
+    const Level& level = m_vLevels[i];
+    if (!(bMeasured ? level.bMeasured : level.bPlanned)) continue;
+    const size_t iDistance = i > iLOD ? i - iLOD : iLOD - i;
+    if (iBest < 0 || iDistance < iBestDistance) {
+      iBest = int(i);
+      iBestDistance = iDistance;
+    }
+  }
+  return iBest;
+}
+
+double LODController::Predict(size_t iLOD, uint64_t iTotalBricks,
+                              uint64_t iPixels) const {
+  if (!IsTrained()) return 0.0;
+  const int iRef = Nearest(iLOD, false);
+  if (iRef < 0) return 0.0;
+
+  const Level& ref = m_vLevels[iRef];
+  const double fBricks = ref.fVisibleFraction * double(iTotalBricks);
+  // a finer level doubles the samples along each ray, the footprint on
+  // screen stays the same
+  const double fFragments = ref.fFragmentsPerPixel * double(iPixels) *
+                            std::pow(2.0, double(iRef) - double(iLOD));
+  const int iCorrection = Nearest(iLOD, true);
+  const double fCorrection = iCorrection < 0 ? 1.0
+                           : m_vLevels[iCorrection].fCorrection;
+
+  return (fBricks * m_fCostPerBrick + fFragments * m_fCostPerFragment) *
+         fCorrection;
+}
+
+size_t LODController::ChooseLOD(size_t iFinest, size_t iCoarsest,
+                                size_t iCurrent, double fBudgetMs,
+                                const std::vector<uint64_t>& vTotalBricks,
+                                uint64_t iPixels, double& fPredicted) const {
+  fPredicted = 0.0;
+  if (vTotalBricks.empty()) return iCoarsest;
+
+  for (size_t i = iFinest;i<=iCoarsest;i++) {
+    const uint64_t iBricks = vTotalBricks[std::min(i, vTotalBricks.size()-1)];
+    fPredicted = Predict(i, iBricks, iPixels);
+    const double fLimit = (i < iCurrent)
+                          ? fBudgetMs * UPGRADE_MARGIN_PERCENT / 100.0
+                          : fBudgetMs;
+    if (fPredicted <= fLimit) return i;
+  }
+  return iCoarsest;
+}
+
+double LODController::GetLastMeasured(size_t iLOD) const {
+  return iLOD < m_vLevels.size() ? m_vLevels[iLOD].fLastMs : -1.0;
+}
+
+double LODController::GetCorrection(size_t iLOD) const {
+  return iLOD < m_vLevels.size() ? m_vLevels[iLOD].fCorrection : 1.0;
+}
@@ -0,0 +1,149 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    LODController.h
+  \brief   Predicts the frame time of each LOD and picks the start LOD.
+*/
+#pragma once
+
+#ifndef LODCONTROLLER_H
+#define LODCONTROLLER_H
+
+#include "../StdTuvokDefines.h"
+#include <vector>
+
+namespace tuvok {
+
+  /**
+   \class LODController
+   \brief Chooses the finest LOD predicted to render within the frame budget
+
+   A subframe is modeled as
+     time = bricks * costPerBrick + fragments * costPerFragment
+   where fragments are the screen pixels the non empty bricks cover times
+   the samples along a ray through them.  Both costs are fitted to the
+   measured subframes with exponentially decaying weights.  Per LOD the
+   controller keeps the fraction of bricks that made it into the last brick
+   list, the fragments per viewport pixel and a correction factor for what
+   the model gets wrong on that level, e.g. because its bricks are unevenly
+   expensive.  Levels that were never planned are extrapolated from the
+   nearest level that was: same visible fraction, twice the fragments per
+   finer level.
+
+   Predictions are for full screen resolution and sampling rate.  Moving to
+   a finer level than the current one requires a prediction within
+   UPGRADE_MARGIN_PERCENT of the budget, so the choice does not flip back
+   and forth around it.
+  */
+  class LODController
+  {
+  public:
+    enum { UPGRADE_MARGIN_PERCENT = 85 };
+
+    //! \param iHalfLife number of subframes after which a measurement has
+    //!                  lost half its weight
+    LODController(uint32_t iHalfLife = 16);
+
+    //! forgets everything, e.g. for a new data set
+    void Reset();
+
+    //! A brick list for level iLOD was built: iListBricks of the level's
+    //! iTotalBricks bricks made the cut, covering fFragments fragments on
+    //! a viewport of iPixels pixels.
+    void PlannedSubframe(size_t iLOD, uint64_t iListBricks,
+                         uint64_t iTotalBricks, double fFragments,
+                         uint64_t iPixels);
+    //! The subframe planned last took fMSecs.  fWorkScale < 1 if it was
+    //! rendered at a reduced resolution or sampling rate.
+    void CompletedSubframe(double fMSecs, double fWorkScale = 1.0);
+    //! drops the planned subframe without measuring it
+    void CancelSubframe() { m_bPlanned = false; }
+    //! While untrained, counts the planned subframe as if it took fMSecs,
+    //! e.g. what a per brick cost model predicts for it.  The subframe is
+    //! still measured by CompletedSubframe(); real measurements soon
+    //! outweigh the seeds.
+    void SeedSubframe(double fMSecs);
+
+    bool IsTrained() const { return m_iSamples >= MIN_SAMPLES; }
+    uint64_t GetSampleCount() const { return m_iSamples; }
+
+    //! predicted time in ms for level iLOD with iTotalBricks bricks on a
+    //! viewport of iPixels pixels, 0 if untrained
+    double Predict(size_t iLOD, uint64_t iTotalBricks, uint64_t iPixels) const;
+
+    //! \param vTotalBricks brick count of every LOD level
+    //! \param fPredicted   the prediction for the returned level
+    //! \return the finest level in [iFinest, iCoarsest] that fits fBudgetMs,
+    //!         iCoarsest if none does
+    size_t ChooseLOD(size_t iFinest, size_t iCoarsest, size_t iCurrent,
+                     double fBudgetMs,
+                     const std::vector<uint64_t>& vTotalBricks,
+                     uint64_t iPixels, double& fPredicted) const;
+
+    double GetCostPerBrick() const { return m_fCostPerBrick; }
+    double GetCostPerFragment() const { return m_fCostPerFragment; }
+    //! the last measured time of level iLOD in ms, < 0 if never measured
+    double GetLastMeasured(size_t iLOD) const;
+    double GetCorrection(size_t iLOD) const;
+
+  private:
+    enum { MIN_SAMPLES = 2 };
+
+    struct Level {
+      Level();
+      bool   bPlanned;
+      double fVisibleFraction;   ///< of the level's bricks in the list
+      double fFragmentsPerPixel;
+      bool   bMeasured;
+      double fCorrection;        ///< measured / modeled time
+      double fLastMs;
+    };
+
+    void AddSample(double b, double f, double fMSecs);
+    void Fit();
+    Level& GetLevel(size_t iLOD);
+    //! nearest level that was planned (or measured), -1 if there is none
+    int Nearest(size_t iLOD, bool bMeasured) const;
+
+    double   m_fDecay;
+    //! decayed sums of b*b, b*f, f*f, b*t and f*t over the subframes
+    double   m_fBB, m_fBF, m_fFF, m_fBT, m_fFT;
+    double   m_fCostPerBrick;
+    double   m_fCostPerFragment;
+    uint64_t m_iSamples;
+    std::vector<Level> m_vLevels;
+
+    bool     m_bPlanned;  ///< the next CompletedSubframe() is measured
+    size_t   m_iPlannedLOD;
+    double   m_fPlannedBricks;
+    double   m_fPlannedFragments;
+  };
+
+}
+#endif // LODCONTROLLER_H
@@ -41,6 +41,7 @@
 #include <functional>
 #include <limits>
 #include "SBVRGeogen.h"
+#include "SBVRGeometryCache.h"
 
 using namespace tuvok;
 
@@ -80,6 +81,49 @@ SBVRGeogen::~SBVRGeogen(void)
 {
 }
 
+void SBVRGeogen::SetGeometryCacheBudget(uint64_t iBudget) {
+  m_pCachedGeometry.reset();
+  if (iBudget == 0) {
+    m_pGeometryCache.reset();
+  } else if (m_pGeometryCache) {
+    m_pGeometryCache->SetBudget(iBudget);
+  } else {
+    m_pGeometryCache.reset(new SBVRGeometryCache(iBudget));
+  }
+}
+
+SBVRGeometryKey SBVRGeogen::GetGeometryKey(int iVariant) const {
+  SBVRGeometryKey key;
+  key.m_matWorldView = m_matWorldView;
+  key.m_matView = m_matView;
+  key.m_vAspect = m_vAspect;
+  key.m_vSize = m_vSize;
+  key.m_vTexCoordMin = m_vTexCoordMin;
+  key.m_vTexCoordMax = m_vTexCoordMax;
+  key.m_fSamplingModifier = m_fSamplingModifier;
+  key.m_bClip = m_bClipPlaneEnabled && (m_bClipVolume || m_bClipMesh);
+  if (key.m_bClip) {
+    key.m_ClipPlane = m_ClipPlane;
+    key.m_bClipVolume = m_bClipVolume;
+    key.m_bClipMesh = m_bClipMesh;
+  }
+  key.m_iVariant = iVariant;
+  return key;
+}
+
+bool SBVRGeogen::FindCachedGeometry(int iVariant) {
+  m_pCachedGeometry.reset();
+  if (!m_pGeometryCache) return false;
+  m_pCachedGeometry = m_pGeometryCache->Find(GetGeometryKey(iVariant));
+  return m_pCachedGeometry != NULL;
+}
+
+void SBVRGeogen::CacheGeometry(int iVariant,
+                    const std::shared_ptr<const SBVRGeometry>& pGeometry) {
+  m_pGeometryCache->Insert(GetGeometryKey(iVariant), pGeometry);
+  m_pCachedGeometry = pGeometry;
+}
+
 float SBVRGeogen::GetOpacityCorrection() const {
   return 1.0f/m_fSamplingModifier * (FLOATVECTOR3(m_vGlobalSize)/FLOATVECTOR3(m_vLODSize)).maxVal(); //  GetLayerDistance()*m_vSize.maxVal();
 }
@@ -38,6 +38,7 @@
 #ifndef SBVRGEOGEN_H
 #define SBVRGEOGEN_H
 
+#include <memory>
 #include <vector>
 #include "../Basics/Vectors.h"
 #include "../StdTuvokDefines.h"
@@ -105,6 +106,20 @@ namespace tuvok {
   };
 #pragma pack(pop)
 
+  /**
+   \class SBVRGeometry
+   \brief the slices generated for one brick, one vector per axis for
+   object aligned slicing, only the first one for view aligned slicing
+  */
+  class SBVRGeometry
+  {
+  public:
+    std::vector<VERTEX_FORMAT> vSlices[3];
+  };
+
+  class SBVRGeometryCache;
+  class SBVRGeometryKey;
+
   /** \class SBVRGeoGen
    * Geometry generation for the slice-based volume renderer. */
 
@@ -228,6 +243,21 @@ namespace tuvok {
     void ClipVolumeOnPlanes(bool bClipVolume) {m_bClipVolume = bClipVolume;}
     void ClipMeshOnPlanes(bool bClipMesh) {m_bClipMesh = bClipMesh;}
 
+    /**
+     \brief Enables keeping the generated slices across frames
+
+     Geometry of bricks without meshes is cached by all the parameters it
+     is computed from, so rendering an unchanged view again skips the
+     geometry generation.
+
+     \param iBudget maximum memory of the cache in bytes, 0 disables it
+    */
+    void SetGeometryCacheBudget(uint64_t iBudget);
+    //! the geometry cache, NULL if disabled
+    const SBVRGeometryCache* GetGeometryCache() const {
+      return m_pGeometryCache.get();
+    }
+
   protected:
     //! user specified oversampling (if > 1) or undersampling (if < 1) rate
     float             m_fSamplingModifier;
@@ -292,6 +322,30 @@ namespace tuvok {
     //! should the mesh be clipped on the clipping plane?
     bool m_bClipMesh;
 
+    //! slices of previous ComputeGeometry calls, NULL if disabled
+    std::shared_ptr<SBVRGeometryCache> m_pGeometryCache;
+    //! the geometry of the last ComputeGeometry call if it came from or
+    //! went into the cache
+    std::shared_ptr<const SBVRGeometry> m_pCachedGeometry;
+
+    //! the cache key for the current parameters
+    SBVRGeometryKey GetGeometryKey(int iVariant) const;
+    /**
+      \brief looks up the geometry for the current parameters
+
+      \param iVariant distinguishes generator specific settings
+      \result true if the geometry was found, m_pCachedGeometry holds it
+    */
+    bool FindCachedGeometry(int iVariant);
+    /**
+      \brief stores the geometry in the cache and in m_pCachedGeometry
+
+      \param iVariant distinguishes generator specific settings
+      \param pGeometry the geometry computed for the current parameters
+    */
+    void CacheGeometry(int iVariant,
+                       const std::shared_ptr<const SBVRGeometry>& pGeometry);
+
     //! Computes the transformed vertices m_pfBBOXVertex from m_pfBBOXStaticVertex
     virtual void InitBBOX();
     
@@ -41,6 +41,7 @@
 #include <functional>
 #include <limits>
 #include "SBVRGeogen2D.h"
+#include "Controller/Tracer.h"
 
 using namespace std;
 using namespace tuvok;
@@ -72,8 +73,13 @@ void SBVRGeogen2D::InterpolateVertices(const VERTEX_FORMAT& v1,
 }
 
 void SBVRGeogen2D::ComputeGeometry(bool bMeshOnly) {
+  TUVOK_TRACE("geometry", "SBVRGeogen2D::ComputeGeometry");
   InitBBOX();
 
+  const bool bCacheable = m_pGeometryCache && !bMeshOnly && !HasMesh();
+  m_pCachedGeometry.reset();
+  if (bCacheable && FindCachedGeometry(int(m_eMethod))) return;
+
   if (bMeshOnly) {
     m_vSliceTrianglesX.clear();
     m_vSliceTrianglesY.clear();
@@ -103,6 +109,14 @@ void SBVRGeogen2D::ComputeGeometry(bool bMeshOnly) {
     m_vSliceTrianglesZ = ClipTriangles(m_vSliceTrianglesZ, normal, d);
   }
 
+  if (bCacheable) {
+    std::shared_ptr<SBVRGeometry> pGeometry(new SBVRGeometry());
+    // hand the triangles over, the accessors read the cached entry
+    pGeometry->vSlices[0].swap(m_vSliceTrianglesX);
+    pGeometry->vSlices[1].swap(m_vSliceTrianglesY);
+    pGeometry->vSlices[2].swap(m_vSliceTrianglesZ);
+    CacheGeometry(int(m_eMethod), pGeometry);
+  }
 }
 
 
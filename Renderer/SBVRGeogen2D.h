@@ -106,6 +106,23 @@ public:
   std::vector<VERTEX_FORMAT> m_vSliceTrianglesY;
   //! Vector holding the slices that access the Z axis aligned textures
   std::vector<VERTEX_FORMAT> m_vSliceTrianglesZ;
+
+  //! the results of ComputeGeometry(), either the vectors above or the
+  //! slices from the geometry cache
+  ///@{
+  const std::vector<VERTEX_FORMAT>& GetSliceTrianglesX() const {
+    return m_pCachedGeometry ? m_pCachedGeometry->vSlices[0]
+                             : m_vSliceTrianglesX;
+  }
+  const std::vector<VERTEX_FORMAT>& GetSliceTrianglesY() const {
+    return m_pCachedGeometry ? m_pCachedGeometry->vSlices[1]
+                             : m_vSliceTrianglesY;
+  }
+  const std::vector<VERTEX_FORMAT>& GetSliceTrianglesZ() const {
+    return m_pCachedGeometry ? m_pCachedGeometry->vSlices[2]
+                             : m_vSliceTrianglesZ;
+  }
+  ///@}
   
   /** 
    \brief Holds the Geometry generation method
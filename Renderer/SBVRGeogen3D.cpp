@@ -40,19 +40,28 @@
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <numeric>
 #include "SBVRGeogen3D.h"
+#include "Controller/Tracer.h"
 #include "MathTools.h"
 
 using namespace tuvok;
 
 static bool CheckOrdering(const FLOATVECTOR3& a, const FLOATVECTOR3& b,
                           const FLOATVECTOR3& c);
-static void SortPoints(std::vector<VERTEX_FORMAT> &fArray);
+static void SortPoints(VERTEX_FORMAT* fArray, size_t iCount);
+
+// Below this many layers the threading overhead outweighs the gain.
+static const int iMinParallelLayers = 64;
 
 SBVRGeogen3D::SBVRGeogen3D(void) :
   SBVRGeogen(),
   m_fMaxZ(0),
-  m_fMinZ(0)
+  m_fMinZ(0),
+  m_bSliceReuse(true),
+  m_bTemplateValid(false),
+  m_fTemplateSamplingModifier(0),
+  m_bTemplateClipVolume(false)
 {
 }
 
@@ -138,13 +147,18 @@ struct vertex_min : public std::binary_function<VERTEX_FORMAT,
 // Sorts a vector
 void SBVRGeogen3D::SortByGradient(std::vector<VERTEX_FORMAT>& fArray)
 {
-  // move bottom element to front of array
   if(fArray.empty()) { return; }
-  std::swap(fArray[0],
-            *std::min_element(fArray.begin(), fArray.end(), vertex_min()));
-  if(fArray.size() > 2) {
+  SortByGradient(&fArray[0], fArray.size());
+}
+
+void SBVRGeogen3D::SortByGradient(VERTEX_FORMAT* fArray, size_t iCount)
+{
+  // move bottom element to front of array
+  if(iCount == 0) { return; }
+  std::swap(fArray[0], *std::min_element(fArray, fArray+iCount, vertex_min()));
+  if(iCount > 2) {
     // sort points according to gradient
-    SortPoints(fArray);
+    SortPoints(fArray, iCount);
   }
 }
 
@@ -247,11 +261,190 @@ void SBVRGeogen3D::DepthSortMeshWithVolume() {
   m_MeshTransferIter = m_mesh.begin();
 }
 
+namespace {
+  // The edges of the bounding box as indices into m_pfBBOXVertex, in the
+  // same order ComputeLayerGeometry intersects them.
+  const size_t BBOXEdges[12][2] = {
+    {0,1}, {1,2}, {2,3}, {3,0},
+    {4,5}, {5,6}, {6,7}, {7,4},
+    {4,0}, {5,1}, {6,2}, {7,3}
+  };
+
+  // The bounding box edges in structure-of-arrays layout.  The depth test
+  // for all twelve edges runs as one branch free loop which the compiler
+  // turns into SIMD code; only the hits are then interpolated.
+  struct EdgeSet {
+    EdgeSet(const VERTEX_FORMAT* pBBOX) {
+      for(size_t e=0; e < 12; ++e) {
+        const VERTEX_FORMAT& a = pBBOX[BBOXEdges[e][0]];
+        const VERTEX_FORMAT& b = pBBOX[BBOXEdges[e][1]];
+        // parallel edges never intersect, give them an empty depth range
+        const bool bParallel = EpsilonEqual(a.m_vPos.z, b.m_vPos.z);
+        fZMin[e] = bParallel ?  std::numeric_limits<float>::max()
+                             : std::min(a.m_vPos.z, b.m_vPos.z);
+        fZMax[e] = bParallel ? -std::numeric_limits<float>::max()
+                             : std::max(a.m_vPos.z, b.m_vPos.z);
+        fZA[e] = a.m_vPos.z;
+        fInvDZ[e] = bParallel ? 0.0f : 1.0f / (a.m_vPos.z - b.m_vPos.z);
+        vPosA[e] = a.m_vPos;
+        vPosD[e] = a.m_vPos - b.m_vPos;
+        vTexA[e] = a.m_vVertexData;
+        vTexD[e] = a.m_vVertexData - b.m_vVertexData;
+      }
+    }
+
+    // Flags in bHit which edges a plane at depth z intersects, returns
+    // the number of intersections.
+    size_t Test(float z, bool bHit[12]) const {
+      size_t iCount = 0;
+      for(size_t e=0; e < 12; ++e) {
+        bHit[e] = (z >= fZMin[e]) & (z <= fZMax[e]);
+        iCount += bHit[e] ? 1 : 0;
+      }
+      return iCount;
+    }
+
+    // Writes the intersections of a plane at depth z into pHits, which
+    // must have room for 12 vertices; returns the number of intersections.
+    size_t Intersect(float z, bool bClip, VERTEX_FORMAT* pHits) const {
+      bool bHit[12];
+      Test(z, bHit);
+      size_t iCount = 0;
+      for(size_t e=0; e < 12; ++e) {
+        if(!bHit[e]) { continue; }
+        const float fAlpha = (z - fZA[e]) * fInvDZ[e];
+        VERTEX_FORMAT& vHit = pHits[iCount++];
+        vHit = VERTEX_FORMAT();
+        vHit.m_vPos = vPosA[e] + vPosD[e] * fAlpha;
+        vHit.m_vPos.z = z;
+        vHit.m_vVertexData = vTexA[e] + vTexD[e] * fAlpha;
+        vHit.m_bClip = bClip;
+      }
+      return iCount;
+    }
+
+    float fZMin[12];
+    float fZMax[12];
+    float fZA[12];
+    float fInvDZ[12];
+    FLOATVECTOR3 vPosA[12];
+    FLOATVECTOR3 vPosD[12];
+    FLOATVECTOR3 vTexA[12];
+    FLOATVECTOR3 vTexD[12];
+  };
+
+  // A polygon of n vertices is split into n-2 triangles.
+  size_t TriangulatedSize(size_t iPolygonSize) {
+    return iPolygonSize > 2 ? 3 * (iPolygonSize-2) : 0;
+  }
+}
+
+void SBVRGeogen3D::ComputeSlicesParallel(float fLayerDistance) {
+  const EdgeSet edges(m_pfBBOXVertex);
+
+  // same layers as the serial loop: m_fMaxZ first, then every layer which
+  // is still in front of m_fMinZ
+  const int iLayerCount = std::max(1, static_cast<int>(
+    std::ceil((m_fMaxZ - m_fMinZ) / fLayerDistance)
+  ));
+
+  // first pass only counts the intersections to find each layer's range
+  m_vLayerOffsets.resize(size_t(iLayerCount) + 1);
+  m_vLayerOffsets[0] = 0;
+#pragma omp parallel for schedule(static) if(iLayerCount > iMinParallelLayers)
+  for(int i=0; i < iLayerCount; ++i) {
+    bool bHit[12];
+    const float fDepth = m_fMaxZ - float(i) * fLayerDistance;
+    m_vLayerOffsets[size_t(i)+1] = TriangulatedSize(edges.Test(fDepth, bHit));
+  }
+  std::partial_sum(m_vLayerOffsets.begin(), m_vLayerOffsets.end(),
+                   m_vLayerOffsets.begin());
+  m_vSliceTriangles.resize(m_vLayerOffsets.back());
+  if(m_vSliceTriangles.empty()) { return; }
+
+  // second pass: every layer triangulates into its own range
+  VERTEX_FORMAT* pOut = &m_vSliceTriangles[0];
+  const bool bClip = m_bClipVolume;
+#pragma omp parallel for schedule(static) if(iLayerCount > iMinParallelLayers)
+  for(int i=0; i < iLayerCount; ++i) {
+    const size_t iOffset = m_vLayerOffsets[size_t(i)];
+    const size_t iSize = m_vLayerOffsets[size_t(i)+1] - iOffset;
+    if(iSize == 0) { continue; }
+
+    VERTEX_FORMAT vHits[12];
+    const float fDepth = m_fMaxZ - float(i) * fLayerDistance;
+    const size_t iHits = edges.Intersect(fDepth, bClip, vHits);
+    assert(TriangulatedSize(iHits) == iSize);
+
+    SortByGradient(vHits, iHits);
+    VERTEX_FORMAT* pLayer = pOut + iOffset;
+    for(size_t t=0; t < iHits-2; ++t) {
+      *pLayer++ = vHits[0];
+      *pLayer++ = vHits[t+1];
+      *pLayer++ = vHits[t+2];
+    }
+  }
+}
+
+FLOATVECTOR3 SBVRGeogen3D::BrickOrigin() const {
+  return (FLOATVECTOR4(m_brickTranslation, 1.0f) * m_matWorld *
+          m_matView).xyz();
+}
+
+bool SBVRGeogen3D::TemplateMatches() const {
+  return m_bTemplateValid &&
+         !(m_vTemplateAspect != m_vAspect) &&
+         !(m_vTemplateSize != m_vSize) &&
+         !(m_vTemplateTexCoordMin != m_vTexCoordMin) &&
+         !(m_vTemplateTexCoordMax != m_vTexCoordMax) &&
+         m_fTemplateSamplingModifier == m_fSamplingModifier &&
+         !(m_matTemplateWorld != m_matWorld) &&
+         !(m_matTemplateView != m_matView) &&
+         m_bTemplateClipVolume == m_bClipVolume;
+}
+
+void SBVRGeogen3D::StoreTemplate() {
+  const FLOATVECTOR3 vOrigin = BrickOrigin();
+  m_vSliceTemplate.resize(m_vSliceTriangles.size());
+  for(size_t i=0; i < m_vSliceTriangles.size(); ++i) {
+    m_vSliceTemplate[i] = m_vSliceTriangles[i];
+    m_vSliceTemplate[i].m_vPos = m_vSliceTriangles[i].m_vPos - vOrigin;
+  }
+  m_vTemplateAspect = m_vAspect;
+  m_vTemplateSize = m_vSize;
+  m_vTemplateTexCoordMin = m_vTexCoordMin;
+  m_vTemplateTexCoordMax = m_vTexCoordMax;
+  m_fTemplateSamplingModifier = m_fSamplingModifier;
+  m_matTemplateWorld = m_matWorld;
+  m_matTemplateView = m_matView;
+  m_bTemplateClipVolume = m_bClipVolume;
+  m_bTemplateValid = true;
+}
+
+void SBVRGeogen3D::ApplyTemplate() {
+  // slices start at the brick's own m_fMaxZ, so a translated brick has
+  // exactly the translated slices of its congruent predecessor
+  const FLOATVECTOR3 vOrigin = BrickOrigin();
+  m_vSliceTriangles.resize(m_vSliceTemplate.size());
+  const int iCount = static_cast<int>(m_vSliceTemplate.size());
+#pragma omp parallel for schedule(static) if(iCount > 12*iMinParallelLayers)
+  for(int i=0; i < iCount; ++i) {
+    m_vSliceTriangles[i] = m_vSliceTemplate[i];
+    m_vSliceTriangles[i].m_vPos = m_vSliceTemplate[i].m_vPos + vOrigin;
+  }
+}
+
 void SBVRGeogen3D::ComputeGeometry(bool bMeshOnly) {
+  TUVOK_TRACE("geometry", "SBVRGeogen3D::ComputeGeometry");
   InitBBOX();
 
   m_vSliceTriangles.clear();
 
+  // interleaved meshes may change without any of the cache key changing
+  const bool bCacheable = m_pGeometryCache && !bMeshOnly && !HasMesh();
+  m_pCachedGeometry.reset();
+  if (bCacheable && FindCachedGeometry(0)) return;
+
   if (bMeshOnly)  {
     SortMeshWithoutVolume(m_vSliceTriangles);
     return;
@@ -267,21 +460,29 @@ void SBVRGeogen3D::ComputeGeometry(bool bMeshOnly) {
   // so we end up with an infinite loop computing geometry below.
   assert(!MathTools::NaN(fDepth));
 
-  // prepare mesh triangles for insertion (i.e. sort them)
-  if (HasMesh()) DepthSortMeshWithVolume();
+  if (HasMesh()) {
+    // mesh triangles are interleaved with the slices in depth order, so
+    // this case has to walk the layers front to back
 
-  do {
-    ComputeLayerGeometry(fDepth);
-    fDepth -= fLayerDistance;
-  } while (fDepth > m_fMinZ);
+    // prepare mesh triangles for insertion (i.e. sort them)
+    DepthSortMeshWithVolume();
 
-  // insert all the leftover triangles they must be behind the last plane
-  if (HasMesh()) { 
+    do {
+      ComputeLayerGeometry(fDepth);
+      fDepth -= fLayerDistance;
+    } while (fDepth > m_fMinZ);
+
+    // insert all the leftover triangles they must be behind the last plane
     for (SortIndexPVec::const_iterator index = m_MeshTransferIter;
          index != m_mesh.end();
          index++) {
       MeshEntryToVertexFormat(m_vSliceTriangles, (*index)->m_mesh, (*index)->m_index, m_bClipMesh);
     }
+  } else if (m_bSliceReuse && TemplateMatches()) {
+    ApplyTemplate();
+  } else {
+    ComputeSlicesParallel(fLayerDistance);
+    if (m_bSliceReuse) StoreTemplate();
   }
 
   if(m_bClipPlaneEnabled && (m_bClipVolume || m_bClipMesh)) {
@@ -291,6 +492,12 @@ void SBVRGeogen3D::ComputeGeometry(bool bMeshOnly) {
     m_vSliceTriangles = ClipTriangles(m_vSliceTriangles, normal, d);
   }
 
+  if (bCacheable) {
+    std::shared_ptr<SBVRGeometry> pGeometry(new SBVRGeometry());
+    // hand the triangles over, GetSliceTriangles reads the cached entry
+    pGeometry->vSlices[0].swap(m_vSliceTriangles);
+    CacheGeometry(0, pGeometry);
+  }
 }
 
 // Checks the ordering of two points relative to a third.
@@ -313,10 +520,10 @@ static bool CheckOrdering(const FLOATVECTOR3& a,
 }
 
 /// @todo: should be replaced with std::sort.
-static void SortPoints(std::vector<VERTEX_FORMAT> &fArray) {
+static void SortPoints(VERTEX_FORMAT* fArray, size_t iCount) {
   // for small arrays, this bubble sort actually beats qsort.
-  for (uint32_t i= 1;i<fArray.size();++i)
-    for (uint32_t j = 1;j<fArray.size()-i;++j)
+  for (size_t i= 1;i<iCount;++i)
+    for (size_t j = 1;j<iCount-i;++j)
       if (!CheckOrdering(fArray[j].m_vPos,fArray[j+1].m_vPos,fArray[0].m_vPos))
         std::swap(fArray[j], fArray[j+1]);
 }
@@ -66,6 +66,24 @@ namespace tuvok {
     virtual void ComputeGeometry(bool bMeshOnly);
     //! this is where ComputeGeometry() outputs the geometry to
     std::vector<VERTEX_FORMAT> m_vSliceTriangles;
+    //! the result of ComputeGeometry(), either m_vSliceTriangles or the
+    //! slices from the geometry cache
+    const std::vector<VERTEX_FORMAT>& GetSliceTriangles() const {
+      return m_pCachedGeometry ? m_pCachedGeometry->vSlices[0]
+                               : m_vSliceTriangles;
+    }
+
+    /**
+     \brief Enables or disables the reuse of slices across bricks
+
+     Bricks of identical size that are rendered with the same view only differ
+     by a translation, so their slices can be copied and shifted rather than
+     recomputed.  Enabled by default.
+    */
+    void SetSliceReuse(bool bReuse) {
+      m_bSliceReuse = bReuse;
+      m_bTemplateValid = false;
+    }
 
   protected:
 
@@ -75,6 +93,27 @@ namespace tuvok {
     //! depth of the slice furthest away from the viewer
     float m_fMinZ;
 
+    //! if true slices of the previous brick are reused for congruent bricks
+    bool m_bSliceReuse;
+    //! true if m_vSliceTemplate holds the slices of a previous brick
+    bool m_bTemplateValid;
+    /**
+      \brief slices of the last brick computed from scratch, relative to the
+      view space position of the brick center
+    */
+    std::vector<VERTEX_FORMAT> m_vSliceTemplate;
+    //! brick parameters m_vSliceTemplate was computed with
+    FLOATVECTOR3 m_vTemplateAspect;
+    UINTVECTOR3  m_vTemplateSize;
+    FLOATVECTOR3 m_vTemplateTexCoordMin;
+    FLOATVECTOR3 m_vTemplateTexCoordMax;
+    float        m_fTemplateSamplingModifier;
+    FLOATMATRIX4 m_matTemplateWorld;
+    FLOATMATRIX4 m_matTemplateView;
+    bool         m_bTemplateClipVolume;
+    //! per layer offsets into m_vSliceTriangles, kept to avoid reallocation
+    std::vector<size_t> m_vLayerOffsets;
+
     /** 
      \brief Calls InitBBOX from the parent class which computes the transformed 
     vertices m_pfBBOXVertex from m_pfBBOXStaticVertex and in addition to this
@@ -131,7 +170,29 @@ namespace tuvok {
      \param fArray the vertices defining the lines
     */
     static void SortByGradient(std::vector<VERTEX_FORMAT>& fArray);
-  
+    //! \copydoc SortByGradient, for fixed size arrays of iCount vertices
+    static void SortByGradient(VERTEX_FORMAT* fArray, size_t iCount);
+
+    /**
+     \brief Computes all slices of the current brick into m_vSliceTriangles
+
+     Layers are intersected with the bounding box independently, so they are
+     processed in parallel and each layer writes into its own range of the
+     (preallocated) output.  Only valid if no mesh is interleaved.
+
+     \param fLayerDistance the distance between two slices
+    */
+    void ComputeSlicesParallel(float fLayerDistance);
+
+    //! view space position of the center of the current brick
+    FLOATVECTOR3 BrickOrigin() const;
+    //! true if m_vSliceTemplate is valid for the current brick parameters
+    bool TemplateMatches() const;
+    //! stores the current m_vSliceTriangles as the template for reuse
+    void StoreTemplate();
+    //! fills m_vSliceTriangles from the template, translated to this brick
+    void ApplyTemplate();
+
     SortIndexPVec::const_iterator m_MeshTransferIter;
     void DepthSortMeshWithVolume();
     void InsertMeshUpToSlice(float fDepth);
@@ -0,0 +1,169 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    SBVRGeometryCache.cpp
+*/
+
+#include "StdTuvokDefines.h"
+#include "SBVRGeometryCache.h"
+
+using namespace tuvok;
+
+namespace {
+  // FNV-1a over the raw bytes of a value
+  template<typename T>
+  void HashBytes(size_t& iHash, const T& value) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+    for (size_t i = 0;i<sizeof(T);i++) {
+      iHash ^= p[i];
+      iHash *= 16777619u;
+    }
+  }
+}
+
+SBVRGeometryKey::SBVRGeometryKey() :
+  m_vAspect(1,1,1),
+  m_vSize(1,1,1),
+  m_vTexCoordMin(0,0,0),
+  m_vTexCoordMax(1,1,1),
+  m_fSamplingModifier(1.0f),
+  m_bClip(false),
+  m_bClipVolume(false),
+  m_bClipMesh(false),
+  m_iVariant(0)
+{
+}
+
+bool SBVRGeometryKey::operator==(const SBVRGeometryKey& other) const {
+  if (m_iVariant != other.m_iVariant ||
+      m_fSamplingModifier != other.m_fSamplingModifier ||
+      m_vSize != other.m_vSize ||
+      m_vAspect != other.m_vAspect ||
+      m_vTexCoordMin != other.m_vTexCoordMin ||
+      m_vTexCoordMax != other.m_vTexCoordMax ||
+      m_matWorldView != other.m_matWorldView ||
+      m_matView != other.m_matView ||
+      m_bClip != other.m_bClip) return false;
+
+  return !m_bClip || (m_bClipVolume == other.m_bClipVolume &&
+                      m_bClipMesh == other.m_bClipMesh &&
+                      !(m_ClipPlane != other.m_ClipPlane));
+}
+
+size_t SBVRGeometryKey::Hash() const {
+  // the clip plane is left out, it rarely differs between two keys that
+  // agree on everything else
+  size_t iHash = size_t(2166136261u);
+  HashBytes(iHash, m_matWorldView);
+  HashBytes(iHash, m_vAspect);
+  HashBytes(iHash, m_vSize);
+  HashBytes(iHash, m_fSamplingModifier);
+  HashBytes(iHash, m_iVariant);
+  return iHash;
+}
+
+SBVRGeometryCache::SBVRGeometryCache(uint64_t iBudget) :
+  m_iBudget(iBudget),
+  m_iMemoryUsage(0),
+  m_iHits(0),
+  m_iMisses(0)
+{
+}
+
+SBVRGeometryCache::EntryIndex::iterator
+SBVRGeometryCache::FindIndex(const SBVRGeometryKey& key, size_t iHash) {
+  std::pair<EntryIndex::iterator, EntryIndex::iterator> range =
+    m_Index.equal_range(iHash);
+  for (EntryIndex::iterator i = range.first; i != range.second; ++i) {
+    if (i->second->key == key) return i;
+  }
+  return m_Index.end();
+}
+
+std::shared_ptr<const SBVRGeometry>
+SBVRGeometryCache::Find(const SBVRGeometryKey& key) {
+  EntryIndex::iterator i = FindIndex(key, key.Hash());
+  if (i == m_Index.end()) {
+    ++m_iMisses;
+    return std::shared_ptr<const SBVRGeometry>();
+  }
+  ++m_iHits;
+  // move to the front of the LRU list, splice keeps the iterator valid
+  m_Entries.splice(m_Entries.begin(), m_Entries, i->second);
+  return i->second->pGeometry;
+}
+
+void SBVRGeometryCache::Insert(const SBVRGeometryKey& key,
+                               std::shared_ptr<const SBVRGeometry> pGeometry) {
+  const size_t iHash = key.Hash();
+  EntryIndex::iterator i = FindIndex(key, iHash);
+  if (i != m_Index.end()) {
+    m_iMemoryUsage -= i->second->iSize;
+    m_Entries.erase(i->second);
+    m_Index.erase(i);
+  }
+
+  uint64_t iSize = sizeof(Entry);
+  for (size_t j = 0;j<3;j++) {
+    iSize += pGeometry->vSlices[j].size() * sizeof(VERTEX_FORMAT);
+  }
+  // an entry larger than the whole budget would only evict everything else
+  if (iSize > m_iBudget) return;
+
+  Evict(m_iBudget - iSize);
+
+  Entry e;
+  e.key = key;
+  e.pGeometry = pGeometry;
+  e.iSize = iSize;
+  m_Entries.push_front(e);
+  m_Index.insert(std::make_pair(iHash, m_Entries.begin()));
+  m_iMemoryUsage += iSize;
+}
+
+void SBVRGeometryCache::Clear() {
+  m_Index.clear();
+  m_Entries.clear();
+  m_iMemoryUsage = 0;
+}
+
+void SBVRGeometryCache::SetBudget(uint64_t iBudget) {
+  m_iBudget = iBudget;
+  Evict(m_iBudget);
+}
+
+void SBVRGeometryCache::Evict(uint64_t iBudget) {
+  while (m_iMemoryUsage > iBudget && !m_Entries.empty()) {
+    EntryList::iterator last = --m_Entries.end();
+    EntryIndex::iterator i = FindIndex(last->key, last->key.Hash());
+    if (i != m_Index.end()) m_Index.erase(i);
+    m_iMemoryUsage -= last->iSize;
+    m_Entries.erase(last);
+  }
+}
@@ -0,0 +1,127 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    SBVRGeometryCache.h
+  \brief   LRU cache of slice geometry for the slice-based volume renderers.
+*/
+#pragma once
+
+#ifndef SBVRGEOMETRYCACHE_H
+#define SBVRGEOMETRYCACHE_H
+
+#include "../StdTuvokDefines.h"
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "SBVRGeogen.h"
+
+namespace tuvok {
+
+  /**
+   \class SBVRGeometryKey
+   \brief Everything the slice geometry of a single brick depends on
+  */
+  class SBVRGeometryKey
+  {
+  public:
+    SBVRGeometryKey();
+
+    bool operator==(const SBVRGeometryKey& other) const;
+    size_t Hash() const;
+
+    //! brick translation * world * view
+    FLOATMATRIX4 m_matWorldView;
+    FLOATMATRIX4 m_matView;
+    FLOATVECTOR3 m_vAspect;
+    UINTVECTOR3  m_vSize;
+    FLOATVECTOR3 m_vTexCoordMin;
+    FLOATVECTOR3 m_vTexCoordMax;
+    float        m_fSamplingModifier;
+    //! clip plane, only meaningful if m_bClip is set
+    PLANE<float> m_ClipPlane;
+    bool         m_bClip;
+    bool         m_bClipVolume;
+    bool         m_bClipMesh;
+    //! geometry generator specific, e.g. the 2D slicing method
+    int          m_iVariant;
+  };
+
+  /**
+   \class SBVRGeometryCache
+   \brief Keeps the slices generated for bricks across frames
+
+   Progressive refinement and stereo rendering request the geometry of the
+   same brick with the same view several times.  This cache hands out the
+   previously generated slices in that case.  Entries are evicted least
+   recently used first once the memory budget is exceeded.
+  */
+  class SBVRGeometryCache
+  {
+  public:
+    explicit SBVRGeometryCache(uint64_t iBudget);
+
+    /**
+     \brief Looks up the geometry for the given parameters
+     \return the cached geometry or NULL, counts a hit or a miss
+    */
+    std::shared_ptr<const SBVRGeometry> Find(const SBVRGeometryKey& key);
+    //! stores the geometry for the given parameters and enforces the budget
+    void Insert(const SBVRGeometryKey& key,
+                std::shared_ptr<const SBVRGeometry> pGeometry);
+    void Clear();
+
+    //! sets the maximum memory in bytes and evicts entries to match it
+    void SetBudget(uint64_t iBudget);
+    uint64_t GetBudget() const {return m_iBudget;}
+    uint64_t GetMemoryUsage() const {return m_iMemoryUsage;}
+    uint64_t GetHits() const {return m_iHits;}
+    uint64_t GetMisses() const {return m_iMisses;}
+
+  private:
+    struct Entry {
+      SBVRGeometryKey key;
+      std::shared_ptr<const SBVRGeometry> pGeometry;
+      uint64_t iSize;
+    };
+    typedef std::list<Entry> EntryList;
+    typedef std::unordered_multimap<size_t, EntryList::iterator> EntryIndex;
+
+    //! most recently used entry first
+    EntryList  m_Entries;
+    EntryIndex m_Index;
+    uint64_t   m_iBudget;
+    uint64_t   m_iMemoryUsage;
+    uint64_t   m_iHits;
+    uint64_t   m_iMisses;
+
+    EntryIndex::iterator FindIndex(const SBVRGeometryKey& key, size_t iHash);
+    void Evict(uint64_t iBudget);
+  };
+};
+#endif // SBVRGEOMETRYCACHE_H
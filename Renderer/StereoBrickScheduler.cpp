@@ -0,0 +1,142 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    StereoBrickScheduler.cpp
+*/
+
+#include "StereoBrickScheduler.h"
+#include <algorithm>
+#include <cassert>
+#include <map>
+
+using namespace tuvok;
+
+namespace {
+  /// Positions of the longest strictly increasing subsequence of vSeq, found
+  /// by patience sorting in O(n log n).
+  std::vector<bool> LongestIncreasing(const std::vector<size_t>& vSeq) {
+    const size_t NONE = ~size_t(0);
+    std::vector<size_t> vTails;   // smallest tail value of each length
+    std::vector<size_t> vTailPos; // ... and its position in vSeq
+    std::vector<size_t> vPrev(vSeq.size(), NONE);
+
+    for (size_t i = 0;i<vSeq.size();i++) {
+      const size_t iLength = std::lower_bound(vTails.begin(), vTails.end(),
+                                              vSeq[i]) - vTails.begin();
+      if (iLength > 0) vPrev[i] = vTailPos[iLength-1];
+      if (iLength == vTails.size()) {
+        vTails.push_back(vSeq[i]);
+        vTailPos.push_back(i);
+      } else {
+        vTails[iLength] = vSeq[i];
+        vTailPos[iLength] = i;
+      }
+    }
+
+    std::vector<bool> vInSequence(vSeq.size(), false);
+    if (!vTailPos.empty()) {
+      for (size_t i = vTailPos.back(); i != NONE; i = vPrev[i]) {
+        vInSequence[i] = true;
+      }
+    }
+    return vInSequence;
+  }
+}
+
+void StereoBrickScheduler::Clear() {
+  m_vSteps.clear();
+  m_vBricksDone.clear();
+  m_iShared = 0;
+}
+
+void StereoBrickScheduler::Build(const std::vector<BrickKey>& vFirstEye,
+                                 const std::vector<BrickKey>& vSecondEye,
+                                 bool bOrderMatters) {
+  assert(vFirstEye.size() == vSecondEye.size());
+  Clear();
+  const size_t n = std::min(vFirstEye.size(), vSecondEye.size());
+
+  std::map<BrickKey, size_t> mSecondIndex;
+  for (size_t i = 0;i<n;i++) mSecondIndex[vSecondEye[i]] = i;
+
+  Step step;
+  if (!bOrderMatters) {
+    m_vSteps.reserve(n);
+    for (size_t i = 0;i<n;i++) {
+      step.key = vFirstEye[i];
+      step.iBrick[0] = i;
+      step.iBrick[1] = mSecondIndex[vFirstEye[i]];
+      m_vSteps.push_back(step);
+    }
+  } else {
+    // the position of each of the second eye's bricks in the first eye's
+    // list; an increasing run of positions is a run both orders agree on
+    std::map<BrickKey, size_t> mFirstIndex;
+    for (size_t i = 0;i<n;i++) mFirstIndex[vFirstEye[i]] = i;
+    std::vector<size_t> vSeq(n);
+    for (size_t j = 0;j<n;j++) vSeq[j] = mFirstIndex[vSecondEye[j]];
+
+    const std::vector<bool> vSharedSecond = LongestIncreasing(vSeq);
+    std::vector<bool> vSharedFirst(n, false);
+    for (size_t j = 0;j<n;j++) {
+      if (vSharedSecond[j]) vSharedFirst[vSeq[j]] = true;
+    }
+
+    // merge both lists: the shared bricks appear in the same relative order
+    // in both, the others are emitted as soon as their eye reaches them
+    size_t i = 0, j = 0;
+    while (i < n || j < n) {
+      if (i < n && !vSharedFirst[i]) {
+        step.key = vFirstEye[i];
+        step.iBrick[0] = i++;
+        step.iBrick[1] = NO_BRICK;
+      } else if (j < n && !vSharedSecond[j]) {
+        step.key = vSecondEye[j];
+        step.iBrick[0] = NO_BRICK;
+        step.iBrick[1] = j++;
+      } else {
+        assert(i < n && j < n && vFirstEye[i] == vSecondEye[j]);
+        step.key = vFirstEye[i];
+        step.iBrick[0] = i++;
+        step.iBrick[1] = j++;
+      }
+      m_vSteps.push_back(step);
+    }
+  }
+
+  size_t iDone[2] = {0, 0};
+  m_vBricksDone.reserve(m_vSteps.size());
+  for (std::vector<Step>::const_iterator s = m_vSteps.begin();
+       s != m_vSteps.end(); ++s) {
+    if (s->iBrick[0] != NO_BRICK) iDone[0]++;
+    if (s->iBrick[1] != NO_BRICK) iDone[1]++;
+    if (s->iBrick[0] != NO_BRICK && s->iBrick[1] != NO_BRICK) m_iShared++;
+    m_vBricksDone.push_back(std::min(iDone[0], iDone[1]));
+  }
+}
@@ -0,0 +1,95 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    StereoBrickScheduler.h
+  \brief   Interleaves the brick lists of both eyes for stereo rendering.
+*/
+#pragma once
+
+#ifndef STEREOBRICKSCHEDULER_H
+#define STEREOBRICKSCHEDULER_H
+
+#include "../StdTuvokDefines.h"
+#include <vector>
+#include "IO/Brick.h"
+
+namespace tuvok {
+
+  /**
+   \class StereoBrickScheduler
+   \brief Orders the bricks of a stereo subframe so that a brick is bound
+          once for both eyes wherever possible
+
+   Both eyes render the same set of bricks, but each eye composites them in
+   its own distance order.  The schedule follows the order of the first eye;
+   a brick is shared, i.e. rendered for both eyes while it is bound, if it
+   is part of the longest sequence of bricks both orders agree on.  The
+   remaining bricks are rendered for each eye in a step of their own at the
+   position its order demands.  If the order does not matter (depth tested
+   isosurfaces) every brick is shared.
+  */
+  class StereoBrickScheduler
+  {
+  public:
+    static const size_t NO_BRICK = ~size_t(0);
+
+    struct Step {
+      BrickKey key;
+      //! index of the brick in the list of each eye, NO_BRICK if the eye
+      //! does not render anything in this step
+      size_t   iBrick[2];
+    };
+
+    StereoBrickScheduler() : m_iShared(0) {}
+
+    //! \param vFirstEye  bricks in the compositing order of the first eye
+    //! \param vSecondEye the same bricks in the order of the second eye
+    //! \param bOrderMatters false if the eyes may share any order
+    void Build(const std::vector<BrickKey>& vFirstEye,
+               const std::vector<BrickKey>& vSecondEye,
+               bool bOrderMatters);
+    void Clear();
+
+    size_t GetStepCount() const { return m_vSteps.size(); }
+    const Step& GetStep(size_t iStep) const { return m_vSteps[iStep]; }
+    //! number of bricks both eyes have rendered after the first iSteps steps
+    size_t GetBricksDone(size_t iSteps) const {
+      return iSteps == 0 ? 0 : m_vBricksDone[iSteps-1];
+    }
+    //! number of bricks rendered for both eyes in a single step
+    size_t GetSharedCount() const { return m_iShared; }
+
+  private:
+    std::vector<Step>   m_vSteps;
+    std::vector<size_t> m_vBricksDone;  ///< per step, see GetBricksDone
+    size_t              m_iShared;
+  };
+}
+
+#endif // STEREOBRICKSCHEDULER_H
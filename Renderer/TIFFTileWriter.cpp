@@ -0,0 +1,227 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    TIFFTileWriter.cpp
+*/
+
+#include <cstring>
+#include "TIFFTileWriter.h"
+#include "Controller/Controller.h"
+
+using namespace tuvok;
+
+namespace {
+  enum {
+    TIFF_SHORT = 3,
+    TIFF_LONG  = 4
+  };
+
+  /// one entry of the image file directory; values of up to four bytes are
+  /// stored in the entry itself, larger ones at 'value' as an offset
+  struct IFDEntry {
+    uint16_t tag;
+    uint16_t type;
+    uint32_t count;
+    uint32_t value;
+  };
+
+  IFDEntry Entry(uint16_t tag, uint16_t type, uint32_t count,
+                 uint32_t value) {
+    IFDEntry e = { tag, type, count, value };
+    // a single SHORT occupies the first two bytes of the value field
+    if (type == TIFF_SHORT && count == 1) {
+      const uint16_t s = uint16_t(value);
+      e.value = 0;
+      memcpy(&e.value, &s, sizeof(s));
+    }
+    return e;
+  }
+
+  bool LittleEndianHost() {
+    const uint16_t i = 1;
+    return *reinterpret_cast<const uint8_t*>(&i) == 1;
+  }
+}
+
+TIFFTileWriter::TIFFTileWriter() :
+  m_pFile(NULL),
+  m_iSamples(0),
+  m_iBitsPerSample(0),
+  m_iOffset(0)
+{
+}
+
+TIFFTileWriter::~TIFFTileWriter() {
+  if (m_pFile) fclose(m_pFile);
+}
+
+bool TIFFTileWriter::IsValidTileSize(const UINTVECTOR2& vTileSize) {
+  return vTileSize.x > 0 && vTileSize.y > 0 &&
+         vTileSize.x % 16 == 0 && vTileSize.y % 16 == 0;
+}
+
+size_t TIFFTileWriter::GetTileBytes() const {
+  return size_t(m_vTileSize.x) * m_vTileSize.y * m_iSamples *
+         (m_iBitsPerSample / 8);
+}
+
+bool TIFFTileWriter::Fail(const char* strWhat) {
+  T_ERROR("Unable to write %s: %s.", m_strFilename.c_str(), strWhat);
+  if (m_pFile) fclose(m_pFile);
+  m_pFile = NULL;
+  return false;
+}
+
+bool TIFFTileWriter::Write(const void* pData, size_t iBytes) {
+  if (fwrite(pData, 1, iBytes, m_pFile) != iBytes) return false;
+  m_iOffset += iBytes;
+  return true;
+}
+
+bool TIFFTileWriter::Open(const std::string& strFilename,
+                          const UINTVECTOR2& vImageSize,
+                          const UINTVECTOR2& vTileSize, uint32_t iSamples,
+                          uint32_t iBitsPerSample) {
+  m_strFilename = strFilename;
+  if (!IsValidTileSize(vTileSize) || vImageSize.x == 0 || vImageSize.y == 0 ||
+      (iSamples != 3 && iSamples != 4) ||
+      (iBitsPerSample != 8 && iBitsPerSample != 16)) {
+    T_ERROR("Invalid TIFF layout for %s.", strFilename.c_str());
+    return false;
+  }
+
+  m_vImageSize = vImageSize;
+  m_vTileSize = vTileSize;
+  m_vTileCount = UINTVECTOR2((vImageSize.x + vTileSize.x - 1) / vTileSize.x,
+                             (vImageSize.y + vTileSize.y - 1) / vTileSize.y);
+  m_iSamples = iSamples;
+  m_iBitsPerSample = iBitsPerSample;
+  m_vTileOffsets.assign(size_t(m_vTileCount.x) * m_vTileCount.y, 0);
+
+  // classic TIFF addresses 4 GB; leave room for the directory
+  const uint64_t iDataBytes = uint64_t(GetTileBytes()) *
+                              m_vTileOffsets.size();
+  if (iDataBytes + (uint64_t(1) << 20) > 0xFFFFFFFFull) {
+    T_ERROR("Image %s is too large for a TIFF file (%llu bytes).",
+            strFilename.c_str(), static_cast<unsigned long long>(iDataBytes));
+    return false;
+  }
+
+  m_pFile = fopen(strFilename.c_str(), "wb");
+  if (!m_pFile) return Fail("can not open the file");
+  m_iOffset = 0;
+
+  // samples are written in host order, so declare that order
+  const char order = LittleEndianHost() ? 'I' : 'M';
+  const char header[2] = { order, order };
+  const uint16_t iMagic = 42;
+  const uint32_t iIFDOffset = 0;  // patched by Close()
+  if (!Write(header, 2) || !Write(&iMagic, 2) || !Write(&iIFDOffset, 4)) {
+    return Fail("can not write the header");
+  }
+  return true;
+}
+
+bool TIFFTileWriter::WriteTile(uint32_t x, uint32_t y, const void* pData) {
+  if (!m_pFile) return false;
+  if (x >= m_vTileCount.x || y >= m_vTileCount.y) {
+    T_ERROR("Tile %u,%u is outside of %s.", x, y, m_strFilename.c_str());
+    return false;
+  }
+  m_vTileOffsets[size_t(y) * m_vTileCount.x + x] = uint32_t(m_iOffset);
+  if (!Write(pData, GetTileBytes())) return Fail("can not write a tile");
+  return true;
+}
+
+bool TIFFTileWriter::Close() {
+  if (!m_pFile) return false;
+  for (size_t i = 0;i<m_vTileOffsets.size();i++) {
+    if (m_vTileOffsets[i] == 0) return Fail("not all tiles were written");
+  }
+
+  // word alignment for the arrays and the directory
+  if (m_iOffset % 2) {
+    const uint8_t pad = 0;
+    if (!Write(&pad, 1)) return Fail("can not write the directory");
+  }
+
+  const uint32_t iTiles = uint32_t(m_vTileOffsets.size());
+  const std::vector<uint32_t> vByteCounts(iTiles, uint32_t(GetTileBytes()));
+  const std::vector<uint16_t> vBits(m_iSamples, uint16_t(m_iBitsPerSample));
+
+  // arrays that do not fit into their directory entries come first
+  const uint32_t iBitsOffset = uint32_t(m_iOffset);
+  if (!Write(&vBits[0], vBits.size() * sizeof(uint16_t)))
+    return Fail("can not write the directory");
+  uint32_t iOffsetsOffset = m_vTileOffsets[0];
+  uint32_t iCountsOffset = vByteCounts[0];
+  if (iTiles > 1) {
+    iOffsetsOffset = uint32_t(m_iOffset);
+    if (!Write(&m_vTileOffsets[0], iTiles * sizeof(uint32_t)))
+      return Fail("can not write the directory");
+    iCountsOffset = uint32_t(m_iOffset);
+    if (!Write(&vByteCounts[0], iTiles * sizeof(uint32_t)))
+      return Fail("can not write the directory");
+  }
+
+  std::vector<IFDEntry> vEntries;
+  vEntries.push_back(Entry(256, TIFF_LONG, 1, m_vImageSize.x));
+  vEntries.push_back(Entry(257, TIFF_LONG, 1, m_vImageSize.y));
+  vEntries.push_back(Entry(258, TIFF_SHORT, m_iSamples, iBitsOffset));
+  vEntries.push_back(Entry(259, TIFF_SHORT, 1, 1));  // no compression
+  vEntries.push_back(Entry(262, TIFF_SHORT, 1, 2));  // RGB
+  vEntries.push_back(Entry(277, TIFF_SHORT, 1, m_iSamples));
+  vEntries.push_back(Entry(284, TIFF_SHORT, 1, 1));  // interleaved
+  vEntries.push_back(Entry(322, TIFF_LONG, 1, m_vTileSize.x));
+  vEntries.push_back(Entry(323, TIFF_LONG, 1, m_vTileSize.y));
+  vEntries.push_back(Entry(324, TIFF_LONG, iTiles, iOffsetsOffset));
+  vEntries.push_back(Entry(325, TIFF_LONG, iTiles, iCountsOffset));
+  if (m_iSamples == 4) {
+    vEntries.push_back(Entry(338, TIFF_SHORT, 1, 1));  // premultiplied
+  }
+
+  const uint32_t iIFDOffset = uint32_t(m_iOffset);
+  const uint16_t iEntryCount = uint16_t(vEntries.size());
+  const uint32_t iNextIFD = 0;
+  if (!Write(&iEntryCount, sizeof(iEntryCount)) ||
+      !Write(&vEntries[0], vEntries.size() * sizeof(IFDEntry)) ||
+      !Write(&iNextIFD, sizeof(iNextIFD))) {
+    return Fail("can not write the directory");
+  }
+
+  if (fseek(m_pFile, 4, SEEK_SET) != 0 ||
+      fwrite(&iIFDOffset, 1, sizeof(iIFDOffset), m_pFile) !=
+        sizeof(iIFDOffset)) {
+    return Fail("can not write the header");
+  }
+  const bool bClosed = fclose(m_pFile) == 0;
+  m_pFile = NULL;
+  if (!bClosed) T_ERROR("Unable to write %s.", m_strFilename.c_str());
+  return bClosed;
+}
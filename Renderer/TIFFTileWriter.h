@@ -0,0 +1,100 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2012 Interactive Visualization and Data Analysis Group,
+   Saarland University
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    TIFFTileWriter.h
+  \brief   Writes a tiled TIFF one tile at a time.
+*/
+#pragma once
+
+#ifndef TUVOK_TIFFTILEWRITER_H
+#define TUVOK_TIFFTILEWRITER_H
+
+#include "../StdTuvokDefines.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Basics/Vectors.h"
+
+namespace tuvok {
+
+  /**
+   \class TIFFTileWriter
+   \brief Uncompressed, tiled baseline TIFF for images that do not fit in
+          memory
+
+   Tiles may arrive in any order; each is written to the file right away
+   and only the tile offsets are kept until Close() appends the image
+   directory.  Tiles are always complete, those at the right and bottom
+   border are padded.  RGBA images are flagged as premultiplied alpha, like
+   the ones TTIFFWriter writes.
+  */
+  class TIFFTileWriter
+  {
+  public:
+    TIFFTileWriter();
+    ~TIFFTileWriter();
+
+    //! tile sizes must be multiples of 16
+    static bool IsValidTileSize(const UINTVECTOR2& vTileSize);
+
+    //! \param iSamples 3 (RGB) or 4 (RGBA)
+    //! \param iBitsPerSample 8 or 16
+    bool Open(const std::string& strFilename, const UINTVECTOR2& vImageSize,
+              const UINTVECTOR2& vTileSize, uint32_t iSamples,
+              uint32_t iBitsPerSample);
+    //! Writes tile (x,y), counted from the top left.  pData holds the rows
+    //! of the tile from top to bottom with interleaved samples in host
+    //! byte order.
+    bool WriteTile(uint32_t x, uint32_t y, const void* pData);
+    //! Writes the image directory.  Fails if a tile is missing.
+    bool Close();
+
+    UINTVECTOR2 GetTileCount() const { return m_vTileCount; }
+    size_t GetTileBytes() const;
+
+  private:
+    TIFFTileWriter(const TIFFTileWriter&);            ///< unimplemented
+    TIFFTileWriter& operator=(const TIFFTileWriter&); ///< unimplemented
+
+    bool Write(const void* pData, size_t iBytes);
+    bool Fail(const char* strWhat);
+
+    std::string           m_strFilename;
+    FILE*                 m_pFile;
+    UINTVECTOR2           m_vImageSize;
+    UINTVECTOR2           m_vTileSize;
+    UINTVECTOR2           m_vTileCount;
+    uint32_t              m_iSamples;
+    uint32_t              m_iBitsPerSample;
+    uint64_t              m_iOffset;       ///< current end of the file
+    std::vector<uint32_t> m_vTileOffsets;  ///< 0 = not written yet
+  };
+}
+
+#endif // TUVOK_TIFFTILEWRITER_H
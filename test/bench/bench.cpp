@@ -0,0 +1,679 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+  \file    bench.cpp
+  \brief   Renders a dataset along a camera path with every combination of
+           renderer, render mode, LOD setting and viewport size and writes
+           timings and performance counters as JSON and CSV.
+           With --lua, times the Lua scripting layer instead.
+*/
+#include "StdTuvokDefines.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <tclap/CmdLine.h>
+
+#include "Basics/SysTools.h"
+#include "Controller/Controller.h"
+#include "Controller/PerfCounters.h"
+#include "IO/IOManager.h"
+#include "Renderer/AbstrRenderer.h"
+#include "Renderer/GL/GLContext.h"
+#include "Renderer/GPUMemMan/GPUMemMan.h"
+#include "LuaScripting/LuaScripting.h"
+#include "LuaScripting/TuvokSpecific/LuaTuvokTypes.h"
+
+#include "context.h"
+
+using namespace tuvok;
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+double ms_since(const bench_clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(
+    bench_clock::now() - start
+  ).count();
+}
+
+struct RendererType {
+  MasterController::EVolumeRendererType type;
+  const char* name;
+};
+const RendererType renderers[] = {
+  { MasterController::OPENGL_SBVR,       "sbvr" },
+  { MasterController::OPENGL_RAYCASTER,  "raycaster" },
+  { MasterController::OPENGL_GRIDLEAPER, "gridleaper" },
+  { MasterController::OPENGL_2DSBVR,     "sbvr2d" },
+};
+
+struct RenderMode {
+  AbstrRenderer::ERenderMode mode;
+  const char* name;
+};
+const RenderMode modes[] = {
+  { AbstrRenderer::RM_1DTRANS,    "1d" },
+  { AbstrRenderer::RM_2DTRANS,    "2d" },
+  { AbstrRenderer::RM_ISOSURFACE, "iso" },
+};
+
+/// 'interactive' refines from coarse to fine LODs, 'capture' renders the
+/// finest LOD right away.
+struct Target {
+  AbstrRenderer::ERendererTarget target;
+  const char* name;
+};
+const Target targets[] = {
+  { AbstrRenderer::RT_INTERACTIVE, "interactive" },
+  { AbstrRenderer::RT_CAPTURE,     "capture" },
+};
+
+struct Counter {
+  enum PerfCounter id;
+  const char* name;
+};
+const Counter counters[] = {
+  { PERF_SUBFRAMES,            "subframes" },
+  { PERF_RENDER,               "render" },
+  { PERF_RAYCAST,              "raycast" },
+  { PERF_READ_HTABLE,          "read_htable" },
+  { PERF_CONDENSE_HTABLE,      "condense_htable" },
+  { PERF_SORT_HTABLE,          "sort_htable" },
+  { PERF_UPLOAD_BRICKS,        "upload_bricks" },
+  { PERF_POOL_SORT,            "pool_sort" },
+  { PERF_POOL_UPLOADED_MEM,    "pool_uploaded_mem" },
+  { PERF_POOL_GET_BRICK,       "pool_get_brick" },
+  { PERF_POOL_UPLOAD_BRICK,    "pool_upload_brick" },
+  { PERF_POOL_UPLOAD_TEXEL,    "pool_upload_texel" },
+  { PERF_POOL_UPLOAD_METADATA, "pool_upload_metadata" },
+  { PERF_DY_GET_BRICK,         "dy_get_brick" },
+  { PERF_DY_CACHE_LOOKUPS,     "dy_cache_lookups" },
+  { PERF_DY_LOAD_BRICK,        "dy_load_brick" },
+  { PERF_DY_CACHE_ADDS,        "dy_cache_adds" },
+  { PERF_DY_BRICK_COPIED,      "dy_brick_copied" },
+  { PERF_EO_BRICKS,            "eo_bricks" },
+  { PERF_EO_DISK_READ,         "eo_disk_read" },
+  { PERF_EO_DECOMPRESSION,     "eo_decompression" },
+};
+const size_t NUM_COUNTERS = sizeof(counters) / sizeof(counters[0]);
+
+/// A renderer that never converges must not hang the benchmark.
+const size_t MAX_PAINTS_PER_FRAME = 10000;
+
+struct Config {
+  size_t renderer;
+  size_t mode;
+  size_t target;
+  bool lod;            ///< else the renderer's default LOD limits
+  UINTVECTOR2 lodLimits;
+  UINTVECTOR2 size;
+};
+
+struct Summary {
+  Summary() : mean(0), min(0), p50(0), p90(0), p95(0), p99(0), max(0) {}
+  double mean, min, p50, p90, p95, p99, max;
+};
+
+struct Result {
+  Result() : loadMs(0), converged(true), gpuPeak(0), cpuPeak(0) {}
+  Config cfg;
+  std::string error;   ///< empty if the run succeeded
+  double loadMs;       ///< setup and the first frame, incl. shader builds
+  bool converged;      ///< false if a frame hit MAX_PAINTS_PER_FRAME
+  std::vector<double> firstImageMs;
+  std::vector<double> convergeMs;
+  std::vector<double> paints;
+  uint64_t gpuPeak;
+  uint64_t cpuPeak;
+  PerfCounterStats stats[NUM_COUNTERS];
+};
+
+/// nearest rank percentiles of the samples
+Summary summarize(std::vector<double> v) {
+  Summary s;
+  if(v.empty()) { return s; }
+  std::sort(v.begin(), v.end());
+  double sum = 0.0;
+  for(size_t i=0; i < v.size(); ++i) { sum += v[i]; }
+  s.mean = sum / v.size();
+  s.min = v.front();
+  s.max = v.back();
+  const double p[] = { 0.5, 0.9, 0.95, 0.99 };
+  double* out[] = { &s.p50, &s.p90, &s.p95, &s.p99 };
+  for(size_t i=0; i < 4; ++i) {
+    const size_t rank = static_cast<size_t>(std::ceil(p[i] * v.size()));
+    *out[i] = v[std::max<size_t>(rank, 1) - 1];
+  }
+  return s;
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+  std::vector<std::string> parts;
+  std::istringstream in(s);
+  std::string part;
+  while(std::getline(in, part, sep)) {
+    if(!part.empty()) { parts.push_back(part); }
+  }
+  return parts;
+}
+
+/// "640x480", or "0:2" with sep ':'
+UINTVECTOR2 parse_pair(const std::string& s, char sep) {
+  const std::vector<std::string> p = split(s, sep);
+  if(p.size() != 2) {
+    throw std::invalid_argument("could not parse '" + s + "'");
+  }
+  return UINTVECTOR2(atoi(p[0].c_str()), atoi(p[1].c_str()));
+}
+
+template<typename T, size_t N>
+std::vector<size_t> select(const T (&table)[N], const std::string& list) {
+  std::vector<size_t> sel;
+  const std::vector<std::string> names = split(list, ',');
+  for(size_t i=0; i < names.size(); ++i) {
+    size_t j = 0;
+    while(j < N && names[i] != table[j].name) { ++j; }
+    if(j == N) { throw std::invalid_argument("unknown name: " + names[i]); }
+    sel.push_back(j);
+  }
+  return sel;
+}
+
+/// paints until the renderer is done with the current view
+void converge(std::shared_ptr<LuaScripting> ss, const std::string& rn,
+              Result& r) {
+  const bench_clock::time_point start = bench_clock::now();
+  size_t n = 0;
+  do {
+    if(!ss->cexecRet<bool>(rn + ".paint")) {
+      throw std::runtime_error("paint failed");
+    }
+    // the wall clock is only meaningful once the GL is done
+    glFinish();
+    if(n++ == 0) { r.firstImageMs.push_back(ms_since(start)); }
+  } while(ss->cexecRet<bool>(rn + ".checkForRedraw") &&
+          n < MAX_PAINTS_PER_FRAME);
+  if(n == MAX_PAINTS_PER_FRAME) { r.converged = false; }
+  r.convergeMs.push_back(ms_since(start));
+  r.paints.push_back(static_cast<double>(n));
+}
+
+/// 'synthetic' non-empty: renders a SyntheticDataset instead of 'uvf'
+void run(const Config& cfg, const std::string& uvf,
+         const std::string& synthetic, const std::string& shaders,
+         uint32_t frames, Result& r) {
+  MasterController& mc = Controller::Instance();
+  std::shared_ptr<LuaScripting> ss = mc.LuaScript();
+  r.cfg = cfg;
+
+  const bench_clock::time_point start = bench_clock::now();
+  LuaClassInstance luaRen;
+  try {
+    luaRen = ss->cexecRet<LuaClassInstance>(
+      "tuvok.renderer.new", int(renderers[cfg.renderer].type),
+      false, false, false, false, false
+    );
+  } catch(const std::exception& e) {
+    r.error = e.what();
+    return;
+  }
+  const std::string rn = luaRen.fqName();
+  try {
+    const bool loaded = synthetic.empty() ?
+      ss->cexecRet<bool>(rn + ".loadDataset", uvf) :
+      ss->cexecRet<bool>(rn + ".loadSynthetic", synthetic);
+    if(!loaded) { throw std::runtime_error("could not load the data set"); }
+    ss->cexec(rn + ".addShaderPath", shaders);
+    ss->cexec(rn + ".initialize", GLContext::Current(0));
+    ss->cexec(rn + ".resize", cfg.size);
+    ss->cexec(rn + ".setRendererTarget", targets[cfg.target].target);
+    ss->cexec(rn + ".setRenderMode", modes[cfg.mode].mode);
+    if(cfg.lod) { ss->cexec(rn + ".setLODLimits", cfg.lodLimits); }
+
+    Result warmup;
+    converge(ss, rn, warmup);
+    r.loadMs = ms_since(start);
+
+    // only the camera path goes into the statistics
+    mc.ResetPerfCounters();
+    const GPUMemMan& mm = *mc.MemMan();
+    const double pi = 3.141592653589793238462643383;
+    FLOATMATRIX4 tilt;
+    tilt.RotationX(pi / 9.0);
+    for(uint32_t f=0; f < frames; ++f) {
+      FLOATMATRIX4 orbit;
+      orbit.RotationY(2.0 * pi * f / frames);
+      ss->cexec(rn + ".setRotation", orbit * tilt);
+      converge(ss, rn, r);
+      r.gpuPeak = std::max(r.gpuPeak, mm.GetAllocatedGPUMem());
+      r.cpuPeak = std::max(r.cpuPeak, mm.GetAllocatedCPUMem());
+    }
+    for(size_t c=0; c < NUM_COUNTERS; ++c) {
+      r.stats[c] = mc.PerfStats(counters[c].id);
+    }
+  } catch(const std::exception& e) {
+    r.error = e.what();
+  }
+  ss->cexec(rn + ".cleanup");
+  mc.ReleaseVolumeRenderer(luaRen);
+}
+
+std::string json_escape(const std::string& s) {
+  std::string out;
+  for(size_t i=0; i < s.size(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(s[i]);
+    if(c == '"' || c == '\\') { out += '\\'; out += s[i]; }
+    else if(c < 0x20) { out += ' '; }
+    else { out += s[i]; }
+  }
+  return out;
+}
+
+std::string config_name(const Config& c) {
+  std::ostringstream name;
+  name << renderers[c.renderer].name << "/" << modes[c.mode].name << "/"
+       << targets[c.target].name << "/";
+  if(c.lod) { name << "lod" << c.lodLimits.x << "-" << c.lodLimits.y; }
+  else { name << "lod-default"; }
+  name << "/" << c.size.x << "x" << c.size.y;
+  return name.str();
+}
+
+void json_summary(std::ostream& out, const char* name, const Summary& s) {
+  out << "\"" << name << "\":{\"mean\":" << s.mean << ",\"min\":" << s.min
+      << ",\"p50\":" << s.p50 << ",\"p90\":" << s.p90 << ",\"p95\":" << s.p95
+      << ",\"p99\":" << s.p99 << ",\"max\":" << s.max << "}";
+}
+
+bool write_json(const std::string& filename, const std::string& gl,
+                const std::vector<Result>& results) {
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::trunc);
+  out << "{\"gl_renderer\":\"" << json_escape(gl) << "\",\"results\":[\n";
+  for(size_t i=0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    const Config& c = r.cfg;
+    out << (i ? ",\n" : "") << "{\"name\":\"" << config_name(c) << "\""
+        << ",\"renderer\":\"" << renderers[c.renderer].name << "\""
+        << ",\"mode\":\"" << modes[c.mode].name << "\""
+        << ",\"target\":\"" << targets[c.target].name << "\""
+        << ",\"lod_limits\":";
+    if(c.lod) { out << "[" << c.lodLimits.x << "," << c.lodLimits.y << "]"; }
+    else { out << "null"; }
+    out << ",\"width\":" << c.size.x << ",\"height\":" << c.size.y;
+    if(!r.error.empty()) {
+      out << ",\"error\":\"" << json_escape(r.error) << "\"}";
+      continue;
+    }
+    const Summary converge = summarize(r.convergeMs);
+    out << ",\"frames\":" << r.convergeMs.size()
+        << ",\"converged\":" << (r.converged ? "true" : "false")
+        << ",\"load_ms\":" << r.loadMs
+        << ",\"fps\":" << (converge.mean > 0.0 ? 1000.0 / converge.mean : 0.0)
+        << ",";
+    json_summary(out, "converge_ms", converge);
+    out << ",";
+    json_summary(out, "first_image_ms", summarize(r.firstImageMs));
+    out << ",";
+    json_summary(out, "paints", summarize(r.paints));
+    out << ",\"gpu_mem_peak\":" << r.gpuPeak
+        << ",\"cpu_mem_peak\":" << r.cpuPeak << ",\"counters\":{";
+    for(size_t k=0; k < NUM_COUNTERS; ++k) {
+      const PerfCounterStats& s = r.stats[k];
+      out << (k ? "," : "") << "\"" << counters[k].name << "\":{\"count\":"
+          << s.count << ",\"sum\":" << s.sum << ",\"mean\":" << s.Mean()
+          << ",\"p50\":" << s.Percentile(0.5) << ",\"p95\":"
+          << s.Percentile(0.95) << ",\"max\":" << s.max << "}";
+    }
+    out << "}}";
+  }
+  out << "\n]}\n";
+  return !out.fail();
+}
+
+bool write_csv(const std::string& filename,
+               const std::vector<Result>& results) {
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::trunc);
+  out << "name,renderer,mode,target,lod_min,lod_max,width,height,error,"
+         "frames,converged,load_ms,fps,converge_mean_ms,converge_p50_ms,"
+         "converge_p95_ms,converge_p99_ms,converge_max_ms,first_image_p50_ms,"
+         "first_image_p95_ms,paints_mean,gpu_mem_peak,cpu_mem_peak";
+  for(size_t k=0; k < NUM_COUNTERS; ++k) {
+    out << "," << counters[k].name << "_count," << counters[k].name << "_sum";
+  }
+  out << "\n";
+  for(size_t i=0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    const Config& c = r.cfg;
+    out << config_name(c) << "," << renderers[c.renderer].name << ","
+        << modes[c.mode].name << "," << targets[c.target].name << ",";
+    if(c.lod) { out << c.lodLimits.x << "," << c.lodLimits.y; }
+    else { out << ","; }
+    std::string error = r.error;
+    std::replace(error.begin(), error.end(), ',', ';');
+    std::replace(error.begin(), error.end(), '\n', ' ');
+    out << "," << c.size.x << "," << c.size.y << "," << error;
+    if(!r.error.empty()) { out << "\n"; continue; }
+    const Summary converge = summarize(r.convergeMs);
+    const Summary first = summarize(r.firstImageMs);
+    out << "," << r.convergeMs.size() << "," << (r.converged ? 1 : 0) << ","
+        << r.loadMs << ","
+        << (converge.mean > 0.0 ? 1000.0 / converge.mean : 0.0) << ","
+        << converge.mean << "," << converge.p50 << "," << converge.p95 << ","
+        << converge.p99 << "," << converge.max << "," << first.p50 << ","
+        << first.p95 << "," << summarize(r.paints).mean << "," << r.gpuPeak
+        << "," << r.cpuPeak;
+    for(size_t k=0; k < NUM_COUNTERS; ++k) {
+      out << "," << r.stats[k].count << "," << r.stats[k].sum;
+    }
+    out << "\n";
+  }
+  return !out.fail();
+}
+
+struct LuaTiming {
+  LuaTiming() : us(0), allocs(0), heapBlocks(0) {}
+  double us;           ///< microseconds per run
+  double allocs;       ///< Lua allocations per run
+  double heapBlocks;   ///< parameter objects taken from the heap per run
+};
+
+/// state at the start of a measurement
+struct LuaStart {
+  explicit LuaStart(const LuaScripting& ss) :
+    time(bench_clock::now()),
+    allocs(ss.getMemoryStats().allocations),
+    heapBlocks(luaFreeListHeapBlocks()) {}
+
+  LuaTiming per_run(const LuaScripting& ss, uint32_t runs) const {
+    LuaTiming t;
+    t.us = 1000.0 * ms_since(time) / runs;
+    t.allocs = double(ss.getMemoryStats().allocations - allocs) / runs;
+    t.heapBlocks = double(luaFreeListHeapBlocks() - heapBlocks) / runs;
+    return t;
+  }
+
+  bench_clock::time_point time;
+  uint64_t allocs;
+  unsigned long long heapBlocks;
+};
+
+LuaTiming replay_script(LuaScripting& ss, const std::string& script,
+                        uint32_t runs) {
+  const LuaStart start(ss);
+  for(uint32_t i=0; i < runs; ++i) { ss.exec(script); }
+  return start.per_run(ss, runs);
+}
+
+/// a scripted animation: one command, its literals change every frame
+LuaTiming replay_animation(LuaScripting& ss, uint32_t runs) {
+  const LuaStart start(ss);
+  for(uint32_t i=0; i < runs; ++i) {
+    std::ostringstream cmd;
+    cmd << "v = math.v4(" << 0.01 * i << ", 1.5, 2.5, 1.0)";
+    ss.exec(cmd.str());
+  }
+  return start.per_run(ss, runs);
+}
+
+/// calls the bindings of the math regression scripts through their
+/// trampolines; the results are the only Lua allocations
+LuaTiming time_calls(LuaScripting& ss, uint32_t runs) {
+  const LuaStart start(ss);
+  for(uint32_t i=0; i < runs; ++i) {
+    ss.cexec("math.v4", 0.01 * i, 1.5, 2.5, 1.0);
+    ss.cexec("math.m4x4");
+  }
+  return start.per_run(ss, 2 * runs);
+}
+
+void print_calls(const char* name, const LuaTiming& t) {
+  std::cout << "calls, " << name << ": " << t.us << " us/call, " << t.allocs
+            << " Lua allocations/call, " << t.heapBlocks
+            << " heap blocks/call\n";
+}
+
+void print_speedup(const std::string& name, const LuaTiming& uncached,
+                   const LuaTiming& cached) {
+  std::cout << name << ": " << uncached.us << " us/run uncached, "
+            << cached.us << " us/run cached ("
+            << (cached.us > 0.0 ? uncached.us / cached.us : 0.0) << "x), "
+            << uncached.allocs << " -> " << cached.allocs
+            << " Lua allocations/run\n";
+}
+
+/// replays the scripts with and without the chunk cache, then times bound
+/// function calls with provenance disabled, recording and exempt
+void lua_bench(const std::vector<std::string>& scripts, uint32_t runs) {
+  std::shared_ptr<LuaScripting> ss = Controller::Instance().LuaScript();
+  const size_t cacheSize = ss->getChunkCacheSize();
+  // the scripts' calls would pile up on the undo stack
+  ss->setTempProvDisable(true);
+
+  for(size_t s=0; s < scripts.size(); ++s) {
+    std::ifstream in(scripts[s].c_str());
+    if(!in) { throw std::invalid_argument("could not read " + scripts[s]); }
+    std::ostringstream text;
+    text << in.rdbuf();
+
+    ss->setChunkCacheSize(0);
+    const LuaTiming uncached = replay_script(*ss, text.str(), runs);
+    ss->setChunkCacheSize(cacheSize);
+    ss->exec(text.str());
+    const LuaTiming cached = replay_script(*ss, text.str(), runs);
+    print_speedup(scripts[s], uncached, cached);
+  }
+
+  ss->setChunkCacheSize(0);
+  const LuaTiming uncached = replay_animation(*ss, runs);
+  ss->setChunkCacheSize(cacheSize);
+  const LuaTiming cached = replay_animation(*ss, runs);
+  print_speedup("animation", uncached, cached);
+
+  print_calls("provenance disabled", time_calls(*ss, runs));
+  ss->setTempProvDisable(false);
+  print_calls("provenance recording", time_calls(*ss, runs));
+  // permanent, but the process ends after the benchmark
+  ss->setProvenanceExempt("math.v4");
+  ss->setProvenanceExempt("math.m4x4");
+  print_calls("provenance exempt", time_calls(*ss, runs));
+}
+
+}
+
+int main(int argc, const char *argv[])
+{
+  std::string filename, synthetic, backend, json, csv, shaders;
+  std::vector<size_t> selRenderers, selModes, selTargets;
+  std::vector<std::string> lods;
+  std::vector<UINTVECTOR2> sizes;
+  std::vector<std::string> luaScripts;
+  uint32_t frames, luaRuns;
+  try {
+    TCLAP::CmdLine cmd("render benchmark");
+    TCLAP::ValueArg<std::string> dset("d", "dataset", "Dataset to render.",
+                                      false, "", "filename");
+    TCLAP::ValueArg<std::string> synth("", "synthetic", "Data set generated "
+                                       "in memory when no dataset is given, "
+                                       "e.g. blobs:size=512:empty=0.9.",
+                                       false, "shells:size=256", "spec");
+    TCLAP::ValueArg<std::string> ren("r", "renderers", "Comma separated: "
+                                     "sbvr, raycaster, gridleaper, sbvr2d.",
+                                     false, "sbvr,raycaster,gridleaper,sbvr2d",
+                                     "list");
+    TCLAP::ValueArg<std::string> mode("m", "modes", "Comma separated: 1d, "
+                                      "2d, iso.", false, "1d", "list");
+    TCLAP::ValueArg<std::string> target("t", "targets", "Comma separated: "
+                                        "interactive (progressive LOD), "
+                                        "capture (finest LOD).", false,
+                                        "interactive,capture", "list");
+    TCLAP::ValueArg<std::string> lod("l", "lod-limits", "Comma separated "
+                                     "min:max LOD limits, 'default' for the "
+                                     "renderer's.", false, "default", "list");
+    TCLAP::ValueArg<std::string> size("s", "sizes", "Comma separated "
+                                      "viewport sizes.", false,
+                                      "640x480,1280x720", "list");
+    TCLAP::ValueArg<uint32_t> nframes("f", "frames", "Frames along the "
+                                      "camera orbit.", false, 36, "N");
+    TCLAP::ValueArg<std::string> jsonArg("j", "json", "JSON output file.",
+                                         false, "bench.json", "filename");
+    TCLAP::ValueArg<std::string> csvArg("", "csv", "CSV output file.",
+                                        false, "bench.csv", "filename");
+    TCLAP::ValueArg<std::string> shaderArg("", "shaders", "Shader "
+                                           "directory.", false,
+                                           "../../Shaders", "path");
+    TCLAP::ValueArg<std::string> context("c", "context",
+                                         "GL context backend: native, egl "
+                                         "or osmesa.", false, "default",
+                                         "backend");
+    TCLAP::ValueArg<std::string> lua("", "lua", "Comma separated Lua "
+                                     "scripts, e.g. ../../LuaScripting/"
+                                     "regression/iv3d/mathMetamethods.lua. "
+                                     "Times the scripting layer on them "
+                                     "instead of rendering.", false, "",
+                                     "list");
+    TCLAP::ValueArg<uint32_t> luaRunsArg("", "lua-runs", "Runs per Lua "
+                                         "measurement.", false, 200, "N");
+    cmd.add(dset); cmd.add(synth); cmd.add(ren); cmd.add(mode);
+    cmd.add(target); cmd.add(lod); cmd.add(size); cmd.add(nframes);
+    cmd.add(jsonArg); cmd.add(csvArg); cmd.add(shaderArg); cmd.add(context);
+    cmd.add(lua); cmd.add(luaRunsArg);
+    cmd.parse(argc, argv);
+
+    filename = dset.getValue();
+    synthetic = synth.getValue();
+    selRenderers = select(renderers, ren.getValue());
+    selModes = select(modes, mode.getValue());
+    selTargets = select(targets, target.getValue());
+    lods = split(lod.getValue(), ',');
+    const std::vector<std::string> s = split(size.getValue(), ',');
+    for(size_t i=0; i < s.size(); ++i) {
+      sizes.push_back(parse_pair(s[i], 'x'));
+    }
+    frames = std::max(nframes.getValue(), 1u);
+    json = jsonArg.getValue();
+    csv = csvArg.getValue();
+    shaders = shaderArg.getValue();
+    backend = context.getValue();
+    luaScripts = split(lua.getValue(), ',');
+    luaRuns = std::max(luaRunsArg.getValue(), 1u);
+  } catch(const TCLAP::ArgException& e) {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << "\n";
+    return EXIT_FAILURE;
+  } catch(const std::invalid_argument& e) {
+    std::cerr << "error: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if(!luaScripts.empty()) {
+    try {
+      // scripts print; only errors are of interest here
+      Controller::Instance().DebugOut()->SetOutput(true,false,false,false);
+      lua_bench(luaScripts, luaRuns);
+    } catch(const std::exception& e) {
+      std::cerr << "Exception: " << e.what() << "\n";
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  try {
+    std::auto_ptr<TvkContext> ctx(TvkContext::Create(
+      64,64, 32,24,8, true, false, TvkContext::ParseBackend(backend)
+    ));
+    if(!ctx->isValid() || ctx->makeCurrent() == false) {
+      T_ERROR("Could not utilize context.");
+      return EXIT_FAILURE;
+    }
+    Controller::Instance().DebugOut()->SetOutput(true,true,false,false);
+    const std::string gl = reinterpret_cast<const char*>(
+      glGetString(GL_RENDERER)
+    );
+
+    std::string uvf_file;
+    if(filename.empty()) {
+      MESSAGE("No dataset given, generating '%s'", synthetic.c_str());
+    } else {
+      synthetic.clear();
+      uvf_file = SysTools::RemoveExt(filename) + ".uvf";
+      const bool quantize8 = false;
+      Controller::Const().IOMan().ConvertDataset(
+        filename, uvf_file, "/tmp/", true, 256, 4, quantize8
+      );
+    }
+
+    std::vector<Config> configs;
+    for(size_t r=0; r < selRenderers.size(); ++r)
+    for(size_t m=0; m < selModes.size(); ++m)
+    for(size_t t=0; t < selTargets.size(); ++t)
+    for(size_t l=0; l < lods.size(); ++l)
+    for(size_t s=0; s < sizes.size(); ++s) {
+      Config c;
+      c.renderer = selRenderers[r];
+      c.mode = selModes[m];
+      c.target = selTargets[t];
+      c.lod = lods[l] != "default";
+      if(c.lod) { c.lodLimits = parse_pair(lods[l], ':'); }
+      c.size = sizes[s];
+      configs.push_back(c);
+    }
+
+    std::vector<Result> results(configs.size());
+    for(size_t i=0; i < configs.size(); ++i) {
+      std::cout << "[" << i+1 << "/" << configs.size() << "] "
+                << config_name(configs[i]) << std::flush;
+      run(configs[i], uvf_file, synthetic, shaders, frames, results[i]);
+      if(results[i].error.empty()) {
+        std::cout << ": " << summarize(results[i].convergeMs).p50
+                  << " ms median to convergence\n";
+      } else {
+        std::cout << ": " << results[i].error << "\n";
+      }
+    }
+
+    if(!write_json(json, gl, results) || !write_csv(csv, results)) {
+      T_ERROR("Could not write the results.");
+      return EXIT_FAILURE;
+    }
+  } catch(const std::exception& e) {
+    std::cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
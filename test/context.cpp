@@ -34,6 +34,7 @@
   \brief   Establishes an OpenGL context.
 */
 #include "StdTuvokDefines.h"
+#include <cstdlib>
 #include <stdexcept>
 #include <GL/glew.h>
 #include "Controller/Controller.h"
@@ -44,30 +45,120 @@
 #include "cgl-context.h"
 #include "glx-context.h"
 #include "wgl-context.h"
+#ifdef TUVOK_HAVE_EGL
+# include "egl-context.h"
+#endif
+#ifdef TUVOK_HAVE_OSMESA
+# include "osmesa-context.h"
+#endif
 
 namespace tuvok {
 
 TvkContext::~TvkContext() { }
 
-TvkContext* TvkContext::Create(uint32_t width, uint32_t height,
-                               uint8_t color_bits, uint8_t depth_bits,
-                               uint8_t stencil_bits, bool double_buffer,
-                               bool visible)
+static TvkContext* create_native(uint32_t width, uint32_t height,
+                                 uint8_t color_bits, uint8_t depth_bits,
+                                 uint8_t stencil_bits, bool double_buffer,
+                                 bool visible)
 {
-  TvkContext* ctx;
 #ifdef DETECTED_OS_WINDOWS
-  ctx = new TvkWGLContext(width, height, color_bits, depth_bits, stencil_bits,
-                          double_buffer, visible);
+  return new TvkWGLContext(width, height, color_bits, depth_bits,
+                           stencil_bits, double_buffer, visible);
 #elif defined(DETECTED_OS_APPLE) && defined(USE_CGL)
-  ctx = new TvkCGLContext(width, height, color_bits, depth_bits, stencil_bits,
-                          double_buffer, visible);
+  return new TvkCGLContext(width, height, color_bits, depth_bits,
+                           stencil_bits, double_buffer, visible);
 #elif defined(DETECTED_OS_APPLE)
-  ctx = new TvkAGLContext(width, height, color_bits, depth_bits, stencil_bits,
-                          double_buffer, visible);
+  return new TvkAGLContext(width, height, color_bits, depth_bits,
+                           stencil_bits, double_buffer, visible);
+#elif defined(TUVOK_NO_GLX)
+  (void)width; (void)height; (void)color_bits; (void)depth_bits;
+  (void)stencil_bits; (void)double_buffer; (void)visible;
+  T_ERROR("This build has no native context support.");
+  throw NoAvailableContext();
+#else
+  return new TvkGLXContext(width, height, color_bits, depth_bits,
+                           stencil_bits, double_buffer, visible);
+#endif
+}
+
+static TvkContext* create_backend(TvkContext::Backend backend,
+                                  uint32_t width, uint32_t height,
+                                  uint8_t color_bits, uint8_t depth_bits,
+                                  uint8_t stencil_bits, bool double_buffer,
+                                  bool visible)
+{
+  switch(backend) {
+    case TvkContext::BACKEND_EGL:
+#ifdef TUVOK_HAVE_EGL
+      return new TvkEGLContext(width, height, color_bits, depth_bits,
+                               stencil_bits, double_buffer, visible);
 #else
-  ctx = new TvkGLXContext(width, height, color_bits, depth_bits, stencil_bits,
-                          double_buffer, visible);
+      T_ERROR("EGL support was not compiled in (CONFIG+=egl).");
+      throw NoAvailableContext();
+#endif
+    case TvkContext::BACKEND_OSMESA:
+#ifdef TUVOK_HAVE_OSMESA
+      return new TvkOSMesaContext(width, height, color_bits, depth_bits,
+                                  stencil_bits, double_buffer, visible);
+#else
+      T_ERROR("OSMesa support was not compiled in (CONFIG+=osmesa).");
+      throw NoAvailableContext();
+#endif
+    default:
+      return create_native(width, height, color_bits, depth_bits,
+                           stencil_bits, double_buffer, visible);
+  }
+}
+
+TvkContext::Backend TvkContext::ParseBackend(const std::string& name)
+{
+  if(name == "default") { return BACKEND_DEFAULT; }
+  if(name == "native") { return BACKEND_NATIVE; }
+  if(name == "egl") { return BACKEND_EGL; }
+  if(name == "osmesa") { return BACKEND_OSMESA; }
+  throw std::invalid_argument("unknown context backend '" + name + "', "
+                              "expected native, egl or osmesa");
+}
+
+TvkContext* TvkContext::Create(uint32_t width, uint32_t height,
+                               uint8_t color_bits, uint8_t depth_bits,
+                               uint8_t stencil_bits, bool double_buffer,
+                               bool visible, Backend backend)
+{
+  if(backend == BACKEND_DEFAULT) {
+    const char* env = getenv("TUVOK_CONTEXT");
+    if(env != NULL && *env != '\0') { backend = ParseBackend(env); }
+  }
+
+  TvkContext* ctx = NULL;
+  if(backend != BACKEND_DEFAULT) {
+    ctx = create_backend(backend, width, height, color_bits, depth_bits,
+                         stencil_bits, double_buffer, visible);
+  } else {
+    // render servers and CI machines have no display: fall back to the
+    // headless backends this build has
+    const Backend order[] = {
+      BACKEND_NATIVE,
+#ifdef TUVOK_HAVE_EGL
+      BACKEND_EGL,
 #endif
+#ifdef TUVOK_HAVE_OSMESA
+      BACKEND_OSMESA,
+#endif
+    };
+    const size_t n = sizeof(order) / sizeof(order[0]);
+    for(size_t i=0; ctx == NULL; ++i) {
+      try {
+        ctx = create_backend(order[i], width, height, color_bits, depth_bits,
+                             stencil_bits, double_buffer, visible);
+      } catch(const NoAvailableContext&) {
+        if(i+1 == n) { throw; }
+        WARNING("Context backend %u is not available, trying the next one.",
+                static_cast<unsigned>(order[i]));
+      }
+    }
+  }
+
   GLenum glerr = glewInit();
   if(GLEW_OK != glerr) {
     T_ERROR("Error initializing GLEW: %s", glewGetErrorString(glerr));
@@ -39,17 +39,31 @@
 #include "StdTuvokDefines.h"
 #include <cstdint>
 #include <exception>
+#include <string>
 
 namespace tuvok {
 
 class TvkContext {
   public:
+    /// Which window system binding Create() uses.  The headless ones exist
+    /// only in builds configured with CONFIG+=egl / CONFIG+=osmesa.
+    enum Backend {
+      BACKEND_DEFAULT, ///< $TUVOK_CONTEXT if set, else native then headless
+      BACKEND_NATIVE,  ///< GLX, WGL, AGL or CGL
+      BACKEND_EGL,     ///< EGL pbuffer or surfaceless, no display needed
+      BACKEND_OSMESA   ///< Mesa's off-screen software rendering
+    };
+
     virtual ~TvkContext();
     // Virtual coonstructor for appropriate kind of context.
     static TvkContext* Create(uint32_t width, uint32_t height,
                               uint8_t color_bits=32, uint8_t depth_bits=24,
                               uint8_t stencil_bits=8, bool double_buffer=true,
-                              bool visible=false);
+                              bool visible=false,
+                              Backend backend=BACKEND_DEFAULT);
+    /// "native", "egl", "osmesa" or "default"; throws std::invalid_argument
+    /// for anything else.
+    static Backend ParseBackend(const std::string& name);
 
     virtual bool isValid() const=0;
     virtual bool makeCurrent()=0;
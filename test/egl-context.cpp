@@ -0,0 +1,220 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include "StdTuvokDefines.h"
+#include <cstring>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "egl-context.h"
+#include "Controller/Controller.h"
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+# define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace tuvok {
+
+struct eglinfo {
+  EGLDisplay display;
+  EGLSurface surface;
+  EGLContext ctx;
+};
+
+static EGLDisplay egl_display();
+static bool has_extension(const char* extensions, const char* name);
+
+TvkEGLContext::TvkEGLContext(uint32_t w, uint32_t h, uint8_t color_bits,
+                             uint8_t depth_bits, uint8_t stencil_bits,
+                             bool, bool visible) :
+  ei(new struct eglinfo())
+{
+  ei->display = EGL_NO_DISPLAY;
+  ei->surface = EGL_NO_SURFACE;
+  ei->ctx = EGL_NO_CONTEXT;
+  if(visible) {
+    WARNING("EGL contexts are headless, ignoring 'visible'.");
+  }
+
+  ei->display = egl_display();
+  EGLint major, minor;
+  if(ei->display == EGL_NO_DISPLAY ||
+     eglInitialize(ei->display, &major, &minor) != EGL_TRUE) {
+    T_ERROR("Could not initialize EGL (error 0x%x).", eglGetError());
+    throw NoAvailableContext();
+  }
+  MESSAGE("EGL %d.%d, vendor '%s'", major, minor,
+          eglQueryString(ei->display, EGL_VENDOR));
+  if(eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+    T_ERROR("EGL implementation does not support desktop OpenGL.");
+    eglTerminate(ei->display);
+    throw NoAvailableContext();
+  }
+
+  // a pbuffer gives a default framebuffer like the other backends have; the
+  // renderers themselves only need FBOs, so go without if there is none
+  const bool surfaceless = has_extension(
+    eglQueryString(ei->display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"
+  );
+  const EGLint channel = color_bits >= 24 ? 8 : 5;
+  EGLint attr[] = {
+    EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+    EGL_RED_SIZE,        channel,
+    EGL_GREEN_SIZE,      channel,
+    EGL_BLUE_SIZE,       channel,
+    EGL_ALPHA_SIZE,      8,
+    EGL_DEPTH_SIZE,      depth_bits,
+    EGL_STENCIL_SIZE,    stencil_bits,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  const EGLint pbuffer_attr[] = {
+    EGL_WIDTH,  static_cast<EGLint>(w),
+    EGL_HEIGHT, static_cast<EGLint>(h),
+    EGL_NONE
+  };
+  EGLConfig config;
+  EGLint nconfigs = 0;
+  if(eglChooseConfig(ei->display, attr, &config, 1, &nconfigs) == EGL_TRUE &&
+     nconfigs > 0) {
+    ei->surface = eglCreatePbufferSurface(ei->display, config, pbuffer_attr);
+  }
+  if(ei->surface == EGL_NO_SURFACE) {
+    if(!surfaceless) {
+      T_ERROR("Could not create %ux%u pbuffer with %u/%u/%u color/depth/"
+              "stencil bits (error 0x%x).", w, h, color_bits, depth_bits,
+              stencil_bits, eglGetError());
+      eglTerminate(ei->display);
+      throw NoAvailableContext();
+    }
+    attr[1] = 0;  // any surface type
+    if(eglChooseConfig(ei->display, attr, &config, 1, &nconfigs) != EGL_TRUE ||
+       nconfigs == 0) {
+      T_ERROR("No EGL config for OpenGL with %u/%u/%u color/depth/stencil "
+              "bits.", color_bits, depth_bits, stencil_bits);
+      eglTerminate(ei->display);
+      throw NoAvailableContext();
+    }
+  }
+
+  ei->ctx = eglCreateContext(ei->display, config, EGL_NO_CONTEXT, NULL);
+  if(ei->ctx == EGL_NO_CONTEXT) {
+    T_ERROR("EGL context creation failed (error 0x%x).", eglGetError());
+    if(ei->surface != EGL_NO_SURFACE) {
+      eglDestroySurface(ei->display, ei->surface);
+    }
+    eglTerminate(ei->display);
+    throw NoAvailableContext();
+  }
+  this->makeCurrent();
+  MESSAGE("Current context: %p (%s)", eglGetCurrentContext(),
+          ei->surface == EGL_NO_SURFACE ? "surfaceless" : "pbuffer");
+}
+
+TvkEGLContext::~TvkEGLContext()
+{
+  eglMakeCurrent(ei->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if(ei->ctx != EGL_NO_CONTEXT) { eglDestroyContext(ei->display, ei->ctx); }
+  if(ei->surface != EGL_NO_SURFACE) {
+    eglDestroySurface(ei->display, ei->surface);
+  }
+  eglTerminate(ei->display);
+  ei.reset();
+}
+
+bool TvkEGLContext::isValid() const
+{
+  return this->ei->display != EGL_NO_DISPLAY &&
+         this->ei->ctx != EGL_NO_CONTEXT;
+}
+
+bool TvkEGLContext::makeCurrent()
+{
+  if(eglMakeCurrent(this->ei->display, this->ei->surface, this->ei->surface,
+                    this->ei->ctx) != EGL_TRUE) {
+    T_ERROR("Could not make context current!");
+    return false;
+  }
+  return true;
+}
+
+bool TvkEGLContext::swapBuffers()
+{
+  // nothing is ever displayed; a surfaceless context has no buffers
+  if(this->ei->surface == EGL_NO_SURFACE) { return true; }
+  return eglSwapBuffers(this->ei->display, this->ei->surface) == EGL_TRUE;
+}
+
+static bool has_extension(const char* extensions, const char* name)
+{
+  if(extensions == NULL) { return false; }
+  const size_t len = strlen(name);
+  for(const char* ext = strstr(extensions, name); ext != NULL;
+      ext = strstr(ext + len, name)) {
+    if((ext == extensions || ext[-1] == ' ') &&
+       (ext[len] == ' ' || ext[len] == '\0')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Prefers a display that needs no window system: the first EGL device (a
+// GPU, or the software device Mesa exposes), then Mesa's surfaceless
+// platform.  The default display is the last resort; it may try to reach
+// an X server.
+static EGLDisplay egl_display()
+{
+  const char* client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+    reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT")
+    );
+
+  if(getPlatformDisplay && has_extension(client, "EGL_EXT_platform_device")) {
+    PFNEGLQUERYDEVICESEXTPROC queryDevices =
+      reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+        eglGetProcAddress("eglQueryDevicesEXT")
+      );
+    EGLDeviceEXT device;
+    EGLint ndevices = 0;
+    if(queryDevices && queryDevices(1, &device, &ndevices) == EGL_TRUE &&
+       ndevices > 0) {
+      EGLDisplay d = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, NULL);
+      if(d != EGL_NO_DISPLAY) { return d; }
+    }
+  }
+  if(getPlatformDisplay &&
+     has_extension(client, "EGL_MESA_platform_surfaceless")) {
+    EGLDisplay d = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                      EGL_DEFAULT_DISPLAY, NULL);
+    if(d != EGL_NO_DISPLAY) { return d; }
+  }
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+} // namespace tuvok
@@ -0,0 +1,95 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2013 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+*/
+#include "StdTuvokDefines.h"
+#include <vector>
+#include <GL/osmesa.h>
+
+#include "osmesa-context.h"
+#include "Controller/Controller.h"
+
+namespace tuvok {
+
+struct osmesainfo {
+  OSMesaContext ctx;
+  std::vector<uint8_t> buffer;
+  uint32_t width;
+  uint32_t height;
+};
+
+TvkOSMesaContext::TvkOSMesaContext(uint32_t w, uint32_t h, uint8_t,
+                                   uint8_t depth_bits, uint8_t stencil_bits,
+                                   bool, bool visible) :
+  oi(new struct osmesainfo())
+{
+  if(visible) {
+    WARNING("OSMesa contexts are headless, ignoring 'visible'.");
+  }
+  oi->width = w;
+  oi->height = h;
+  oi->ctx = OSMesaCreateContextExt(OSMESA_RGBA, depth_bits, stencil_bits, 0,
+                                   NULL);
+  if(oi->ctx == NULL) {
+    T_ERROR("OSMesa context creation failed.");
+    throw NoAvailableContext();
+  }
+  // the default framebuffer; the renderers themselves draw into FBOs
+  oi->buffer.resize(static_cast<size_t>(w) * h * 4);
+  this->makeCurrent();
+  OSMesaPixelStore(OSMESA_Y_UP, 1);
+  MESSAGE("Current context: %p", OSMesaGetCurrentContext());
+}
+
+TvkOSMesaContext::~TvkOSMesaContext()
+{
+  OSMesaDestroyContext(oi->ctx);
+  oi.reset();
+}
+
+bool TvkOSMesaContext::isValid() const
+{
+  return this->oi->ctx != NULL;
+}
+
+bool TvkOSMesaContext::makeCurrent()
+{
+  if(OSMesaMakeCurrent(this->oi->ctx, &this->oi->buffer[0], GL_UNSIGNED_BYTE,
+                       this->oi->width, this->oi->height) != GL_TRUE) {
+    T_ERROR("Could not make context current!");
+    return false;
+  }
+  return true;
+}
+
+bool TvkOSMesaContext::swapBuffers()
+{
+  // single buffered; make sure the image in memory is complete
+  glFinish();
+  return true;
+}
+
+} // namespace tuvok
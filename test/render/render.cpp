@@ -59,21 +59,30 @@ using namespace tuvok;
 int main(int argc, const char *argv[])
 {
   std::string filename;
+  std::string backend;
   try {
     TCLAP::CmdLine cmd("rendering test program");
     TCLAP::ValueArg<std::string> dset("d", "dataset", "Dataset to render.",
                                       true, "", "filename");
+    TCLAP::ValueArg<std::string> context("c", "context",
+                                         "GL context backend: native, egl "
+                                         "or osmesa.", false, "default",
+                                         "backend");
     cmd.add(dset);
+    cmd.add(context);
     cmd.parse(argc, argv);
 
     filename = dset.getValue();
+    backend = context.getValue();
   } catch(const TCLAP::ArgException& e) {
     std::cerr << "error: " << e.error() << " for arg " << e.argId() << "\n";
     return EXIT_FAILURE;
   }
 
   try {
-    std::auto_ptr<TvkContext> ctx(TvkContext::Create(640,480, 32,24,8, true));
+    std::auto_ptr<TvkContext> ctx(TvkContext::Create(
+      640,480, 32,24,8, true, false, TvkContext::ParseBackend(backend)
+    ));
     if(!ctx->isValid() || ctx->makeCurrent() == false) {
       T_ERROR("Could not utilize context.");
       return EXIT_FAILURE;
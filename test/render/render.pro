@@ -56,12 +56,38 @@ SOURCES += \
   ../context.cpp \
   render.cpp
 
-unix:!macx { SOURCES += ../glx-context.cpp }
+unix:!macx:!osmesa { SOURCES += ../glx-context.cpp }
 macx { SOURCES += ../cgl-context.cpp ../agl-context.cpp }
 win32 { SOURCES += ../wgl-context.cpp }
 
+# Headless backends, e.g. for CPU-only machines with llvmpipe:
+#   qmake CONFIG+=egl     EGL pbuffer/surfaceless context
+#   qmake CONFIG+=osmesa  libOSMesa instead of libGL, so no GLX
+# Build libTuvok with the same CONFIG.  Both link the system's GLEW, which
+# must be 2.0+ built for EGL (SYSTEM=linux-egl) or OSMesa
+# (SYSTEM=linux-osmesa); the bundled 1.9 initializes through GLX only.
+egl {
+  DEFINES += TUVOK_HAVE_EGL GLEW_EGL
+  SOURCES += ../egl-context.cpp
+  LIBS    += -lEGL
+  CONFIG  += systemglew
+}
+osmesa {
+  DEFINES += TUVOK_HAVE_OSMESA TUVOK_NO_GLX GLEW_OSMESA
+  SOURCES += ../osmesa-context.cpp
+  LIBS    -= -lGL -lX11
+  LIBS    += -lOSMesa
+  CONFIG  += systemglew
+}
+systemglew {
+  INCLUDEPATH -= ../../3rdParty/GLEW
+  LIBS        += -lGLEW
+}
+
 HEADERS += \
   ../context.h \
   ../cgl-context.h \
+  ../egl-context.h \
   ../glx-context.h \
+  ../osmesa-context.h \
   ../wgl-context.h
@@ -57,21 +57,30 @@ using namespace tuvok;
 int main(int argc, char *argv[])
 {
   std::string filename;
+  std::string backend;
   try {
     TCLAP::CmdLine cmd("shader test program");
     TCLAP::ValueArg<std::string> dset("d", "dataset", "Dataset to render.",
                                       true, "", "filename");
+    TCLAP::ValueArg<std::string> context("c", "context",
+                                         "GL context backend: native, egl "
+                                         "or osmesa.", false, "default",
+                                         "backend");
     cmd.add(dset);
+    cmd.add(context);
     cmd.parse(argc, argv);
 
     filename = dset.getValue();
+    backend = context.getValue();
   } catch(const TCLAP::ArgException& e) {
     std::cerr << "error: " << e.error() << " for arg " << e.argId() << "\n";
     return EXIT_FAILURE;
   }
 
   try {
-    std::auto_ptr<TvkContext> ctx(TvkContext::Create(320,240, 32,24,8, true));
+    std::auto_ptr<TvkContext> ctx(TvkContext::Create(
+      320,240, 32,24,8, true, false, TvkContext::ParseBackend(backend)
+    ));
     Controller::Instance().DebugOut()->SetOutput(true,true,false,true);
 
     // Convert the data into a UVF.
@@ -117,8 +117,11 @@ HEADERS += \
            Basics/Vectors.h \
            Controller/Controller.h \
            Controller/MasterController.h \
+           Controller/PerfCounters.h \
+           Controller/Tracer.h \
            DebugOut/AbstrDebugOut.h \
            DebugOut/ConsoleOut.h \
+           DebugOut/DebugRecordStore.h \
            DebugOut/MultiplexOut.h \
            DebugOut/TextfileOut.h \
            IO/3rdParty/bzip2/bzlib_private.h \
@@ -225,6 +228,7 @@ HEADERS += \
            IO/REKConverter.h \
            IO/StkConverter.h \
            IO/StLGeoConverter.h \
+           IO/SyntheticDataset.h \
            IO/TiffVolumeConverter.h \
            IO/TransferFunction1D.h \
            IO/TransferFunction2D.h \
@@ -262,13 +266,17 @@ HEADERS += \
            IO/VGStudioConverter.h \
            IO/VTKConverter.h \
            IO/XML3DGeoConverter.h \
+           LuaScripting/LuaChunkCache.h \
            LuaScripting/LuaClassConstructor.h \
            LuaScripting/LuaClassInstance.h \
            LuaScripting/LuaClassRegistration.h \
+           LuaScripting/LuaCommandBatch.h \
            LuaScripting/LuaCommon.h \
            LuaScripting/LuaError.h \
+           LuaScripting/LuaFreeListAllocator.h \
            LuaScripting/LuaFunBindingCore.h \
            LuaScripting/LuaFunBinding.h \
+           LuaScripting/LuaMemAllocator.h \
            LuaScripting/LuaMemberReg.h \
            LuaScripting/LuaMemberRegUnsafe.h \
            LuaScripting/LuaProvenance.h \
@@ -283,14 +291,18 @@ HEADERS += \
            LuaScripting/TuvokSpecific/LuaTuvokTypes.h \
            LuaScripting/TuvokSpecific/MatrixMath.h \
            Renderer/AbstrRenderer.h \
+           Renderer/BrickCostModel.h \
+           Renderer/CaptureSequence.h \
            Renderer/Context.h \
            Renderer/ContextIdentification.h \
            Renderer/CullingLOD.h \
            Renderer/FrameCapture.h \
+           Renderer/FrameCaptureQueue.h \
            Renderer/GL/GLCommon.h \
            Renderer/GL/GLContext.h \
            Renderer/GL/GLFrameCapture.h \
            Renderer/GL/GLGPURayTraverser.h \
+           Renderer/GL/GLGPUTracer.h \
            Renderer/GL/GLGridLeaper.h \
            Renderer/GL/GLHashTable.h \
            Renderer/GL/GLInclude.h \
@@ -306,6 +318,9 @@ HEADERS += \
            Renderer/GL/GLTexture2D.h \
            Renderer/GL/GLTexture3D.h \
            Renderer/GL/GLTexture.h \
+           Renderer/GL/GLTextureReadback.h \
+           Renderer/GL/GLTimeSlicer.h \
+           Renderer/GL/GLTimerQueryPool.h \
            Renderer/GL/GLVBO.h \
            Renderer/GL/GLVolume2DTex.h \
            Renderer/GL/GLVolume3DTex.h \
@@ -316,14 +331,18 @@ HEADERS += \
            Renderer/GPUMemMan/GPUMemManDataStructs.h \
            Renderer/GPUMemMan/GPUMemMan.h \
            Renderer/GPUObject.h \
+           Renderer/LODController.h \
            Renderer/RenderMesh.h \
            Renderer/RenderRegion.h \
            Renderer/SBVRGeoGen2D.h \
            Renderer/SBVRGeoGen3D.h \
            Renderer/SBVRGeoGen.h \
+           Renderer/SBVRGeometryCache.h \
            Renderer/ShaderDescriptor.h \
            Renderer/StateManager.h \
+           Renderer/StereoBrickScheduler.h \
            Renderer/TFScaling.h \
+           Renderer/TIFFTileWriter.h \
            Renderer/VisibilityState.h \
            Renderer/writebrick.h \
            StdTuvokDefines.h
@@ -387,8 +406,11 @@ SOURCES += \
            Basics/Threads.cpp \
            Basics/Timer.cpp \
            Controller/MasterController.cpp \
+           Controller/PerfCounters.cpp \
+           Controller/Tracer.cpp \
            DebugOut/AbstrDebugOut.cpp \
            DebugOut/ConsoleOut.cpp \
+           DebugOut/DebugRecordStore.cpp \
            DebugOut/MultiplexOut.cpp \
            DebugOut/TextfileOut.cpp \
            IO/3rdParty/bzip2/blocksort.c \
@@ -562,6 +584,7 @@ SOURCES += \
            IO/REKConverter.cpp \
            IO/StkConverter.cpp \
            IO/StLGeoConverter.cpp \
+           IO/SyntheticDataset.cpp \
            IO/TiffVolumeConverter.cpp \
            IO/TransferFunction1D.cpp \
            IO/TransferFunction2D.cpp \
@@ -594,9 +617,12 @@ SOURCES += \
            IO/VGStudioConverter.cpp \
            IO/VTKConverter.cpp \
            IO/XML3DGeoConverter.cpp \
+           LuaScripting/LuaChunkCache.cpp \
            LuaScripting/LuaClassConstructor.cpp \
            LuaScripting/LuaClassInstance.cpp \
            LuaScripting/LuaClassRegistration.cpp \
+           LuaScripting/LuaCommandBatch.cpp \
+           LuaScripting/LuaMemAllocator.cpp \
            LuaScripting/LuaMemberReg.cpp \
            LuaScripting/LuaMemberRegUnsafe.cpp \
            LuaScripting/LuaProvenance.cpp \
@@ -609,12 +635,17 @@ SOURCES += \
            LuaScripting/TuvokSpecific/LuaTuvokTypes.cpp \
            LuaScripting/TuvokSpecific/MatrixMath.cpp \
            Renderer/AbstrRenderer.cpp \
+           Renderer/BrickCostModel.cpp \
+           Renderer/CaptureSequence.cpp \
            Renderer/Context.cpp \
            Renderer/CullingLOD.cpp \
+           Renderer/FrameCapture.cpp \
+           Renderer/FrameCaptureQueue.cpp \
            Renderer/GL/GLCommon.cpp \
            Renderer/GL/GLFBOTex.cpp \
            Renderer/GL/GLFrameCapture.cpp \
            Renderer/GL/GLGPURayTraverser.cpp \
+           Renderer/GL/GLGPUTracer.cpp \
            Renderer/GL/GLGridLeaper.cpp \
            Renderer/GL/GLHashTable.cpp \
            Renderer/GL/GLRaycaster.cpp \
@@ -628,6 +659,9 @@ SOURCES += \
            Renderer/GL/GLTexture2D.cpp \
            Renderer/GL/GLTexture3D.cpp \
            Renderer/GL/GLTexture.cpp \
+           Renderer/GL/GLTextureReadback.cpp \
+           Renderer/GL/GLTimeSlicer.cpp \
+           Renderer/GL/GLTimerQueryPool.cpp \
            Renderer/GL/GLVBO.cpp \
            Renderer/GL/GLVolume2DTex.cpp \
            Renderer/GL/GLVolume3DTex.cpp \
@@ -636,13 +670,17 @@ SOURCES += \
            Renderer/GL/RenderMeshGL.cpp \
            Renderer/GPUMemMan/GPUMemMan.cpp \
            Renderer/GPUMemMan/GPUMemManDataStructs.cpp \
+           Renderer/LODController.cpp \
            Renderer/RenderMesh.cpp \
            Renderer/RenderRegion.cpp \
            Renderer/SBVRGeogen2D.cpp \
            Renderer/SBVRGeogen3D.cpp \
            Renderer/SBVRGeogen.cpp \
+           Renderer/SBVRGeometryCache.cpp \
            Renderer/ShaderDescriptor.cpp \
+           Renderer/StereoBrickScheduler.cpp \
            Renderer/TFScaling.cpp \
+           Renderer/TIFFTileWriter.cpp \
            Renderer/VisibilityState.cpp
 
 unix:SOURCES += \
@@ -675,3 +713,26 @@ win32 {
              Renderer/DX/DXTexture2D.cpp \
              Renderer/DX/DXTexture3D.cpp
 }
+
+# Headless builds for the test tools (test/*/*.pro with the same CONFIG):
+#   qmake CONFIG+=egl     also finds EGL contexts
+#   qmake CONFIG+=osmesa  OSMesa contexts, without GLX
+# Both need a system GLEW 2.0+ built for EGL (SYSTEM=linux-egl) or OSMesa
+# (SYSTEM=linux-osmesa) instead of the bundled 1.9, whose glewInit needs a
+# GLX display.  CONFIG+=systemglew alone just swaps the GLEW.
+egl {
+  DEFINES += TUVOK_HAVE_EGL GLEW_EGL
+  CONFIG  += systemglew
+}
+osmesa {
+  DEFINES += TUVOK_HAVE_OSMESA TUVOK_NO_GLX GLEW_OSMESA
+  CONFIG  += systemglew
+}
+systemglew {
+  INCLUDEPATH -= 3rdParty/GLEW
+  HEADERS     -= 3rdParty/GLEW/GL/glew.h \
+                 3rdParty/GLEW/GL/glxew.h \
+                 3rdParty/GLEW/GL/wglew.h
+  SOURCES     -= 3rdParty/GLEW/GL/glew.c
+  LIBS        += -lGLEW
+}